@@ -0,0 +1,56 @@
+// Cold vs warm ingest of an unchanged tree through the parse state store.
+// Usage: bench_cache [logs] [lines-per-log]
+#include "ingest.hpp"
+#include "synth_logs.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char **argv) {
+    const int logs = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const long lines = argc > 2 ? std::atol(argv[2]) : 2000;
+
+    const fs::path dir = fs::temp_directory_path() / "bench_cache";
+    fs::create_directories(dir);
+    const auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    std::vector<std::string> pm, rm;
+    for (int i = 0; i < logs; ++i) {
+        const bool isPm = i % 2 == 0;
+        auto &list = isPm ? pm : rm;
+        list.push_back((dir / ((isPm ? "pm_" : "rm_") + std::to_string(i) + ".log")).string());
+        if (isPm) synth::write_pm(list.back(), lines);
+        else synth::write_rm(list.back(), lines);
+        fs::last_write_time(list.back(), old);  // settled, as on a farm share
+    }
+    const std::string storeFile = (dir / ".parse_state").string();
+
+    auto run = [&](const char *what) {
+        auto t0 = std::chrono::steady_clock::now();
+        ParseStateStore store;
+        store.load(storeFile);
+        ParsedLogs got = parse_logs(pm, rm, 0, &store);
+        store.save(storeFile);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("%-5s %6d logs  %9.1f ms\n", what, logs, ms);
+        return got;
+    };
+    const ParsedLogs cold = run("cold");
+    const ParsedLogs warm = run("warm");
+
+    bool same = cold.pm.size() == warm.pm.size() && cold.rm.size() == warm.rm.size();
+    for (size_t i = 0; same && i < cold.pm.size(); ++i)
+        same = cold.pm[i].endTime == warm.pm[i].endTime && cold.pm[i].warnings == warm.pm[i].warnings &&
+               cold.pm[i].totalSizeGB == warm.pm[i].totalSizeGB;
+    for (size_t i = 0; same && i < cold.rm.size(); ++i)
+        same = cold.rm[i].offsetZ == warm.rm[i].offsetZ && cold.rm[i].errors == warm.rm[i].errors &&
+                   cold.rm[i].errorCount == warm.rm[i].errorCount;
+    std::printf("rows %s\n", same ? "match" : "MISMATCH");
+    fs::remove_all(dir);
+    return same ? 0 : 1;
+}
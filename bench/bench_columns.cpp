@@ -0,0 +1,136 @@
+// Master TSV serialization: the previous per-row vector<string> + ostringstream
+// line builder vs the column schema appending into one reused buffer.
+// Usage: bench_columns [rows]
+#include "columns.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Heap allocations since start, for the per-row figures
+static std::atomic<std::size_t> g_allocs{0};
+
+void *operator new(std::size_t n) {
+    ++g_allocs;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// The line builder the schema replaced
+namespace legacy {
+
+static std::string to_tsv(const std::vector<std::string> &cells) {
+    std::ostringstream os;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        std::string v = cells[i];
+        for (char &c : v) if (c == '\t' || c == '\r' || c == '\n') c = ' ';
+        os << v;
+        if (i + 1 < cells.size()) os << '\t';
+    }
+    return os.str();
+}
+
+static std::string tsv_line(const excel::UnifiedRow &u) {
+    std::vector<std::string> cells = {
+        u.ProjectName(), to_text(u.Tool()), u.DatasetName(), to_text(u.BuildID()),
+        to_text(u.StartTime()), to_text(u.EndTime()), to_text(u.Duration()), date_text(u.RunDate()),
+        to_text(u.ProcessPreset()), to_text(u.ExportType()), to_text(u.SelAreaSize()), to_text(u.Resolution()),
+        to_text(u.TileScheme()), to_text(u.PhotosUsed()), u.PhotoFolders(), to_text(u.PhotoCoverage()),
+        to_text(u.FusersUsed()), to_text(u.CPUThreads()), to_text(u.GPUCount()),
+        to_text(u.Machine()), to_text(u.HostIP()), to_text(u.User()),
+        to_text(u.OutputFolder()), to_text(u.TotalFiles()), gb_text(u.TotalSizeGB()),
+        to_text(u.Offset_CoordSys()), to_text(u.Offset_HDatum()), to_text(u.Offset_VDatum()),
+        to_text(u.OffsetX()), to_text(u.OffsetY()), to_text(u.OffsetZ()),
+        to_text(u.PivotCenterX()), to_text(u.PivotCenterY()), to_text(u.PivotCenterZ()),
+        to_text(u.FlipYZ()), to_text(u.Trim()), to_text(u.Collision()), to_text(u.VisualLOD()),
+        to_text(u.Success()), tally_text(u.Warnings()), errors_text(u.Errors(), u.ErrorMessages()), u.LogPath(),
+        stamp_text(u.IngestedAt())};
+    return to_tsv(cells);
+}
+
+} // namespace legacy
+
+int main(int argc, char **argv) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 200000;
+    const auto t0 = util::TimePoint(std::chrono::seconds(1755712795));
+
+    std::vector<PhotoMeshRow> pm;
+    std::vector<RealityMeshRow> rm;
+    auto fill = [&](auto &r, long i) {
+        r.projectName = "Project_" + std::to_string(i % 500);
+        r.startTime = t0 + std::chrono::minutes(i);
+        r.endTime = *r.startTime + std::chrono::seconds(600 + i % 7200);
+        r.duration = std::chrono::duration_cast<std::chrono::seconds>(*r.endTime - *r.startTime);
+        from_text(i % 2 ? "3mx" : "OBJ", r.exportType);
+        from_text("HIGH", r.resolution);
+        from_text("NODE" + std::to_string(i % 64), r.machine);
+        from_text("D:\\Exports\\Project_" + std::to_string(i % 500) + "\\Output", r.outputFolder);
+        from_text("WGS84", r.offsetCoordSys);
+        r.totalFiles = 20 + i % 1000;
+        r.totalSizeGB = (i % 10000) / 7.0;
+        r.offsetX = 100.5; r.offsetY = 200.25; r.offsetZ = i * 0.5;
+        r.flipYZ = Tri::False; r.trim = Tri::True;
+        r.success = i % 17 ? Tri::True : Tri::False;
+        r.warnings = static_cast<std::int32_t>(i % 5);
+        r.logPath = "\\\\fileserver\\logs\\Project_" + std::to_string(i % 500) + "\\run_" + std::to_string(i) + ".log";
+    };
+    for (long i = 0; i < n; ++i) {
+        if (i % 3) {
+            auto &r = pm.emplace_back();
+            fill(r, i);
+            r.photosUsed = 1000 + i % 900;
+            r.fusersUsed = 4;
+            r.cpuThreads = 32;
+        } else {
+            auto &r = rm.emplace_back();
+            fill(r, i);
+            r.datasetName = "Dataset\t" + std::to_string(i % 50);  // a tab to sanitize
+            if (i % 7 == 0) { r.errorCount = 1; r.errors = "Error: tile failed"; }
+        }
+    }
+    const auto rows = excel::unify(pm, rm);
+
+    std::string oldOut;
+    const std::size_t a0 = g_allocs;
+    const double tOld = time_ms([&] {
+        for (const auto &u : rows) {
+            oldOut += legacy::tsv_line(u);
+            oldOut += '\n';
+        }
+    });
+    const double allocsOld = double(g_allocs - a0) / n;
+
+    // Same flushing pattern as the master writer: one buffer, reused
+    std::string buf, newOut;
+    buf.reserve(1u << 20);
+    newOut.reserve(oldOut.size());
+    const std::size_t a1 = g_allocs;
+    const double tNew = time_ms([&] {
+        for (const auto &u : rows) {
+            excel::append_tsv_line(buf, excel::kMasterColumns, u);
+            if (buf.size() >= (1u << 20)) { newOut += buf; buf.clear(); }
+        }
+        newOut += buf;
+    });
+    const double allocsNew = double(g_allocs - a1) / n;
+
+    const bool same = oldOut == newOut;
+    std::printf("tsv lines   old %9.1f ms  new %8.1f ms  speedup %5.1fx  %s\n", tOld, tNew, tOld / tNew,
+                same ? "match" : "MISMATCH");
+    std::printf("allocs/row  old %9.1f     new %8.3f\n", allocsOld, allocsNew);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// Compares the rule-table parsers against the previous per-line std::regex loop
+// on a synthetic log. Usage: bench_extract [lines]
+#include "line_reader.hpp"
+#include "photomesh_parser.hpp"
+#include "realitymesh_parser.hpp"
+#include "synth_logs.hpp"
+#include "thread_pool.hpp"
+#include "util_time.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace legacy {
+
+// The all-text rows the regex parsers produced (fields they set)
+struct PhotoMeshRow {
+    std::string projectName, machine, startTime, endTime, duration, exportType, resolution, totalSizeGB,
+        visualLOD, success, warnings, errors, logPath;
+};
+
+struct RealityMeshRow {
+    std::string datasetName, duration, offsetX, offsetY, offsetZ, success, errors, logPath;
+};
+
+PhotoMeshRow parse_photomesh(const std::string &path) {
+    PhotoMeshRow row;
+    row.logPath = path;
+    row.projectName = fs::path(path).stem().string();
+    std::ifstream in(path);
+    if (!in) return row;
+    std::string line;
+    std::regex kv(R"(SLDEFAULT=>\s*(\w+)\s*:\s*(.*))");
+    std::regex machine(R"delim("MachineName"\s*:\s*"([^"]+)")delim");
+    std::regex timeR(R"delim("MsgTime"\s*:\s*"([^"]+)")delim");
+    std::regex exitR(R"(Finished with exit code\s*\((\d+)\))");
+    int warn=0, err=0;
+    while (std::getline(in,line)) {
+        std::smatch m;
+        if (std::regex_search(line,m,machine)) row.machine = m[1];
+        if (std::regex_search(line,m,timeR)) {
+            if (row.startTime.empty()) row.startTime = m[1];
+            row.endTime = m[1];
+        }
+        if (std::regex_search(line,m,kv)) {
+            std::string key = m[1];
+            std::string val = util::trim(m[2]);
+            if (key == "ExportType") row.exportType = val;
+            else if (key == "Resolution") row.resolution = val;
+            else if (key == "TotalSize") row.totalSizeGB = util::size_to_gb(val);
+            else if (key == "VisualLOD") row.visualLOD = val;
+        }
+        if (line.find("Warning") != std::string::npos) warn++;
+        if (line.find("Error") != std::string::npos) err++;
+        if (std::regex_search(line,m,exitR)) row.success = (m[1]=="0")?"True":"False";
+    }
+    if (row.success.empty()) row.success = err==0 ? "True" : "False";
+    row.warnings = warn?std::to_string(warn):"";
+    row.errors = err?std::to_string(err):"";
+    row.duration = util::compute_duration(row.startTime,row.endTime);
+    return row;
+}
+
+RealityMeshRow parse_realitymesh(const std::string &path) {
+    RealityMeshRow row;
+    row.logPath = path;
+    std::ifstream in(path);
+    if (!in) return row;
+    std::string line;
+    std::regex dataset(R"delim(-command_file\s+"([^"]+)")delim");
+    std::regex exitR(R"(Process completed with exit code:\s*(\d+))");
+    std::regex runR(R"(Time to run TT project:\s*([0-9]+)\s*seconds)");
+    std::regex inputOffset(R"(Input offset:\s*([\-0-9\.]+)\s+([\-0-9\.]+)\s+([\-0-9\.]+))");
+    std::regex convOffset(R"(Converted offset:\s*([\-0-9\.]+)\s+([\-0-9\.]+)\s+([\-0-9\.]+))");
+    int errCount=0;
+    while (std::getline(in,line)) {
+        std::smatch m;
+        if (std::regex_search(line,m,dataset)) row.datasetName = m[1];
+        if (std::regex_search(line,m,inputOffset)) { row.offsetX = m[1]; row.offsetY = m[2]; row.offsetZ = m[3]; }
+        if (std::regex_search(line,m,convOffset)) { row.offsetX = m[1]; row.offsetY = m[2]; row.offsetZ = m[3]; }
+        if (std::regex_search(line,m,exitR)) row.success = (m[1]=="0")?"True":"False";
+        if (std::regex_search(line,m,runR)) row.duration = util::seconds_to_hhmmss(std::stoi(m[1]));
+        auto pos = line.find("Error:");
+        if (pos != std::string::npos) {
+            errCount++;
+            if (!row.errors.empty()) row.errors += ";";
+            row.errors += util::trim(line.substr(pos+6));
+        }
+    }
+    if (row.success.empty()) row.success = errCount==0 ? "True":"False";
+    if (row.errors.empty() && errCount) row.errors = std::to_string(errCount);
+    return row;
+}
+
+} // namespace legacy
+
+static bool same_text(const legacy::PhotoMeshRow &a, const PhotoMeshRow &b) {
+    return a.machine == to_text(b.machine) && a.endTime == to_text(b.endTime) && a.totalSizeGB == gb_text(b.totalSizeGB) &&
+           a.warnings == tally_text(b.warnings) && a.errors == tally_text(b.errors) && a.success == to_text(b.success);
+}
+
+static bool same_text(const legacy::RealityMeshRow &a, const RealityMeshRow &b) {
+    return a.offsetZ == to_text(b.offsetZ) && a.errors == errors_text(b.errorCount, b.errors) &&
+           a.duration == to_text(b.duration) && a.datasetName == b.datasetName && a.success == to_text(b.success);
+}
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    const long lines = argc > 1 ? std::atol(argv[1]) : 200000;
+    const fs::path dir = fs::temp_directory_path();
+    const std::string pm = (dir / "bench_extract_pm.log").string();
+    const std::string rm = (dir / "bench_extract_rm.log").string();
+    synth::write_pm(pm, lines);
+    synth::write_rm(rm, lines);
+
+    legacy::PhotoMeshRow old;
+    PhotoMeshRow a, b;
+    double tRegex = time_ms([&] { old = legacy::parse_photomesh(pm); });
+    double tRules = time_ms([&] { b = parse_photomesh(pm); });
+    bool same = same_text(old, b);
+    std::printf("photomesh    %ld lines  regex %9.1f ms  rules %9.1f ms  speedup %5.1fx  %s\n",
+                lines, tRegex, tRules, tRegex / tRules, same ? "match" : "MISMATCH");
+
+    legacy::RealityMeshRow c;
+    RealityMeshRow d;
+    tRegex = time_ms([&] { c = legacy::parse_realitymesh(rm); });
+    tRules = time_ms([&] { d = parse_realitymesh(rm); });
+    bool same2 = same_text(c, d);
+    std::printf("realitymesh  %ld lines  regex %9.1f ms  rules %9.1f ms  speedup %5.1fx  %s\n",
+                lines, tRegex, tRules, tRegex / tRules, same2 ? "match" : "MISMATCH");
+
+    // Intra-file chunking on all cores
+    ParseOptions chunked;
+    chunked.threads = util::resolve_jobs(0);
+    chunked.chunkBytes = 1 << 20;
+    tRegex = time_ms([&] { a = parse_photomesh(pm); });
+    tRules = time_ms([&] { b = parse_photomesh(pm, chunked); });
+    bool same3 = a.machine == b.machine && a.endTime == b.endTime && a.totalSizeGB == b.totalSizeGB &&
+                 a.warnings == b.warnings && a.errors == b.errors && a.success == b.success;
+    std::printf("chunked      %u threads  sequential %9.1f ms  chunked %9.1f ms  speedup %5.1fx  %s\n",
+                chunked.threads, tRegex, tRules, tRegex / tRules, same3 ? "match" : "MISMATCH");
+
+    // Raw line iteration: getline into a std::string vs views over the mapping
+    size_t bytesA = 0, bytesB = 0;
+    tRegex = time_ms([&] {
+        std::ifstream in(pm);
+        std::string line;
+        while (std::getline(in, line)) bytesA += line.size();
+    });
+    tRules = time_ms([&] {
+        util::LineReader in(pm);
+        std::string_view line;
+        while (in.next(line)) bytesB += line.size();
+    });
+    std::printf("lines        getline %9.1f ms  mapped %9.1f ms  speedup %5.1fx  %s\n",
+                tRegex, tRules, tRegex / tRules, bytesA == bytesB ? "match" : "MISMATCH");
+
+    fs::remove(pm);
+    fs::remove(rm);
+    return same && same2 && same3 && bytesA == bytesB ? 0 : 1;
+}
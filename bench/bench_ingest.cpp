@@ -0,0 +1,47 @@
+// Multi-file parse scaling from 1 to N threads.
+// Usage: bench_ingest [files] [lines-per-file] [max-threads]
+#include "ingest.hpp"
+#include "synth_logs.hpp"
+#include "thread_pool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char **argv) {
+    const int files = argc > 1 ? std::atoi(argv[1]) : 64;
+    const long lines = argc > 2 ? std::atol(argv[2]) : 20000;
+    const unsigned maxThreads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : util::resolve_jobs(0);
+
+    const fs::path dir = fs::temp_directory_path() / "bench_ingest";
+    fs::create_directories(dir);
+    std::vector<std::string> pm, rm;
+    for (int i = 0; i < files; ++i) {
+        pm.push_back((dir / ("pm_" + std::to_string(i) + ".log")).string());
+        rm.push_back((dir / ("rm_" + std::to_string(i) + ".log")).string());
+        synth::write_pm(pm.back(), lines);
+        synth::write_rm(rm.back(), lines);
+    }
+
+    double base = 0;
+    ParsedLogs ref;
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        auto t0 = std::chrono::steady_clock::now();
+        ParsedLogs got = parse_logs(pm, rm, t);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (t == 1) { base = ms; ref = got; }
+        bool ordered = true;
+        for (size_t i = 0; i < got.pm.size(); ++i) ordered &= got.pm[i].logPath == ref.pm[i].logPath;
+        for (size_t i = 0; i < got.rm.size(); ++i) ordered &= got.rm[i].logPath == ref.rm[i].logPath;
+        std::printf("threads %3u  %9.1f ms  speedup %5.2fx  %s\n", t, ms, base / ms,
+                    ordered ? "ordered" : "ORDER MISMATCH");
+        if (t < maxThreads && t * 2 > maxThreads) t = maxThreads / 2;  // always end on maxThreads
+    }
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Master queries: the column store (zone maps, dictionaries, LogPath index)
+// against a scan of the TSV alone, on the same master.
+// Usage: bench_query [rows]
+#include "column_store.hpp"
+#include "columns.hpp"
+#include "logpath_index.hpp"
+#include "master_query.hpp"
+#include "util_time.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    using excel::column_index;
+    using excel::kMasterColumns;
+    const long n = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+    // A row a minute from 2025-01-01, as ingestion appends them
+    std::string text;
+    excel::append_tsv_header(text, kMasterColumns);
+    const std::size_t headerBytes = text.size();
+    std::vector<std::string> cells(kMasterColumns.size());
+    const auto t0 = util::TimePoint(std::chrono::seconds(1735689600));
+    char buf[40];
+    for (long i = 0; i < n; ++i) {
+        const auto start = t0 + std::chrono::minutes(i);
+        cells[column_index(kMasterColumns, "ProjectName")] = "Project_" + std::to_string(i % 500);
+        cells[column_index(kMasterColumns, "Tool")] = i % 3 ? "PhotoMesh" : "RealityMesh";
+        cells[column_index(kMasterColumns, "StartTime")] = std::string(buf, util::format_time(buf, start));
+        cells[column_index(kMasterColumns, "Duration(hh:mm:ss)")] = util::seconds_to_hhmmss(static_cast<int>(600 + i % 7200));
+        cells[column_index(kMasterColumns, "RunDate")] = std::string(buf, util::format_date(buf, start));
+        cells[column_index(kMasterColumns, "Machine")] = "NODE" + std::to_string(i % 64);
+        cells[column_index(kMasterColumns, "TotalFiles")] = std::to_string(20 + i % 1000);
+        cells[column_index(kMasterColumns, "TotalSize(GB)")] = std::to_string(i % 10000 / 100) + ".50";
+        cells[column_index(kMasterColumns, "Errors")] = i % 7 ? "" : "Error: tile " + std::to_string(i % 13) + " failed";
+        cells[column_index(kMasterColumns, "LogPath")] = "\\\\fileserver\\logs\\run_" + std::to_string(i) + ".log";
+        cells[column_index(kMasterColumns, "IngestedAt")] = std::string(buf, util::format_stamp(buf, start));
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            if (c) text.push_back('\t');
+            text += cells[c];
+        }
+        text.push_back('\n');
+    }
+
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_bench_query";
+    const fs::path plain = dir / "tsv_only";
+    fs::remove_all(dir);
+    fs::create_directories(plain);
+    std::ofstream(dir / "All_Exports.tsv", std::ios::binary) << text;
+    std::ofstream(plain / "All_Exports.tsv", std::ios::binary) << text;
+    {
+        std::vector<std::pair<std::string, excel::CellKind>> columns;
+        for (const auto &c : kMasterColumns) columns.emplace_back(std::string(c.name), c.kind);
+        excel::ColumnStore store(excel::ColumnStore::path_for(dir.string()));
+        store.create(columns);
+        store.append(std::string_view(text).substr(headerBytes), text.size());
+        excel::LogPathIndex((dir / "All_Exports.tsv").string()).save();
+    }
+    text = {};
+
+    struct Case {
+        const char *name;
+        std::vector<std::string> where;
+    };
+    const std::vector<Case> cases = {
+        {"one day", {"RunDate=2025-03-01"}},
+        {"month+files", {"RunDate=2025-02", "TotalFiles>=1000"}},
+        {"duration", {"Duration<0:10:05", "Machine=NODE32"}},
+        {"errors", {"Errors~tile 12"}},
+        {"logpath", {"LogPath=\\\\fileserver\\logs\\run_" + std::to_string(n / 2) + ".log"}},
+    };
+    std::printf("rows %ld\n", n);
+    bool same = true;
+    for (const auto &c : cases) {
+        excel::Query q;
+        for (const auto &w : c.where) {
+            excel::QueryPredicate p;
+            excel::parse_query_predicate(w, p);
+            q.where.push_back(p);
+        }
+        q.columns = {"LogPath"};
+        std::string error;
+        excel::QueryStats store, scan;
+        std::size_t bytesStore = 0, bytesScan = 0;
+        const double tStore = time_ms([&] {
+            excel::query_master(dir.string(), q, [&](auto cells) { bytesStore += cells[0].size(); }, store, error);
+        });
+        const double tScan = time_ms([&] {
+            excel::query_master(plain.string(), q, [&](auto cells) { bytesScan += cells[0].size(); }, scan, error);
+        });
+        same &= store.matches == scan.matches && bytesStore == bytesScan;
+        std::printf("%-12s %7zu rows  %-5s %8.2f ms (%zu/%zu segments skipped)  scan %8.1f ms  speedup %6.1fx\n", c.name,
+                    store.matches, store.plan, tStore, store.skipped, store.segments, tScan, tScan / tStore);
+    }
+    std::printf("%s\n", same ? "match" : "MISMATCH");
+    fs::remove_all(dir);
+    return same ? 0 : 1;
+}
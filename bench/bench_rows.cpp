@@ -0,0 +1,177 @@
+// Memory per master row, an aggregate and a group-by over the master: all-text
+// rows (as unify produced before the typed model) vs typed parsed rows with
+// interned categorical values, read through UnifiedRow views.
+// Usage: bench_rows [rows]
+#include "single_sheet_writer.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Heap bytes requested since start, for the memory figures
+static std::atomic<std::size_t> g_heap{0};
+
+void *operator new(std::size_t n) {
+    g_heap += n;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Every master column as text, in header order
+using TextRow = std::array<std::string, 43>;
+enum Col { kTool = 1, kEndTime = 5, kDuration = 6, kMachine = 19, kTotalSize = 24, kSuccess = 38 };
+
+static TextRow as_text(const excel::UnifiedRow &u) {
+    char stamp[32];
+    return {u.ProjectName(), to_text(u.Tool()), u.DatasetName(), to_text(u.BuildID()),
+            to_text(u.StartTime()), to_text(u.EndTime()), to_text(u.Duration()), date_text(u.RunDate()),
+            to_text(u.ProcessPreset()), to_text(u.ExportType()), to_text(u.SelAreaSize()), to_text(u.Resolution()), to_text(u.TileScheme()),
+            to_text(u.PhotosUsed()), u.PhotoFolders(), to_text(u.PhotoCoverage()), to_text(u.FusersUsed()),
+            to_text(u.CPUThreads()), to_text(u.GPUCount()),
+            to_text(u.Machine()), to_text(u.HostIP()), to_text(u.User()),
+            to_text(u.OutputFolder()), to_text(u.TotalFiles()), gb_text(u.TotalSizeGB()),
+            to_text(u.Offset_CoordSys()), to_text(u.Offset_HDatum()), to_text(u.Offset_VDatum()),
+            to_text(u.OffsetX()), to_text(u.OffsetY()), to_text(u.OffsetZ()),
+            to_text(u.PivotCenterX()), to_text(u.PivotCenterY()), to_text(u.PivotCenterZ()),
+            to_text(u.FlipYZ()), to_text(u.Trim()), to_text(u.Collision()), to_text(u.VisualLOD()),
+            to_text(u.Success()), tally_text(u.Warnings()), errors_text(u.Errors(), u.ErrorMessages()), u.LogPath(),
+            std::string(stamp, util::format_stamp(stamp, *u.IngestedAt()))};
+}
+
+struct Totals {
+    double gb = 0;
+    long long seconds = 0;
+    long ok = 0;
+    std::string lastEnd;
+};
+
+int main(int argc, char **argv) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const auto t0 = util::TimePoint(std::chrono::seconds(1755712795));
+
+    // Parsed rows: two PhotoMesh runs for every RealityMesh run
+    std::vector<PhotoMeshRow> pm;
+    std::vector<RealityMeshRow> rm;
+    const std::size_t heap0 = g_heap;
+    pm.reserve(n - n / 3);
+    rm.reserve(n / 3 + 1);
+    auto fill = [&](auto &r, long i) {
+        r.projectName = "Project_" + std::to_string(i % 500);
+        r.startTime = t0 + std::chrono::minutes(i);
+        r.endTime = *r.startTime + std::chrono::seconds(600 + i % 7200);
+        r.duration = std::chrono::duration_cast<std::chrono::seconds>(*r.endTime - *r.startTime);
+        from_text(i % 2 ? "3mx" : "OBJ", r.exportType);
+        from_text("HIGH", r.resolution);
+        from_text("NODE" + std::to_string(i % 64), r.machine);
+        from_text("D:\\Exports\\Project_" + std::to_string(i % 500) + "\\Output", r.outputFolder);
+        r.totalFiles = 20 + i % 1000;
+        r.totalSizeGB = (i % 10000) / 7.0;
+        r.offsetX = 100.5; r.offsetY = 200.25; r.offsetZ = i * 0.5;
+        r.success = i % 17 ? Tri::True : Tri::False;
+        r.warnings = static_cast<std::int32_t>(i % 5);
+        r.logPath = "\\\\fileserver\\logs\\Project_" + std::to_string(i % 500) + "\\run_" + std::to_string(i) + ".log";
+    };
+    for (long i = 0; i < n; ++i) {
+        if (i % 3) {
+            auto &r = pm.emplace_back();
+            fill(r, i);
+            r.photosUsed = 1000 + i % 900;
+            r.fusersUsed = 4;
+        } else {
+            fill(rm.emplace_back(), i);
+        }
+    }
+    const std::size_t parsedHeap = g_heap - heap0;
+
+    // The master and the summary read the parsed rows through views
+    const std::size_t heap1 = g_heap;
+    const auto typed = excel::unify(pm, rm);
+    const std::size_t viewHeap = g_heap - heap1;
+    const double typedBytes = double(parsedHeap + viewHeap) / n;
+
+    std::vector<TextRow> text;
+    const std::size_t heap2 = g_heap;
+    text.reserve(n);
+    for (const auto &u : typed) text.push_back(as_text(u));
+    const double textBytes = double(g_heap - heap2) / n;
+
+    std::printf("row size    text %5zu B  PhotoMesh %zu B  RealityMesh %zu B  view %zu B\n", sizeof(TextRow),
+                sizeof(PhotoMeshRow), sizeof(RealityMeshRow), sizeof(excel::UnifiedRow));
+    std::printf("per row     text %7.0f B  typed %7.0f B  (inline + heap, views %.0f B)  %.1fx smaller\n", textBytes,
+                typedBytes, double(viewHeap) / n, textBytes / typedBytes);
+
+    // Per tool: total size, total duration, successes and latest end
+    std::map<std::string, Totals> byText;
+    const double tText = time_ms([&] {
+        for (const auto &r : text) {
+            auto &t = byText[r[kTool]];
+            if (!r[kTotalSize].empty()) t.gb += std::stod(r[kTotalSize]);
+            const auto &d = r[kDuration];
+            if (d.size() >= 8) {
+                const auto c1 = d.find(':'), c2 = d.find(':', c1 + 1);
+                t.seconds += std::stoll(d.substr(0, c1)) * 3600 + std::stoll(d.substr(c1 + 1, 2)) * 60 +
+                             std::stoll(d.substr(c2 + 1));
+            }
+            t.ok += r[kSuccess] == "True";
+            if (r[kEndTime] > t.lastEnd) t.lastEnd = r[kEndTime];
+        }
+    });
+
+    struct Typed { double gb = 0; long long seconds = 0; long ok = 0; Instant lastEnd; };
+    std::array<Typed, 3> byKind{};
+    const double tTyped = time_ms([&] {
+        for (const auto &u : typed) {
+            auto &t = byKind[static_cast<int>(u.Tool())];
+            t.gb += u.TotalSizeGB().value_or(0);
+            if (const auto d = u.Duration()) t.seconds += d->count();
+            t.ok += u.Success() == Tri::True;
+            if (const auto end = u.EndTime(); end && (!t.lastEnd || *end > *t.lastEnd)) t.lastEnd = end;
+        }
+    });
+
+    // Text sums round each size to two decimals, so compare at that precision
+    bool same = true;
+    for (auto kind : {LogKind::PhotoMesh, LogKind::RealityMesh}) {
+        const auto &a = byText[to_text(kind)];
+        const auto &b = byKind[static_cast<int>(kind)];
+        same &= std::abs(a.gb - b.gb) < 0.005 * n && a.seconds == b.seconds && a.ok == b.ok &&
+                a.lastEnd == to_text(b.lastEnd);
+    }
+    std::printf("aggregate   text %9.1f ms  typed %8.1f ms  speedup %5.1fx  %s\n", tText, tTyped, tText / tTyped,
+                same ? "match" : "MISMATCH");
+
+    // Rows per machine: hashing the text vs indexing by interned id
+    std::unordered_map<std::string, long> perText;
+    const double tgText = time_ms([&] {
+        for (const auto &r : text) ++perText[r[kMachine]];
+    });
+    std::vector<long> perSym;
+    const double tgSym = time_ms([&] {
+        perSym.assign(util::strings().size(), 0);
+        for (const auto &u : typed) ++perSym[static_cast<std::size_t>(u.Machine())];
+    });
+    bool sameGroups = true;
+    for (const auto &[machine, rows] : perText)
+        sameGroups &= perSym[static_cast<std::size_t>(*util::strings().find(machine))] == rows;
+    std::printf("group-by    text %9.1f ms  ids   %8.1f ms  speedup %5.1fx  %zu machines  %s\n", tgText, tgSym,
+                tgText / tgSym, perText.size(), sameGroups ? "match" : "MISMATCH");
+    std::printf("pool        %zu strings  %zu arena bytes\n", util::strings().size(), util::strings().arena_bytes());
+    return same && sameGroups ? 0 : 1;
+}
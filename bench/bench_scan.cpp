@@ -0,0 +1,54 @@
+// Line + keyword counting: per-line getline/find loop vs the scan kernel.
+// Usage: bench_scan [lines]
+#include "line_reader.hpp"
+#include "scan_kernel.hpp"
+#include "synth_logs.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    const long lines = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const std::string path = (fs::temp_directory_path() / "bench_scan_pm.log").string();
+    synth::write_pm(path, lines);
+
+    constexpr std::string_view kw[] = {"Warning", "Error"};
+    size_t refLines = 0, refWarn = 0, refErr = 0;
+    const double tFind = time_ms([&] {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            ++refLines;
+            if (line.find("Warning") != std::string::npos) refWarn++;
+            if (line.find("Error") != std::string::npos) refErr++;
+        }
+    });
+    std::printf("getline+find  %9.1f ms  lines %zu  warnings %zu  errors %zu\n", tFind, refLines, refWarn, refErr);
+
+    util::MappedFile map(path);
+    bool ok = true;
+    for (auto isa : {util::ScanIsa::Scalar, util::ScanIsa::SSE2, util::ScanIsa::AVX2}) {
+        if (isa > util::scan_isa()) continue;
+        util::LineCounts c;
+        const double t = time_ms([&] { c = util::count_lines(map.data(), kw, isa); });
+        const bool same = c.lines == refLines && c.hits[0] == refWarn && c.hits[1] == refErr;
+        ok &= same;
+        std::printf("kernel %-6s %9.1f ms  speedup %5.1fx  %s\n", util::scan_isa_name(isa), t, tFind / t,
+                    same ? "match" : "MISMATCH");
+    }
+    fs::remove(path);
+    return ok ? 0 : 1;
+}
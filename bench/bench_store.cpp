@@ -0,0 +1,158 @@
+// Master storage: the TSV against the column store for the same rows. Times
+// writing both, a full scan back to cell text, and a one-column scan
+// (LogPath) plus a typed filter (TotalFiles > 500), and reports file sizes.
+// Usage: bench_store [rows]
+#include "column_store.hpp"
+#include "line_reader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const auto t0 = util::TimePoint(std::chrono::seconds(1755712795));
+
+    // Same mix as bench_columns
+    std::vector<PhotoMeshRow> pm;
+    std::vector<RealityMeshRow> rm;
+    auto fill = [&](auto &r, long i) {
+        r.projectName = "Project_" + std::to_string(i % 500);
+        r.startTime = t0 + std::chrono::minutes(i);
+        r.endTime = *r.startTime + std::chrono::seconds(600 + i % 7200);
+        r.duration = std::chrono::duration_cast<std::chrono::seconds>(*r.endTime - *r.startTime);
+        from_text(i % 2 ? "3mx" : "OBJ", r.exportType);
+        from_text("HIGH", r.resolution);
+        from_text("NODE" + std::to_string(i % 64), r.machine);
+        from_text("D:\\Exports\\Project_" + std::to_string(i % 500) + "\\Output", r.outputFolder);
+        from_text("WGS84", r.offsetCoordSys);
+        r.totalFiles = 20 + i % 1000;
+        r.totalSizeGB = (i % 10000) / 7.0;
+        r.offsetX = 100.5; r.offsetY = 200.25; r.offsetZ = i * 0.5;
+        r.flipYZ = Tri::False; r.trim = Tri::True;
+        r.success = i % 17 ? Tri::True : Tri::False;
+        r.warnings = static_cast<std::int32_t>(i % 5);
+        r.logPath = "\\\\fileserver\\logs\\Project_" + std::to_string(i % 500) + "\\run_" + std::to_string(i) + ".log";
+    };
+    for (long i = 0; i < n; ++i) {
+        if (i % 3) {
+            auto &r = pm.emplace_back();
+            fill(r, i);
+            r.photosUsed = 1000 + i % 900;
+            r.fusersUsed = 4;
+            r.cpuThreads = 32;
+        } else {
+            auto &r = rm.emplace_back();
+            fill(r, i);
+            r.datasetName = "Dataset " + std::to_string(i % 50);
+            if (i % 7 == 0) { r.errorCount = 1; r.errors = "Error: tile failed"; }
+        }
+    }
+    const auto rows = excel::unify(pm, rm);
+    std::string text;
+    excel::append_tsv_header(text, excel::kMasterColumns);
+    const std::size_t headerBytes = text.size();
+    for (const auto &u : rows) excel::append_tsv_line(text, excel::kMasterColumns, u);
+
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_bench_store";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string tsv = (dir / "All_Exports.tsv").string();
+    const std::string cols = excel::ColumnStore::path_for(dir.string());
+
+    const double wTsv = time_ms([&] { std::ofstream(tsv, std::ios::binary) << text; });
+    const double wStore = time_ms([&] {
+        std::vector<std::pair<std::string, excel::CellKind>> columns;
+        for (const auto &c : excel::kMasterColumns) columns.emplace_back(std::string(c.name), c.kind);
+        excel::ColumnStore store(cols);
+        store.create(columns);
+        store.append(std::string_view(text).substr(headerBytes), text.size());
+    });
+    text = {};
+
+    constexpr std::size_t kLogPath = excel::column_index(excel::kMasterColumns, "LogPath");
+    constexpr std::size_t kFiles = excel::column_index(excel::kMasterColumns, "TotalFiles");
+
+    // Full scan: every cell's text
+    std::size_t bytesTsv = 0, bytesStore = 0;
+    const double sTsv = time_ms([&] {
+        util::MappedFile f(tsv);
+        std::string_view rest = f.data(), line;
+        util::next_line(rest, line);
+        std::string cell;
+        while (util::next_line(rest, line))
+            for (std::size_t from = 0;;) {
+                const std::size_t tab = line.find('\t', from);
+                cell.assign(line.substr(from, tab == std::string_view::npos ? std::string_view::npos : tab - from));
+                bytesTsv += cell.size();
+                if (tab == std::string_view::npos) break;
+                from = tab + 1;
+            }
+    });
+    const double sStore = time_ms([&] {
+        excel::ColumnStore store(cols);
+        std::string cell;
+        for (std::size_t s = 0; s < store.segments(); ++s)
+            for (std::size_t r = 0; r < store.segment_rows(s); ++r)
+                for (std::size_t c = 0; c < store.columns(); ++c) {
+                    cell.clear();
+                    store.append_cell(cell, s, r, c);
+                    bytesStore += cell.size();
+                }
+    });
+
+    // One column, and a filter on a typed one
+    std::size_t pathsTsv = 0, pathsStore = 0, bigTsv = 0, bigStore = 0;
+    const double cTsv = time_ms([&] {
+        util::MappedFile f(tsv);
+        std::string_view rest = f.data(), line;
+        util::next_line(rest, line);
+        while (util::next_line(rest, line)) {
+            std::string_view files, path;
+            for (std::size_t c = 0, from = 0; c <= kLogPath; ++c) {
+                const std::size_t tab = line.find('\t', from);
+                if (c == kFiles) files = line.substr(from, tab - from);
+                if (c == kLogPath) path = line.substr(from, tab - from);
+                from = tab + 1;
+            }
+            pathsTsv += path.size();
+            bigTsv += std::atoi(std::string(files).c_str()) > 500;
+        }
+    });
+    const double cStore = time_ms([&] {
+        excel::ColumnStore store(cols);
+        std::string cell;
+        for (std::size_t s = 0; s < store.segments(); ++s)
+            for (std::size_t r = 0; r < store.segment_rows(s); ++r) {
+                cell.clear();
+                store.append_cell(cell, s, r, kLogPath);
+                pathsStore += cell.size();
+                cell.clear();
+                store.append_cell(cell, s, r, kFiles);
+                bigStore += std::atoi(cell.c_str()) > 500;
+            }
+    });
+
+    const bool same = bytesTsv == bytesStore && pathsTsv == pathsStore && bigTsv == bigStore;
+    std::printf("rows %ld\n", n);
+    std::printf("size        tsv %9.1f MB  store %8.1f MB\n", fs::file_size(tsv) / 1e6, fs::file_size(cols) / 1e6);
+    std::printf("write       tsv %9.1f ms  store %8.1f ms\n", wTsv, wStore);
+    std::printf("full scan   tsv %9.1f ms  store %8.1f ms  speedup %5.1fx\n", sTsv, sStore, sTsv / sStore);
+    std::printf("2 columns   tsv %9.1f ms  store %8.1f ms  speedup %5.1fx  %s\n", cTsv, cStore, cTsv / cStore,
+                same ? "match" : "MISMATCH");
+    fs::remove_all(dir);
+    return same ? 0 : 1;
+}
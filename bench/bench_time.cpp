@@ -0,0 +1,76 @@
+// Timestamp/duration/size helpers: get_time + regex + ostringstream versions
+// vs the hand-written parsers in util_time.
+// Usage: bench_time [values]
+#include "legacy_util_time.hpp"
+#include "util_time.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void report(const char *what, double tOld, double tNew, bool same) {
+    std::printf("%-12s old %9.1f ms  new %8.1f ms  speedup %6.1fx  %s\n", what, tOld, tNew, tOld / tNew,
+                same ? "match" : "MISMATCH");
+}
+
+int main(int argc, char **argv) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 200000;
+    std::vector<std::string> stamps, sizes;
+    stamps.reserve(n);
+    sizes.reserve(n);
+    for (long i = 0; i < n; ++i) {
+        char buf[64];
+        // Mostly ISO with 'Z', like PhotoMesh MsgTime, with some of the other layouts mixed in
+        if (i % 10 == 9)
+            std::snprintf(buf, sizeof buf, "%02ld/%02ld/2025 %02ld:%02ld:%02ld", 1 + i % 12, 1 + i % 28, i % 24, i % 60, (i / 7) % 60);
+        else
+            std::snprintf(buf, sizeof buf, "2025-%02ld-%02ldT%02ld:%02ld:%02ldZ", 1 + i % 12, 1 + i % 28, i % 24, i % 60, (i / 7) % 60);
+        stamps.push_back(buf);
+        static const char *units[] = {"B", "KB", "MB", "GB"};
+        std::snprintf(buf, sizeof buf, "Size %ld.%02ld %s", i % 5000, i % 100, units[i % 4]);
+        sizes.push_back(buf);
+    }
+
+    bool ok = true;
+    long long sumOld = 0, sumNew = 0;
+    const double tpOld = time_ms([&] {
+        for (const auto &s : stamps) sumOld += legacy::parse_time(s)->time_since_epoch().count();
+    });
+    const double tpNew = time_ms([&] {
+        util::TimeParser parse;
+        for (const auto &s : stamps) sumNew += parse(s)->time_since_epoch().count();
+    });
+    ok &= sumOld == sumNew;
+    report("parse_time", tpOld, tpNew, sumOld == sumNew);
+
+    std::vector<std::string_view> views(stamps.begin(), stamps.end());
+    std::vector<std::optional<util::TimePoint>> out(views.size());
+    long long sumBatch = 0;
+    const double tBatch = time_ms([&] { util::parse_times(views, out); });
+    for (const auto &t : out) sumBatch += t->time_since_epoch().count();
+    ok &= sumOld == sumBatch;
+    report("parse_times", tpOld, tBatch, sumOld == sumBatch);
+
+    size_t lenOld = 0, lenNew = 0;
+    const double thOld = time_ms([&] { for (long i = 0; i < n; ++i) lenOld += legacy::seconds_to_hhmmss(i * 37).size(); });
+    const double thNew = time_ms([&] { for (long i = 0; i < n; ++i) lenNew += util::seconds_to_hhmmss(i * 37).size(); });
+    ok &= lenOld == lenNew;
+    report("hhmmss", thOld, thNew, lenOld == lenNew);
+
+    std::string catOld, catNew;
+    const double tsOld = time_ms([&] { for (const auto &s : sizes) catOld += legacy::size_to_gb(s); });
+    const double tsNew = time_ms([&] { for (const auto &s : sizes) catNew += util::size_to_gb(s); });
+    ok &= catOld == catNew;
+    report("size_to_gb", tsOld, tsNew, catOld == catNew);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Reading the master TSV: the previous std::getline + split_tsv loop (a
+// std::string per cell, a vector per line) against util::TsvReader, with all
+// fields and with only LogPath projected, on each SIMD path.
+// Usage: bench_tsv [rows]
+#include "columns.hpp"
+#include "line_reader.hpp"
+#include "scan_kernel.hpp"
+#include "tsv_reader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+namespace legacy {
+
+// The splitter the master loader used before
+inline std::vector<std::string> split_tsv(const std::string &line) {
+    std::vector<std::string> out;
+    std::string cur;
+    for (char c : line) {
+        if (c == '\t') { out.push_back(cur); cur.clear(); }
+        else if (c != '\r' && c != '\n') cur.push_back(c);
+    }
+    out.push_back(cur);
+    return out;
+}
+
+} // namespace legacy
+
+int main(int argc, char **argv) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 500000;
+    const auto t0 = util::TimePoint(std::chrono::seconds(1755712795));
+
+    // Same mix as bench_columns
+    std::vector<PhotoMeshRow> pm;
+    std::vector<RealityMeshRow> rm;
+    auto fill = [&](auto &r, long i) {
+        r.projectName = "Project_" + std::to_string(i % 500);
+        r.startTime = t0 + std::chrono::minutes(i);
+        r.endTime = *r.startTime + std::chrono::seconds(600 + i % 7200);
+        r.duration = std::chrono::duration_cast<std::chrono::seconds>(*r.endTime - *r.startTime);
+        from_text(i % 2 ? "3mx" : "OBJ", r.exportType);
+        from_text("HIGH", r.resolution);
+        from_text("NODE" + std::to_string(i % 64), r.machine);
+        from_text("D:\\Exports\\Project_" + std::to_string(i % 500) + "\\Output", r.outputFolder);
+        from_text("WGS84", r.offsetCoordSys);
+        r.totalFiles = 20 + i % 1000;
+        r.totalSizeGB = (i % 10000) / 7.0;
+        r.offsetX = 100.5; r.offsetY = 200.25; r.offsetZ = i * 0.5;
+        r.flipYZ = Tri::False; r.trim = Tri::True;
+        r.success = i % 17 ? Tri::True : Tri::False;
+        r.warnings = static_cast<std::int32_t>(i % 5);
+        r.logPath = "\\\\fileserver\\logs\\Project_" + std::to_string(i % 500) + "\\run_" + std::to_string(i) + ".log";
+    };
+    for (long i = 0; i < n; ++i) {
+        if (i % 3) {
+            auto &r = pm.emplace_back();
+            fill(r, i);
+            r.photosUsed = 1000 + i % 900;
+            r.fusersUsed = 4;
+            r.cpuThreads = 32;
+        } else {
+            auto &r = rm.emplace_back();
+            fill(r, i);
+            r.datasetName = "Dataset " + std::to_string(i % 50);
+            if (i % 7 == 0) { r.errorCount = 1; r.errors = "Error: tile failed"; }
+        }
+    }
+    const auto rows = excel::unify(pm, rm);
+    std::string text;
+    excel::append_tsv_header(text, excel::kMasterColumns);
+    for (const auto &u : rows) excel::append_tsv_line(text, excel::kMasterColumns, u);
+
+    const fs::path path = fs::temp_directory_path() / "bench_tsv_All_Exports.tsv";
+    std::ofstream(path, std::ios::binary) << text;
+    text = {};
+    constexpr std::size_t kLogPath = excel::column_index(excel::kMasterColumns, "LogPath");
+
+    // Checksums: fields seen and their bytes; LogPath bytes
+    std::size_t refFields = 0, refBytes = 0, refPaths = 0;
+    const double tSplit = time_ms([&] {
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto cells = legacy::split_tsv(line);
+            refFields += cells.size();
+            for (const auto &c : cells) refBytes += c.size();
+        }
+    });
+    const double tSplitPath = time_ms([&] {
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto cells = legacy::split_tsv(line);
+            if (cells.size() > kLogPath) refPaths += cells[kLogPath].size();
+        }
+    });
+    std::printf("rows %ld, %.1f MB\n", n, fs::file_size(path) / 1e6);
+    std::printf("getline+split_tsv  all     %9.1f ms\n", tSplit);
+    std::printf("getline+split_tsv  LogPath %9.1f ms\n", tSplitPath);
+
+    util::MappedFile map(path.string());
+    util::count_lines(map.data(), {});  // faults the mapping in before any timing
+    bool ok = true;
+    for (auto isa : {util::ScanIsa::Scalar, util::ScanIsa::SSE2, util::ScanIsa::AVX2}) {
+        if (isa > util::scan_isa()) continue;
+        std::size_t fields = 0, bytes = 0, paths = 0;
+        const double tAll = time_ms([&] {
+            util::TsvReader reader(map.data(), isa);
+            while (reader.next()) {
+                fields += reader.fields().size();
+                for (const auto f : reader.fields()) bytes += f.size();
+            }
+        });
+        const double tPath = time_ms([&] {
+            util::TsvReader reader(map.data(), isa);
+            const std::size_t project[] = {kLogPath};
+            reader.project(project);
+            while (reader.next()) paths += reader.fields()[0].size();
+        });
+        const bool same = fields == refFields && bytes == refBytes && paths == refPaths;
+        ok &= same;
+        std::printf("reader %-6s     all     %9.1f ms  speedup %5.1fx\n", util::scan_isa_name(isa), tAll, tSplit / tAll);
+        std::printf("reader %-6s     LogPath %9.1f ms  speedup %5.1fx  %s\n", util::scan_isa_name(isa), tPath,
+                    tSplitPath / tPath, same ? "match" : "MISMATCH");
+    }
+    fs::remove(path);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Master workbook cells: every cell as a shared string (the previous writer)
+// against typed cells (numbers, date-times, durations, booleans with shared
+// number formats), for the same master TSV, then the native writer for the
+// same typed workbook on 1 to N threads. Reports write time and file size.
+// Usage: bench_workbook [rows] [max-threads]
+#include "columns.hpp"
+#include "line_reader.hpp"
+#include "native_xlsx.hpp"
+#include "single_sheet_writer.hpp"
+#include "thread_pool.hpp"
+#include "tsv_reader.hpp"
+#include "util_time.hpp"
+
+#include <xlsxwriter.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+template <class F>
+static double time_ms(F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static double size_mb(const fs::path &p) {
+    std::error_code ec;
+    const auto n = fs::file_size(p, ec);
+    return ec ? 0.0 : n / 1e6;
+}
+
+int main(int argc, char **argv) {
+    using excel::column_index;
+    using excel::kMasterColumns;
+    const long n = argc > 1 ? std::atol(argv[1]) : 200000;
+    const unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : util::resolve_jobs(0);
+
+    std::string text;
+    excel::append_tsv_header(text, kMasterColumns);
+    std::vector<std::string> cells(kMasterColumns.size());
+    const auto t0 = util::TimePoint(std::chrono::seconds(1735689600));
+    char buf[40];
+    for (long i = 0; i < n; ++i) {
+        const auto start = t0 + std::chrono::minutes(i);
+        cells[column_index(kMasterColumns, "ProjectName")] = "Project_" + std::to_string(i % 500);
+        cells[column_index(kMasterColumns, "Tool")] = i % 3 ? "PhotoMesh" : "RealityMesh";
+        cells[column_index(kMasterColumns, "StartTime")] = std::string(buf, util::format_time(buf, start));
+        cells[column_index(kMasterColumns, "EndTime")] =
+            std::string(buf, util::format_time(buf, start + std::chrono::seconds(600 + i % 7200)));
+        cells[column_index(kMasterColumns, "Duration(hh:mm:ss)")] = util::seconds_to_hhmmss(static_cast<int>(600 + i % 7200));
+        cells[column_index(kMasterColumns, "RunDate")] = std::string(buf, util::format_date(buf, start));
+        cells[column_index(kMasterColumns, "PhotosUsed")] = std::to_string(1000 + i % 900);
+        cells[column_index(kMasterColumns, "Machine")] = "NODE" + std::to_string(i % 64);
+        cells[column_index(kMasterColumns, "TotalFiles")] = std::to_string(20 + i % 1000);
+        cells[column_index(kMasterColumns, "TotalSize(GB)")] = std::to_string(i % 10000 / 100) + ".50";
+        cells[column_index(kMasterColumns, "OffsetX")] = "100.5";
+        cells[column_index(kMasterColumns, "OffsetZ")] = std::to_string(i / 2) + (i % 2 ? ".5" : "");
+        cells[column_index(kMasterColumns, "Success")] = i % 17 ? "True" : "False";
+        cells[column_index(kMasterColumns, "Warnings")] = std::to_string(i % 5);
+        cells[column_index(kMasterColumns, "LogPath")] = "\\\\fileserver\\logs\\run_" + std::to_string(i) + ".log";
+        cells[column_index(kMasterColumns, "IngestedAt")] = std::string(buf, util::format_stamp(buf, start));
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            if (c) text.push_back('\t');
+            text += cells[c];
+        }
+        text.push_back('\n');
+    }
+
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_bench_workbook";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path tsv = dir / "All_Exports.tsv", strings = dir / "strings.xlsx", typed = dir / "typed.xlsx";
+    std::ofstream(tsv, std::ios::binary) << text;
+
+    const double tStrings = time_ms([&] {
+        util::MappedFile f(tsv.string());
+        util::TsvReader reader(f.data());
+        lxw_workbook_options options{};
+        options.constant_memory = LXW_TRUE;
+        lxw_workbook *wb = workbook_new_opt(strings.string().c_str(), &options);
+        lxw_worksheet *ws = workbook_add_worksheet(wb, "All_Exports");
+        std::string cell;
+        for (lxw_row_t row = 0; reader.next(); ++row) {
+            lxw_col_t col = 0;
+            for (const std::string_view field : reader.fields()) {
+                if (!field.empty()) worksheet_write_string(ws, row, col, cell.assign(field).c_str(), nullptr);
+                ++col;
+            }
+        }
+        workbook_close(wb);
+    });
+    const double tTyped = time_ms([&] { excel::write_tsv_workbook(tsv.string(), typed.string()); });
+
+    std::printf("rows %ld\n", n);
+    std::printf("strings  %9.1f ms  %8.1f MB\n", tStrings, size_mb(strings));
+    std::printf("typed    %9.1f ms  %8.1f MB\n", tTyped, size_mb(typed));
+
+    // The native writer, as the master rebuild drives it, on more and more threads
+    excel::SheetLayout layout;
+    layout.name = "All_Exports";
+    for (const auto &c : kMasterColumns) {
+        layout.headers.emplace_back(c.name);
+        layout.kinds.push_back(c.kind);
+    }
+    layout.table = true;
+    layout.successColumn = static_cast<int>(column_index(kMasterColumns, "Success"));
+    const fs::path native = dir / "native.xlsx";
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        const double t = time_ms([&] {
+            util::MappedFile f(tsv.string());
+            util::TsvReader reader(f.data());
+            reader.next();
+            excel::NativeSheetWriter writer(native.string(), layout, threads);
+            while (reader.next()) writer.add_row(reader.fields());
+            writer.close();
+        });
+        std::printf("native %2u thread(s) %9.1f ms  %8.1f MB\n", threads, t, size_mb(native));
+    }
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+// Synthetic PhotoMesh / RealityMesh logs shared by the benchmarks.
+#include <fstream>
+#include <string>
+
+namespace synth {
+
+inline void write_pm(const std::string &path, long lines) {
+    std::ofstream out(path, std::ios::binary);
+    for (long i = 0; i < lines; ++i) {
+        switch (i % 8) {
+        case 0: out << "[Msg] $$PM__ { \"MachineName\": \"NODE7\", \"MsgTime\": \"2025-08-20T17:"
+                    << (10 + i % 50) << ":00Z\", \"type\": 0, \"Progress\": 10.0 } __$$\n"; break;
+        case 1: out << "SLDEFAULT=> ExportType : 3mx\n"; break;
+        case 2: out << "SLDEFAULT=> TotalSize : " << i << " MB\n"; break;
+        case 3: out << "[Info] Reconstruction tile " << i << " finished, 1423 triangles written to cache\n"; break;
+        case 4: out << "[Warning] tile " << i << " has low overlap\n"; break;
+        default: out << "[Trace] worker " << i % 32 << " idle; queue depth " << i % 97 << "\n"; break;
+        }
+    }
+    out << "Finished with exit code (0)\n";
+}
+
+inline void write_rm(const std::string &path, long lines) {
+    std::ofstream out(path, std::ios::binary);
+    out << "terratoolssh.exe RealityMeshProcess.tcl -command_file \"dataset1.txt\"\n";
+    for (long i = 0; i < lines; ++i) {
+        switch (i % 6) {
+        case 0: out << "Input offset: 1.0 2.0 " << i << ".5\n"; break;
+        case 1: out << "Converted offset: 100.0 200.0 " << i << ".5\n"; break;
+        case 2: if (i % 600 == 2) out << "Error: tile " << i << " skipped\n"; else out << "tile " << i << " ok\n"; break;
+        default: out << "[TT] processing block " << i << " of dataset, elapsed " << i % 3600 << "s\n"; break;
+        }
+    }
+    out << "Process completed with exit code: 0\nTime to run TT project: 4242 seconds\n";
+}
+
+} // namespace synth
@@ -0,0 +1,246 @@
+#include "archive_reader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+namespace util {
+
+namespace {
+
+bool iends_with(std::string_view s, std::string_view suffix) {
+    if (s.size() < suffix.size()) return false;
+    return std::equal(suffix.begin(), suffix.end(), s.end() - suffix.size(),
+                      [](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); });
+}
+
+std::uint64_t le(std::string_view s, std::size_t at, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= std::uint64_t(static_cast<unsigned char>(s[at + i])) << (8 * i);
+    return v;
+}
+
+constexpr std::uint32_t kLocalSig = 0x04034b50;
+constexpr std::uint32_t kCentralSig = 0x02014b50;
+constexpr std::uint32_t kEndSig = 0x06054b50;
+constexpr std::uint32_t kEnd64Sig = 0x06064b50;
+constexpr std::uint32_t kEnd64LocatorSig = 0x07064b50;
+
+} // namespace
+
+bool split_archive_path(const std::string &path, std::string &archive, std::string &entry) {
+    for (std::size_t at = path.find(kArchiveSep); at != std::string::npos; at = path.find(kArchiveSep, at + 1)) {
+        if (iends_with(std::string_view(path).substr(0, at), ".zip")) {
+            archive = path.substr(0, at);
+            entry = path.substr(at + kArchiveSep.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string log_stem(const std::string &path) {
+    std::string archive, entry;
+    std::string name = split_archive_path(path, archive, entry) ? entry : path;
+    if (iends_with(name, ".gz")) name.resize(name.size() - 3);
+    return fs::path(name).stem().string();
+}
+
+std::vector<std::string> expand_archives(const std::vector<std::string> &paths) {
+    std::vector<std::string> out;
+    for (const auto &p : paths) {
+        std::error_code ec;
+        if (!iends_with(p, ".zip") || !fs::is_regular_file(p, ec)) {
+            out.push_back(p);
+            continue;
+        }
+        const auto zip = open_zip(p);  // kept for the readers of its entries
+        if (!zip) continue;
+        for (const auto &e : zip->dir.entries()) {
+            if (e.name.empty() || e.name.back() == '/' || e.encrypted) continue;
+            if (!iends_with(e.name, ".log") && !iends_with(e.name, ".txt")) continue;
+            out.push_back(p + std::string(kArchiveSep) + e.name);
+        }
+    }
+    return out;
+}
+
+// ---------------- ZipDirectory ----------------
+
+ZipDirectory::ZipDirectory(std::string_view zip) : zip_(zip) {
+    if (zip.size() < 22) return;
+    // End of central directory: last 22 bytes plus up to 64 KiB of comment
+    std::size_t end = std::string_view::npos;
+    const std::size_t lowest = zip.size() > 22 + 0xffff ? zip.size() - 22 - 0xffff : 0;
+    for (std::size_t at = zip.size() - 22 + 1; at-- > lowest;)
+        if (le(zip, at, 4) == kEndSig) { end = at; break; }
+    if (end == std::string_view::npos) return;
+
+    std::uint64_t count = le(zip, end + 10, 2);
+    std::uint64_t cdSize = le(zip, end + 12, 4);
+    std::uint64_t cdOffset = le(zip, end + 16, 4);
+    if (end >= 20 && le(zip, end - 20, 4) == kEnd64LocatorSig) {
+        const std::uint64_t at = le(zip, end - 20 + 8, 8);
+        if (at + 56 <= zip.size() && le(zip, at, 4) == kEnd64Sig) {
+            count = le(zip, at + 32, 8);
+            cdSize = le(zip, at + 40, 8);
+            cdOffset = le(zip, at + 48, 8);
+        }
+    }
+    if (cdOffset > zip.size() || cdSize > zip.size() - cdOffset) return;
+
+    std::size_t at = static_cast<std::size_t>(cdOffset);
+    const std::size_t cdEnd = at + static_cast<std::size_t>(cdSize);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (at + 46 > cdEnd || le(zip, at, 4) != kCentralSig) return;
+        const std::size_t nameLen = le(zip, at + 28, 2), extraLen = le(zip, at + 30, 2), commentLen = le(zip, at + 32, 2);
+        if (at + 46 + nameLen + extraLen + commentLen > cdEnd) return;
+        ZipEntry e;
+        e.encrypted = le(zip, at + 8, 2) & 1;
+        e.method = static_cast<std::uint16_t>(le(zip, at + 10, 2));
+        e.compressedSize = le(zip, at + 20, 4);
+        e.size = le(zip, at + 24, 4);
+        e.localHeader = le(zip, at + 42, 4);
+        e.name.assign(zip.substr(at + 46, nameLen));
+
+        // Zip64 extra field: 8-byte values for the fields saturated above, in order
+        for (std::size_t x = at + 46 + nameLen, xEnd = x + extraLen; x + 4 <= xEnd;) {
+            const std::size_t id = le(zip, x, 2), len = le(zip, x + 2, 2);
+            if (x + 4 + len > xEnd) break;  // a field running past the extra area is corrupt
+            std::size_t v = x + 4;
+            if (id == 0x0001) {
+                for (auto *f : {&e.size, &e.compressedSize, &e.localHeader}) {
+                    if (*f != 0xffffffffu || v + 8 > x + 4 + len) continue;
+                    *f = le(zip, v, 8);
+                    v += 8;
+                }
+            }
+            x += 4 + len;
+        }
+        entries_.push_back(std::move(e));
+        at += 46 + nameLen + extraLen + commentLen;
+    }
+    byName_.resize(entries_.size());
+    for (std::uint32_t i = 0; i < byName_.size(); ++i) byName_[i] = i;
+    std::stable_sort(byName_.begin(), byName_.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return entries_[a].name < entries_[b].name; });
+    ok_ = true;
+}
+
+const ZipEntry *ZipDirectory::find(std::string_view name) const {
+    const auto it = std::lower_bound(byName_.begin(), byName_.end(), name,
+                                     [&](std::uint32_t i, std::string_view n) { return entries_[i].name < n; });
+    return it != byName_.end() && entries_[*it].name == name ? &entries_[*it] : nullptr;
+}
+
+std::string_view ZipDirectory::data(const ZipEntry &e) const {
+    const std::uint64_t at = e.localHeader;
+    if (at + 30 > zip_.size() || le(zip_, at, 4) != kLocalSig) return {};
+    const std::uint64_t begin = at + 30 + le(zip_, at + 26, 2) + le(zip_, at + 28, 2);
+    if (begin > zip_.size() || e.compressedSize > zip_.size() - begin) return {};
+    return zip_.substr(static_cast<std::size_t>(begin), static_cast<std::size_t>(e.compressedSize));
+}
+
+// ---------------- ZipArchive ----------------
+
+ZipArchive::ZipArchive(const std::string &path) : map(path), dir(map.data()) {}
+
+std::shared_ptr<const ZipArchive> open_zip(const std::string &path) {
+    constexpr std::size_t kCached = 8;
+    struct Cached {
+        std::string path;
+        std::uint64_t size;
+        fs::file_time_type mtime;
+        std::shared_ptr<const ZipArchive> zip;
+    };
+    static std::mutex m;
+    static std::deque<Cached> cache;  // most recently used last
+
+    std::error_code ec;
+    const fs::directory_entry f(path, ec);
+    const std::uint64_t size = ec ? 0 : f.file_size(ec);
+    const fs::file_time_type mtime = ec ? fs::file_time_type{} : f.last_write_time(ec);
+    if (ec) return nullptr;
+    {
+        std::lock_guard<std::mutex> lk(m);
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->path != path || it->size != size || it->mtime != mtime) continue;
+            Cached hit = std::move(*it);
+            cache.erase(it);
+            cache.push_back(std::move(hit));
+            return cache.back().zip;
+        }
+    }
+    auto zip = std::make_shared<const ZipArchive>(path);
+    if (!zip->map.is_open()) return nullptr;
+    std::lock_guard<std::mutex> lk(m);
+    std::erase_if(cache, [&](const Cached &c) { return c.path == path; });
+    cache.push_back({path, size, mtime, zip});
+    if (cache.size() > kCached) cache.pop_front();
+    return zip;
+}
+
+// ---------------- Inflater ----------------
+
+struct Inflater::Impl {
+    z_stream z{};
+    Format format;
+    std::string_view rest;  // input not yet handed to zlib
+    bool done = false;
+    bool failed = false;
+};
+
+Inflater::Inflater(Format format, std::string_view input) : impl_(std::make_unique<Impl>()) {
+    impl_->format = format;
+    impl_->rest = input;
+    // 16 + 15: gzip wrapper; -15: raw deflate as stored in zip entries
+    if (inflateInit2(&impl_->z, format == Format::Gzip ? 16 + MAX_WBITS : -MAX_WBITS) != Z_OK) {
+        impl_->done = impl_->failed = true;
+    }
+}
+
+Inflater::~Inflater() { inflateEnd(&impl_->z); }
+
+bool Inflater::failed() const { return impl_->failed; }
+
+std::size_t Inflater::read(char *out, std::size_t n) {
+    Impl &s = *impl_;
+    if (s.done) return 0;
+    z_stream &z = s.z;
+    z.next_out = reinterpret_cast<Bytef *>(out);
+    z.avail_out = static_cast<uInt>(std::min<std::size_t>(n, UINT_MAX));
+    const uInt want = z.avail_out;
+    while (z.avail_out) {
+        if (z.avail_in == 0) {
+            if (s.rest.empty()) { s.done = true; break; }  // truncated stream
+            const std::size_t take = std::min<std::size_t>(s.rest.size(), 1u << 30);
+            z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(s.rest.data()));
+            z.avail_in = static_cast<uInt>(take);
+            s.rest.remove_prefix(take);
+        }
+        const int r = inflate(&z, Z_NO_FLUSH);
+        if (r == Z_STREAM_END) {
+            // Concatenated gzip members continue the same text
+            const std::string_view left(reinterpret_cast<const char *>(z.next_in), z.avail_in);
+            if (s.format == Format::Gzip && (is_gzip(left) || (left.empty() && is_gzip(s.rest)))) {
+                inflateReset(&z);
+                continue;
+            }
+            s.done = true;
+            break;
+        }
+        if (r != Z_OK) {
+            s.done = s.failed = true;
+            break;
+        }
+    }
+    return want - z.avail_out;
+}
+
+} // namespace util
@@ -0,0 +1,91 @@
+#pragma once
+#include "line_reader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// Logs inside a zip are addressed as "<archive>.zip!/<entry name>"
+constexpr std::string_view kArchiveSep = "!/";
+
+// Split "job.zip!/a/b.log" into "job.zip" and "a/b.log"; false for other paths
+bool split_archive_path(const std::string &path, std::string &archive, std::string &entry);
+
+// Project name of a log path: the file stem without ".gz", taking the entry
+// name for paths inside an archive
+std::string log_stem(const std::string &path);
+
+// Replace every .zip in `paths` by its .log/.txt entries (in archive order);
+// other paths are kept as they are
+std::vector<std::string> expand_archives(const std::vector<std::string> &paths);
+
+struct ZipEntry {
+    std::string name;
+    std::uint16_t method = 0;         // 0 stored, 8 deflate
+    bool encrypted = false;
+    std::uint64_t compressedSize = 0;
+    std::uint64_t size = 0;
+    std::uint64_t localHeader = 0;    // offset of the local file header
+};
+
+// Central directory of a zip held in memory (usually a mapping), zip64 aware
+class ZipDirectory {
+public:
+    explicit ZipDirectory(std::string_view archive);
+    bool ok() const { return ok_; }
+    const std::vector<ZipEntry> &entries() const { return entries_; }
+    // By name, in O(log n); the first of several entries with one name
+    const ZipEntry *find(std::string_view name) const;
+    // Compressed bytes of an entry; empty if the local header is broken
+    std::string_view data(const ZipEntry &e) const;
+
+private:
+    std::string_view zip_;
+    std::vector<ZipEntry> entries_;
+    std::vector<std::uint32_t> byName_;  // entries_ indices sorted by name
+    bool ok_ = false;
+};
+
+// A zip mapped once with its directory read once
+struct ZipArchive {
+    explicit ZipArchive(const std::string &path);
+    MappedFile map;
+    ZipDirectory dir;
+};
+
+// The zip at `path`, shared with every other reader of its entries: the last
+// few archives opened stay cached while their size and mtime are unchanged,
+// so reading all N logs of an archive parses its directory once, not N
+// times. Null if it cannot be opened.
+std::shared_ptr<const ZipArchive> open_zip(const std::string &path);
+
+// Streaming zlib inflate of an in-memory gzip file (all members) or of a raw
+// deflate stream from a zip entry. Corrupt or truncated input ends the stream.
+class Inflater {
+public:
+    enum class Format { Gzip, RawDeflate };
+    Inflater(Format format, std::string_view input);
+    ~Inflater();
+    Inflater(const Inflater &) = delete;
+    Inflater &operator=(const Inflater &) = delete;
+
+    // Up to n decompressed bytes; 0 once the stream has ended
+    std::size_t read(char *out, std::size_t n);
+    bool failed() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+inline bool is_gzip(std::string_view bytes) {
+    return bytes.size() >= 2 && static_cast<unsigned char>(bytes[0]) == 0x1f &&
+           static_cast<unsigned char>(bytes[1]) == 0x8b;
+}
+
+} // namespace util
@@ -0,0 +1,79 @@
+#include "cell_writer.hpp"
+#include "column_store.hpp"
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace excel {
+
+namespace {
+
+lxw_format *number_format(lxw_workbook *wb, const char *spec) {
+    lxw_format *f = workbook_add_format(wb);
+    format_set_num_format(f, spec);
+    return f;
+}
+
+// Nanoseconds since the epoch (UTC) as Excel's broken-down date-time
+lxw_datetime datetime_of(std::int64_t ns) {
+    using namespace std::chrono;
+    const sys_time<nanoseconds> t{nanoseconds(ns)};
+    const auto day = floor<days>(t);
+    const year_month_day ymd(day);
+    const hh_mm_ss<nanoseconds> hms(t - day);
+    lxw_datetime dt{};
+    dt.year = static_cast<int>(ymd.year());
+    dt.month = static_cast<int>(static_cast<unsigned>(ymd.month()));
+    dt.day = static_cast<int>(static_cast<unsigned>(ymd.day()));
+    dt.hour = static_cast<int>(hms.hours().count());
+    dt.min = static_cast<int>(hms.minutes().count());
+    dt.sec = static_cast<double>(hms.seconds().count()) + static_cast<double>(hms.subseconds().count()) / 1e9;
+    return dt;
+}
+
+} // namespace
+
+CellWriter::CellWriter(lxw_workbook *wb)
+    : fixed2_(number_format(wb, "0.00")),
+      date_(number_format(wb, "yyyy-mm-dd")),
+      time_(number_format(wb, "yyyy-mm-dd hh:mm:ss")),
+      duration_(number_format(wb, "[h]:mm:ss")) {}
+
+void CellWriter::write(lxw_worksheet *ws, lxw_row_t row, lxw_col_t col, CellKind kind, std::string_view text) {
+    if (text.empty()) return;
+    std::uint64_t bits = 0;
+    const auto i = [&] { return static_cast<double>(static_cast<std::int64_t>(bits)); };
+    if (kind == CellKind::Bool) {
+        if (text == "True" || text == "False") {
+            worksheet_write_boolean(ws, row, col, text == "True", nullptr);
+            return;
+        }
+    } else if (kind != CellKind::Text && ColumnStore::value_of(kind, text, bits)) {
+        switch (kind) {
+        case CellKind::Int: worksheet_write_number(ws, row, col, i(), nullptr); return;
+        case CellKind::Real: {
+            const double v = std::bit_cast<double>(bits);
+            if (!std::isfinite(v)) break;  // no such number in a workbook
+            worksheet_write_number(ws, row, col, v, nullptr);
+            return;
+        }
+        case CellKind::Fixed2: worksheet_write_number(ws, row, col, i() / 100, fixed2_); return;
+        case CellKind::Duration: worksheet_write_number(ws, row, col, i() / 86400, duration_); return;
+        case CellKind::Time:
+        case CellKind::Stamp:
+        case CellKind::Date: {
+            lxw_datetime dt = datetime_of(static_cast<std::int64_t>(bits));
+            if (dt.year < 1900) break;  // before Excel's calendar
+            worksheet_write_datetime(ws, row, col, &dt, kind == CellKind::Date ? date_ : time_);
+            return;
+        }
+        case CellKind::Text:
+        case CellKind::Bool: break;
+        }
+    }
+    worksheet_write_string(ws, row, col, cell_.assign(text).c_str(), nullptr);
+}
+
+} // namespace excel
@@ -0,0 +1,28 @@
+#pragma once
+#include "columns.hpp"
+
+#include <string>
+#include <string_view>
+#include <xlsxwriter.h>
+
+namespace excel {
+
+// Writes workbook cells by column kind: counts, sizes and offsets as numbers,
+// times and dates as Excel date-times, durations as day fractions shown as
+// [h]:mm:ss, flags as booleans, and text (or a typed cell that does not read
+// as its kind) as a string. Typed cells stay out of the shared-strings table,
+// and Excel sorts, filters and charts them as values. Each number format is
+// added to the workbook once and shared by every cell that uses it.
+class CellWriter {
+public:
+    explicit CellWriter(lxw_workbook *wb);
+
+    // `text` is the cell as the TSV holds it; an empty one is left blank
+    void write(lxw_worksheet *ws, lxw_row_t row, lxw_col_t col, CellKind kind, std::string_view text);
+
+private:
+    lxw_format *fixed2_, *date_, *time_, *duration_;
+    std::string cell_;  // NUL-terminated copy for string writes
+};
+
+} // namespace excel
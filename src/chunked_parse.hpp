@@ -0,0 +1,204 @@
+#pragma once
+#include "content_hash.hpp"
+#include "line_reader.hpp"
+#include "parse_state.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ParseOptions {
+    unsigned threads = 1;                   // >1 splits large mapped files into chunks
+    std::size_t chunkBytes = 64u << 20;     // smallest chunk worth a thread
+};
+
+// Feed a buffer of whole lines into a State. Buffers larger than one chunk are
+// split at newline boundaries and parsed on several threads; the partial
+// states are merged in file order, so the result equals a sequential pass.
+// State needs feed(std::string_view wholeLines) and merge(const State &later).
+template <class State>
+State parse_buffer(std::string_view buf, const ParseOptions &opt) {
+    if (opt.threads > 1 && buf.size() >= 2 * opt.chunkBytes) {
+        const auto chunks = util::split_chunks(buf, opt.threads, opt.chunkBytes);
+        std::vector<State> parts(chunks.size());
+        util::parallel_for(chunks.size(), opt.threads, [&](std::size_t i) { parts[i].feed(chunks[i]); });
+        for (std::size_t i = 1; i < parts.size(); ++i) parts[0].merge(parts[i]);
+        return std::move(parts[0]);
+    }
+    State s;
+    if (!buf.empty()) s.feed(buf);
+    return s;
+}
+
+// Feed all of `in` into a State; mapped files go through parse_buffer.
+template <class State>
+State parse_lines(util::LineReader &in, const ParseOptions &opt) {
+    if (in.is_mapped()) return parse_buffer<State>(in.mapped(), opt);
+    State s;
+    std::string_view block;
+    while (in.next_block(block)) s.feed(block);
+    return s;
+}
+
+namespace detail {
+
+template <class State>
+bool restore(const TailEntry &tail, State &s) {
+    util::StateReader r(tail.state);
+    if (s.load(r) && r.done()) return true;
+    s = State{};
+    return false;
+}
+
+} // namespace detail
+
+// Like parse_lines, but starts from the state saved in `tail` when the file
+// still begins with the bytes it was saved from, and updates `tail` to cover
+// every whole line now in the file. A partial last line (still being written)
+// is parsed into the result but only kept as raw bytes in `tail`. Compressed
+// logs have no resume point: they are parsed in full and `tail` only caches
+// the result.
+// State additionally needs save(util::StateWriter &) and bool load(util::StateReader &).
+template <class State>
+State parse_resumable(util::LineReader &in, const ParseOptions &opt, TailEntry &tail,
+                      const util::FileStamp &stamp) {
+    if (!in.is_mapped()) {
+        State s;
+        util::ContentHash hash;
+        std::string partial;
+        std::string_view block;
+        while (in.next_block(block)) {
+            hash.update(block);
+            const std::size_t whole = block.rfind('\n') + 1;  // only the last block can end mid-line
+            s.feed(block.substr(0, whole));
+            partial.assign(block.substr(whole));
+        }
+        tail = {};
+        util::StateWriter w;
+        s.save(w);
+        tail.state = w.bytes();
+        tail.partial = partial;
+        tail.contentHash = hash.digest();
+        tail.stamp = {stamp.size, util::mtime_settled(stamp.mtime) ? stamp.mtime : 0};
+        if (!partial.empty()) s.feed(partial);
+        return s;
+    }
+    const std::size_t size = in.mapped().size();  // as mapped when opened
+    State s;
+    util::ContentHash hash;
+
+    // Resume with pread: only the fingerprint windows and the bytes after the
+    // saved offset are read, none of the mapped pages already parsed
+    std::size_t from = 0, base = 0;
+    std::string head, read;
+    if (tail.offset > 0 && tail.offset <= size) {
+        from = static_cast<std::size_t>(tail.offset);
+        base = from - std::min(from, util::kFingerprintWindow);
+        head = in.read_at(0, std::min(from, util::kFingerprintWindow));
+        read = in.read_at(base, size - base);
+        util::StateReader r(tail.hashState);
+        if (read.size() != size - base ||
+            util::prefix_fingerprint(head, std::string_view(read).substr(0, from - base), from) != tail.fingerprint ||
+            !hash.load(r) || !r.done() || !detail::restore(tail, s)) {
+            hash = {};
+            from = base = 0;
+        }
+    }
+
+    // From byte `base` of the file: the bytes read above, or the whole mapping
+    const std::string_view text = from ? std::string_view(read) : in.mapped();
+    const std::string_view rest = text.substr(from - base);
+    const std::size_t whole = rest.rfind('\n') + 1;  // 0 when no '\n'
+    if (from == 0) s = parse_buffer<State>(rest.substr(0, whole), opt);
+    else s.merge(parse_buffer<State>(rest.substr(0, whole), opt));
+    hash.update(rest.substr(0, whole));
+
+    tail.offset = from + whole;
+    tail.fingerprint =
+        util::prefix_fingerprint(from ? std::string_view(head) : text, text.substr(0, tail.offset - base), tail.offset);
+    util::StateWriter w;
+    s.save(w);
+    tail.state = w.bytes();
+    util::StateWriter hw;
+    hash.save(hw);
+    tail.hashState = hw.bytes();
+    tail.partial = rest.substr(whole);
+    hash.update(tail.partial);
+    tail.contentHash = hash.digest();
+    tail.stamp = {stamp.size, util::mtime_settled(stamp.mtime) ? stamp.mtime : 0};
+
+    if (!tail.partial.empty()) s.feed(tail.partial);
+    return s;
+}
+
+// A log opened once. The stamp is taken before opening, so bytes appended
+// while it is parsed are never mistaken for content the saved state covers.
+struct OpenLog {
+    OpenLog(const std::string &path, std::optional<util::FileStamp> stampBeforeOpen)
+        : path(path), stamp(stampBeforeOpen), in(path) {}
+
+    std::string path;
+    std::optional<util::FileStamp> stamp;
+    util::LineReader in;
+};
+
+// Saved state of a log whose size and settled mtime still match `tail`,
+// with its partial line replayed; nullopt when the file must be read
+template <class State>
+std::optional<State> replay_unchanged(const TailEntry &tail, const std::optional<util::FileStamp> &stamp) {
+    State s;
+    if (!stamp || !tail.stamp.mtime || stamp->size != tail.stamp.size || stamp->mtime != tail.stamp.mtime ||
+        !detail::restore(tail, s))
+        return std::nullopt;
+    if (!tail.partial.empty()) s.feed(tail.partial);
+    return s;
+}
+
+namespace detail {
+
+template <class State>
+std::optional<State> parse_opened(OpenLog &log, const ParseOptions &opt, TailEntry *tail) {
+    if (!log.in.is_open()) {
+        if (tail) *tail = {};
+        return std::nullopt;
+    }
+    if (!tail || !log.stamp) {
+        if (tail) *tail = {};
+        return parse_lines<State>(log.in, opt);
+    }
+    return parse_resumable<State>(log.in, opt, *tail, *log.stamp);
+}
+
+} // namespace detail
+
+// Parse an opened log (see parse_resumable); nullopt if it is not readable.
+// Without a stamp, `tail` is cleared instead of updated. A log truncated
+// (rotated) while it was read is read once more as it is now.
+template <class State>
+std::optional<State> parse_open(OpenLog &log, const ParseOptions &opt, TailEntry *tail) {
+    std::optional<State> s = detail::parse_opened<State>(log, opt, tail);
+    if (!log.in.truncated()) return s;
+    if (tail) *tail = {};
+    OpenLog again(log.path, log.stamp ? util::file_stamp(log.path) : std::nullopt);
+    s = detail::parse_opened<State>(again, opt, tail);
+    if (again.in.truncated() && tail) *tail = {};
+    return s;
+}
+
+// Parse one log into a State; nullopt if it cannot be opened. With `tail`, a
+// file whose size and settled mtime match the saved entry is not opened at
+// all: the saved state and partial line are replayed.
+template <class State>
+std::optional<State> parse_log(const std::string &path, const ParseOptions &opt, TailEntry *tail) {
+    std::optional<util::FileStamp> stamp;
+    if (tail) {
+        stamp = util::file_stamp(path);
+        if (auto s = replay_unchanged<State>(*tail, stamp)) return s;
+    }
+    OpenLog log(path, stamp);
+    return parse_open<State>(log, opt, tail);
+}
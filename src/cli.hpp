@@ -1,11 +1,22 @@
 #pragma once
+#include <cstddef>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
 struct Options {
     std::vector<std::string> photomeshLogs;
     std::vector<std::string> realitymeshLogs;
+    std::vector<std::string> detectLogs; // bare paths (drag & drop); format sniffed from content
     std::string output = "Photomesh_RealityMesh_LogReport.xlsx";
+    unsigned jobs = 0; // parser threads; 0 = hardware concurrency
+    bool fullParse = false; // ignore saved parse offsets and read every log from the start
+    bool dedupeContent = false; // keep copies of an already-ingested log out of the master
+    std::string partitionMaster = "none"; // master workbook per "month" / "project", or one ("none")
+    std::string sortMaster; // master workbook row order, e.g. "RunDate,Machine"; ingestion order when empty
+    std::size_t memoryLimitMB = 256; // memory the master sort may hold before spilling runs to disk
+    std::string xlsxBackend = "libxlsxwriter"; // master workbook writer: "libxlsxwriter" or "native"
+    unsigned shardIndex = 0, shardCount = 0; // --shard i/N: ingest only shard i of N (by path hash); 0 = all
 };
 
 inline Options parse_cli(int argc, char **argv) {
@@ -22,6 +33,40 @@ inline Options parse_cli(int argc, char **argv) {
             }
         } else if (a == "-o" || a == "--output") {
             if (i + 1 < argc) opt.output = argv[++i];
+        } else if (a == "-j" || a == "--jobs") {
+            if (i + 1 < argc) opt.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (a == "--full-parse") {
+            opt.fullParse = true;
+        } else if (a == "--dedupe-content") {
+            opt.dedupeContent = true;
+        } else if (a == "--partition-master") {
+            if (i + 1 < argc) opt.partitionMaster = argv[++i];
+        } else if (a == "--sort-master") {
+            if (i + 1 < argc) opt.sortMaster = argv[++i];
+        } else if (a == "--xlsx-backend") {
+            if (i + 1 < argc) opt.xlsxBackend = argv[++i];
+        } else if (a == "--memory-limit") {
+            if (i + 1 < argc) opt.memoryLimitMB = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (a == "--shard") {
+            // "i/N"; a malformed value leaves shardCount 0 for the caller to reject
+            if (i + 1 < argc) {
+                char *end = nullptr;
+                const char *v = argv[++i];
+                const unsigned long index = std::strtoul(v, &end, 10);
+                if (end != v && *end == '/') {
+                    const char *n = end + 1;
+                    const unsigned long count = std::strtoul(n, &end, 10);
+                    if (end != n && *end == '\0' && index < count) {
+                        opt.shardIndex = static_cast<unsigned>(index);
+                        opt.shardCount = static_cast<unsigned>(count);
+                    }
+                }
+                if (!opt.shardCount) opt.shardIndex = ~0u;
+            }
+        } else if (a == "--outputs-dir") {
+            ++i; // value read by the caller
+        } else if (!a.empty() && a[0] != '-') {
+            opt.detectLogs.push_back(a);
         }
     }
     return opt;
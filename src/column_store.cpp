@@ -0,0 +1,779 @@
+#include "column_store.hpp"
+#include "content_hash.hpp"
+#include "file_lock.hpp"
+#include "util_time.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+namespace fs = std::filesystem;
+
+namespace excel {
+
+namespace {
+
+// File layout, native-endian 64-bit words, every part 8-byte aligned:
+//   header:  magic (4 words), columns, then per column its kind, name length
+//            and name
+//   segment: magic, rows, bytes, columns, XXH64 of the rest; per column its
+//            encoding, block offset and block bytes; then the blocks:
+//            typed: presence bitmap, base, scale, width, packed values
+//            dictionary: entries, text bytes, code width, offset width,
+//            packed offsets, packed codes, text
+//   footer:  magic, segments, export bytes; per segment its offset and rows,
+//            then per column the zone map (empty, min, max, min and max text)
+//   trailer: footer offset, footer bytes, XXH64 of the footer, magic
+constexpr char kMagic[32] = "logtoExcel column store v1";
+constexpr std::uint64_t kSegmentMagic = 0x31544e454d474553ull;  // "SEGMENT1"
+constexpr std::uint64_t kFooterMagic = 0x31524554544f4f46ull;   // "FOOTER1"
+constexpr std::uint64_t kTrailerMagic = 0x31524c4941525431ull;
+constexpr std::size_t kSegmentHeaderWords = 5;
+constexpr std::size_t kTrailerBytes = 32;
+
+enum Encoding : std::uint64_t { kDictionary = 0, kTyped = 1 };
+
+std::uint64_t word_at(std::string_view bytes, std::uint64_t at) {
+    std::uint64_t w;
+    std::memcpy(&w, bytes.data() + at, sizeof w);
+    return w;
+}
+
+void put(std::string &out, std::uint64_t w) { out.append(reinterpret_cast<const char *>(&w), sizeof w); }
+
+void put_text(std::string &out, std::string_view s) {
+    out.append(s);
+    out.append((8 - s.size() % 8) % 8, '\0');
+}
+
+void patch(std::string &out, std::size_t at, std::uint64_t w) { std::memcpy(out.data() + at, &w, sizeof w); }
+
+std::uint64_t padded(std::uint64_t n) { return (n + 7) / 8 * 8; }
+
+// Bounds-checked reads through the header and footer
+struct Cursor {
+    std::string_view bytes;
+    std::uint64_t at = 0;
+    bool ok = true;
+
+    std::uint64_t u64() {
+        if (!ok || at > bytes.size() || bytes.size() - at < 8) { ok = false; return 0; }
+        const std::uint64_t w = word_at(bytes, at);
+        at += 8;
+        return w;
+    }
+    std::string_view text(std::uint64_t n) {
+        if (!ok || n > bytes.size() - at) { ok = false; return {}; }
+        const std::string_view s = bytes.substr(static_cast<std::size_t>(at), static_cast<std::size_t>(n));
+        at += padded(n);
+        if (at > bytes.size()) ok = false;
+        return s;
+    }
+};
+
+using Nanos = std::chrono::nanoseconds;
+
+std::uint64_t time_bits(util::TimePoint t) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<Nanos>(t.time_since_epoch()).count());
+}
+
+util::TimePoint time_of(std::uint64_t bits) {
+    return util::TimePoint(std::chrono::duration_cast<util::TimePoint::duration>(Nanos(static_cast<std::int64_t>(bits))));
+}
+
+// Text of a typed value, appended
+void append_value(std::string &out, CellKind kind, std::uint64_t bits) {
+    char buf[40];
+    char *end = buf;
+    const auto i = static_cast<std::int64_t>(bits);
+    switch (kind) {
+    case CellKind::Int: end = std::to_chars(buf, buf + sizeof buf, i).ptr; break;
+    case CellKind::Real: end = std::to_chars(buf, buf + sizeof buf, std::bit_cast<double>(bits)).ptr; break;
+    case CellKind::Fixed2: {
+        const std::uint64_t a = i < 0 ? 0 - bits : bits;
+        if (i < 0) *end++ = '-';
+        end = std::to_chars(end, buf + sizeof buf, a / 100).ptr;
+        *end++ = '.';
+        *end++ = static_cast<char>('0' + a % 100 / 10);
+        *end++ = static_cast<char>('0' + a % 10);
+        break;
+    }
+    case CellKind::Time: end = util::format_time(buf, time_of(bits)); break;
+    case CellKind::Date: end = util::format_date(buf, time_of(bits)); break;
+    case CellKind::Stamp: end = util::format_stamp(buf, time_of(bits)); break;
+    case CellKind::Duration: end = util::format_hhmmss(buf, static_cast<int>(i)); break;
+    case CellKind::Text:
+    case CellKind::Bool: break;
+    }
+    out.append(buf, end);
+}
+
+template <class T>
+bool number(std::string_view s, T &v) {
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+// Value bits of a cell's text, read as `kind`
+bool read_value(CellKind kind, std::string_view s, std::uint64_t &bits) {
+    switch (kind) {
+    case CellKind::Int: {
+        std::int64_t v;
+        if (!number(s, v)) return false;
+        bits = static_cast<std::uint64_t>(v);
+        break;
+    }
+    case CellKind::Real: {
+        double v;
+        if (!number(s, v)) return false;
+        bits = std::bit_cast<std::uint64_t>(v);
+        break;
+    }
+    case CellKind::Fixed2: {
+        const std::size_t dot = s.find('.');
+        std::int64_t whole, cents;
+        if (dot == std::string_view::npos || s.size() - dot != 3 || !number(s.substr(0, dot), whole) ||
+            !number(s.substr(dot + 1), cents) || whole > INT64_MAX / 100 || whole < INT64_MIN / 100)
+            return false;
+        bits = static_cast<std::uint64_t>(s[0] == '-' ? whole * 100 - cents : whole * 100 + cents);
+        break;
+    }
+    case CellKind::Time:
+    case CellKind::Stamp: {
+        const auto t = util::parse_time(s);
+        if (!t) return false;
+        bits = time_bits(*t);
+        break;
+    }
+    case CellKind::Date: {
+        if (s.size() != 10) return false;
+        char buf[20];
+        std::memcpy(buf, s.data(), 10);
+        std::memcpy(buf + 10, " 00:00:00", 9);
+        const auto t = util::parse_time(std::string_view(buf, 19));
+        if (!t) return false;
+        bits = time_bits(*t);
+        break;
+    }
+    case CellKind::Duration: {
+        // hours widen past 99, minutes and seconds are two digits
+        const std::size_t colon = s.find(':');
+        int h, m, sec;
+        if (colon == std::string_view::npos || s.size() - colon != 6 || s[colon + 3] != ':' ||
+            !number(s.substr(0, colon), h) || !number(s.substr(colon + 1, 2), m) || !number(s.substr(colon + 4), sec) ||
+            h > 596522)
+            return false;
+        bits = static_cast<std::uint64_t>(std::int64_t{h} * 3600 + m * 60 + sec);
+        break;
+    }
+    case CellKind::Text:
+    case CellKind::Bool: return false;
+    }
+    return true;
+}
+
+// read_value, false unless the value is written back as exactly the same text
+bool parse_value(CellKind kind, std::string_view s, std::uint64_t &bits, std::string &scratch) {
+    if (!read_value(kind, s, bits)) return false;
+    scratch.clear();
+    append_value(scratch, kind, bits);
+    return scratch == s;
+}
+
+// Bytes per packed value: 0 (all the same), 1, 2, 4 or 8
+unsigned width_for(std::uint64_t top) {
+    return top == 0 ? 0 : top <= 0xff ? 1 : top <= 0xffff ? 2 : top <= 0xffffffffu ? 4 : 8;
+}
+
+bool packed_width(std::uint64_t w) { return w == 0 || w == 1 || w == 2 || w == 4 || w == 8; }
+
+void put_packed(std::string &out, const std::uint64_t *v, std::size_t n, unsigned width) {
+    const std::size_t from = out.size();
+    out.resize(from + padded(n * width), '\0');
+    char *p = out.data() + from;
+    for (std::size_t i = 0; i < n; ++i) {
+        switch (width) {
+        case 1: p[i] = static_cast<char>(v[i]); break;
+        case 2: { const auto x = static_cast<std::uint16_t>(v[i]); std::memcpy(p + 2 * i, &x, 2); break; }
+        case 4: { const auto x = static_cast<std::uint32_t>(v[i]); std::memcpy(p + 4 * i, &x, 4); break; }
+        case 8: std::memcpy(p + 8 * i, &v[i], 8); break;
+        }
+    }
+}
+
+} // namespace
+
+bool ColumnStore::value_of(CellKind kind, std::string_view text, std::uint64_t &bits) {
+    if (kind == CellKind::Fixed2 && !read_value(kind, text, bits)) {
+        // "5", "5.5": any decimal, rounded to cents
+        double v;
+        if (!number(text, v) || !(v > -9e16 && v < 9e16)) return false;
+        bits = static_cast<std::uint64_t>(std::llround(v * 100));
+        return true;
+    }
+    return read_value(kind, text, bits);
+}
+
+bool ColumnStore::value_less(CellKind kind, std::uint64_t a, std::uint64_t b) {
+    if (kind == CellKind::Real) return std::bit_cast<double>(a) < std::bit_cast<double>(b);
+    return static_cast<std::int64_t>(a) < static_cast<std::int64_t>(b);
+}
+
+std::string ColumnStore::path_for(const std::string &outputsDir) {
+    return (fs::path(outputsDir) / "All_Exports.cols").string();
+}
+
+ColumnStore::ColumnStore(std::string path) : path_(std::move(path)) { open_ = load(); }
+
+bool ColumnStore::load() {
+    file_ = util::MappedFile(path_);
+    names_.clear();
+    kinds_.clear();
+    segments_.clear();
+    rows_ = 0;
+    exportBytes_ = 0;
+    const std::string_view bytes = file_.data();
+    if (bytes.size() < sizeof kMagic || std::memcmp(bytes.data(), kMagic, sizeof kMagic) != 0) return false;
+
+    Cursor in{bytes, sizeof kMagic};
+    const std::uint64_t columns = in.u64();
+    for (std::uint64_t c = 0; in.ok && c < columns; ++c) {
+        const std::uint64_t kind = in.u64();
+        names_.emplace_back(in.text(in.u64()));
+        kinds_.push_back(kind <= static_cast<std::uint64_t>(CellKind::Bool) ? static_cast<CellKind>(kind) : CellKind::Text);
+    }
+    if (!in.ok || columns == 0) return false;
+    headerEnd_ = in.at;
+    if (!load_footer(in.at)) recover(in.at);
+    for (const auto &s : segments_) rows_ += s.rows;
+    return true;
+}
+
+bool ColumnStore::load_footer(std::uint64_t headerEnd) {
+    const std::string_view bytes = file_.data();
+    if (bytes.size() < headerEnd + kTrailerBytes) return false;
+    const std::uint64_t t = bytes.size() - kTrailerBytes;
+    const std::uint64_t at = word_at(bytes, t), size = word_at(bytes, t + 8);
+    if (word_at(bytes, t + 24) != kTrailerMagic || at < headerEnd || at > t || size != t - at ||
+        util::content_hash(bytes.substr(static_cast<std::size_t>(at), static_cast<std::size_t>(size))) != word_at(bytes, t + 16))
+        return false;
+
+    Cursor in{bytes.substr(0, static_cast<std::size_t>(t)), at};
+    if (in.u64() != kFooterMagic) return false;
+    const std::uint64_t count = in.u64();
+    exportBytes_ = in.u64();
+    std::uint64_t next = headerEnd;
+    for (std::uint64_t s = 0; in.ok && s < count; ++s) {
+        Segment seg;
+        const std::uint64_t offset = in.u64(), rows = in.u64();
+        // In order; a gap is left by a tail rewrite that was not copied down
+        if (!in.ok || offset < next || !parse_segment(bytes.substr(0, static_cast<std::size_t>(at)), offset, seg, false) ||
+            seg.rows != rows)
+            return false;
+        for (auto &b : seg.blocks) {
+            b.zone.empty = in.u64();
+            b.zone.min = in.u64();
+            b.zone.max = in.u64();
+            const std::uint64_t minLen = in.u64(), maxLen = in.u64();
+            b.zone.minText = in.text(minLen);
+            b.zone.maxText = in.text(maxLen);
+        }
+        next = offset + seg.bytes;
+        segments_.push_back(std::move(seg));
+    }
+    if (!in.ok || next > at) {
+        segments_.clear();
+        return false;
+    }
+    dataEnd_ = at;
+    return true;
+}
+
+// No usable footer: keep the segments that are whole and intact, in order.
+// The size of the TSV export is unknown then, so it is rewritten.
+void ColumnStore::recover(std::uint64_t headerEnd) {
+    const std::string_view bytes = file_.data();
+    segments_.clear();
+    std::uint64_t at = headerEnd;
+    for (Segment seg; parse_segment(bytes, at, seg, true); seg = {}) {
+        for (std::size_t c = 0; c < seg.blocks.size(); ++c) seg.blocks[c].zone = zone_of(seg.blocks[c], kinds_[c], seg.rows);
+        at += seg.bytes;
+        segments_.push_back(std::move(seg));
+    }
+    dataEnd_ = at;
+    exportBytes_ = 0;
+    recovered_ = true;
+}
+
+// The segment at `offset` of `bytes`, its blocks located; `verify` also
+// checks its hash and every dictionary code and offset
+bool ColumnStore::parse_segment(std::string_view bytes, std::uint64_t offset, Segment &seg, bool verify) const {
+    const std::size_t columns = names_.size();
+    const std::uint64_t headerBytes = (kSegmentHeaderWords + 3 * columns) * 8;
+    if (offset % 8 || offset > bytes.size() || bytes.size() - offset < headerBytes) return false;
+    const std::uint64_t rows = word_at(bytes, offset + 8), size = word_at(bytes, offset + 16);
+    if (word_at(bytes, offset) != kSegmentMagic || word_at(bytes, offset + 24) != columns || rows == 0 ||
+        rows > kSegmentRows || size < headerBytes || size % 8 || size > bytes.size() - offset)
+        return false;
+    const std::string_view body = bytes.substr(static_cast<std::size_t>(offset), static_cast<std::size_t>(size));
+    if (verify && util::content_hash(body.substr(kSegmentHeaderWords * 8)) != word_at(body, 32)) return false;
+
+    const char *base = body.data();
+    const std::uint64_t words = (rows + 63) / 64;
+    seg.offset = offset;
+    seg.bytes = size;
+    seg.rows = static_cast<std::size_t>(rows);
+    seg.blocks.assign(columns, {});
+    for (std::size_t c = 0; c < columns; ++c) {
+        const std::uint64_t dir = (kSegmentHeaderWords + 3 * c) * 8;
+        const std::uint64_t enc = word_at(body, dir), at = word_at(body, dir + 8), len = word_at(body, dir + 16);
+        if (at < headerBytes || at % 8 || at > size || len > size - at || len < 32) return false;
+        Block &b = seg.blocks[c];
+        if (enc == kTyped) {
+            b.typed = true;
+            b.present = reinterpret_cast<const std::uint64_t *>(base + at);
+            b.base = word_at(body, at + words * 8);
+            b.scale = word_at(body, at + words * 8 + 8);
+            b.width = static_cast<unsigned>(word_at(body, at + words * 8 + 16));
+            b.packed = base + at + words * 8 + 24;
+            if (kinds_[c] == CellKind::Text || !packed_width(b.width) || len != words * 8 + 24 + padded(rows * b.width))
+                return false;
+        } else if (enc == kDictionary) {
+            const std::uint64_t entries = word_at(body, at), chars = word_at(body, at + 8);
+            b.width = static_cast<unsigned>(word_at(body, at + 16));
+            b.offsetWidth = static_cast<unsigned>(word_at(body, at + 24));
+            if (entries > rows || !packed_width(b.width) || !packed_width(b.offsetWidth) ||
+                len != 32 + padded((entries + 1) * b.offsetWidth) + padded(rows * b.width) + padded(chars))
+                return false;
+            b.entries = static_cast<std::size_t>(entries);
+            b.offsets = base + at + 32;
+            b.packed = b.offsets + padded((entries + 1) * b.offsetWidth);
+            b.chars = static_cast<const char *>(b.packed) + padded(rows * b.width);
+            b.charBytes = chars;
+            if (verify) {
+                for (std::size_t i = 0; i < entries; ++i)
+                    if (b.offset(i) > b.offset(i + 1)) return false;
+                if (b.offset(0) != 0 || b.offset(b.entries) != chars) return false;
+                for (std::size_t r = 0; r < rows; ++r)
+                    if (b.code(r) >= entries) return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+ColumnStore::Zone ColumnStore::zone_of(const Block &b, CellKind kind, std::size_t rows) {
+    Zone z;
+    bool any = false;
+    if (b.typed) {
+        for (std::size_t r = 0; r < rows; ++r) {
+            if (!b.has(r)) { ++z.empty; continue; }
+            const std::uint64_t v = b.value(r);
+            if (!any || value_less(kind, v, z.min)) z.min = v;
+            if (!any || value_less(kind, z.max, v)) z.max = v;
+            any = true;
+        }
+        return z;
+    }
+    // Every entry is used; the empty one, if any, counts its rows
+    std::size_t emptyCode = b.entries;
+    for (std::size_t e = 0; e < b.entries; ++e) {
+        const std::string_view s = b.entry(e);
+        if (s.empty()) { emptyCode = e; continue; }
+        if (!any || s < z.minText) z.minText = s;
+        if (!any || s > z.maxText) z.maxText = s;
+        any = true;
+    }
+    if (emptyCode < b.entries)
+        for (std::size_t r = 0; r < rows; ++r) z.empty += b.code(r) == emptyCode;
+    return z;
+}
+
+void ColumnStore::discard() {
+    file_ = {};
+    open_ = false;
+    segments_.clear();
+    rows_ = 0;
+    std::error_code ec;
+    fs::remove(path_, ec);
+}
+
+bool ColumnStore::create(const std::vector<std::pair<std::string, CellKind>> &columns) {
+    std::string header(kMagic, sizeof kMagic);
+    put(header, columns.size());
+    for (const auto &[name, kind] : columns) {
+        put(header, static_cast<std::uint64_t>(kind));
+        put(header, name.size());
+        put_text(header, name);
+    }
+    file_ = {};
+    const std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.write(header.data(), static_cast<std::streamsize>(header.size())) || !out.flush()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path_, ec);
+    open_ = !ec && load() && write_footer(0);
+    recovered_ = false;  // a new store has no footer until the first one is written
+    return open_;
+}
+
+// One segment of these rows: cells[c][r] is column c of row r
+std::string ColumnStore::encode_segment(const std::vector<std::vector<std::string_view>> &cells, std::size_t rows) const {
+    const std::size_t columns = names_.size();
+    std::string seg;
+    put(seg, kSegmentMagic);
+    put(seg, rows);
+    put(seg, 0);   // bytes
+    put(seg, columns);
+    put(seg, 0);   // hash
+    seg.append(3 * columns * 8, '\0');
+
+    std::vector<std::uint64_t> values(rows), present((rows + 63) / 64);
+    std::string scratch;
+    std::size_t slots = 1;
+    while (slots < 2 * rows) slots *= 2;
+    std::vector<std::uint32_t> table(slots);   // open addressing: code + 1, 0 when free
+    std::vector<std::string_view> entries;
+    for (std::size_t c = 0; c < columns; ++c) {
+        const std::vector<std::string_view> &col = cells[c];
+        const std::size_t at = seg.size();
+
+        // Typed when every cell reads back as the same text; a cell equal to
+        // the one before reuses its value. Flags stay dictionaries (two
+        // entries, one-byte codes), which stores from before the kind read too.
+        bool typed = kinds_[c] != CellKind::Text && kinds_[c] != CellKind::Bool;
+        for (std::size_t r = 0; typed && r < rows; ++r) {
+            if (col[r].empty()) values[r] = 0;
+            else if (r && col[r] == col[r - 1]) values[r] = values[r - 1];
+            else typed = parse_value(kinds_[c], col[r], values[r], scratch);
+        }
+        if (typed) {
+            // Frame of reference: value = base + scale * packed, packed as
+            // narrow as the largest one allows
+            std::fill(present.begin(), present.end(), 0);
+            std::uint64_t base = ~std::uint64_t{0};
+            for (std::size_t r = 0; r < rows; ++r)
+                if (!col[r].empty()) {
+                    present[r / 64] |= std::uint64_t{1} << (r % 64);
+                    base = std::min(base, values[r]);
+                }
+            std::uint64_t scale = 0, top = 0;
+            for (std::size_t r = 0; r < rows; ++r)
+                if (!col[r].empty()) scale = std::gcd(scale, values[r] - base);
+            if (!scale) scale = 1;
+            for (std::size_t r = 0; r < rows; ++r) {
+                values[r] = col[r].empty() ? 0 : (values[r] - base) / scale;
+                top = std::max(top, values[r]);
+            }
+            const unsigned width = width_for(top);
+            seg.append(reinterpret_cast<const char *>(present.data()), present.size() * 8);
+            put(seg, base == ~std::uint64_t{0} ? 0 : base);
+            put(seg, scale);
+            put(seg, width);
+            put_packed(seg, values.data(), rows, width);
+        } else {
+            std::fill(table.begin(), table.end(), 0);
+            entries.clear();
+            std::uint64_t chars = 0;
+            for (std::size_t r = 0; r < rows; ++r) {
+                std::size_t slot = std::hash<std::string_view>{}(col[r]) & (slots - 1);
+                while (table[slot] && entries[table[slot] - 1] != col[r]) slot = (slot + 1) & (slots - 1);
+                if (!table[slot]) {
+                    entries.push_back(col[r]);
+                    chars += col[r].size();
+                    table[slot] = static_cast<std::uint32_t>(entries.size());
+                }
+                values[r] = table[slot] - 1;
+            }
+            const unsigned width = width_for(entries.size() - 1), offsetWidth = width_for(chars);
+            put(seg, entries.size());
+            put(seg, chars);
+            put(seg, width);
+            put(seg, offsetWidth);
+            std::uint64_t offset = 0;
+            std::vector<std::uint64_t> offsets{0};
+            for (const auto &e : entries) offsets.push_back(offset += e.size());
+            put_packed(seg, offsets.data(), offsets.size(), offsetWidth);
+            put_packed(seg, values.data(), rows, width);
+            for (const auto &e : entries) seg.append(e);
+            seg.append(padded(chars) - chars, '\0');
+        }
+        const std::size_t dir = (kSegmentHeaderWords + 3 * c) * 8;
+        patch(seg, dir, typed ? kTyped : kDictionary);
+        patch(seg, dir + 8, at);
+        patch(seg, dir + 16, seg.size() - at);
+    }
+    patch(seg, 16, seg.size());
+    patch(seg, 32, util::content_hash(std::string_view(seg).substr(kSegmentHeaderWords * 8)));
+    return seg;
+}
+
+// Footer words up to and including the entries of the first `segments`
+// segments in the file
+std::string ColumnStore::footer_head(std::uint64_t exportBytes, std::size_t segments) const {
+    std::string footer;
+    put(footer, kFooterMagic);
+    put(footer, segments);
+    put(footer, exportBytes);
+    for (std::size_t s = 0; s < segments; ++s) put_entry(footer, segments_[s]);
+    return footer;
+}
+
+void ColumnStore::put_entry(std::string &footer, const Segment &seg) const {
+    put(footer, seg.offset);
+    put(footer, seg.rows);
+    for (const auto &b : seg.blocks) {
+        put(footer, b.zone.empty);
+        put(footer, b.zone.min);
+        put(footer, b.zone.max);
+        put(footer, b.zone.minText.size());
+        put(footer, b.zone.maxText.size());
+        put_text(footer, b.zone.minText);
+        put_text(footer, b.zone.maxText);
+    }
+}
+
+// The footer (for `segments` segments) and the trailer that locates it,
+// written at `at` where the last segment ends; then the file is mapped again
+bool ColumnStore::finish(std::fstream &out, std::string &footer, std::size_t segments, std::uint64_t at) {
+    patch(footer, 8, segments);
+    const std::uint64_t body = footer.size();
+    put(footer, at);
+    put(footer, body);
+    put(footer, util::content_hash(std::string_view(footer).substr(0, static_cast<std::size_t>(body))));
+    put(footer, kTrailerMagic);
+    out.seekp(static_cast<std::streamoff>(at));
+    out.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+    const bool written = static_cast<bool>(out.flush());
+    out.close();
+    std::error_code ec;
+    if (written) fs::resize_file(path_, at + footer.size(), ec);  // after a longer footer
+    open_ = written && !ec && load();
+    return open_;
+}
+
+bool ColumnStore::write_footer(std::uint64_t exportBytes) {
+    std::string footer = footer_head(exportBytes, segments_.size());
+    file_ = {};  // unmapped before it is written
+    std::fstream out(path_, std::ios::binary | std::ios::in | std::ios::out);
+    return out && finish(out, footer, segments_.size(), dataEnd_);
+}
+
+bool ColumnStore::append(std::string_view lines, std::uint64_t exportBytes) {
+    if (!open_) return false;
+    const std::size_t columns = names_.size();
+
+    // A short last segment is read back as lines and written again in front
+    // of the new ones
+    const bool merge = !lines.empty() && !segments_.empty() && segments_.back().rows < kMergeRows;
+    std::string text;
+    if (merge) {
+        for (std::size_t r = 0; r < segments_.back().rows; ++r) append_line(text, segments_.size() - 1, r);
+        text.append(lines);
+        lines = text;
+    }
+    const std::size_t kept = segments_.size() - merge;
+    const std::uint64_t start = !merge ? dataEnd_ : kept ? segments_[kept - 1].offset + segments_[kept - 1].bytes : headerEnd_;
+    const std::uint64_t fileBytes = file_.data().size();
+
+    // Without a merge each segment goes to the file as soon as it is encoded,
+    // over the old footer; with one they are kept until all are encoded
+    std::string footer = footer_head(exportBytes, kept);
+    std::uint64_t at = start;
+    std::size_t count = kept;
+    std::vector<std::string> encoded;
+    file_ = {};
+    std::fstream out(path_, std::ios::binary | std::ios::in | std::ios::out);
+    if (!out) return false;
+    out.seekp(static_cast<std::streamoff>(at));
+
+    // The footer entry of an encoded segment placed at `offset`
+    auto put_encoded = [&](std::string &to, const std::string &seg, std::uint64_t offset) {
+        Segment info;
+        if (!parse_segment(seg, 0, info, false)) return false;
+        for (std::size_t c = 0; c < columns; ++c) info.blocks[c].zone = zone_of(info.blocks[c], kinds_[c], info.rows);
+        info.offset = offset;
+        put_entry(to, info);
+        return true;
+    };
+    std::vector<std::vector<std::string_view>> cells(columns);
+    std::size_t rows = 0;
+    auto flush = [&] {
+        if (!rows) return true;
+        std::string seg = encode_segment(cells, rows);
+        for (auto &col : cells) col.clear();
+        rows = 0;
+        if (merge) {
+            encoded.push_back(std::move(seg));
+            ++count;
+            return true;
+        }
+        if (!put_encoded(footer, seg, at)) return false;
+        out.write(seg.data(), static_cast<std::streamsize>(seg.size()));
+        at += seg.size();
+        ++count;
+        return static_cast<bool>(out);
+    };
+    bool ok = true;
+    while (ok && !lines.empty()) {
+        const std::size_t nl = lines.find('\n');
+        std::string_view line = lines.substr(0, nl);
+        lines.remove_prefix(nl == std::string_view::npos ? lines.size() : nl + 1);
+        std::size_t c = 0;
+        for (;; ++c) {
+            const std::size_t tab = line.find('\t');
+            if (c < columns) cells[c].push_back(line.substr(0, tab));
+            if (tab == std::string_view::npos) break;
+            line.remove_prefix(tab + 1);
+        }
+        ok = c + 1 == columns;  // else a line the columns cannot hold
+        if (ok && ++rows == kSegmentRows) ok = flush();
+    }
+    ok = ok && flush();
+    if (!ok) {
+        // Nothing written yet keeps the store as it was; a partial write
+        // is recovered from on the next open
+        out.close();
+        if (merge || count == kept) open_ = load();
+        return false;
+    }
+    if (!merge) return finish(out, footer, count, at);
+
+    // The new segments and their footer placed at `base`; false if either
+    // could not be written
+    auto place = [&](std::fstream &to, std::uint64_t base) {
+        std::string f = footer;
+        std::uint64_t offset = base;
+        for (const auto &seg : encoded) {
+            if (!put_encoded(f, seg, offset)) return false;
+            offset += seg.size();
+        }
+        to.seekp(static_cast<std::streamoff>(base));
+        for (const auto &seg : encoded) to.write(seg.data(), static_cast<std::streamsize>(seg.size()));
+        return to && finish(to, f, count, offset);
+    };
+    std::uint64_t bytes = 0;
+    for (const auto &seg : encoded) bytes += seg.size();
+    std::string sized = footer;
+    for (const auto &seg : encoded) put_encoded(sized, seg, 0);
+    // First past everything the copy down will write, so a copy cut short
+    // leaves this one and its footer whole
+    const std::uint64_t shadow = padded(std::max(fileBytes, start + bytes + sized.size() + kTrailerBytes));
+    if (!place(out, shadow) || !util::sync_file(path_)) {
+        std::error_code ec;
+        fs::resize_file(path_, fileBytes, ec);
+        open_ = load();
+        return false;
+    }
+    file_ = {};
+    std::fstream down(path_, std::ios::binary | std::ios::in | std::ios::out);
+    return down && place(down, start);
+}
+
+bool ColumnStore::importable(std::string_view text) {
+    if (text.empty() || text.back() != '\n' || text.find('\r') != std::string_view::npos) return false;
+    const std::size_t columns = std::count(text.begin(), text.begin() + text.find('\n'), '\t') + 1;
+    std::string_view rest = text.substr(text.find('\n') + 1), line;
+    while (util::next_line(rest, line))
+        if (line.empty() || static_cast<std::size_t>(std::count(line.begin(), line.end(), '\t')) + 1 != columns) return false;
+    return true;
+}
+
+bool ColumnStore::export_tsv(const std::string &tsvPath) {
+    std::error_code ec;
+    const auto size = fs::file_size(tsvPath, ec);
+    if (!ec && size == exportBytes_) return true;
+
+    std::string buf;
+    for (std::size_t c = 0; c < names_.size(); ++c) {
+        if (c) buf.push_back('\t');
+        buf += names_[c];
+    }
+    buf.push_back('\n');
+    std::uint64_t written = 0;
+    const std::string tmp = tsvPath + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        for (std::size_t s = 0; s < segments_.size(); ++s)
+            for (std::size_t r = 0; r < segments_[s].rows; ++r) {
+                append_line(buf, s, r);
+                if (buf.size() >= (1u << 20)) {
+                    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                    written += buf.size();
+                    buf.clear();
+                }
+            }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        written += buf.size();
+        if (!out.flush()) return false;
+    }
+    fs::rename(tmp, tsvPath, ec);
+    return !ec && write_footer(written);
+}
+
+void ColumnStore::append_cell(std::string &out, std::size_t s, std::size_t row, std::size_t c) const {
+    const Block &b = segments_[s].blocks[c];
+    if (b.typed) {
+        if (b.has(row)) append_value(out, kinds_[c], b.value(row));
+        return;
+    }
+    const std::uint64_t code = b.code(row);
+    if (code < b.entries) out.append(b.entry(static_cast<std::size_t>(code)));
+}
+
+void ColumnStore::append_line(std::string &out, std::size_t s, std::size_t row) const {
+    for (std::size_t c = 0; c < names_.size(); ++c) {
+        if (c) out.push_back('\t');
+        append_cell(out, s, row, c);
+    }
+    out.push_back('\n');
+}
+
+bool ColumnStore::filter(std::size_t s, std::size_t c, std::vector<std::uint64_t> &keep,
+                         const std::function<bool(std::uint64_t)> &value,
+                         const std::function<bool(std::string_view)> &text, bool empty) const {
+    const Block &b = segments_[s].blocks[c];
+    const std::size_t words = (segments_[s].rows + 63) / 64;
+    std::vector<char> pass;
+    bool passEmpty = empty;
+    if (!b.typed) {
+        // Each distinct string once; a block where none passes keeps no row
+        pass.resize(b.entries);
+        bool any = passEmpty = text({});
+        for (std::size_t e = 0; e < b.entries; ++e) any |= pass[e] = text(b.entry(e));
+        if (!any) {
+            std::fill_n(keep.begin(), words, 0);
+            return false;
+        }
+    }
+    std::uint64_t left = 0;
+    for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t bits = keep[w];
+        for (std::uint64_t m = bits; m; m &= m - 1) {
+            const std::size_t r = w * 64 + static_cast<std::size_t>(std::countr_zero(m));
+            bool ok;
+            if (b.typed) {
+                ok = b.has(r) ? value(b.value(r)) : passEmpty;
+            } else {
+                const std::uint64_t code = b.code(r);
+                ok = code < b.entries ? pass[static_cast<std::size_t>(code)] != 0 : passEmpty;
+            }
+            if (!ok) bits &= ~(std::uint64_t{1} << (r % 64));
+        }
+        keep[w] = bits;
+        left |= bits;
+    }
+    return left != 0;
+}
+
+} // namespace excel
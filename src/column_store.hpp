@@ -0,0 +1,165 @@
+#pragma once
+#include "columns.hpp"
+#include "line_reader.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace excel {
+
+// Append-only columnar copy of the master, kept as <outputs>/All_Exports.cols
+// and the record the TSV and workbooks are exported from.
+// Rows are stored in segments of up to kSegmentRows rows. Within a segment
+// each column is one block: values of a typed column (counts, sizes, times,
+// durations) as numbers behind a presence bitmap, when every cell reads back
+// to the same text; anything else as a dictionary of distinct strings and a
+// code per row. Numbers and codes are packed as narrow as the segment allows.
+// A footer at the end lists the segments with a zone map (empty cells, min,
+// max) per column, so a reader can skip whole segments.
+// The file is memory-mapped for reads. An append writes its segments over the
+// old footer and a new footer after them: one cut short leaves no valid
+// footer, and the next open recovers the segments that were complete by
+// walking them from the start. A last segment of fewer than kMergeRows rows
+// is rewritten together with the new rows instead, so runs that add a row or
+// two do not leave a segment each: the new segments and a footer listing
+// them are first written past the end of the file and synced, then copied
+// down over the old last segment, so the old rows are always in a valid
+// footer's segments.
+class ColumnStore {
+public:
+    static constexpr std::size_t kSegmentRows = 65536;
+    static constexpr std::size_t kMergeRows = kSegmentRows / 8;
+
+    struct Zone {
+        std::uint64_t empty = 0;         // cells with no text
+        std::uint64_t min = 0, max = 0;  // typed: value bits (double for Real)
+        std::string_view minText, maxText;  // dictionary: byte order
+    };
+
+    static std::string path_for(const std::string &outputsDir);
+
+    // Maps the store at `path` when there is a valid one
+    explicit ColumnStore(std::string path);
+
+    bool is_open() const { return open_; }
+    bool recovered() const { return recovered_; }  // the footer was lost and rebuilt
+
+    // Deletes the file, leaving the store closed
+    void discard();
+
+    // New store with these columns; false on I/O failure
+    bool create(const std::vector<std::pair<std::string, CellKind>> &columns);
+
+    // TSV data lines ('\n'-terminated, no header) as new rows. `exportBytes`
+    // is what the TSV export will measure once they are written to it.
+    bool append(std::string_view lines, std::uint64_t exportBytes);
+
+    // The master TSV the store stands for: the whole file is checked against
+    // the size it last recorded, and rewritten from the store when it differs
+    bool export_tsv(const std::string &tsvPath);
+    std::uint64_t export_bytes() const { return exportBytes_; }
+
+    // Whether `text` (a TSV with a header) can be stored and exported back
+    // byte for byte: '\n' line ends, no blank lines, the header's cell count
+    static bool importable(std::string_view text);
+
+    std::size_t columns() const { return names_.size(); }
+    std::string_view name(std::size_t c) const { return names_[c]; }
+    CellKind kind(std::size_t c) const { return kinds_[c]; }
+    std::size_t rows() const { return rows_; }
+    std::size_t segments() const { return segments_.size(); }
+    std::size_t segment_rows(std::size_t s) const { return segments_[s].rows; }
+    const Zone &zone(std::size_t s, std::size_t c) const { return segments_[s].blocks[c].zone; }
+
+    bool typed(std::size_t s, std::size_t c) const { return segments_[s].blocks[c].typed; }
+
+    // Value bits of `text` read as `kind`, as typed blocks and zone maps hold
+    // them (double bits for Real, cents for Fixed2, nanoseconds since the
+    // epoch, seconds for Duration); other spellings of the value are taken
+    // too ("007", "5" for 5.00). False for Text and for text that is no value.
+    static bool value_of(CellKind kind, std::string_view text, std::uint64_t &bits);
+    static bool value_less(CellKind kind, std::uint64_t a, std::uint64_t b);
+
+    // Narrows `keep` (a bit per row of segment `s`) to the rows whose cell in
+    // column `c` passes a test: a typed block asks `value` about each set
+    // row's value and takes `empty` for its empty cells, a dictionary block
+    // asks `text` once per distinct string. False when no row is left.
+    bool filter(std::size_t s, std::size_t c, std::vector<std::uint64_t> &keep,
+                const std::function<bool(std::uint64_t)> &value,
+                const std::function<bool(std::string_view)> &text, bool empty) const;
+
+    // Text of one cell, appended to `out`
+    void append_cell(std::string &out, std::size_t s, std::size_t row, std::size_t c) const;
+    // Row `row` of segment `s` as a TSV line with its '\n'
+    void append_line(std::string &out, std::size_t s, std::size_t row) const;
+
+private:
+    struct Block {
+        bool typed = false;
+        unsigned width = 0;                      // bytes per packed value or code
+        const void *packed = nullptr;            // typed values or dictionary codes, one per row
+        const std::uint64_t *present = nullptr;  // typed: bit per row
+        std::uint64_t base = 0, scale = 0;       // typed: value = base + scale * packed
+        const char *offsets = nullptr;           // dictionary: entries + 1, packed
+        unsigned offsetWidth = 0;
+        const char *chars = nullptr;
+        std::size_t entries = 0;
+        std::uint64_t charBytes = 0;
+        Zone zone;
+
+        static std::uint64_t unpack(const void *p, unsigned width, std::size_t i) {
+            switch (width) {
+            case 1: return static_cast<const std::uint8_t *>(p)[i];
+            case 2: return static_cast<const std::uint16_t *>(p)[i];
+            case 4: return static_cast<const std::uint32_t *>(p)[i];
+            case 8: return static_cast<const std::uint64_t *>(p)[i];
+            default: return 0;
+            }
+        }
+        bool has(std::size_t r) const { return present[r / 64] >> (r % 64) & 1; }
+        std::uint64_t value(std::size_t r) const { return base + scale * unpack(packed, width, r); }
+        std::uint64_t code(std::size_t r) const { return unpack(packed, width, r); }
+        std::uint64_t offset(std::size_t e) const { return unpack(offsets, offsetWidth, e); }
+        std::string_view entry(std::size_t e) const {
+            const std::uint64_t from = std::min(offset(e), charBytes), to = std::min(offset(e + 1), charBytes);
+            return from < to ? std::string_view(chars + from, static_cast<std::size_t>(to - from)) : std::string_view{};
+        }
+    };
+    struct Segment {
+        std::uint64_t offset = 0, bytes = 0;
+        std::size_t rows = 0;
+        std::vector<Block> blocks;
+    };
+
+    bool load();
+    bool load_footer(std::uint64_t headerEnd);
+    void recover(std::uint64_t headerEnd);
+    bool parse_segment(std::string_view bytes, std::uint64_t offset, Segment &seg, bool verify) const;
+    static Zone zone_of(const Block &b, CellKind kind, std::size_t rows);
+    std::string encode_segment(const std::vector<std::vector<std::string_view>> &cells, std::size_t rows) const;
+    std::string footer_head(std::uint64_t exportBytes, std::size_t segments) const;
+    void put_entry(std::string &footer, const Segment &seg) const;
+    bool finish(std::fstream &out, std::string &footer, std::size_t segments, std::uint64_t at);
+    bool write_footer(std::uint64_t exportBytes);
+
+    std::string path_;
+    util::MappedFile file_;
+    bool open_ = false;
+    bool recovered_ = false;
+    std::vector<std::string> names_;
+    std::vector<CellKind> kinds_;
+    std::vector<Segment> segments_;
+    std::uint64_t headerEnd_ = 0;    // where the first segment may start
+    std::uint64_t dataEnd_ = 0;      // where the footer starts
+    std::uint64_t exportBytes_ = 0;
+    std::size_t rows_ = 0;
+};
+
+} // namespace excel
@@ -0,0 +1,253 @@
+#pragma once
+#include "models.hpp"
+#include "single_sheet_writer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace excel {
+
+// Kind of value behind a column's text, for stores that keep cells typed
+// (see column_store.hpp) and workbooks that write them as values; Text covers
+// names and labels, Bool the True/False flags
+enum class CellKind : std::uint8_t { Text, Int, Real, Fixed2, Time, Date, Stamp, Duration, Bool };
+
+// One output column: its header and how a row's value is written as cell
+// text. Each sheet (and the master TSV) is a constexpr array of these, so the
+// headers, the cell order and the column of any named field come from one
+// list.
+template <class Row>
+struct Column {
+    std::string_view name;
+    void (*append)(std::string &out, const Row &row);  // cell text, appended
+    CellKind kind = CellKind::Text;
+};
+
+// How a value becomes cell text (see the append_* functions in models.hpp)
+enum class Format { Text, GB, Date, Stamp, Tally };
+
+namespace detail {
+
+template <class> struct member_of;
+template <class T, class C> struct member_of<T C::*> { using type = C; };
+
+template <Format F, class T>
+void append_as(std::string &out, const T &v) {
+    if constexpr (F == Format::GB) append_gb(out, v);
+    else if constexpr (F == Format::Date) append_date(out, v);
+    else if constexpr (F == Format::Stamp) append_stamp(out, v);
+    else if constexpr (F == Format::Tally) append_tally(out, v);
+    else append_text(out, v);
+}
+
+template <Format F, class T>
+constexpr CellKind kind_of() {
+    if constexpr (F == Format::GB) return CellKind::Fixed2;
+    else if constexpr (F == Format::Date) return CellKind::Date;
+    else if constexpr (F == Format::Stamp) return CellKind::Stamp;
+    else if constexpr (F == Format::Tally || std::is_same_v<T, Count>) return CellKind::Int;
+    else if constexpr (std::is_same_v<T, Real>) return CellKind::Real;
+    else if constexpr (std::is_same_v<T, Instant>) return CellKind::Time;
+    else if constexpr (std::is_same_v<T, Elapsed>) return CellKind::Duration;
+    else if constexpr (std::is_same_v<T, Tri>) return CellKind::Bool;
+    else return CellKind::Text;
+}
+
+} // namespace detail
+
+// Column reading a data member or a const accessor of the row
+template <auto Field, Format F = Format::Text>
+constexpr auto column(std::string_view name) {
+    using Row = typename detail::member_of<decltype(Field)>::type;
+    using T = std::remove_cvref_t<std::invoke_result_t<decltype(Field), const Row &>>;
+    return Column<Row>{name, [](std::string &out, const Row &r) {
+        detail::append_as<F>(out, std::invoke(Field, r));
+    }, detail::kind_of<F, T>()};
+}
+
+// Position of the column called `name`; cols.size() when there is none
+template <class Row, std::size_t N>
+constexpr std::size_t column_index(const std::array<Column<Row>, N> &cols, std::string_view name) {
+    for (std::size_t i = 0; i < N; ++i)
+        if (cols[i].name == name) return i;
+    return N;
+}
+
+// Kind of the column called `name`; Text when there is none
+template <class Row, std::size_t N>
+constexpr CellKind kind_named(const std::array<Column<Row>, N> &cols, std::string_view name) {
+    const std::size_t i = column_index(cols, name);
+    return i < N ? cols[i].kind : CellKind::Text;
+}
+
+inline constexpr std::array kPhotoMeshColumns{
+    column<&PhotoMeshRow::projectName>("ProjectName"),
+    column<&PhotoMeshRow::buildID>("BuildID"),
+    column<&PhotoMeshRow::machine>("Machine"),
+    column<&PhotoMeshRow::hostIP>("HostIP"),
+    column<&PhotoMeshRow::user>("User"),
+    column<&PhotoMeshRow::startTime>("StartTime"),
+    column<&PhotoMeshRow::endTime>("EndTime"),
+    column<&PhotoMeshRow::duration>("Duration(hh:mm:ss)"),
+    column<&PhotoMeshRow::exportType>("ExportType"),
+    column<&PhotoMeshRow::resolution>("Resolution"),
+    column<&PhotoMeshRow::tileScheme>("TileScheme"),
+    column<&PhotoMeshRow::photosUsed>("PhotosUsed"),
+    column<&PhotoMeshRow::photoFolders>("PhotoFolders"),
+    column<&PhotoMeshRow::photoCoverage>("PhotoCoverage(km²)"),
+    column<&PhotoMeshRow::fusersUsed>("FusersUsed"),
+    column<&PhotoMeshRow::cpuThreads>("CPUThreads"),
+    column<&PhotoMeshRow::gpuCount>("GPUCount"),
+    column<&PhotoMeshRow::outputFolder>("OutputFolder"),
+    column<&PhotoMeshRow::totalFiles>("TotalFiles"),
+    column<&PhotoMeshRow::totalSizeGB, Format::GB>("TotalSize(GB)"),
+    column<&PhotoMeshRow::offsetCoordSys>("Offset_CoordSys"),
+    column<&PhotoMeshRow::offsetHDatum>("Offset_HDatum"),
+    column<&PhotoMeshRow::offsetVDatum>("Offset_VDatum"),
+    column<&PhotoMeshRow::offsetX>("OffsetX"),
+    column<&PhotoMeshRow::offsetY>("OffsetY"),
+    column<&PhotoMeshRow::offsetZ>("OffsetZ"),
+    column<&PhotoMeshRow::pivotCenterX>("PivotCenterX"),
+    column<&PhotoMeshRow::pivotCenterY>("PivotCenterY"),
+    column<&PhotoMeshRow::pivotCenterZ>("PivotCenterZ"),
+    column<&PhotoMeshRow::flipYZ>("FlipYZ"),
+    column<&PhotoMeshRow::trim>("Trim"),
+    column<&PhotoMeshRow::collision>("Collision"),
+    column<&PhotoMeshRow::visualLOD>("VisualLOD"),
+    column<&PhotoMeshRow::success>("Success"),
+    column<&PhotoMeshRow::warnings, Format::Tally>("Warnings"),
+    column<&PhotoMeshRow::errors, Format::Tally>("Errors"),
+    column<&PhotoMeshRow::logPath>("LogPath"),
+};
+
+inline constexpr std::array kRealityMeshColumns{
+    column<&RealityMeshRow::projectName>("ProjectName"),
+    column<&RealityMeshRow::datasetName>("DatasetName"),
+    column<&RealityMeshRow::machine>("Machine"),
+    column<&RealityMeshRow::hostIP>("HostIP"),
+    column<&RealityMeshRow::user>("User"),
+    column<&RealityMeshRow::startTime>("StartTime"),
+    column<&RealityMeshRow::endTime>("EndTime"),
+    column<&RealityMeshRow::duration>("Duration(hh:mm:ss)"),
+    column<&RealityMeshRow::processPreset>("ProcessPreset"),
+    column<&RealityMeshRow::exportType>("ExportType"),
+    column<&RealityMeshRow::selAreaSize>("SelAreaSize(km²)"),
+    column<&RealityMeshRow::resolution>("Resolution"),
+    column<&RealityMeshRow::tileScheme>("TileScheme"),
+    column<&RealityMeshRow::offsetCoordSys>("Offset_CoordSys"),
+    column<&RealityMeshRow::offsetHDatum>("Offset_HDatum"),
+    column<&RealityMeshRow::offsetVDatum>("Offset_VDatum"),
+    column<&RealityMeshRow::offsetX>("OffsetX"),
+    column<&RealityMeshRow::offsetY>("OffsetY"),
+    column<&RealityMeshRow::offsetZ>("OffsetZ"),
+    column<&RealityMeshRow::flipYZ>("FlipYZ"),
+    column<&RealityMeshRow::trim>("Trim"),
+    column<&RealityMeshRow::collision>("Collision"),
+    column<&RealityMeshRow::outputFolder>("OutputFolder"),
+    column<&RealityMeshRow::totalFiles>("TotalFiles"),
+    column<&RealityMeshRow::totalSizeGB, Format::GB>("TotalSize(GB)"),
+    column<&RealityMeshRow::success>("Success"),
+    column<&RealityMeshRow::warnings, Format::Tally>("Warnings"),
+    Column<RealityMeshRow>{"Errors", [](std::string &out, const RealityMeshRow &r) {
+        append_errors(out, r.errorCount, r.errors);
+    }},
+    column<&RealityMeshRow::logPath>("LogPath"),
+};
+
+// Errors column of the unified views: messages, else the count
+inline void append_unified_errors(std::string &out, const UnifiedRow &u) {
+    append_errors(out, u.Errors(), u.ErrorMessages());
+}
+
+// The per-run Summary sheet
+inline constexpr std::array kSummaryColumns{
+    column<&UnifiedRow::ProjectName>("ProjectName"),
+    column<&UnifiedRow::RunDate, Format::Date>("RunDate"),
+    column<&UnifiedRow::Tool>("Tool"),
+    column<&UnifiedRow::ExportType>("ExportType"),
+    column<&UnifiedRow::Duration>("Duration(hh:mm:ss)"),
+    column<&UnifiedRow::TotalSizeGB, Format::GB>("TotalSize(GB)"),
+    column<&UnifiedRow::PhotosUsed>("PhotosUsed"),
+    column<&UnifiedRow::FusersUsed>("FusersUsed"),
+    column<&UnifiedRow::Machine>("Machine"),
+    column<&UnifiedRow::Success>("Success"),
+    Column<UnifiedRow>{"Errors", append_unified_errors},
+};
+
+// The master (All_Exports.tsv / .xlsx)
+inline constexpr std::array kMasterColumns{
+    column<&UnifiedRow::ProjectName>("ProjectName"),
+    column<&UnifiedRow::Tool>("Tool"),
+    column<&UnifiedRow::DatasetName>("DatasetName"),
+    column<&UnifiedRow::BuildID>("BuildID"),
+    column<&UnifiedRow::StartTime>("StartTime"),
+    column<&UnifiedRow::EndTime>("EndTime"),
+    column<&UnifiedRow::Duration>("Duration(hh:mm:ss)"),
+    column<&UnifiedRow::RunDate, Format::Date>("RunDate"),
+    column<&UnifiedRow::ProcessPreset>("ProcessPreset"),
+    column<&UnifiedRow::ExportType>("ExportType"),
+    column<&UnifiedRow::SelAreaSize>("SelAreaSize(km²)"),
+    column<&UnifiedRow::Resolution>("Resolution"),
+    column<&UnifiedRow::TileScheme>("TileScheme"),
+    column<&UnifiedRow::PhotosUsed>("PhotosUsed"),
+    column<&UnifiedRow::PhotoFolders>("PhotoFolders"),
+    column<&UnifiedRow::PhotoCoverage>("PhotoCoverage(km²)"),
+    column<&UnifiedRow::FusersUsed>("FusersUsed"),
+    column<&UnifiedRow::CPUThreads>("CPUThreads"),
+    column<&UnifiedRow::GPUCount>("GPUCount"),
+    column<&UnifiedRow::Machine>("Machine"),
+    column<&UnifiedRow::HostIP>("HostIP"),
+    column<&UnifiedRow::User>("User"),
+    column<&UnifiedRow::OutputFolder>("OutputFolder"),
+    column<&UnifiedRow::TotalFiles>("TotalFiles"),
+    column<&UnifiedRow::TotalSizeGB, Format::GB>("TotalSize(GB)"),
+    column<&UnifiedRow::Offset_CoordSys>("Offset_CoordSys"),
+    column<&UnifiedRow::Offset_HDatum>("Offset_HDatum"),
+    column<&UnifiedRow::Offset_VDatum>("Offset_VDatum"),
+    column<&UnifiedRow::OffsetX>("OffsetX"),
+    column<&UnifiedRow::OffsetY>("OffsetY"),
+    column<&UnifiedRow::OffsetZ>("OffsetZ"),
+    column<&UnifiedRow::PivotCenterX>("PivotCenterX"),
+    column<&UnifiedRow::PivotCenterY>("PivotCenterY"),
+    column<&UnifiedRow::PivotCenterZ>("PivotCenterZ"),
+    column<&UnifiedRow::FlipYZ>("FlipYZ"),
+    column<&UnifiedRow::Trim>("Trim"),
+    column<&UnifiedRow::Collision>("Collision"),
+    column<&UnifiedRow::VisualLOD>("VisualLOD"),
+    column<&UnifiedRow::Success>("Success"),
+    column<&UnifiedRow::Warnings, Format::Tally>("Warnings"),
+    Column<UnifiedRow>{"Errors", append_unified_errors},
+    column<&UnifiedRow::LogPath>("LogPath"),
+    column<&UnifiedRow::IngestedAt, Format::Stamp>("IngestedAt"),
+};
+
+// One row as a TSV line with its '\n', appended to `out`. Tabs and line
+// breaks inside a cell become spaces.
+template <class Row, std::size_t N>
+void append_tsv_line(std::string &out, const std::array<Column<Row>, N> &cols, const Row &row) {
+    for (std::size_t c = 0; c < N; ++c) {
+        if (c) out.push_back('\t');
+        const std::size_t from = out.size();
+        cols[c].append(out, row);
+        for (std::size_t i = from; i < out.size(); ++i)
+            if (out[i] == '\t' || out[i] == '\r' || out[i] == '\n') out[i] = ' ';
+    }
+    out.push_back('\n');
+}
+
+// The header line, same layout
+template <class Row, std::size_t N>
+void append_tsv_header(std::string &out, const std::array<Column<Row>, N> &cols) {
+    for (std::size_t c = 0; c < N; ++c) {
+        if (c) out.push_back('\t');
+        out.append(cols[c].name);
+    }
+    out.push_back('\n');
+}
+
+} // namespace excel
@@ -0,0 +1,108 @@
+#include "content_hash.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace util {
+
+namespace {
+
+constexpr std::uint64_t P1 = 11400714785074694791ull;
+constexpr std::uint64_t P2 = 14029467366897019727ull;
+constexpr std::uint64_t P3 = 1609587929392839161ull;
+constexpr std::uint64_t P4 = 9650029242287828579ull;
+constexpr std::uint64_t P5 = 2870177450012600261ull;
+
+std::uint64_t read64(const unsigned char *p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+std::uint32_t read32(const unsigned char *p) {
+    return std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 | std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24;
+}
+
+std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+    acc += input * P2;
+    return std::rotl(acc, 31) * P1;
+}
+
+std::uint64_t merge_round(std::uint64_t acc, std::uint64_t v) {
+    acc ^= round(0, v);
+    return acc * P1 + P4;
+}
+
+} // namespace
+
+ContentHash::ContentHash() : v_{P1 + P2, P2, 0, 0 - P1} {}
+
+void ContentHash::update(std::string_view bytes) {
+    auto p = reinterpret_cast<const unsigned char *>(bytes.data());
+    std::size_t n = bytes.size();
+    total_ += n;
+
+    if (buffered_ + n < 32) {
+        std::memcpy(buf_ + buffered_, p, n);
+        buffered_ += n;
+        return;
+    }
+    if (buffered_) {
+        const std::size_t fill = 32 - buffered_;
+        std::memcpy(buf_ + buffered_, p, fill);
+        for (int i = 0; i < 4; ++i) v_[i] = round(v_[i], read64(buf_ + 8 * i));
+        p += fill;
+        n -= fill;
+        buffered_ = 0;
+    }
+    for (; n >= 32; p += 32, n -= 32)
+        for (int i = 0; i < 4; ++i) v_[i] = round(v_[i], read64(p + 8 * i));
+    std::memcpy(buf_, p, n);
+    buffered_ = n;
+}
+
+std::uint64_t ContentHash::digest() const {
+    std::uint64_t h;
+    if (total_ >= 32) {
+        h = std::rotl(v_[0], 1) + std::rotl(v_[1], 7) + std::rotl(v_[2], 12) + std::rotl(v_[3], 18);
+        for (int i = 0; i < 4; ++i) h = merge_round(h, v_[i]);
+    } else {
+        h = v_[2] + P5;  // v_[2] is still the seed
+    }
+    h += total_;
+
+    const unsigned char *p = buf_;
+    std::size_t n = buffered_;
+    for (; n >= 8; p += 8, n -= 8) h = std::rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+    if (n >= 4) {
+        h = std::rotl(h ^ std::uint64_t(read32(p)) * P1, 23) * P2 + P3;
+        p += 4;
+        n -= 4;
+    }
+    for (; n; ++p, --n) h = std::rotl(h ^ *p * P5, 11) * P1;
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+void ContentHash::save(StateWriter &w) const {
+    for (auto v : v_) w.u64(v);
+    w.u64(total_);
+    w.str({reinterpret_cast<const char *>(buf_), buffered_});
+}
+
+bool ContentHash::load(StateReader &r) {
+    for (auto &v : v_) v = r.u64();
+    total_ = r.u64();
+    const std::string rest = r.str();
+    if (!r.ok() || rest.size() >= 32 || rest.size() != total_ % 32) return false;
+    std::memcpy(buf_, rest.data(), rest.size());
+    buffered_ = rest.size();
+    return true;
+}
+
+} // namespace util
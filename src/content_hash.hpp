@@ -0,0 +1,34 @@
+#pragma once
+#include "parse_state.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace util {
+
+// Streaming XXH64 (seed 0): update() with any split of the input gives the
+// same digest. The running state can be persisted to continue later.
+class ContentHash {
+public:
+    ContentHash();
+    void update(std::string_view bytes);
+    std::uint64_t digest() const;
+
+    void save(StateWriter &w) const;
+    bool load(StateReader &r);
+
+private:
+    std::uint64_t v_[4];
+    std::uint64_t total_ = 0;
+    unsigned char buf_[32];
+    std::size_t buffered_ = 0;
+};
+
+inline std::uint64_t content_hash(std::string_view bytes) {
+    ContentHash h;
+    h.update(bytes);
+    return h.digest();
+}
+
+} // namespace util
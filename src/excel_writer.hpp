@@ -1,12 +1,15 @@
 #pragma once
 #include "models.hpp"
+#include "single_sheet_writer.hpp"
 #include <vector>
 #include <string>
 
 namespace excel {
+// One sheet per tool, plus a Summary sheet read from the unified views of
+// the same rows (see unify)
 void write_workbook(const std::string &path,
                     const std::vector<PhotoMeshRow> &pm,
                     const std::vector<RealityMeshRow> &rm,
-                    const std::vector<SummaryRow> &summary);
+                    const std::vector<UnifiedRow> &summary);
 }
 
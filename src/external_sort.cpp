@@ -0,0 +1,202 @@
+#include "external_sort.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+
+namespace fs = std::filesystem;
+
+namespace util {
+
+namespace {
+
+constexpr std::size_t kMinRunBuffer = 64 * 1024;
+constexpr std::size_t kMaxFanIn = 128;   // run files open at once
+constexpr std::size_t kRecordHeader = 8; // key bytes, payload bytes (u32 each)
+
+// Sequential reader of a run file through a fixed buffer (grown only for a
+// record larger than it)
+class RunReader {
+public:
+    RunReader(const std::string &path, std::size_t bufferBytes)
+        : in_(path, std::ios::binary), buf_(std::max(bufferBytes, kRecordHeader), '\0') {}
+
+    bool failed() const { return failed_; }
+
+    // Next record; the views stay valid until the following call
+    bool next() {
+        if (!fill(kRecordHeader)) return false;
+        std::uint32_t sizes[2];
+        std::memcpy(sizes, buf_.data() + pos_, sizeof sizes);
+        const std::size_t bytes = kRecordHeader + sizes[0] + sizes[1];
+        if (!fill(bytes)) {
+            failed_ = true;   // cut short
+            return false;
+        }
+        key = std::string_view(buf_.data() + pos_ + kRecordHeader, sizes[0]);
+        payload = std::string_view(key.data() + sizes[0], sizes[1]);
+        pos_ += bytes;
+        return true;
+    }
+
+    std::string_view key, payload;
+
+private:
+    // At least n unread bytes in the buffer; false at the end of the file
+    bool fill(std::size_t n) {
+        if (end_ - pos_ >= n) return true;
+        std::memmove(buf_.data(), buf_.data() + pos_, end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+        if (buf_.size() < n) buf_.resize(n);
+        while (end_ < n && in_) {
+            in_.read(buf_.data() + end_, static_cast<std::streamsize>(buf_.size() - end_));
+            end_ += static_cast<std::size_t>(in_.gcount());
+        }
+        if (end_ < n && end_ > 0) failed_ = true;
+        return end_ >= n;
+    }
+
+    std::ifstream in_;
+    std::string buf_;
+    std::size_t pos_ = 0, end_ = 0;
+    bool failed_ = false;
+};
+
+void put_record(std::string &out, std::string_view key, std::string_view payload) {
+    const std::uint32_t sizes[2] = {static_cast<std::uint32_t>(key.size()), static_cast<std::uint32_t>(payload.size())};
+    out.append(reinterpret_cast<const char *>(sizes), sizeof sizes);
+    out.append(key).append(payload);
+}
+
+} // namespace
+
+ExternalSorter::ExternalSorter(std::string tmpDir, std::size_t memoryLimit)
+    : tmpDir_(std::move(tmpDir)), memoryLimit_(std::max<std::size_t>(memoryLimit, 2 * kMinRunBuffer)) {}
+
+ExternalSorter::~ExternalSorter() {
+    std::error_code ec;
+    for (const auto &run : runs_) fs::remove(run, ec);
+    if (nextRun_) fs::remove(tmpDir_, ec);   // only if empty
+}
+
+std::string ExternalSorter::run_path(std::size_t n) const {
+    return (fs::path(tmpDir_) / ("run-" + std::to_string(n) + ".bin")).string();
+}
+
+bool ExternalSorter::add(std::string_view key, std::string_view payload) {
+    if (failed_) return false;
+    // Half the budget for records and their entries (twice: stable_sort takes
+    // a scratch copy), half as slack for the arena growing
+    const std::size_t bytes = key.size() + payload.size();
+    if (!entries_.empty() && arena_.size() + bytes + (entries_.size() + 1) * 2 * sizeof(Entry) > memoryLimit_ / 2 &&
+        !spill())
+        return false;
+    entries_.push_back({arena_.size(), static_cast<std::uint32_t>(key.size()), static_cast<std::uint32_t>(payload.size())});
+    arena_.append(key).append(payload);
+    ++records_;
+    return true;
+}
+
+void ExternalSorter::sort_entries() {
+    std::stable_sort(entries_.begin(), entries_.end(), [&](const Entry &a, const Entry &b) {
+        return std::string_view(arena_.data() + a.at, a.keyBytes) < std::string_view(arena_.data() + b.at, b.keyBytes);
+    });
+}
+
+// The records in memory, sorted, as the next run file
+bool ExternalSorter::spill() {
+    sort_entries();
+    std::error_code ec;
+    fs::create_directories(tmpDir_, ec);
+    const std::string path = run_path(nextRun_++);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string buf;
+    for (const Entry &e : entries_) {
+        put_record(buf, std::string_view(arena_.data() + e.at, e.keyBytes),
+                   std::string_view(arena_.data() + e.at + e.keyBytes, e.payloadBytes));
+        if (buf.size() >= kMinRunBuffer) { out.write(buf.data(), static_cast<std::streamsize>(buf.size())); buf.clear(); }
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    out.close();
+    runs_.push_back(path);
+    arena_.clear();
+    entries_.clear();
+    if (!out) failed_ = true;
+    return !failed_;
+}
+
+// runs[from, to) merged into `out`; ties go to the earlier run, which holds
+// the records added earlier
+bool ExternalSorter::merge(const std::vector<std::string> &runs, std::size_t from, std::size_t to,
+                           const std::function<void(std::string_view, std::string_view)> &out) const {
+    const std::size_t k = to - from;
+    std::vector<RunReader> readers;
+    readers.reserve(k);
+    for (std::size_t i = from; i < to; ++i)
+        readers.emplace_back(runs[i], std::max(kMinRunBuffer, memoryLimit_ / (k + 1)));
+
+    auto later = [&](std::size_t a, std::size_t b) {
+        const int c = readers[a].key.compare(readers[b].key);
+        return c != 0 ? c > 0 : a > b;
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+    for (std::size_t i = 0; i < k; ++i)
+        if (readers[i].next()) heap.push(i);
+    while (!heap.empty()) {
+        const std::size_t i = heap.top();
+        heap.pop();
+        out(readers[i].key, readers[i].payload);
+        if (readers[i].next()) heap.push(i);
+    }
+    return std::none_of(readers.begin(), readers.end(), [](const RunReader &r) { return r.failed(); });
+}
+
+bool ExternalSorter::finish(const std::function<void(std::string_view)> &sink) {
+    if (failed_) return false;
+    if (runs_.empty()) {
+        sort_entries();
+        for (const Entry &e : entries_) sink(std::string_view(arena_.data() + e.at + e.keyBytes, e.payloadBytes));
+        arena_.clear();
+        entries_.clear();
+        return true;
+    }
+    if (!entries_.empty() && !spill()) return false;
+    std::string{}.swap(arena_);
+    std::vector<Entry>{}.swap(entries_);
+
+    // Consecutive runs are merged, so that earlier records stay first, until
+    // one pass can take them all
+    const std::size_t fanIn = std::clamp<std::size_t>(memoryLimit_ / kMinRunBuffer - 1, 2, kMaxFanIn);
+    while (runs_.size() > fanIn) {
+        std::vector<std::string> next;
+        for (std::size_t from = 0; from < runs_.size(); from += fanIn) {
+            const std::size_t to = std::min(from + fanIn, runs_.size());
+            if (to - from == 1) { next.push_back(runs_[from]); continue; }
+            const std::string path = run_path(nextRun_++);
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            std::string buf;
+            const bool read = merge(runs_, from, to, [&](std::string_view key, std::string_view payload) {
+                put_record(buf, key, payload);
+                if (buf.size() >= kMinRunBuffer) { out.write(buf.data(), static_cast<std::streamsize>(buf.size())); buf.clear(); }
+            });
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            out.close();
+            next.push_back(path);
+            std::error_code ec;
+            for (std::size_t i = from; i < to; ++i) fs::remove(runs_[i], ec);
+            if (!read || !out) {
+                next.insert(next.end(), runs_.begin() + static_cast<std::ptrdiff_t>(to), runs_.end());
+                runs_ = std::move(next);   // still removed by the destructor
+                failed_ = true;
+                return false;
+            }
+        }
+        runs_ = std::move(next);
+    }
+    return merge(runs_, 0, runs_.size(), [&](std::string_view, std::string_view payload) { sink(payload); });
+}
+
+} // namespace util
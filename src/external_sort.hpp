@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// Sorts records (a key and a payload) by key bytes in bounded memory; equal
+// keys keep the order they were added in. Records are gathered until they
+// fill `memoryLimit`, sorted, and spilled as a binary run file into `tmpDir`.
+// finish() merges the runs k ways, in several passes when there are more runs
+// than the budget can buffer at once. Input that fits never touches the disk.
+class ExternalSorter {
+public:
+    ExternalSorter(std::string tmpDir, std::size_t memoryLimit);
+    ~ExternalSorter();  // removes the run files
+    ExternalSorter(const ExternalSorter &) = delete;
+    ExternalSorter &operator=(const ExternalSorter &) = delete;
+
+    // False once a run could not be written
+    bool add(std::string_view key, std::string_view payload);
+
+    // Every payload, in key order; false on an I/O failure (the sink may then
+    // have seen only some of them)
+    bool finish(const std::function<void(std::string_view payload)> &sink);
+
+    std::size_t records() const { return records_; }
+    std::size_t runs() const { return runs_.size(); }  // spilled so far
+
+private:
+    struct Entry {
+        std::size_t at;                     // into arena_: the key, then the payload
+        std::uint32_t keyBytes, payloadBytes;
+    };
+
+    bool spill();
+    void sort_entries();
+    bool merge(const std::vector<std::string> &runs, std::size_t from, std::size_t to,
+               const std::function<void(std::string_view, std::string_view)> &out) const;
+    std::string run_path(std::size_t n) const;
+
+    std::string tmpDir_;
+    std::size_t memoryLimit_;
+    std::string arena_;
+    std::vector<Entry> entries_;
+    std::vector<std::string> runs_;
+    std::size_t nextRun_ = 0;
+    std::size_t records_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace util
@@ -0,0 +1,192 @@
+#include "extract_rules.hpp"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace extract {
+
+namespace {
+
+// ASCII subset of ECMAScript \s
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+inline bool is_word(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+inline bool is_num(char c) { return is_digit(c) || c == '-' || c == '.'; }
+
+inline std::size_t skip_ws(std::string_view s, std::size_t i) {
+    while (i < s.size() && is_space(s[i])) ++i;
+    return i;
+}
+
+template <class Pred>
+inline std::size_t take(std::string_view s, std::size_t i, Pred p) {
+    while (i < s.size() && p(s[i])) ++i;
+    return i;
+}
+
+// FNV-1a with the seed folded in before a murmur3 finalizer, so every seed
+// reshuffles the low bits used for the slot index
+inline std::uint32_t seeded_hash(std::string_view s, std::uint32_t seed) {
+    std::uint32_t h = 2166136261u;
+    for (unsigned char c : s) { h ^= c; h *= 16777619u; }
+    h ^= seed * 0x9e3779b9u;
+    h ^= h >> 16; h *= 0x85ebca6bu;
+    h ^= h >> 13; h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Try to match the capture shape right after the anchor (s starts there).
+bool match_shape(Shape shape, std::string_view s, Match &m) {
+    std::size_t i = 0, b = 0;
+    switch (shape) {
+    case Shape::Presence:
+        return true;
+    case Shape::Quoted:
+        i = skip_ws(s, i);
+        if (i >= s.size() || s[i] != ':') return false;
+        i = skip_ws(s, i + 1);
+        [[fallthrough]];
+    case Shape::SpacedQuoted:
+        if (shape == Shape::SpacedQuoted) {
+            b = i;
+            i = skip_ws(s, i);
+            if (i == b) return false;
+        }
+        if (i >= s.size() || s[i] != '"') return false;
+        b = ++i;
+        i = take(s, i, [](char c) { return c != '"'; });
+        if (i == b || i >= s.size()) return false;
+        m.cap[0] = s.substr(b, i - b);
+        return true;
+    case Shape::KeyValue: {
+        i = skip_ws(s, i);
+        b = i;
+        i = take(s, i, is_word);
+        if (i == b) return false;
+        m.cap[0] = s.substr(b, i - b);
+        i = skip_ws(s, i);
+        if (i >= s.size() || s[i] != ':') return false;
+        // '.' stops at a carriage return
+        auto rest = s.substr(i + 1);
+        rest = rest.substr(0, rest.find_first_of("\r\n"));
+        m.cap[1] = trim_view(rest);
+        return true;
+    }
+    case Shape::ParenInt:
+        i = skip_ws(s, i);
+        if (i >= s.size() || s[i] != '(') return false;
+        b = ++i;
+        i = take(s, i, is_digit);
+        if (i == b || i >= s.size() || s[i] != ')') return false;
+        m.cap[0] = s.substr(b, i - b);
+        return true;
+    case Shape::Int:
+    case Shape::Seconds:
+        i = skip_ws(s, i);
+        b = i;
+        i = take(s, i, is_digit);
+        if (i == b) return false;
+        m.cap[0] = s.substr(b, i - b);
+        if (shape == Shape::Seconds) {
+            i = skip_ws(s, i);
+            if (s.substr(i, 7) != "seconds") return false;
+        }
+        return true;
+    case Shape::Triple:
+        i = skip_ws(s, i);
+        for (int k = 0; k < 3; ++k) {
+            if (k) {
+                b = i;
+                i = skip_ws(s, i);
+                if (i == b) return false;
+            }
+            b = i;
+            i = take(s, i, is_num);
+            if (i == b) return false;
+            m.cap[k] = s.substr(b, i - b);
+        }
+        return true;
+    case Shape::Rest:
+        m.cap[0] = trim_view(s);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+std::string_view trim_view(std::string_view s) {
+    static constexpr char ws[] = " \t\r\n";
+    const auto b = s.find_first_not_of(ws);
+    if (b == std::string_view::npos) return {};
+    const auto e = s.find_last_not_of(ws);
+    return s.substr(b, e - b + 1);
+}
+
+Matcher::Matcher(std::span<const Rule> rules, std::span<const std::string_view> keys)
+    : rules_(rules.begin(), rules.end()), keys_(keys.begin(), keys.end()) {
+    if (rules_.size() > kMaxRules) throw std::invalid_argument("extract::Matcher: too many rules");
+    for (std::size_t r = 0; r < rules_.size(); ++r) {
+        if (rules_[r].anchor.empty()) throw std::invalid_argument("extract::Matcher: empty anchor");
+        first_[static_cast<unsigned char>(rules_[r].anchor.front())] |= 1u << r;
+    }
+
+    // Search for a seed that maps every distinct key to its own slot (table at
+    // least 2x keys); a repeated key shares the slot of its first occurrence,
+    // or no seed would ever separate the two
+    const std::size_t size = std::bit_ceil(keys_.size() * 2 + 1);
+    mask_ = static_cast<std::uint32_t>(size - 1);
+    for (seed_ = 0;; ++seed_) {
+        slots_.assign(size, -1);
+        bool ok = true;
+        for (std::size_t k = 0; k < keys_.size() && ok; ++k) {
+            auto &slot = slots_[seeded_hash(keys_[k], seed_) & mask_];
+            if (slot >= 0 && keys_[slot] == keys_[k]) continue;
+            ok = slot < 0;
+            slot = static_cast<std::int16_t>(k);
+        }
+        if (ok) break;
+    }
+}
+
+int Matcher::key_index(std::string_view key) const {
+    const int k = slots_[seeded_hash(key, seed_) & mask_];
+    return (k >= 0 && keys_[k] == key) ? k : -1;
+}
+
+std::size_t Matcher::scan(std::string_view line, Match *out) const {
+    Match found[kMaxRules];
+    const std::uint32_t all = rules_.size() == 32 ? ~0u : (1u << rules_.size()) - 1;
+    std::uint32_t pending = all;
+
+    for (std::size_t i = 0; i < line.size() && pending; ++i) {
+        std::uint32_t cand = first_[static_cast<unsigned char>(line[i])] & pending;
+        while (cand) {
+            const int r = std::countr_zero(cand);
+            cand &= cand - 1;
+            const auto &rule = rules_[r];
+            if (line.size() - i < rule.anchor.size() ||
+                std::memcmp(line.data() + i, rule.anchor.data(), rule.anchor.size()) != 0)
+                continue;
+            Match m;
+            if (!match_shape(rule.shape, line.substr(i + rule.anchor.size()), m)) continue;
+            m.id = rule.id;
+            if (rule.shape == Shape::KeyValue) m.key = key_index(m.cap[0]);
+            found[r] = m;
+            pending &= ~(1u << r);
+        }
+    }
+
+    std::size_t n = 0;
+    for (std::uint32_t hit = all & ~pending; hit; hit &= hit - 1)
+        out[n++] = found[std::countr_zero(hit)];
+    return n;
+}
+
+} // namespace extract
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Declarative line extraction shared by the PhotoMesh and RealityMesh parsers.
+// Each rule is an anchor literal followed by a fixed capture shape; all rules of
+// a parser are compiled into one Matcher that scans a line once.
+namespace extract {
+
+enum class Shape : std::uint8_t {
+    Presence,     // anchor only
+    Quoted,       // \s*:\s*"([^"]+)"
+    SpacedQuoted, // \s+"([^"]+)"
+    KeyValue,     // \s*(\w+)\s*:\s*(.*)   value trimmed, key resolved via the key table
+    ParenInt,     // \s*\((\d+)\)
+    Int,          // \s*(\d+)
+    Seconds,      // \s*(\d+)\s*seconds
+    Triple,       // \s*([-0-9.]+)\s+([-0-9.]+)\s+([-0-9.]+)
+    Rest,         // (.*)  trimmed
+};
+
+struct Rule {
+    std::string_view anchor;
+    Shape shape;
+    int id;        // caller-defined target, echoed back in Match::id
+};
+
+struct Match {
+    int id = -1;
+    int key = -1;  // KeyValue only: index into the key table, -1 if unknown
+    std::array<std::string_view, 3> cap{};
+};
+
+constexpr std::size_t kMaxRules = 32;
+
+class Matcher {
+public:
+    // Throws std::invalid_argument for more than kMaxRules rules or an empty
+    // anchor. A key listed twice resolves to its first index.
+    Matcher(std::span<const Rule> rules, std::span<const std::string_view> keys = {});
+
+    // Scan the line once. Writes at most one match per rule into out[] (leftmost
+    // occurrence that satisfies the shape), in rule-table order; returns the count.
+    std::size_t scan(std::string_view line, Match *out) const;
+
+    // Perfect-hash lookup of a KeyValue key; -1 when not in the table.
+    int key_index(std::string_view key) const;
+
+private:
+    std::vector<Rule> rules_;
+    std::array<std::uint32_t, 256> first_{};   // first anchor byte -> rule bitmask
+    std::vector<std::string_view> keys_;
+    std::vector<std::int16_t> slots_;
+    std::uint32_t seed_ = 0;
+    std::uint32_t mask_ = 0;
+};
+
+// Trim leading/trailing " \t\r\n" without copying.
+std::string_view trim_view(std::string_view s);
+
+} // namespace extract
@@ -0,0 +1,159 @@
+#include "file_lock.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+#ifdef _WIN32
+
+FileLock::FileLock(const std::string &path, bool shared) {
+    HANDLE h = ::CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ | GENERIC_WRITE,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return;
+    handle_ = h;
+    OVERLAPPED ov{};
+    locked_ = ::LockFileEx(h, shared ? 0 : LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &ov) != 0;
+}
+
+FileLock::~FileLock() {
+    if (!handle_) return;
+    if (locked_) {
+        OVERLAPPED ov{};
+        ::UnlockFileEx(handle_, 0, MAXDWORD, MAXDWORD, &ov);
+    }
+    ::CloseHandle(handle_);
+}
+
+FileLock::FileLock(FileLock &&o) noexcept : handle_(o.handle_), locked_(o.locked_) {
+    o.handle_ = nullptr;
+    o.locked_ = false;
+}
+
+static bool write_and_sync(const std::string &path, std::string_view data) {
+    HANDLE h = ::CreateFileW(std::filesystem::path(path).c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    bool ok = true;
+    while (ok && !data.empty()) {
+        DWORD n = 0;
+        const DWORD chunk = data.size() > (1u << 30) ? (1u << 30) : static_cast<DWORD>(data.size());
+        ok = ::WriteFile(h, data.data(), chunk, &n, nullptr) != 0;
+        data.remove_prefix(n);
+    }
+    ok = ok && ::FlushFileBuffers(h) != 0;
+    ::CloseHandle(h);
+    return ok;
+}
+
+bool sync_file(const std::string &path) {
+    HANDLE h = ::CreateFileW(std::filesystem::path(path).c_str(), GENERIC_WRITE,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    const bool ok = ::FlushFileBuffers(h) != 0;
+    ::CloseHandle(h);
+    return ok;
+}
+
+static void sync_dir(const std::string &) {}  // renames are journaled by NTFS
+
+#else
+
+FileLock::FileLock(const std::string &path, bool shared) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd_ < 0) return;
+    int rc;
+    do rc = ::flock(fd_, shared ? LOCK_SH : LOCK_EX);
+    while (rc != 0 && errno == EINTR);
+    locked_ = rc == 0;
+}
+
+FileLock::~FileLock() {
+    if (fd_ >= 0) ::close(fd_);  // releases the lock
+}
+
+FileLock::FileLock(FileLock &&o) noexcept : fd_(o.fd_), locked_(o.locked_) {
+    o.fd_ = -1;
+    o.locked_ = false;
+}
+
+static bool write_and_sync(const std::string &path, std::string_view data) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+    bool ok = true;
+    while (ok && !data.empty()) {
+        const ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) data.remove_prefix(static_cast<std::size_t>(n));
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool sync_file(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// Makes a rename in `dir` durable
+static void sync_dir(const std::string &dir) {
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+#endif
+
+std::string unique_temp_path(const std::string &path) {
+    static std::atomic<unsigned> seq{0};
+    static const std::uint64_t nonce = (std::uint64_t(std::random_device{}()) << 32) ^ std::random_device{}();
+    char suffix[48];
+    std::snprintf(suffix, sizeof suffix, ".%016llx-%u.tmp", static_cast<unsigned long long>(nonce), seq++);
+    return path + suffix;
+}
+
+bool replace_file(const std::string &tmp, const std::string &path) {
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::error_code ignored;
+        std::filesystem::remove(tmp, ignored);
+        return false;
+    }
+    return true;
+}
+
+bool write_file_durably(const std::string &path, std::string_view data) {
+    const std::string tmp = path + ".tmp";
+    if (!write_and_sync(tmp, data)) {
+        std::error_code ignored;
+        std::filesystem::remove(tmp, ignored);
+        return false;
+    }
+    if (!replace_file(tmp, path)) return false;
+    sync_dir(std::filesystem::path(path).parent_path().string());
+    return true;
+}
+
+} // namespace util
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Advisory lock on `path` (created if missing), held from construction until
+// destruction; the constructor blocks until it is granted. Exclusive, or
+// shared with other shared holders (readers). flock() on POSIX, LockFileEx()
+// on Windows: the lock goes away with the process, so a crashed holder never
+// leaves it stuck. locked() is false if the file could not be opened or
+// locked (some network shares refuse locks); callers must not go on then.
+// Move-only.
+class FileLock {
+public:
+    explicit FileLock(const std::string &path, bool shared = false);
+    ~FileLock();
+    FileLock(FileLock &&o) noexcept;
+    FileLock &operator=(FileLock &&o) = delete;
+    FileLock(const FileLock &) = delete;
+    FileLock &operator=(const FileLock &) = delete;
+
+    bool locked() const { return locked_; }
+
+private:
+#ifdef _WIN32
+    void *handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    bool locked_ = false;
+};
+
+// A temp file name beside `path` that no other process (or earlier call)
+// uses, for writers that are not serialized by a lock
+std::string unique_temp_path(const std::string &path);
+
+// `data` written to a temp file beside `path`, flushed to disk and renamed
+// over `path`: readers see the old file or the new one, never part of it
+bool write_file_durably(const std::string &path, std::string_view data);
+
+// Flushes a file's written data to disk; false if it cannot be opened
+bool sync_file(const std::string &path);
+
+// Renames `tmp` over `path`, replacing it; removes `tmp` if that fails
+bool replace_file(const std::string &tmp, const std::string &path);
+
+} // namespace util
@@ -3,8 +3,8 @@
 
 #include <algorithm>
 
-#include "photomesh_parser.hpp"
-#include "realitymesh_parser.hpp"
+#include "archive_reader.hpp"
+#include "ingest.hpp"
 #include "excel_writer.hpp"
 #include "single_sheet_writer.hpp"
 #include "models.hpp"
@@ -151,31 +151,6 @@ static void ensure_dir(const std::string& d) {
     std::error_code ec; fs::create_directories(fs::path(d), ec);
 }
 
-// ---------------------- classification ----------------------
-enum class LogKind { PhotoMesh, RealityMesh, Unknown };
-
-static LogKind detect_log_type(const std::string& path) {
-    std::ifstream in(path);
-    if (!in) return LogKind::Unknown;
-    std::string line; size_t limit = 4000;
-    while (limit-- && std::getline(in, line)) {
-        // PhotoMesh markers
-        if (line.find("SLDEFAULT=>") != std::string::npos ||
-            line.find("\"MachineName\"") != std::string::npos ||
-            line.find("\"MsgTime\"")    != std::string::npos) {
-            return LogKind::PhotoMesh;
-        }
-        // RealityMesh markers
-        if (line.find("Time to run TT project:") != std::string::npos ||
-            line.find("-command_file")           != std::string::npos ||
-            line.find("Process completed with exit code:") != std::string::npos ||
-            line.find("Converted offset:")       != std::string::npos) {
-            return LogKind::RealityMesh;
-        }
-    }
-    return LogKind::Unknown;
-}
-
 // ---------------------- UI state ----------------------
 enum class Mode { MasterOnly, ReportOnly, Both };
 struct UIState {
@@ -196,48 +171,51 @@ static void run_pipeline(HWND hwndLog) {
 
     if (g.dropPaths.empty()) { append("[!] No logs to process."); return; }
 
-    std::vector<std::string> pmFiles, rmFiles;
-    for (auto& p : g.dropPaths) {
-        switch (detect_log_type(p)) {
-            case LogKind::PhotoMesh:   pmFiles.push_back(p); break;
-            case LogKind::RealityMesh: rmFiles.push_back(p); break;
-            default: // unknown -> try both parsers safely
-                pmFiles.push_back(p); rmFiles.push_back(p); break;
-        }
-    }
+    // Each log is classified from its first lines while it is parsed
+    LogInputs inputs;
+    inputs.detect = util::expand_archives(g.dropPaths);
 
     append("[*] Parsing logs...");
-    std::vector<PhotoMeshRow> pm_rows;
-    for (auto &p : pmFiles) pm_rows.push_back(parse_photomesh(p));  // safe to parse; row stays mostly empty if unmatched
-    std::vector<RealityMeshRow> rm_rows;
-    for (auto &p : rmFiles) rm_rows.push_back(parse_realitymesh(p));
+    // Parsed on all cores. Logs seen by an earlier run resume from the saved
+    // state in the outputs dir.
+    ensure_dir(g.outputsDir);
+    const std::string statePath = ParseStateStore::default_path(g.outputsDir);
+    ParseStateStore state;
+    state.load(statePath);
+    ParsedLogs parsed = parse_logs(inputs, 0, &state);
+    if (!state.save(statePath)) append("[!] Could not save parse state: " + statePath);
+    for (const auto& p : parsed.unknown) append("[!] Skipped (not a PhotoMesh/RealityMesh log): " + p);
+    std::vector<PhotoMeshRow>& pm_rows = parsed.pm;
+    std::vector<RealityMeshRow>& rm_rows = parsed.rm;
 
     // Filter out rows that are completely empty (no success, no machine, no duration)
     auto pm_end = std::remove_if(pm_rows.begin(), pm_rows.end(), [](const PhotoMeshRow& r){
-        return r.machine.empty() && r.duration.empty() && r.success.empty() && r.exportType.empty();
+        return r.machine == Sym{} && !r.duration && r.success == Tri::Missing && r.exportType.code == ExportType::Missing;
     });
     pm_rows.erase(pm_end, pm_rows.end());
     auto rm_end = std::remove_if(rm_rows.begin(), rm_rows.end(), [](const RealityMeshRow& r){
-        return r.machine.empty() && r.duration.empty() && r.success.empty() && r.exportType.empty();
+        return r.machine == Sym{} && !r.duration && r.success == Tri::Missing && r.exportType.code == ExportType::Missing;
     });
     rm_rows.erase(rm_end, rm_rows.end());
 
     ensure_dir(g.outputsDir);
 
+    // Views of the rows, shared by the master and the report's summary
+    const auto unified = excel::unify(pm_rows, rm_rows);
+
     // Master single-sheet (append + rebuild)
     if (g.mode == Mode::MasterOnly || g.mode == Mode::Both) {
-        auto unified = excel::unify(pm_rows, rm_rows);
-        excel::append_to_master_and_rebuild_xlsx(g.outputsDir, unified);
-        append("[+] Updated master: " + g.outputsDir + "/All_Exports.xlsx");
+        std::string error;
+        if (excel::append_to_master_and_rebuild_xlsx(g.outputsDir, unified, error))
+            append("[+] Updated master: " + g.outputsDir + "/All_Exports.xlsx");
+        else
+            append("[!] " + error);
     }
 
     // Per-run report (multi-sheet)
     if (g.mode == Mode::ReportOnly || g.mode == Mode::Both) {
-        std::vector<SummaryRow> summary;
-        for (const auto &r : pm_rows) summary.push_back(make_summary(r));
-        for (const auto &r : rm_rows) summary.push_back(make_summary(r));
         const std::string out = g.outputsDir + "/Report.xlsx";
-        excel::write_workbook(out, pm_rows, rm_rows, summary);
+        excel::write_workbook(out, pm_rows, rm_rows, unified);
         append("[+] Wrote per-run report: " + out);
     }
 
@@ -559,7 +537,7 @@ static LRESULT CALLBACK WndProc(HWND h, UINT msg, WPARAM w, LPARAM l) {
                     IFileOpenDialog* dlg = nullptr;
                     if (SUCCEEDED(CoCreateInstance(CLSID_FileOpenDialog, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&dlg)))) {
                         DWORD opts=0; dlg->GetOptions(&opts); dlg->SetOptions(opts | FOS_ALLOWMULTISELECT);
-                        COMDLG_FILTERSPEC filters[] = { { L"Log files (*.log;*.txt)", L"*.log;*.txt" }, { L"All files (*.*)", L"*.*" } };
+                        COMDLG_FILTERSPEC filters[] = { { L"Log files (*.log;*.txt;*.gz;*.zip)", L"*.log;*.txt;*.gz;*.zip" }, { L"All files (*.*)", L"*.*" } };
                         dlg->SetFileTypes(2, filters);
                         if (SUCCEEDED(dlg->Show(nullptr))) {
                             IShellItemArray* items = nullptr;
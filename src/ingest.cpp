@@ -0,0 +1,148 @@
+#include "ingest.hpp"
+#include "content_hash.hpp"
+#include "photomesh_parser.hpp"
+#include "realitymesh_parser.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+// Content hash -> the stored log of one kind that had it first (the one not
+// flagged as a duplicate)
+std::unordered_map<std::uint64_t, const std::string *> content_owners(const ParseStateStore &store,
+                                                                      std::string_view kind) {
+    std::unordered_map<std::uint64_t, const std::string *> out;
+    for (const auto &[key, e] : store.entries()) {
+        if (!e.contentHash || e.duplicate || key.size() <= kind.size() || key.compare(0, kind.size(), kind) != 0 ||
+            key[kind.size()] != '\t')
+            continue;
+        out.emplace(e.contentHash, &key);
+    }
+    return out;
+}
+
+} // namespace
+
+ParsedLogs parse_logs(const LogInputs &logs, unsigned jobs, ParseStateStore *resume) {
+    // One flat index space so every log shares the same workers; each task
+    // writes only its own slot. Workers only read the store.
+    struct Slot {
+        const std::string *path = nullptr;
+        LogKind kind = LogKind::Unknown;
+        std::string key{};
+        TailEntry tail{};
+        PhotoMeshRow pm{};
+        RealityMeshRow rm{};
+    };
+    std::vector<Slot> slots;
+    slots.reserve(logs.photomesh.size() + logs.realitymesh.size() + logs.detect.size());
+    for (const auto &p : logs.photomesh) slots.push_back({&p, LogKind::PhotoMesh});
+    for (const auto &p : logs.realitymesh) slots.push_back({&p, LogKind::RealityMesh});
+    for (const auto &p : logs.detect) slots.push_back({&p, LogKind::Unknown});
+    const size_t total = slots.size();
+
+    // Fewer files than threads: spare threads split large files into chunks
+    ParseOptions opt;
+    if (total) opt.threads = std::max<unsigned>(1, util::resolve_jobs(jobs) / static_cast<unsigned>(total));
+
+    auto parse_known = [&](Slot &s) {
+        TailEntry *tail = resume ? &s.tail : nullptr;
+        if (s.kind == LogKind::PhotoMesh) s.pm = parse_photomesh(*s.path, opt, tail);
+        else s.rm = parse_realitymesh(*s.path, opt, tail);
+    };
+
+    util::parallel_for(total, jobs, [&](size_t i) {
+        Slot &s = slots[i];
+        if (s.kind != LogKind::Unknown) {
+            if (resume) {
+                s.key = ParseStateStore::key(log_format(s.kind).name, *s.path);
+                s.tail = resume->get(s.key);
+            }
+            parse_known(s);
+            return;
+        }
+
+        std::optional<util::FileStamp> stamp;
+        if (resume) {
+            // Unchanged since an earlier run classified it: no need to read it
+            stamp = util::file_stamp(*s.path);
+            for (const auto &f : log_formats()) {
+                TailEntry t = resume->get(ParseStateStore::key(f.name, *s.path));
+                if (stamp && t.stamp.mtime && t.stamp.size == stamp->size && t.stamp.mtime == stamp->mtime) {
+                    s.kind = f.kind;
+                    s.key = ParseStateStore::key(f.name, *s.path);
+                    s.tail = std::move(t);
+                    parse_known(s);
+                    return;
+                }
+            }
+        }
+
+        // Classify from the head of the buffer the parser then consumes
+        OpenLog log(*s.path, stamp);
+        s.kind = sniff_log(log.in.head(kSniffLines));
+        if (s.kind == LogKind::Unknown) return;
+        TailEntry *tail = nullptr;
+        if (resume) {
+            s.key = ParseStateStore::key(log_format(s.kind).name, *s.path);
+            s.tail = resume->get(s.key);
+            tail = &s.tail;
+        }
+        if (s.kind == LogKind::PhotoMesh) s.pm = parse_photomesh(log, *s.path, opt, tail);
+        else s.rm = parse_realitymesh(log, *s.path, opt, tail);
+    });
+
+    // Rows in input order; duplicate content is judged against the store as
+    // it was before this call
+    ParsedLogs out;
+    std::unordered_map<std::uint64_t, const std::string *> stored[2];
+    if (resume) {
+        stored[0] = content_owners(*resume, log_format(LogKind::PhotoMesh).name);
+        stored[1] = content_owners(*resume, log_format(LogKind::RealityMesh).name);
+    }
+    for (auto &s : slots) {
+        if (s.kind == LogKind::Unknown) {
+            out.unknown.push_back(*s.path);
+            continue;
+        }
+        const bool isPm = s.kind == LogKind::PhotoMesh;
+        const size_t row = isPm ? out.pm.size() : out.rm.size();
+        if (isPm) out.pm.push_back(std::move(s.pm));
+        else out.rm.push_back(std::move(s.rm));
+
+        if (!resume) continue;
+        // The first log with this content, stored or earlier in this call, owns it
+        const std::uint64_t h = s.tail.contentHash;
+        s.tail.duplicate = h && *stored[!isPm].emplace(h, &s.key).first->second != s.key;
+        if (s.tail.duplicate) (isPm ? out.pmDuplicates : out.rmDuplicates).push_back(row);
+    }
+
+    if (resume)
+        for (auto &s : slots)
+            if (s.kind != LogKind::Unknown) resume->put(s.key, std::move(s.tail));
+    return out;
+}
+
+ParsedLogs parse_logs(const std::vector<std::string> &photomeshLogs,
+                      const std::vector<std::string> &realitymeshLogs,
+                      unsigned jobs,
+                      ParseStateStore *resume) {
+    return parse_logs(LogInputs{photomeshLogs, realitymeshLogs, {}}, jobs, resume);
+}
+
+LogInputs select_shard(const LogInputs &logs, unsigned index, unsigned count) {
+    auto pick = [&](const std::vector<std::string> &paths) {
+        std::vector<std::string> out;
+        for (const auto &p : paths) {
+            std::string key = p;
+            std::replace(key.begin(), key.end(), '\\', '/');
+            if (util::content_hash(key) % count == index) out.push_back(p);
+        }
+        return out;
+    };
+    return {pick(logs.photomesh), pick(logs.realitymesh), pick(logs.detect)};
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "log_format.hpp"
+#include "models.hpp"
+#include "parse_state.hpp"
+#include <string>
+#include <vector>
+
+struct LogInputs {
+    std::vector<std::string> photomesh;    // known PhotoMesh logs
+    std::vector<std::string> realitymesh;  // known RealityMesh logs
+    std::vector<std::string> detect;       // classified from their first lines
+};
+
+struct ParsedLogs {
+    std::vector<PhotoMeshRow> pm;
+    std::vector<RealityMeshRow> rm;
+
+    // Logs from LogInputs::detect that matched no registered format
+    std::vector<std::string> unknown;
+
+    // With a state store: indices of rows whose log content was already seen
+    // under another path, earlier in this call or by an earlier run
+    std::vector<size_t> pmDuplicates, rmDuplicates;
+};
+
+// Parse every log on up to `jobs` threads (0 = hardware concurrency).
+// Rows come back in input order regardless of which thread parsed them:
+// known logs first, then detected ones. Each log is opened and read once;
+// a detected log is classified from the start of the buffer its parser then
+// consumes. When there are fewer files than threads, large files are chunk-parsed.
+// With a state store, unchanged logs are not reopened, growing logs resume
+// from their saved offset, and the store is updated to the new end of every log.
+ParsedLogs parse_logs(const LogInputs &logs, unsigned jobs = 0, ParseStateStore *resume = nullptr);
+
+// Known PhotoMesh and RealityMesh logs only
+ParsedLogs parse_logs(const std::vector<std::string> &photomeshLogs,
+                      const std::vector<std::string> &realitymeshLogs,
+                      unsigned jobs = 0,
+                      ParseStateStore *resume = nullptr);
+
+// Shard `index` of `count`: the inputs whose path (with '\\' read as '/')
+// hashes to it. Nodes given the same input list and each its own index split
+// it with no overlap, and a log always lands in the same shard.
+LogInputs select_shard(const LogInputs &logs, unsigned index, unsigned count);
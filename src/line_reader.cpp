@@ -0,0 +1,332 @@
+#include "line_reader.hpp"
+#include "archive_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <mutex>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+namespace {
+constexpr std::size_t kReadChunk = 1 << 20;
+}
+
+// ---------------- MappedFile ----------------
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path, bool) {
+    HANDLE f = ::CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return;
+    LARGE_INTEGER sz{};
+    if (::GetFileType(f) != FILE_TYPE_DISK || !::GetFileSizeEx(f, &sz)) { ::CloseHandle(f); return; }
+    file_ = f;
+    size_ = static_cast<std::size_t>(sz.QuadPart);
+    if (size_ == 0) { open_ = true; return; }
+    mapping_ = ::CreateFileMappingW(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) data_ = static_cast<const char *>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) { close(); return; }
+    open_ = true;
+}
+
+bool MappedFile::truncated() const { return false; }
+
+std::size_t MappedFile::read(std::uint64_t offset, char *dst, std::size_t n) const {
+    std::size_t got = 0;
+    while (file_ && got < n) {
+        OVERLAPPED at{};
+        at.Offset = static_cast<DWORD>(offset + got);
+        at.OffsetHigh = static_cast<DWORD>((offset + got) >> 32);
+        DWORD part = 0;
+        const DWORD want = static_cast<DWORD>(std::min<std::size_t>(n - got, 1u << 30));
+        if (!::ReadFile(file_, dst + got, want, &part, &at) || part == 0) break;
+        got += part;
+    }
+    return got;
+}
+
+void MappedFile::close() {
+    if (data_) ::UnmapViewOfFile(data_);
+    if (mapping_) ::CloseHandle(mapping_);
+    if (file_) ::CloseHandle(file_);
+    data_ = nullptr; mapping_ = nullptr; file_ = nullptr;
+    size_ = 0; open_ = false;
+}
+
+MappedFile::MappedFile(MappedFile &&o) noexcept
+    : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)),
+      open_(std::exchange(o.open_, false)), file_(std::exchange(o.file_, nullptr)),
+      mapping_(std::exchange(o.mapping_, nullptr)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+    if (this != &o) {
+        close();
+        data_ = std::exchange(o.data_, nullptr);
+        size_ = std::exchange(o.size_, 0);
+        open_ = std::exchange(o.open_, false);
+        file_ = std::exchange(o.file_, nullptr);
+        mapping_ = std::exchange(o.mapping_, nullptr);
+    }
+    return *this;
+}
+
+#else
+
+namespace {
+
+// Guarded mappings, found by the SIGBUS handler without locking
+struct Guard {
+    std::atomic<bool> used{false};
+    std::atomic<std::uintptr_t> begin{0}, end{0};
+    std::atomic<bool> cut{false};
+};
+constexpr int kGuards = 1024;
+Guard g_guards[kGuards];
+std::uintptr_t g_pageSize = 4096;
+struct sigaction g_previous;
+
+// A read past the end of a truncated file faults; back the rest of that
+// mapping with zero pages so the read resumes, and flag it. Faults outside
+// guarded mappings go to the previous handler.
+void on_sigbus(int sig, siginfo_t *info, void *) {
+    const auto at = reinterpret_cast<std::uintptr_t>(info->si_addr);
+    for (Guard &g : g_guards) {
+        const std::uintptr_t b = g.begin.load(std::memory_order_acquire), e = g.end.load(std::memory_order_acquire);
+        if (at < b || at >= e) continue;
+        const std::uintptr_t page = at & ~(g_pageSize - 1);
+        if (::mmap(reinterpret_cast<void *>(page), e - page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1,
+                   0) == MAP_FAILED)
+            break;
+        g.cut.store(true, std::memory_order_release);
+        return;
+    }
+    ::sigaction(sig, &g_previous, nullptr);  // the access faults again, now unhandled
+}
+
+int add_guard(const void *p, std::size_t n) {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        g_pageSize = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        struct sigaction sa{};
+        sa.sa_sigaction = on_sigbus;
+        sa.sa_flags = SA_SIGINFO;
+        sigemptyset(&sa.sa_mask);
+        ::sigaction(SIGBUS, &sa, &g_previous);
+    });
+    for (int i = 0; i < kGuards; ++i) {
+        bool free = false;
+        if (!g_guards[i].used.compare_exchange_strong(free, true)) continue;
+        g_guards[i].cut.store(false);
+        g_guards[i].end.store(reinterpret_cast<std::uintptr_t>(p) + n, std::memory_order_release);
+        g_guards[i].begin.store(reinterpret_cast<std::uintptr_t>(p), std::memory_order_release);
+        return i;
+    }
+    return -1;  // all slots busy: left unguarded
+}
+
+void drop_guard(int i) {
+    g_guards[i].begin.store(0, std::memory_order_release);
+    g_guards[i].end.store(0, std::memory_order_release);
+    g_guards[i].used.store(false, std::memory_order_release);
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::string &path, bool guarded) {
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) return;
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) { close(); return; }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) { open_ = true; return; }
+    void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (p == MAP_FAILED) { close(); return; }
+    ::madvise(p, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(p);
+    if (guarded) guard_ = add_guard(data_, size_);
+    open_ = true;
+}
+
+bool MappedFile::truncated() const {
+    return guard_ >= 0 && g_guards[guard_].cut.load(std::memory_order_acquire);
+}
+
+std::size_t MappedFile::read(std::uint64_t offset, char *dst, std::size_t n) const {
+    std::size_t got = 0;
+    while (fd_ >= 0 && got < n) {
+        const ssize_t part = ::pread(fd_, dst + got, n - got, static_cast<off_t>(offset + got));
+        if (part < 0 && errno == EINTR) continue;
+        if (part <= 0) break;
+        got += static_cast<std::size_t>(part);
+    }
+    return got;
+}
+
+void MappedFile::close() {
+    if (guard_ >= 0) drop_guard(guard_);
+    if (data_) ::munmap(const_cast<char *>(data_), size_);
+    if (fd_ >= 0) ::close(fd_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    fd_ = guard_ = -1;
+}
+
+MappedFile::MappedFile(MappedFile &&o) noexcept
+    : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)),
+      open_(std::exchange(o.open_, false)), fd_(std::exchange(o.fd_, -1)), guard_(std::exchange(o.guard_, -1)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+    if (this != &o) {
+        close();
+        data_ = std::exchange(o.data_, nullptr);
+        size_ = std::exchange(o.size_, 0);
+        open_ = std::exchange(o.open_, false);
+        fd_ = std::exchange(o.fd_, -1);
+        guard_ = std::exchange(o.guard_, -1);
+    }
+    return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+// ---------------- LineReader ----------------
+
+LineReader::LineReader(const std::string &path) {
+    std::string archive, entry;
+    if (split_archive_path(path, archive, entry)) {
+        open_entry(archive, entry);
+        return;
+    }
+    map_ = MappedFile(path, true);
+    if (map_.is_open()) {
+        const std::string_view whole = map_.data();
+        if (is_gzip(whole)) {
+            inflate_ = std::make_unique<Inflater>(Inflater::Format::Gzip, whole);
+            return;
+        }
+        text_ = rest_ = whole;
+        direct_ = eof_ = true;
+        return;
+    }
+    // Pipes, FIFOs, devices: stream in fixed-size chunks
+    in_.open(path, std::ios::binary);
+}
+
+LineReader::~LineReader() = default;
+
+std::string LineReader::read_at(std::uint64_t offset, std::size_t n) const {
+    std::string out;
+    if (offset >= text_.size()) return out;
+    n = static_cast<std::size_t>(std::min<std::uint64_t>(n, text_.size() - offset));
+    if (!map_.is_open()) return out.assign(text_.substr(static_cast<std::size_t>(offset), n));  // stored zip entry
+    out.resize(n);
+    out.resize(map_.read(offset, out.data(), n));
+    return out;
+}
+
+bool LineReader::truncated() const { return map_.truncated(); }
+
+void LineReader::open_entry(const std::string &archive, const std::string &entry) {
+    zip_ = open_zip(archive);
+    if (!zip_) return;
+    const ZipEntry *e = zip_->dir.find(entry);
+    if (!e || e->encrypted) return;
+    const std::string_view data = zip_->dir.data(*e);
+    if (e->method == 0 && data.size() == e->size) {
+        text_ = rest_ = data;
+        direct_ = eof_ = true;
+    } else if (e->method == 8) {
+        inflate_ = std::make_unique<Inflater>(Inflater::Format::RawDeflate, data);
+    }
+}
+
+bool LineReader::refill() {
+    // Keep the unfinished line, then append the next chunk after it
+    const std::size_t keep = rest_.size();
+    if (keep && rest_.data() != buf_.data()) std::memmove(buf_.data(), rest_.data(), keep);
+    buf_.resize(keep + kReadChunk);
+    std::size_t got;
+    if (inflate_) {
+        got = inflate_->read(buf_.data() + keep, kReadChunk);
+    } else {
+        in_.read(buf_.data() + keep, static_cast<std::streamsize>(kReadChunk));
+        got = static_cast<std::size_t>(in_.gcount());
+    }
+    buf_.resize(keep + got);
+    if (got == 0) eof_ = true;
+    rest_ = buf_;
+    return got != 0;
+}
+
+std::string_view LineReader::head(std::size_t lines) {
+    if (!direct_ && is_open()) {
+        // A refill keeps the text already counted in front; count only what it adds
+        auto seen = static_cast<std::size_t>(std::count(rest_.begin(), rest_.end(), '\n'));
+        while (!eof_ && seen < lines) {
+            const std::size_t counted = rest_.size();
+            refill();
+            seen += static_cast<std::size_t>(std::count(rest_.begin() + counted, rest_.end(), '\n'));
+        }
+    }
+    return rest_;
+}
+
+bool LineReader::next(std::string_view &line) {
+    if (direct_) return next_line(rest_, line);
+    if (!is_open()) return false;
+    while (!eof_ && rest_.find('\n') == std::string_view::npos) refill();
+    return next_line(rest_, line);
+}
+
+bool LineReader::next_block(std::string_view &block) {
+    if (!direct_) {
+        if (!is_open()) return false;
+        while (!eof_ && rest_.find('\n') == std::string_view::npos) refill();
+    }
+    if (rest_.empty()) return false;
+    const std::size_t end = eof_ ? rest_.size() : rest_.rfind('\n') + 1;
+    block = rest_.substr(0, end);
+    rest_.remove_prefix(end);
+    return true;
+}
+
+std::vector<std::string_view> split_chunks(std::string_view buf, unsigned parts, std::size_t minBytes) {
+    std::vector<std::string_view> out;
+    if (minBytes == 0) minBytes = 1;
+    std::size_t n = parts ? parts : 1;
+    if (buf.size() / minBytes < n) n = buf.size() / minBytes;
+    if (n == 0) n = 1;
+    const std::size_t step = buf.size() / n;
+    std::size_t begin = 0;
+    for (std::size_t k = 1; k < n && begin < buf.size(); ++k) {
+        std::size_t cut = std::max(begin, k * step);
+        cut = buf.find('\n', cut);
+        if (cut == std::string_view::npos) break;
+        out.push_back(buf.substr(begin, cut + 1 - begin));
+        begin = cut + 1;
+    }
+    if (begin < buf.size() || out.empty()) out.push_back(buf.substr(begin));
+    return out;
+}
+
+} // namespace util
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+class Inflater;
+struct ZipArchive;
+
+// Read-only memory mapping of a whole regular file, sized when opened. Move-only.
+// A guarded mapping survives its file being truncated (a rotated log): on
+// POSIX the pages past the new end read as zeros instead of raising SIGBUS,
+// and truncated() turns true. Windows refuses to truncate a mapped file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path, bool guarded = false);
+    ~MappedFile();
+    MappedFile(MappedFile &&o) noexcept;
+    MappedFile &operator=(MappedFile &&o) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool is_open() const { return open_; }
+    std::string_view data() const { return {data_, size_}; }
+    bool truncated() const;
+
+    // Up to n bytes at `offset` read from the file itself (pread), leaving the
+    // mapping untouched; fewer when the file now ends sooner
+    std::size_t read(std::uint64_t offset, char *dst, std::size_t n) const;
+
+private:
+    void close();
+
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool open_ = false;
+#ifdef _WIN32
+    void *file_ = nullptr;
+    void *mapping_ = nullptr;
+#else
+    int fd_ = -1;
+    int guard_ = -1;  // slot watched by the SIGBUS handler
+#endif
+};
+
+// Line iteration over a log file. Regular files are memory-mapped (guarded, as
+// rotation may truncate a log while it is read) and lines are views into the
+// mapping; pipes and special files fall back to buffered reads, where a line
+// stays valid only until the next call to next().
+// Gzip files and zip entries ("job.zip!/a.log") are inflated while streaming;
+// stored zip entries are read straight from the mapped archive.
+// The '\n' and a trailing '\r' are stripped.
+class LineReader {
+public:
+    explicit LineReader(const std::string &path);
+    ~LineReader();
+
+    bool is_open() const { return direct_ || in_.is_open() || inflate_; }
+    bool is_mapped() const { return direct_; }
+    bool next(std::string_view &line);
+
+    // Next run of whole lines ('\n' kept): the rest of the mapping, or what
+    // one buffered read completed. Valid until the next call.
+    bool next_block(std::string_view &block);
+
+    // Start of the remaining text without consuming it: everything when
+    // mapped, else at least `lines` whole lines (or all that is left)
+    std::string_view head(std::size_t lines = 1);
+
+    // Whole text when it lies uncompressed in a mapping, empty otherwise
+    std::string_view mapped() const { return text_; }
+
+    // Copy of up to n bytes of mapped() from `offset`, read with pread for a
+    // plain file so none of the mapped pages are touched; shorter when the file
+    // now ends sooner
+    std::string read_at(std::uint64_t offset, std::size_t n) const;
+
+    // The file shrank while mapped: text past the cut reads as zeros
+    bool truncated() const;
+
+private:
+    bool refill();
+    void open_entry(const std::string &archive, const std::string &entry);
+
+    MappedFile map_;              // the log
+    std::shared_ptr<const ZipArchive> zip_;  // or the archive holding it
+    std::string_view text_;       // whole text, when direct_
+    bool direct_ = false;
+    std::unique_ptr<Inflater> inflate_;
+    std::ifstream in_;
+    std::string buf_;
+    std::string_view rest_;
+    bool eof_ = false;
+};
+
+// Split one line off the front of buf (no copy); false when buf is empty.
+inline bool next_line(std::string_view &buf, std::string_view &line) {
+    if (buf.empty()) return false;
+    const std::size_t nl = buf.find('\n');
+    if (nl == std::string_view::npos) {
+        line = buf;
+        buf = {};
+    } else {
+        line = buf.substr(0, nl);
+        buf.remove_prefix(nl + 1);
+    }
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return true;
+}
+
+// Split buf into at most `parts` pieces of at least minBytes each, cutting
+// only after a '\n' so no line spans two pieces.
+std::vector<std::string_view> split_chunks(std::string_view buf, unsigned parts, std::size_t minBytes);
+
+} // namespace util
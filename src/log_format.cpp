@@ -0,0 +1,41 @@
+#include "log_format.hpp"
+#include "photomesh_parser.hpp"
+#include "realitymesh_parser.hpp"
+
+#include <stdexcept>
+
+std::span<const LogFormat> log_formats() {
+    static const LogFormat formats[] = {photomesh_format(), realitymesh_format()};
+    return formats;
+}
+
+const LogFormat &log_format(LogKind kind) {
+    for (const auto &f : log_formats())
+        if (f.kind == kind) return f;
+    throw std::invalid_argument("unregistered log format");
+}
+
+LogKind sniff_log(std::string_view head) {
+    std::size_t end = 0;
+    for (std::size_t n = 0; n < kSniffLines && end < head.size(); ++n) {
+        const std::size_t nl = head.find('\n', end);
+        end = nl == std::string_view::npos ? head.size() : nl + 1;
+    }
+    const std::string_view window = head.substr(0, end);
+
+    LogKind best = LogKind::Unknown;
+    std::size_t bestLine = std::string_view::npos;  // start of the deciding line
+    for (const auto &f : log_formats()) {
+        for (const auto marker : f.markers) {
+            const std::size_t pos = window.find(marker);
+            if (pos == std::string_view::npos) continue;
+            const std::size_t nl = pos ? window.rfind('\n', pos - 1) : std::string_view::npos;
+            const std::size_t line = nl == std::string_view::npos ? 0 : nl + 1;
+            if (bestLine == std::string_view::npos || line < bestLine) {
+                bestLine = line;
+                best = f.kind;
+            }
+        }
+    }
+    return best;
+}
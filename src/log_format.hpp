@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+enum class LogKind { PhotoMesh, RealityMesh, Unknown };
+
+// One parser's entry in the format registry
+struct LogFormat {
+    LogKind kind;
+    std::string_view name;                      // also keys the format's parse state
+    std::span<const std::string_view> markers;  // any of these near the start identifies the format
+};
+
+// Every registered format, in classification priority order
+std::span<const LogFormat> log_formats();
+const LogFormat &log_format(LogKind kind);  // kind must be registered
+
+// Lines at the start of a log that classification looks at
+constexpr std::size_t kSniffLines = 4000;
+
+// Format of a log from the start of its text: the first of kSniffLines lines
+// that holds any marker decides; within one line earlier formats win.
+LogKind sniff_log(std::string_view head);
@@ -0,0 +1,324 @@
+#include "logpath_index.hpp"
+#include "content_hash.hpp"
+#include "parse_state.hpp"
+#include "tsv_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace excel {
+
+namespace {
+
+// File layout, native-endian 64-bit words:
+//   magic (4 words), covered TSV bytes, util::prefix_fingerprint of them,
+//   LogPath column (all ones when none), sorted count, tail count, bloom words,
+//   then the bloom filter, the sorted (hash, offset) pairs and the tail pairs
+constexpr char kMagic[32] = "logtoExcel logpath index v1";
+constexpr std::size_t kHeaderWords = 10;
+enum Word { kCovered = 4, kFingerprint, kColumn, kSorted, kTail, kBloom };
+
+constexpr unsigned kBloomProbes = 7;      // with 10 bits per entry: ~1% false positives
+constexpr std::size_t kBloomBitsPerEntry = 10;
+
+std::uint64_t path_hash(std::string_view logPath) { return util::content_hash(logPath); }
+
+// Double hashing: probe i is h1 + i*h2 over the filter's bits
+template <class F>
+void bloom_probes(std::uint64_t hash, std::size_t words, F &&f) {
+    const std::uint64_t bits = static_cast<std::uint64_t>(words) * 64;
+    const std::uint64_t h2 = ((hash >> 32) | (hash << 32)) | 1;
+    for (unsigned i = 0; i < kBloomProbes; ++i) {
+        const std::uint64_t bit = (hash + i * h2) % bits;
+        if (!f(static_cast<std::size_t>(bit / 64), std::uint64_t{1} << (bit % 64))) return;
+    }
+}
+
+// Cell `column` of the TSV line starting at `line`
+std::string_view cell_of(std::string_view line, std::size_t column) {
+    for (std::size_t c = 0; c < column; ++c) {
+        const std::size_t tab = line.find('\t');
+        if (tab == std::string_view::npos) return {};
+        line.remove_prefix(tab + 1);
+    }
+    return line.substr(0, line.find('\t'));
+}
+
+bool write_words(std::ofstream &out, const std::uint64_t *w, std::size_t n) {
+    out.write(reinterpret_cast<const char *>(w), static_cast<std::streamsize>(n * sizeof *w));
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+std::string LogPathIndex::path_for(const std::string &tsvPath) { return tsvPath + ".idx"; }
+
+LogPathIndex::LogPathIndex(const std::string &tsvPath)
+    : tsvPath_(tsvPath), path_(path_for(tsvPath)), tsv_(tsvPath) {
+    if (load()) {
+        // Lines appended without updating the index
+        if (covered_ < tsv_.data().size()) scan(static_cast<std::size_t>(covered_));
+        return;
+    }
+    file_ = {};
+    sorted_ = bloomWords_ = savedTail_ = 0;
+    tail_.clear();
+    column_ = SIZE_MAX;
+    covered_ = 0;
+    rebuilt_ = true;
+    scan(0);
+}
+
+bool LogPathIndex::load() {
+    file_ = util::MappedFile(path_);
+    const std::string_view bytes = file_.data();
+    if (bytes.size() < kHeaderWords * 8 || std::memcmp(bytes.data(), kMagic, sizeof kMagic) != 0) return false;
+    const auto *w = reinterpret_cast<const std::uint64_t *>(bytes.data());  // the mapping is page-aligned
+    const std::uint64_t covered = w[kCovered], sorted = w[kSorted], tail = w[kTail], bloom = w[kBloom];
+    if (sorted > bytes.size() || tail > bytes.size() || bloom > bytes.size() ||
+        bytes.size() != (kHeaderWords + bloom + 2 * (sorted + tail)) * 8 || (sorted && !bloom))
+        return false;
+
+    // Stale unless the TSV still begins with the bytes that were indexed
+    const std::string_view text = tsv_.data();
+    if (covered > text.size() || util::prefix_fingerprint(text, covered) != w[kFingerprint]) return false;
+
+    covered_ = covered;
+    column_ = w[kColumn] == ~std::uint64_t{0} ? SIZE_MAX : static_cast<std::size_t>(w[kColumn]);
+    sorted_ = static_cast<std::size_t>(sorted);
+    bloomWords_ = static_cast<std::size_t>(bloom);
+    savedTail_ = static_cast<std::size_t>(tail);
+    const std::uint64_t *t = w + kHeaderWords + bloom + 2 * sorted;
+    tail_.reserve(savedTail_);
+    for (std::size_t i = 0; i < savedTail_; ++i) tail_.emplace_back(t[2 * i], t[2 * i + 1]);
+    tailStale_ = true;
+    return true;
+}
+
+// Index the TSV lines from byte `from` (a line start) to its end
+void LogPathIndex::scan(std::size_t from) {
+    std::string_view text = tsv_.data();
+    std::size_t pos = from;
+    if (pos == 0) {
+        // The header names the columns
+        std::string_view header;
+        std::string_view rest = text;
+        if (!util::next_line(rest, header)) return;
+        column_ = SIZE_MAX;
+        for (std::size_t c = 0;; ++c) {
+            const std::size_t tab = header.find('\t');
+            if (header.substr(0, tab) == "LogPath") { column_ = c; break; }
+            if (tab == std::string_view::npos) break;
+            header.remove_prefix(tab + 1);
+        }
+        pos = text.size() - rest.size();
+    }
+    if (column_ != SIZE_MAX) {
+        // Only the LogPath cell of each line is split out
+        util::TsvReader reader(text.substr(pos));
+        const std::size_t project[] = {column_};
+        reader.project(project);
+        while (reader.next()) {
+            if (!reader.line().empty()) tail_.emplace_back(path_hash(reader.fields()[0]), pos + reader.offset());
+        }
+        tailStale_ = true;
+    }
+    covered_ = text.size();
+    dirty_ = true;
+}
+
+const std::uint64_t *LogPathIndex::sorted_entries() const {
+    return reinterpret_cast<const std::uint64_t *>(file_.data().data()) + kHeaderWords + bloomWords_;
+}
+
+bool LogPathIndex::maybe_sorted(std::uint64_t hash) const {
+    if (!sorted_) return false;
+    const auto *bloom = reinterpret_cast<const std::uint64_t *>(file_.data().data()) + kHeaderWords;
+    bool hit = true;
+    bloom_probes(hash, bloomWords_, [&](std::size_t word, std::uint64_t bit) {
+        hit = (bloom[word] & bit) != 0;
+        return hit;
+    });
+    return hit;
+}
+
+bool LogPathIndex::confirm(std::uint64_t offset, std::string_view logPath) const {
+    const std::string_view text = tsv_.data();
+    if (offset >= text.size()) return false;
+    std::string_view rest = text.substr(static_cast<std::size_t>(offset)), line;
+    util::next_line(rest, line);
+    return cell_of(line, column_) == logPath;
+}
+
+bool LogPathIndex::lookup(std::string_view logPath, std::vector<std::uint64_t> *offsets) const {
+    if (column_ == SIZE_MAX) return false;
+    const std::uint64_t hash = path_hash(logPath);
+    bool found = false;
+    const auto hit = [&](std::uint64_t offset) {
+        if (!confirm(offset, logPath)) return false;
+        found = true;
+        if (offsets) offsets->push_back(offset);
+        return !offsets;
+    };
+
+    if (tailStale_) {
+        tailSorted_ = tail_;
+        std::sort(tailSorted_.begin(), tailSorted_.end());
+        tailStale_ = false;
+    }
+    for (auto it = std::lower_bound(tailSorted_.begin(), tailSorted_.end(), Entry{hash, 0});
+         it != tailSorted_.end() && it->first == hash; ++it)
+        if (hit(it->second)) return true;
+
+    if (!maybe_sorted(hash)) return found;
+    const std::uint64_t *e = sorted_entries();
+    std::size_t lo = 0, hi = sorted_;
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (e[2 * mid] < hash) lo = mid + 1;
+        else hi = mid;
+    }
+    for (; lo < sorted_ && e[2 * lo] == hash; ++lo)
+        if (hit(e[2 * lo + 1])) return true;
+    return found;
+}
+
+bool LogPathIndex::contains(std::string_view logPath) const { return lookup(logPath, nullptr); }
+
+std::vector<std::uint64_t> LogPathIndex::find(std::string_view logPath) const {
+    std::vector<std::uint64_t> offsets;
+    lookup(logPath, &offsets);
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+void LogPathIndex::add(std::string_view logPath, std::uint64_t offset) {
+    tail_.emplace_back(path_hash(logPath), offset);
+    tailStale_ = true;
+    dirty_ = true;
+}
+
+bool LogPathIndex::save() {
+    // The TSV as it is now: the bytes this run appended are covered too
+    tsv_ = util::MappedFile(tsvPath_);
+    if (column_ == SIZE_MAX && !tsv_.data().empty()) {
+        // A master created by this run: its header names the columns now
+        tail_.clear();
+        scan(0);
+    }
+    covered_ = tsv_.data().size();
+    if (!dirty_ && savedTail_ == tail_.size()) return true;
+
+    // Merge the tail into the sorted table once it is no longer short
+    const std::size_t tailLimit = std::max<std::size_t>(1024, sorted_ / 8);
+    if (!sorted_ || tail_.size() > tailLimit) {
+        std::vector<Entry> all;
+        all.reserve(sorted_ + tail_.size());
+        const std::uint64_t *e = sorted_ ? sorted_entries() : nullptr;
+        for (std::size_t i = 0; i < sorted_; ++i) all.emplace_back(e[2 * i], e[2 * i + 1]);
+        all.insert(all.end(), tail_.begin(), tail_.end());
+        std::sort(all.begin(), all.end());
+        file_ = {};  // unmapped before it is replaced
+        if (!write_full(all)) {
+            // Nothing backs the sorted table any more: keep every entry in memory
+            sorted_ = bloomWords_ = savedTail_ = 0;
+            tail_ = std::move(all);
+            tailStale_ = true;
+            return false;
+        }
+    } else if (!write_tail()) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+// Whole index into a temp file, renamed over the old one
+bool LogPathIndex::write_full(const std::vector<Entry> &entries) {
+    const std::size_t bloomWords = std::max<std::size_t>(1, (entries.size() * kBloomBitsPerEntry + 63) / 64);
+    std::vector<std::uint64_t> bloom(bloomWords, 0);
+    for (const auto &e : entries)
+        bloom_probes(e.first, bloomWords, [&](std::size_t word, std::uint64_t bit) {
+            bloom[word] |= bit;
+            return true;
+        });
+
+    std::uint64_t header[kHeaderWords];
+    std::memcpy(header, kMagic, sizeof kMagic);
+    header[kCovered] = covered_;
+    header[kFingerprint] = util::prefix_fingerprint(tsv_.data(), covered_);
+    header[kColumn] = column_ == SIZE_MAX ? ~std::uint64_t{0} : column_;
+    header[kSorted] = entries.size();
+    header[kTail] = 0;
+    header[kBloom] = bloomWords;
+
+    const std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out || !write_words(out, header, kHeaderWords) || !write_words(out, bloom.data(), bloom.size()))
+            return false;
+        for (const auto &e : entries) {
+            const std::uint64_t pair[2] = {e.first, e.second};
+            if (!write_words(out, pair, 2)) return false;
+        }
+        if (!out.flush()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path_, ec);
+    if (ec) {
+        std::error_code ignored;
+        fs::remove(tmp, ignored);
+        return false;
+    }
+    file_ = util::MappedFile(path_);
+    if (!file_.is_open()) return false;
+    sorted_ = entries.size();
+    bloomWords_ = bloomWords;
+    tail_.clear();
+    tailSorted_.clear();
+    tailStale_ = false;
+    savedTail_ = 0;
+    return true;
+}
+
+// New tail entries appended in place, then the header that counts them; a
+// write cut short leaves a size mismatch, which the next open rebuilds from
+bool LogPathIndex::write_tail() {
+    const std::size_t sorted = sorted_, bloomWords = bloomWords_;
+    const std::size_t tableBytes = (kHeaderWords + bloomWords + 2 * sorted) * 8;
+    // On failure the sorted table is mapped again; if the file no longer holds
+    // it, the entries are rebuilt from the TSV instead
+    const auto remap = [&] {
+        file_ = util::MappedFile(path_);
+        if (file_.data().size() >= tableBytes) return false;
+        file_ = {};
+        sorted_ = bloomWords_ = savedTail_ = 0;
+        tail_.clear();
+        scan(0);
+        return false;
+    };
+    file_ = {};
+    std::fstream out(path_, std::ios::binary | std::ios::in | std::ios::out);
+    if (!out) return remap();
+    out.seekp(static_cast<std::streamoff>((kHeaderWords + bloomWords + 2 * (sorted + savedTail_)) * 8));
+    for (std::size_t i = savedTail_; i < tail_.size(); ++i) {
+        const std::uint64_t pair[2] = {tail_[i].first, tail_[i].second};
+        out.write(reinterpret_cast<const char *>(pair), sizeof pair);
+    }
+    const std::uint64_t header[] = {covered_, util::prefix_fingerprint(tsv_.data(), covered_),
+                                    column_ == SIZE_MAX ? ~std::uint64_t{0} : column_, sorted, tail_.size()};
+    out.seekp(kCovered * 8);
+    out.write(reinterpret_cast<const char *>(header), sizeof header);
+    if (!out.flush()) return remap();
+    out.close();
+    file_ = util::MappedFile(path_);
+    if (file_.data().size() < tableBytes) return remap();
+    savedTail_ = tail_.size();
+    return true;
+}
+
+} // namespace excel
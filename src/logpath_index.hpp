@@ -0,0 +1,70 @@
+#pragma once
+#include "line_reader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace excel {
+
+// Persistent set of the LogPaths in the master TSV, kept next to it in
+// <tsv>.idx, so an append only looks up its new rows instead of rereading the
+// master. 64-bit hashes of the paths sit in a sorted table, memory-mapped and
+// guarded by a bloom filter; a hash hit is confirmed against the TSV line it
+// points at. Entries added since the table was last sorted form a short tail,
+// merged in when it grows.
+// The index records how many TSV bytes it covers: lines appended behind its
+// back are indexed when it is opened, and a TSV that was rewritten or
+// truncated (or a missing or corrupt index) is rescanned in full.
+class LogPathIndex {
+public:
+    static std::string path_for(const std::string &tsvPath);
+
+    explicit LogPathIndex(const std::string &tsvPath);
+
+    // Whether a TSV line has this LogPath
+    bool contains(std::string_view logPath) const;
+    // Offsets of the TSV lines with this LogPath, in file order
+    std::vector<std::uint64_t> find(std::string_view logPath) const;
+
+    // A line appended to the TSV at byte `offset`
+    void add(std::string_view logPath, std::uint64_t offset);
+
+    // Cover the TSV as it is now; false on I/O failure (the next open then
+    // catches up or rebuilds)
+    bool save();
+
+    std::size_t size() const { return sorted_ + tail_.size(); }
+    bool rebuilt() const { return rebuilt_; }  // open had to scan the whole TSV
+
+private:
+    using Entry = std::pair<std::uint64_t, std::uint64_t>;  // path hash, line offset
+
+    bool load();
+    void scan(std::size_t from);
+    bool lookup(std::string_view logPath, std::vector<std::uint64_t> *offsets) const;
+    bool confirm(std::uint64_t offset, std::string_view logPath) const;
+    bool maybe_sorted(std::uint64_t hash) const;
+    const std::uint64_t *sorted_entries() const;
+    bool write_full(const std::vector<Entry> &entries);
+    bool write_tail();
+
+    std::string tsvPath_, path_;
+    util::MappedFile tsv_;
+    util::MappedFile file_;        // the index on disk
+    std::size_t column_ = SIZE_MAX; // LogPath column, SIZE_MAX when there is none
+    std::uint64_t covered_ = 0;     // TSV bytes indexed
+    std::size_t sorted_ = 0;        // entries in the mapped, sorted table
+    std::size_t bloomWords_ = 0;
+    std::size_t savedTail_ = 0;     // tail entries already in the file
+    std::vector<Entry> tail_;       // in file order
+    mutable std::vector<Entry> tailSorted_;  // for lookups, sorted on demand
+    mutable bool tailStale_ = false;
+    bool rebuilt_ = false;
+    bool dirty_ = false;
+};
+
+} // namespace excel
@@ -1,12 +1,17 @@
+#include "archive_reader.hpp"
 #include "cli.hpp"
-#include "photomesh_parser.hpp"
-#include "realitymesh_parser.hpp"
+#include "ingest.hpp"
 #include "excel_writer.hpp"
+#include "master_query.hpp"
 #include "single_sheet_writer.hpp"
 #include "models.hpp"
 
 #include <fmt/printf.h>
+#include <algorithm>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -28,39 +33,178 @@ static void parse_extra_flags(int argc, char** argv,
   }
 }
 
-int main(int argc, char **argv) {
-  Options opt = parse_cli(argc, argv);
+// Splits "A,B,C" into its non-empty parts
+static std::vector<std::string> split_list(const std::string& s) {
+  std::vector<std::string> out;
+  for (size_t from = 0; from <= s.size();) {
+    size_t comma = s.find(',', from);
+    if (comma == std::string::npos) comma = s.size();
+    if (comma > from) out.push_back(s.substr(from, comma - from));
+    from = comma + 1;
+  }
+  return out;
+}
 
-  // Also accept raw paths (drag & drop). Classify by extension; parser is robust anyway.
-  for (int i=1;i<argc;++i) {
-    std::string a = argv[i];
-    if (!a.empty() && a[0] != '-') {
-      // push to both; parser won't crash if log doesn't match
-      opt.photomeshLogs.push_back(a);
-      opt.realitymeshLogs.push_back(a);
+// logtoExcel_cli query: the master rows passing every --where, as TSV on
+// stdout or in -o (.tsv, or .xlsx through a TSV beside it)
+static int run_query(int argc, char** argv) {
+  std::string outputsDir = "EXCEL OUTPUTS", output;
+  excel::Query query;
+  excel::WorkbookBackend backend = excel::WorkbookBackend::Libxlsxwriter;
+  for (int i = 2; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--outputs-dir" && i+1 < argc)               outputsDir = argv[++i];
+    else if (a == "--columns" && i+1 < argc)              query.columns = split_list(argv[++i]);
+    else if ((a == "-o" || a == "--output") && i+1 < argc) output = argv[++i];
+    else if (a == "--xlsx-backend" && i+1 < argc &&
+             excel::parse_workbook_backend(argv[i+1], backend)) ++i;
+    else if (a == "--where" && i+1 < argc) {
+      excel::QueryPredicate p;
+      if (!excel::parse_query_predicate(argv[++i], p)) {
+        fmt::print(stderr, "Bad --where '{}': use Column<op>value with = != < <= > >= or ~ (contains)\n", argv[i]);
+        return 2;
+      }
+      query.where.push_back(std::move(p));
+    } else {
+      fmt::print(stderr,
+        "Usage: logtoExcel_cli query [--outputs-dir <folder>] [--where <col><op><value>]... "
+        "[--columns <col>[,<col>...]] [-o out.xlsx|out.tsv] [--xlsx-backend libxlsxwriter|native]\n");
+      return 2;
+    }
+  }
+
+  const bool xlsx = output.size() > 5 && output.compare(output.size() - 5, 5, ".xlsx") == 0;
+  const std::string tsvOut = xlsx ? output + ".tsv" : output;
+  std::ofstream file;
+  if (!tsvOut.empty()) {
+    file.open(tsvOut, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      fmt::print(stderr, "Cannot write {}\n", tsvOut);
+      return 1;
+    }
+  }
+  std::string line;
+  const auto write = [&](std::span<const std::string_view> cells) {
+    line.clear();
+    for (size_t c = 0; c < cells.size(); ++c) {
+      if (c) line.push_back('\t');
+      line.append(cells[c]);
+    }
+    line.push_back('\n');
+    if (file.is_open()) file.write(line.data(), (std::streamsize)line.size());
+    else std::fwrite(line.data(), 1, line.size(), stdout);
+  };
+
+  excel::QueryStats stats;
+  std::string error;
+  if (!excel::query_master(outputsDir, query, write, stats, error)) {
+    fmt::print(stderr, "{}\n", error);
+    if (file.is_open()) { file.close(); fs::remove(tsvOut); }
+    return 2;
+  }
+  if (file.is_open()) file.close();
+  else std::fflush(stdout);
+  if (xlsx) {
+    const bool written = excel::write_tsv_workbook(tsvOut, output, backend);
+    std::error_code ec;
+    fs::remove(tsvOut, ec);
+    if (!written) {
+      fmt::print(stderr, "Could not write {}\n", output);
+      return 1;
     }
   }
+  if (stats.segments)
+    fmt::print(stderr, "{} of {} rows ({}: {} of {} segments skipped)\n",
+               stats.matches, stats.rows, stats.plan, stats.skipped, stats.segments);
+  else
+    fmt::print(stderr, "{} of {} rows ({})\n", stats.matches, stats.rows, stats.plan);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && std::string(argv[1]) == "query") return run_query(argc, argv);
+  Options opt = parse_cli(argc, argv);
+
+  // Zip archives stand for the logs inside them ("job.zip!/a.log"); bare
+  // paths are classified by content as they are parsed
+  LogInputs inputs{util::expand_archives(opt.photomeshLogs),
+                   util::expand_archives(opt.realitymeshLogs),
+                   util::expand_archives(opt.detectLogs)};
 
   std::string outputsDir; bool doMaster, doReport;
   parse_extra_flags(argc, argv, outputsDir, doMaster, doReport);
 
-  if (opt.photomeshLogs.empty() && opt.realitymeshLogs.empty()) {
+  if (inputs.photomesh.empty() && inputs.realitymesh.empty() && inputs.detect.empty()) {
     fmt::print(stderr,
-      "Usage: logtoExcel_cli --photomesh <pm.log> --realitymesh <rm.log> -o out.xlsx "
-      "[--outputs-dir <folder>] [--no-master] [--no-report|--single-only]\n");
+      "Usage: logtoExcel_cli [--photomesh <pm.log>...] [--realitymesh <rm.log>...] [<log>...] -o out.xlsx "
+      "[--outputs-dir <folder>] [--no-master] [--no-report|--single-only] [--jobs N] [--full-parse] [--dedupe-content] "
+      "[--partition-master none|month|project] [--sort-master <col>[,<col>...]] [--memory-limit <MB>] [--shard i/N] "
+      "[--xlsx-backend libxlsxwriter|native]\n"
+      "       logtoExcel_cli query [--outputs-dir <folder>] [--where <col><op><value>]... "
+      "[--columns <col>[,<col>...]] [-o out.xlsx|out.tsv] [--xlsx-backend libxlsxwriter|native]\n");
+    return 2;
+  }
+  excel::MasterPartition partition;
+  if (!excel::parse_master_partition(opt.partitionMaster, partition)) {
+    fmt::print(stderr, "Unknown --partition-master '{}': use none, month or project\n", opt.partitionMaster);
+    return 2;
+  }
+  excel::WorkbookBackend backend;
+  if (!excel::parse_workbook_backend(opt.xlsxBackend, backend)) {
+    fmt::print(stderr, "Unknown --xlsx-backend '{}': use libxlsxwriter or native\n", opt.xlsxBackend);
+    return 2;
+  }
+  if (opt.shardIndex == ~0u) {
+    fmt::print(stderr, "--shard takes i/N with i < N, e.g. --shard 0/4\n");
+    return 2;
+  }
+  // One node's share of the inputs (possibly none); the partial masters of
+  // all nodes are combined with logtoExcel_merge
+  if (opt.shardCount) inputs = select_shard(inputs, opt.shardIndex, opt.shardCount);
+
+  excel::MasterSort sort;
+  if (!excel::parse_master_sort(opt.sortMaster, sort)) {
+    fmt::print(stderr, "Unknown column in --sort-master '{}': use master columns such as RunDate,Machine,ProjectName,Tool"
+               " ('-' before one for descending)\n", opt.sortMaster);
     return 2;
   }
+  sort.memoryLimit = std::max<std::size_t>(opt.memoryLimitMB, 1) << 20;
 
-  // Parse logs
-  std::vector<PhotoMeshRow> pm_rows;
-  for (const auto &p : opt.photomeshLogs) pm_rows.push_back(parse_photomesh(p));
-  std::vector<RealityMeshRow> rm_rows;
-  for (const auto &p : opt.realitymeshLogs) rm_rows.push_back(parse_realitymesh(p));
+  // Parse logs (in parallel; rows keep command-line order). Unchanged logs
+  // come from the saved state and growing logs resume where the last run
+  // stopped, unless --full-parse is given. A full parse starts from an empty
+  // state but only replaces the saved entries of the logs it parsed.
+  fs::create_directories(outputsDir);
+  const std::string statePath = ParseStateStore::default_path(outputsDir);
+  ParseStateStore state, fresh;
+  state.load(statePath);
+  ParsedLogs parsed = parse_logs(inputs, opt.jobs, opt.fullParse ? &fresh : &state);
+  for (const auto& [key, entry] : fresh.entries()) state.put(key, entry);
+  if (!state.save(statePath))
+    fmt::print(stderr, "Warning: could not save parse state to {}\n", statePath);
+  for (const auto &p : parsed.unknown)
+    fmt::print(stderr, "Skipped {}: not a PhotoMesh or RealityMesh log\n", p);
+  std::vector<PhotoMeshRow>& pm_rows = parsed.pm;
+  std::vector<RealityMeshRow>& rm_rows = parsed.rm;
+
+  // One view per parsed row, shared by the master and the report's summary;
+  // the rows themselves are not copied
+  const auto unified = excel::unify(pm_rows, rm_rows);
 
   // Master single-sheet: unify -> append -> rebuild xlsx
   if (doMaster) {
-    auto unified = excel::unify(pm_rows, rm_rows);
-    excel::append_to_master_and_rebuild_xlsx(outputsDir, unified);
+    std::string error;
+    const bool committed =
+        opt.dedupeContent
+            ? excel::append_to_master_and_rebuild_xlsx(
+                  outputsDir, excel::unify(pm_rows, rm_rows, parsed.pmDuplicates, parsed.rmDuplicates), error,
+                  partition, sort, backend, opt.jobs)
+            : excel::append_to_master_and_rebuild_xlsx(outputsDir, unified, error, partition, sort, backend,
+                                                       opt.jobs);
+    if (!committed) {
+      fmt::print(stderr, "{}\n", error);
+      return 1;
+    }
   }
 
   // Per-run multi-sheet report (existing)
@@ -69,14 +213,14 @@ int main(int argc, char **argv) {
       fs::create_directories(outputsDir);
       opt.output = (fs::path(outputsDir)/"Report.xlsx").string();
     }
-    std::vector<SummaryRow> summary;
-    for (const auto &r : pm_rows) summary.push_back(make_summary(r));
-    for (const auto &r : rm_rows) summary.push_back(make_summary(r));
-    excel::write_workbook(opt.output, pm_rows, rm_rows, summary); // existing function
+    excel::write_workbook(opt.output, pm_rows, rm_rows, unified); // existing function
   }
 
-  fmt::print("Done. Master: {}/All_Exports.xlsx{}{}\n",
+  fmt::print("Done. Master: {}/{}{}{}\n",
              outputsDir,
+             partition == excel::MasterPartition::Month     ? "All_Exports_by_month/Index.xlsx"
+             : partition == excel::MasterPartition::Project ? "All_Exports_by_project/Index.xlsx"
+                                                            : "All_Exports.xlsx",
              doReport ? ", Per-run: " : "",
              doReport ? opt.output : "");
   return 0;
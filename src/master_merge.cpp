@@ -0,0 +1,137 @@
+#include "master_merge.hpp"
+#include "columns.hpp"
+#include "content_hash.hpp"
+#include "line_reader.hpp"
+#include "tsv_reader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace excel {
+
+namespace {
+
+constexpr std::size_t kLogPath = column_index(kMasterColumns, "LogPath");
+constexpr std::size_t kIngestedAt = column_index(kMasterColumns, "IngestedAt");
+constexpr std::size_t kMissing = SIZE_MAX;
+
+// One input: its mapping, a reader on the current line, and where each master
+// column sits in its lines
+struct Input {
+    util::MappedFile file;
+    util::TsvReader reader;
+    std::vector<std::size_t> source;  // master column -> input column, or kMissing
+    bool identity = true;             // lines are already in master layout
+
+    explicit Input(const std::string &path) : file(path), reader(file.data()) {}
+
+    std::string_view cell(std::size_t c) const {
+        const std::size_t at = source[c];
+        const auto fields = reader.fields();
+        return at < fields.size() ? fields[at] : std::string_view{};
+    }
+
+    // Next non-empty line
+    bool next() {
+        while (reader.next())
+            if (!reader.line().empty()) return true;
+        return false;
+    }
+};
+
+// Opens a master TSV and maps its header onto the master columns; nullptr
+// when it has no LogPath column to merge on
+std::unique_ptr<Input> open_input(const std::string &path) {
+    if (!fs::is_regular_file(path)) return nullptr;
+    auto in = std::make_unique<Input>(path);
+    if (!in->next()) return nullptr;
+    const auto header = in->reader.fields();
+    in->source.assign(kMasterColumns.size(), kMissing);
+    for (std::size_t c = 0; c < kMasterColumns.size(); ++c) {
+        const auto at = std::find(header.begin(), header.end(), kMasterColumns[c].name);
+        if (at != header.end()) in->source[c] = static_cast<std::size_t>(at - header.begin());
+        in->identity &= in->source[c] == c;
+    }
+    in->identity &= header.size() == kMasterColumns.size();
+    if (in->source[kLogPath] == kMissing) return nullptr;
+    return in;
+}
+
+} // namespace
+
+bool merge_masters(const std::vector<std::string> &inputs, const std::string &outTsv, const MergeOptions &options,
+                   MergeStats &stats) {
+    std::vector<std::unique_ptr<Input>> in;
+    for (const auto &path : inputs) {
+        auto input = open_input(path);
+        if (input) in.push_back(std::move(input));
+        else stats.skipped.push_back(path);
+    }
+
+    // Smallest IngestedAt on top; equal stamps in input order
+    auto later = [&](std::size_t a, std::size_t b) {
+        const int c = in[a]->cell(kIngestedAt).compare(in[b]->cell(kIngestedAt));
+        return c != 0 ? c > 0 : a > b;
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+    for (std::size_t i = 0; i < in.size(); ++i)
+        if (in[i]->next()) heap.push(i);
+
+    std::ofstream out(outTsv, std::ios::binary | std::ios::trunc);
+    std::string buf;
+    append_tsv_header(buf, kMasterColumns);
+    std::unordered_set<std::uint64_t> paths, contents;
+    while (!heap.empty()) {
+        const std::size_t i = heap.top();
+        heap.pop();
+        Input &src = *in[i];
+
+        const std::uint64_t path = util::content_hash(src.cell(kLogPath));
+        std::uint64_t content = 0;
+        bool keep = !paths.count(path);
+        if (keep && options.dedupeContent) {
+            util::ContentHash h;
+            for (std::size_t c = 0; c < kMasterColumns.size(); ++c) {
+                if (c == kLogPath || c == kIngestedAt) continue;
+                h.update(src.cell(c));
+                h.update("\t");
+            }
+            content = h.digest();
+            keep = !contents.count(content);
+        }
+        if (keep) {
+            paths.insert(path);
+            if (options.dedupeContent) contents.insert(content);
+        }
+        if (!keep) {
+            ++stats.duplicates;
+        } else {
+            if (src.identity) {
+                buf.append(src.reader.line());
+            } else {
+                for (std::size_t c = 0; c < kMasterColumns.size(); ++c) {
+                    if (c) buf.push_back('\t');
+                    buf.append(src.cell(c));
+                }
+            }
+            buf.push_back('\n');
+            ++stats.rows;
+            if (buf.size() >= (1u << 20)) {
+                out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                buf.clear();
+            }
+        }
+        if (src.next()) heap.push(i);
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    out.close();
+    return static_cast<bool>(out);
+}
+
+} // namespace excel
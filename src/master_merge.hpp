@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace excel {
+
+struct MergeOptions {
+    // Also drop rows equal to a kept one in every cell but LogPath and
+    // IngestedAt: the same log ingested from another path
+    bool dedupeContent = false;
+};
+
+struct MergeStats {
+    std::size_t rows = 0;        // written
+    std::size_t duplicates = 0;  // dropped
+    std::vector<std::string> skipped;  // inputs that are not master TSVs
+};
+
+// K-way merge of master TSVs (partial masters from several nodes, each in
+// ingestion order) into one master TSV at `outTsv`, in one streaming pass:
+// rows come out by IngestedAt, ties going to the earlier input, so each
+// input's own order is kept. Inputs whose header lists the master columns in
+// another order (or only some of them) are mapped by column name. A row whose
+// LogPath was already written is dropped. Memory holds one line per input
+// (the inputs are mapped) and a 64-bit hash per row written.
+// False if the output could not be written.
+bool merge_masters(const std::vector<std::string> &inputs, const std::string &outTsv, const MergeOptions &options,
+                   MergeStats &stats);
+
+} // namespace excel
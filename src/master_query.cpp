@@ -0,0 +1,406 @@
+#include "master_query.hpp"
+#include "column_store.hpp"
+#include "columns.hpp"
+#include "file_lock.hpp"
+#include "line_reader.hpp"
+#include "logpath_index.hpp"
+#include "single_sheet_writer.hpp"
+#include "tsv_reader.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+
+namespace fs = std::filesystem;
+
+namespace excel {
+
+namespace {
+
+using Op = QueryPredicate::Op;
+
+// A predicate bound to a master column
+struct Test {
+    std::size_t column = 0;
+    CellKind kind = CellKind::Text;
+    Op op = Op::Eq;
+    std::string value;
+    bool typed = false;              // compared by value, the literal standing for [lo, hi]
+    std::uint64_t lo = 0, hi = 0;
+};
+
+bool same_char(char a, char b) {
+    return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+}
+
+bool same_text(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), same_char);
+}
+
+bool contains_text(std::string_view text, std::string_view part) {
+    return std::search(text.begin(), text.end(), part.begin(), part.end(), same_char) != text.end();
+}
+
+bool digits(std::string_view s, int &v) {
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size() && s.front() != '-';
+}
+
+// Nanoseconds since the epoch of midnight on y-m-d, as time columns hold them
+bool midnight(int y, int m, int d, std::uint64_t &bits) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%04d-%02d-%02d 00:00:00", y, m, d);
+    return ColumnStore::value_of(CellKind::Time, buf, bits);
+}
+
+// The values a literal stands for on a column of `kind`: one value, or on a
+// time column for a year, month or day the whole period
+bool literal_values(CellKind kind, std::string_view s, std::uint64_t &lo, std::uint64_t &hi) {
+    const bool time = kind == CellKind::Time || kind == CellKind::Date || kind == CellKind::Stamp;
+    if (time && (s.size() == 4 || s.size() == 7 || s.size() == 10)) {
+        int y, m = 1, d = 1;
+        if (!digits(s.substr(0, 4), y)) return false;
+        if (s.size() >= 7 && (s[4] != '-' || !digits(s.substr(5, 2), m) || m < 1 || m > 12)) return false;
+        if (s.size() == 10 && (s[7] != '-' || !digits(s.substr(8, 2), d) || d < 1 || d > 31)) return false;
+        std::uint64_t end;
+        if (!midnight(y, m, d, lo)) return false;
+        if (s.size() == 4) {
+            if (!midnight(y + 1, 1, 1, end)) return false;
+        } else if (s.size() == 7) {
+            if (!midnight(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1, end)) return false;
+        } else {
+            end = lo + std::uint64_t{86400} * 1000000000;
+        }
+        hi = end - 1;
+        return true;
+    }
+    if (!ColumnStore::value_of(time ? CellKind::Time : kind, s, lo)) return false;
+    hi = lo;
+    return true;
+}
+
+const char *kind_hint(CellKind kind) {
+    switch (kind) {
+    case CellKind::Int: return "a whole number";
+    case CellKind::Real:
+    case CellKind::Fixed2: return "a number";
+    case CellKind::Time:
+    case CellKind::Date:
+    case CellKind::Stamp: return "a date or time (2025-06, 2025-06-01, 2025-06-01 14:30:00)";
+    case CellKind::Duration: return "a duration (h:mm:ss)";
+    case CellKind::Text:
+    case CellKind::Bool: break;
+    }
+    return "text";
+}
+
+bool match_value(const Test &t, std::uint64_t v) {
+    const auto less = [&](std::uint64_t a, std::uint64_t b) { return ColumnStore::value_less(t.kind, a, b); };
+    switch (t.op) {
+    case Op::Eq: return !less(v, t.lo) && !less(t.hi, v);
+    case Op::Ne: return less(v, t.lo) || less(t.hi, v);
+    case Op::Lt: return less(v, t.lo);
+    case Op::Le: return !less(t.hi, v);
+    case Op::Gt: return less(t.hi, v);
+    case Op::Ge: return !less(v, t.lo);
+    case Op::Contains: break;
+    }
+    return false;
+}
+
+// A typed cell that is present (not empty)
+bool match_present(const Test &t, std::uint64_t v) { return t.typed ? match_value(t, v) : t.op != Op::Eq; }
+
+bool match_text(const Test &t, std::string_view cell) {
+    if (cell.empty() || t.value.empty()) {
+        switch (t.op) {
+        case Op::Eq: return cell.empty() && t.value.empty();
+        case Op::Ne: return !cell.empty() || !t.value.empty();
+        case Op::Contains: return t.value.empty();
+        default: return false;
+        }
+    }
+    if (t.op == Op::Contains) return contains_text(cell, t.value);
+    if (t.typed) {
+        // Text in a typed column that is no value only differs from one
+        std::uint64_t v;
+        return ColumnStore::value_of(t.kind, cell, v) ? match_value(t, v) : t.op == Op::Ne;
+    }
+    switch (t.op) {
+    case Op::Eq: return cell == t.value;
+    case Op::Ne: return cell != t.value;
+    case Op::Lt: return cell < t.value;
+    case Op::Le: return cell <= t.value;
+    case Op::Gt: return cell > t.value;
+    case Op::Ge: return cell >= t.value;
+    case Op::Contains: break;
+    }
+    return false;
+}
+
+// Whether a block's zone map alone shows that none of its cells passes
+bool zone_excludes(const Test &t, const ColumnStore::Zone &z, bool typed, std::size_t rows) {
+    if (z.empty && match_text(t, {})) return false;
+    if (z.empty == rows) return true;
+    if (t.value.empty()) return t.op == Op::Eq;
+    if (t.op == Op::Contains) return false;
+    if (typed && t.typed) {
+        const auto less = [&](std::uint64_t a, std::uint64_t b) { return ColumnStore::value_less(t.kind, a, b); };
+        switch (t.op) {
+        case Op::Eq: return less(z.max, t.lo) || less(t.hi, z.min);
+        case Op::Ne: return !less(z.min, t.lo) && !less(t.hi, z.max);
+        case Op::Lt: return !less(z.min, t.lo);
+        case Op::Le: return less(t.hi, z.min);
+        case Op::Gt: return !less(t.hi, z.max);
+        case Op::Ge: return less(z.max, t.lo);
+        case Op::Contains: break;
+        }
+        return false;
+    }
+    if (typed || t.typed) return false;  // text of a typed column: no order to go by
+    const std::string_view v = t.value;
+    switch (t.op) {
+    case Op::Eq: return v < z.minText || v > z.maxText;
+    case Op::Ne: return z.minText == v && z.maxText == v;
+    case Op::Lt: return z.minText >= v;
+    case Op::Le: return z.minText > v;
+    case Op::Gt: return z.maxText <= v;
+    case Op::Ge: return z.maxText < v;
+    case Op::Contains: break;
+    }
+    return false;
+}
+
+// Column `name` among `names`: ignoring case, an exact match or else the one
+// column it is a prefix of
+std::optional<std::size_t> find_column(const std::vector<std::string> &names, std::string_view name) {
+    std::optional<std::size_t> prefixed;
+    std::size_t prefixes = 0;
+    for (std::size_t c = 0; c < names.size(); ++c) {
+        if (same_text(names[c], name)) return c;
+        if (names[c].size() > name.size() && same_text(std::string_view(names[c]).substr(0, name.size()), name)) {
+            prefixed = c;
+            ++prefixes;
+        }
+    }
+    if (prefixes == 1 && !name.empty()) return prefixed;
+    return std::nullopt;
+}
+
+bool bind_test(const QueryPredicate &p, const std::vector<std::string> &names, const std::vector<CellKind> &kinds,
+               Test &t, std::string &error) {
+    const auto c = find_column(names, p.column);
+    if (!c) {
+        error = "Unknown column '" + p.column + "' in --where";
+        return false;
+    }
+    t.column = *c;
+    t.kind = kinds[*c] == CellKind::Bool ? CellKind::Text : kinds[*c];  // flags compare as their text
+    t.op = p.op;
+    t.value = p.value;
+    const bool range = p.op == Op::Lt || p.op == Op::Le || p.op == Op::Gt || p.op == Op::Ge;
+    if (range && p.value.empty()) {
+        error = "--where on " + names[*c] + ": a range needs a value";
+        return false;
+    }
+    if (t.kind == CellKind::Text || p.value.empty()) return true;
+    if (p.op == Op::Contains) {
+        error = "--where on " + names[*c] + ": '~' matches text; compare its values with = or a range";
+        return false;
+    }
+    if (!literal_values(t.kind, p.value, t.lo, t.hi)) {
+        error = "--where on " + names[*c] + ": '" + p.value + "' is not " + kind_hint(t.kind);
+        return false;
+    }
+    t.typed = true;
+    return true;
+}
+
+// The master's columns in the order of its TSV, typed as the master defines them
+std::vector<CellKind> master_kinds(const std::vector<std::string> &names) {
+    std::vector<CellKind> kinds;
+    for (const auto &n : names) kinds.push_back(kind_named(kMasterColumns, n));
+    return kinds;
+}
+
+} // namespace
+
+bool parse_query_predicate(std::string_view expr, QueryPredicate &out) {
+    const std::size_t at = expr.find_first_of("=!<>~");
+    if (at == 0 || at == std::string_view::npos) return false;
+    const char a = expr[at], b = at + 1 < expr.size() ? expr[at + 1] : '\0';
+    std::size_t len = 1;
+    switch (a) {
+    case '=': out.op = Op::Eq; break;
+    case '~': out.op = Op::Contains; break;
+    case '!':
+        if (b != '=') return false;
+        out.op = Op::Ne;
+        len = 2;
+        break;
+    case '<': out.op = b == '=' ? Op::Le : Op::Lt; len = b == '=' ? 2 : 1; break;
+    case '>': out.op = b == '=' ? Op::Ge : Op::Gt; len = b == '=' ? 2 : 1; break;
+    }
+    const auto trim = [](std::string_view s) {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+        return std::string(s);
+    };
+    out.column = trim(expr.substr(0, at));
+    out.value = trim(expr.substr(at + len));
+    return !out.column.empty();
+}
+
+bool query_master(const std::string &outputsDir, const Query &query, const QueryRow &row, QueryStats &stats,
+                  std::string &error) {
+    stats = {};
+    const std::string tsv = (fs::path(outputsDir) / "All_Exports.tsv").string();
+    const std::string cols = ColumnStore::path_for(outputsDir);
+    if (!fs::exists(tsv) && !fs::exists(cols)) {
+        error = "No master in '" + outputsDir + "'";
+        return false;
+    }
+    // Shared: queries only read, so they run side by side and only wait for appends
+    util::FileLock lock(excel::master_lock_path(outputsDir), true);
+    if (!lock.locked()) {
+        error = "Could not lock the master in '" + outputsDir + "'";
+        return false;
+    }
+
+    ColumnStore store(cols);
+    util::MappedFile master(tsv);
+    util::TsvReader reader(master.data());
+    std::vector<std::string> names;
+    std::vector<CellKind> kinds;
+    if (store.is_open()) {
+        for (std::size_t c = 0; c < store.columns(); ++c) {
+            names.emplace_back(store.name(c));
+            kinds.push_back(store.kind(c));
+        }
+    } else {
+        while (reader.next()) {
+            if (reader.line().empty()) continue;
+            names.assign(reader.fields().begin(), reader.fields().end());
+            break;
+        }
+        kinds = master_kinds(names);
+    }
+
+    std::vector<Test> tests(query.where.size());
+    for (std::size_t i = 0; i < tests.size(); ++i)
+        if (!bind_test(query.where[i], names, kinds, tests[i], error)) return false;
+    std::vector<std::size_t> out;
+    for (const auto &name : query.columns) {
+        const auto c = find_column(names, name);
+        if (!c) {
+            error = "Unknown column '" + name + "' in --columns";
+            return false;
+        }
+        out.push_back(*c);
+    }
+    if (query.columns.empty())
+        for (std::size_t c = 0; c < names.size(); ++c) out.push_back(c);
+
+    std::vector<std::string_view> cells;
+    for (const std::size_t c : out) cells.push_back(names[c]);
+    row(cells);
+
+    // A TSV line's cells: the test and output columns, read through a projection
+    std::vector<std::size_t> needed, slot(names.size(), SIZE_MAX);
+    for (const auto &t : tests) needed.push_back(t.column);
+    needed.insert(needed.end(), out.begin(), out.end());
+    std::sort(needed.begin(), needed.end());
+    needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+    for (std::size_t i = 0; i < needed.size(); ++i) slot[needed[i]] = i;
+    reader.project(needed);
+    const auto emit_line = [&] {
+        const auto fields = reader.fields();
+        for (const auto &t : tests)
+            if (!match_text(t, fields[slot[t.column]])) return;
+        cells.clear();
+        for (const std::size_t c : out) cells.push_back(fields[slot[c]]);
+        ++stats.matches;
+        row(cells);
+    };
+
+    // One LogPath: a saved index points at its line, when the TSV is the store's
+    const bool tsvCurrent = !store.is_open() || store.export_bytes() == master.data().size();
+    const bool indexed = tsvCurrent && fs::exists(LogPathIndex::path_for(tsv));
+    const auto byPath = std::find_if(tests.begin(), tests.end(), [&](const Test &t) {
+        return names[t.column] == "LogPath" && t.op == Op::Eq && !t.value.empty();
+    });
+    if (byPath != tests.end() && indexed) {
+        stats.plan = "index";
+        LogPathIndex index(tsv);
+        stats.rows = index.size();
+        const std::string_view text = master.data();
+        for (const std::uint64_t offset : index.find(byPath->value)) {
+            std::string_view rest = text.substr(static_cast<std::size_t>(offset)), line;
+            util::next_line(rest, line);
+            reader.reset(line);
+            if (reader.next()) emit_line();
+        }
+        return true;
+    }
+
+    if (!store.is_open()) {
+        // The reader is past the header
+        stats.plan = "scan";
+        while (reader.next()) {
+            if (reader.line().empty()) continue;
+            ++stats.rows;
+            emit_line();
+        }
+        return true;
+    }
+
+    stats.plan = "store";
+    stats.rows = store.rows();
+    stats.segments = store.segments();
+    std::vector<std::uint64_t> keep;
+    std::string text;
+    std::vector<std::size_t> ends;
+    for (std::size_t s = 0; s < store.segments(); ++s) {
+        const std::size_t rows = store.segment_rows(s);
+        if (std::any_of(tests.begin(), tests.end(), [&](const Test &t) {
+                return zone_excludes(t, store.zone(s, t.column), store.typed(s, t.column), rows);
+            })) {
+            ++stats.skipped;
+            continue;
+        }
+        keep.assign((rows + 63) / 64, ~std::uint64_t{0});
+        if (rows % 64) keep.back() = (std::uint64_t{1} << (rows % 64)) - 1;
+        bool any = true;
+        for (const auto &t : tests) {
+            any = store.filter(
+                s, t.column, keep, [&](std::uint64_t v) { return match_present(t, v); },
+                [&](std::string_view cell) { return match_text(t, cell); }, match_text(t, {}));
+            if (!any) break;
+        }
+        if (!any) continue;
+        for (std::size_t w = 0; w < keep.size(); ++w) {
+            for (std::uint64_t m = keep[w]; m; m &= m - 1) {
+                const std::size_t r = w * 64 + static_cast<std::size_t>(std::countr_zero(m));
+                text.clear();
+                ends.clear();
+                for (const std::size_t c : out) {
+                    store.append_cell(text, s, r, c);
+                    ends.push_back(text.size());
+                }
+                cells.clear();
+                for (std::size_t i = 0, from = 0; i < ends.size(); from = ends[i++])
+                    cells.push_back(std::string_view(text).substr(from, ends[i] - from));
+                ++stats.matches;
+                row(cells);
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace excel
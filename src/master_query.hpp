@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace excel {
+
+// One condition on a master column, "Column<op>value":
+//   =  != < <= > >=  by value on typed columns (counts, sizes, times,
+//                    durations), by byte order on text; an empty value
+//                    stands for an empty cell ("Errors=")
+//   ~                text contains the value, ignoring ASCII case
+// On RunDate and the other time columns a date or part of one ("2025",
+// "2025-06", "2025-06-01") is the whole period: "RunDate=2025-06" is any time
+// in June, "RunDate>2025-06" from July on. Empty cells only pass "=" with an
+// empty value and "!=" with any other.
+struct QueryPredicate {
+    enum class Op { Eq, Ne, Lt, Le, Gt, Ge, Contains };
+    std::string column;
+    Op op = Op::Eq;
+    std::string value;
+};
+
+// "Column<op>value"; false when no operator follows a column name
+bool parse_query_predicate(std::string_view expr, QueryPredicate &out);
+
+struct Query {
+    std::vector<QueryPredicate> where;  // all must hold
+    std::vector<std::string> columns;   // output columns, all when empty
+};
+
+struct QueryStats {
+    const char *plan = "";        // "index", "store" or "scan"
+    std::size_t rows = 0;         // in the master
+    std::size_t matches = 0;
+    std::size_t segments = 0;     // store segments
+    std::size_t skipped = 0;      // of them ruled out by their zone maps
+};
+
+// Cells of one output row, or of the header
+using QueryRow = std::function<void(std::span<const std::string_view>)>;
+
+// The rows of the master in `outputsDir` that pass every predicate, in
+// ingestion order: `row` gets the header (the chosen columns) first, then
+// each match. Column names may be abbreviated to a unique prefix and ignore
+// case ("totalsize" for TotalSize(GB)).
+// "LogPath=<path>" is answered from the LogPath index when the master has
+// one. Otherwise the column store is read: a segment whose zone map (or, for
+// a text column, whose dictionary) rules a predicate out is skipped whole,
+// and the rest are narrowed column by column. Without a store the TSV is
+// scanned. Runs under a shared master lock, so it never sees an append half
+// done.
+// False with `error` set when a predicate or column does not fit the master.
+bool query_master(const std::string &outputsDir, const Query &query, const QueryRow &row, QueryStats &stats,
+                  std::string &error);
+
+} // namespace excel
@@ -0,0 +1,100 @@
+#include "master_merge.hpp"
+#include "single_sheet_writer.hpp"
+
+#include <fmt/printf.h>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Combines the partial masters written by nodes that each ingested one shard
+// (logtoExcel_cli --shard i/N) into the master of --outputs-dir, which is
+// merged in first so that merging again only adds what is new.
+int main(int argc, char** argv) {
+  std::string outputsDir = "EXCEL OUTPUTS";
+  std::string partitionName = "none", sortSpec, backendName = "libxlsxwriter";
+  std::size_t memoryLimitMB = 256;
+  unsigned jobs = 0;
+  excel::MergeOptions options;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--outputs-dir" && i + 1 < argc)           outputsDir = argv[++i];
+    else if (a == "--dedupe-content")                   options.dedupeContent = true;
+    else if (a == "--partition-master" && i + 1 < argc) partitionName = argv[++i];
+    else if (a == "--sort-master" && i + 1 < argc)      sortSpec = argv[++i];
+    else if (a == "--memory-limit" && i + 1 < argc)     memoryLimitMB = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--xlsx-backend" && i + 1 < argc)     backendName = argv[++i];
+    else if ((a == "-j" || a == "--jobs") && i + 1 < argc) jobs = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+    else if (!a.empty() && a[0] != '-')                 inputs.push_back(a);
+  }
+  if (inputs.empty()) {
+    fmt::print(stderr,
+      "Usage: logtoExcel_merge [--outputs-dir <folder>] [--dedupe-content] [--partition-master none|month|project] "
+      "[--sort-master <col>[,<col>...]] [--memory-limit <MB>] [--xlsx-backend libxlsxwriter|native] "
+      "[--jobs N] <partial master TSV or outputs folder>...\n");
+    return 2;
+  }
+  excel::MasterPartition partition;
+  if (!excel::parse_master_partition(partitionName, partition)) {
+    fmt::print(stderr, "Unknown --partition-master '{}': use none, month or project\n", partitionName);
+    return 2;
+  }
+  excel::MasterSort sort;
+  if (!excel::parse_master_sort(sortSpec, sort)) {
+    fmt::print(stderr, "Unknown column in --sort-master '{}'\n", sortSpec);
+    return 2;
+  }
+  sort.memoryLimit = std::max<std::size_t>(memoryLimitMB, 1) << 20;
+  excel::WorkbookBackend backend;
+  if (!excel::parse_workbook_backend(backendName, backend)) {
+    fmt::print(stderr, "Unknown --xlsx-backend '{}': use libxlsxwriter or native\n", backendName);
+    return 2;
+  }
+
+  // A folder stands for the master in it; the target's own master goes first
+  fs::create_directories(outputsDir);
+  const std::string target = (fs::path(outputsDir) / "All_Exports.tsv").string();
+  std::vector<std::string> tsvs;
+  if (fs::exists(target)) tsvs.push_back(target);
+  for (const auto& in : inputs) {
+    const std::string tsv = fs::is_directory(in) ? (fs::path(in) / "All_Exports.tsv").string() : in;
+    std::error_code ec;
+    if (fs::exists(target) && fs::equivalent(tsv, target, ec)) continue;
+    tsvs.push_back(tsv);
+  }
+
+  // Held from reading the central master until the merge replaces it, or an
+  // append committed in between would be dropped by the rename
+  util::FileLock lock(excel::master_lock_path(outputsDir));
+  if (!lock.locked()) {
+    fmt::print(stderr, "Could not lock {}\n", excel::master_lock_path(outputsDir));
+    return 1;
+  }
+  const std::string merged = target + ".merge";
+  excel::MergeStats stats;
+  if (!excel::merge_masters(tsvs, merged, options, stats)) {
+    fmt::print(stderr, "Could not write {}\n", merged);
+    std::error_code ec;
+    fs::remove(merged, ec);
+    return 1;
+  }
+  for (const auto& s : stats.skipped) fmt::print(stderr, "Skipped {}: not a master TSV\n", s);
+  std::string error;
+  if (!excel::replace_master(outputsDir, lock, merged, error, partition, sort, backend, jobs)) {
+    fmt::print(stderr, "{}\n", error);
+    std::error_code ec;
+    fs::remove(merged, ec);
+    return 1;
+  }
+
+  fmt::print("Merged {} master(s): {} rows, {} duplicates dropped. Master: {}/{}\n",
+             tsvs.size() - stats.skipped.size(), stats.rows, stats.duplicates, outputsDir,
+             partition == excel::MasterPartition::Month     ? "All_Exports_by_month/Index.xlsx"
+             : partition == excel::MasterPartition::Project ? "All_Exports_by_project/Index.xlsx"
+                                                            : "All_Exports.xlsx");
+  return 0;
+}
@@ -1,36 +1,259 @@
 #include "models.hpp"
-#include "util_time.hpp"
-#include <filesystem>
-
-SummaryRow make_summary(const PhotoMeshRow &row) {
-    SummaryRow s;
-    s.projectName = row.projectName;
-    s.runDate = util::extract_date(row.startTime.empty() ? row.endTime : row.startTime);
-    s.tool = "PhotoMesh";
-    s.exportType = row.exportType;
-    s.duration = row.duration;
-    s.totalSizeGB = row.totalSizeGB;
-    s.photosUsed = row.photosUsed;
-    s.fusersUsed = row.fusersUsed;
-    s.machine = row.machine;
-    s.success = row.success;
-    s.errors = row.errors;
+#include "parse_state.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
+namespace {
+
+template <class E> struct LabelNames;
+// Spelling written for each code, indexed by the enum value
+template <> struct LabelNames<ExportType> {
+    static constexpr std::string_view names[] = {"", "", "OBJ", "3MX", "3DML", "3DTiles", "I3S", "OSGB", "LAS"};
+};
+template <> struct LabelNames<Resolution> {
+    static constexpr std::string_view names[] = {"", "", "LOW", "MEDIUM", "HIGH", "ULTRA"};
+};
+template <> struct LabelNames<TileScheme> {
+    static constexpr std::string_view names[] = {"", "", "QTM", "Grid"};
+};
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x + 32);
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y + 32);
+        if (x != y) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void from_text(std::string_view text, std::string &out) { out = text; }
+
+void from_text(std::string_view text, Sym &out) { out = util::strings().intern(text); }
+
+void from_text(std::string_view text, Count &out) {
+    std::int64_t v = 0;
+    const auto r = std::from_chars(text.data(), text.data() + text.size(), v);
+    if (r.ec == std::errc() && r.ptr == text.data() + text.size()) out = v;
+    else out.reset();
+}
+
+void from_text(std::string_view text, Real &out) {
+    double v = 0;
+    const auto r = std::from_chars(text.data(), text.data() + text.size(), v);
+    if (r.ec == std::errc() && r.ptr == text.data() + text.size()) out = v;
+    else out.reset();
+}
+
+void from_text(std::string_view text, Tri &out) {
+    if (iequals(text, "true") || iequals(text, "yes") || iequals(text, "on") || text == "1") out = Tri::True;
+    else if (iequals(text, "false") || iequals(text, "no") || iequals(text, "off") || text == "0") out = Tri::False;
+    else out = Tri::Missing;
+}
+
+template <class E>
+void from_text(std::string_view text, Label<E> &out) {
+    out = {};
+    if (text.empty()) return;
+    const auto &names = LabelNames<E>::names;
+    for (size_t i = 2; i < std::size(names); ++i)
+        if (iequals(text, names[i])) { out.code = static_cast<E>(i); return; }
+    out.code = E::Other;
+    out.other = util::strings().intern(text);
+}
+
+void append_text(std::string &out, std::string_view v) { out.append(v); }
+
+void append_text(std::string &out, Sym v) { out.append(util::strings().view(v)); }
+
+void append_text(std::string &out, const Count &v) {
+    if (!v) return;
+    char buf[24];
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, *v).ptr);
+}
+
+void append_text(std::string &out, const Real &v) {
+    if (!v) return;
+    char buf[32];
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, *v).ptr);
+}
+
+void append_text(std::string &out, const Instant &v) {
+    if (!v) return;
+    char buf[40];
+    out.append(buf, util::format_time(buf, *v));
+}
+
+void append_text(std::string &out, const Elapsed &v) {
+    if (!v) return;
+    const auto secs = std::min<std::int64_t>(v->count(), INT32_MAX);
+    char buf[16];
+    out.append(buf, util::format_hhmmss(buf, static_cast<int>(secs)));
+}
+
+void append_text(std::string &out, Tri v) {
+    out.append(v == Tri::True ? "True" : v == Tri::False ? "False" : "");
+}
+
+void append_text(std::string &out, LogKind v) {
+    if (v != LogKind::Unknown) out.append(log_format(v).name);
+}
+
+template <class E>
+void append_text(std::string &out, const Label<E> &v) {
+    if (v.code == E::Other) append_text(out, v.other);
+    else out.append(LabelNames<E>::names[static_cast<size_t>(v.code)]);
+}
+
+void append_gb(std::string &out, const Real &v) {
+    if (!v) return;
+    char buf[400];  // fixed notation of the largest double
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, *v, std::chars_format::fixed, 2).ptr);
+}
+
+void append_date(std::string &out, const Instant &v) {
+    if (!v) return;
+    char buf[32];
+    out.append(buf, util::format_date(buf, *v));
+}
+
+void append_stamp(std::string &out, const Instant &v) {
+    if (!v) return;
+    char buf[32];
+    out.append(buf, util::format_stamp(buf, *v));
+}
+
+void append_tally(std::string &out, std::int32_t n) {
+    if (!n) return;
+    char buf[16];
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, n).ptr);
+}
+
+void append_errors(std::string &out, std::int32_t count, const std::string &messages) {
+    if (messages.empty()) append_tally(out, count);
+    else out.append(messages);
+}
+
+namespace {
+
+template <class T>
+std::string text_of(const T &v) {
+    std::string s;
+    append_text(s, v);
+    return s;
+}
+
+} // namespace
+
+std::string to_text(Sym v) { return text_of(v); }
+std::string to_text(const Count &v) { return text_of(v); }
+std::string to_text(const Real &v) { return text_of(v); }
+std::string to_text(const Instant &v) { return text_of(v); }
+std::string to_text(const Elapsed &v) { return text_of(v); }
+std::string to_text(Tri v) { return text_of(v); }
+std::string to_text(LogKind v) { return text_of(v); }
+template <class E>
+std::string to_text(const Label<E> &v) { return text_of(v); }
+
+std::string gb_text(const Real &v) {
+    std::string s;
+    append_gb(s, v);
     return s;
 }
 
-SummaryRow make_summary(const RealityMeshRow &row) {
-    SummaryRow s;
-    s.projectName = row.projectName.empty() ? row.datasetName : row.projectName;
-    s.runDate = util::extract_date(row.startTime.empty() ? row.endTime : row.startTime);
-    s.tool = "RealityMesh";
-    s.exportType = row.exportType;
-    s.duration = row.duration;
-    s.totalSizeGB = row.totalSizeGB;
-    s.photosUsed = "";
-    s.fusersUsed = "";
-    s.machine = row.machine;
-    s.success = row.success;
-    s.errors = row.errors;
+std::string date_text(const Instant &v) {
+    std::string s;
+    append_date(s, v);
     return s;
 }
 
+std::string stamp_text(const Instant &v) {
+    std::string s;
+    append_stamp(s, v);
+    return s;
+}
+
+std::string tally_text(std::int32_t n) {
+    std::string s;
+    append_tally(s, n);
+    return s;
+}
+
+std::string errors_text(std::int32_t count, const std::string &messages) {
+    std::string s;
+    append_errors(s, count, messages);
+    return s;
+}
+
+// Optional values are a presence word followed by the value
+void save_value(util::StateWriter &w, const std::string &v) { w.str(v); }
+void save_value(util::StateWriter &w, Sym v) { w.str(util::strings().view(v)); }
+void save_value(util::StateWriter &w, const Count &v) {
+    w.u64(v.has_value());
+    if (v) w.u64(static_cast<std::uint64_t>(*v));
+}
+void save_value(util::StateWriter &w, const Real &v) {
+    w.u64(v.has_value());
+    if (v) w.u64(std::bit_cast<std::uint64_t>(*v));
+}
+void save_value(util::StateWriter &w, const Instant &v) {
+    w.u64(v.has_value());
+    if (v) w.u64(static_cast<std::uint64_t>(v->time_since_epoch().count()));
+}
+void save_value(util::StateWriter &w, const Elapsed &v) {
+    w.u64(v.has_value());
+    if (v) w.u64(static_cast<std::uint64_t>(v->count()));
+}
+void save_value(util::StateWriter &w, Tri v) { w.u64(static_cast<std::uint64_t>(v)); }
+template <class E>
+void save_value(util::StateWriter &w, const Label<E> &v) {
+    w.u64(static_cast<std::uint64_t>(v.code));
+    if (v.code == E::Other) save_value(w, v.other);
+}
+
+void load_value(util::StateReader &r, std::string &v) { v = r.str(); }
+void load_value(util::StateReader &r, Sym &v) { v = util::strings().intern(r.str()); }
+void load_value(util::StateReader &r, Count &v) {
+    v.reset();
+    if (r.u64()) v = static_cast<std::int64_t>(r.u64());
+}
+void load_value(util::StateReader &r, Real &v) {
+    v.reset();
+    if (r.u64()) v = std::bit_cast<double>(r.u64());
+}
+void load_value(util::StateReader &r, Instant &v) {
+    v.reset();
+    if (r.u64()) v = util::TimePoint(util::TimePoint::duration(static_cast<util::TimePoint::rep>(r.u64())));
+}
+void load_value(util::StateReader &r, Elapsed &v) {
+    v.reset();
+    if (r.u64()) v = std::chrono::seconds(static_cast<std::int64_t>(r.u64()));
+}
+void load_value(util::StateReader &r, Tri &v) {
+    const auto x = r.u64();
+    v = x <= static_cast<std::uint64_t>(Tri::True) ? static_cast<Tri>(x) : Tri::Missing;
+}
+template <class E>
+void load_value(util::StateReader &r, Label<E> &v) {
+    v = {};
+    const auto code = r.u64();
+    if (code >= std::size(LabelNames<E>::names)) return;
+    v.code = static_cast<E>(code);
+    if (v.code == E::Other) load_value(r, v.other);
+}
+
+#define LTE_LABEL(E)                                                        \
+    template void from_text(std::string_view, Label<E> &);                  \
+    template std::string to_text(const Label<E> &);                         \
+    template void append_text(std::string &, const Label<E> &);             \
+    template void save_value(util::StateWriter &, const Label<E> &);        \
+    template void load_value(util::StateReader &, Label<E> &);
+LTE_LABEL(ExportType)
+LTE_LABEL(Resolution)
+LTE_LABEL(TileScheme)
+#undef LTE_LABEL
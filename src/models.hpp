@@ -1,97 +1,185 @@
 #pragma once
+#include "log_format.hpp"
+#include "string_pool.hpp"
+#include "util_time.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace util {
+class StateWriter;
+class StateReader;
+}
+
+// Row values keep their type from the parsers to the writers: log text is
+// converted once when it is read (from_text) and turned back into cell text
+// only when a TSV or workbook is written (to_text). nullopt / Missing means
+// the log did not give the value or gave one that does not parse.
+// Categorical text (machines, users, folders, datums, ...) is interned in
+// util::strings(), so rows hold 32-bit ids and compare them directly.
+using util::Sym;
+using Count = std::optional<std::int64_t>;
+using Real = std::optional<double>;
+using Instant = std::optional<util::TimePoint>;
+using Elapsed = std::optional<std::chrono::seconds>;
+
+enum class Tri : std::uint8_t { Missing, False, True };
+
+// Closed value sets, matched case-insensitively; Other keeps the text of
+// anything outside the set
+enum class ExportType : std::uint8_t { Missing, Other, OBJ, ThreeMX, ThreeDML, ThreeDTiles, I3S, OSGB, LAS };
+enum class Resolution : std::uint8_t { Missing, Other, Low, Medium, High, Ultra };
+enum class TileScheme : std::uint8_t { Missing, Other, QTM, Grid };
+
+template <class E>
+struct Label {
+    E code = E::Missing;
+    Sym other{};        // only for E::Other
+
+    bool operator==(const Label &) const = default;
+};
+
 struct PhotoMeshRow {
     std::string projectName;
-    std::string buildID;
-    std::string machine;
-    std::string hostIP;
-    std::string user;
-    std::string startTime;
-    std::string endTime;
-    std::string duration;
-    std::string exportType;
-    std::string resolution;
-    std::string tileScheme;
-    std::string photosUsed;
+    Sym buildID{};
+    Sym machine{};
+    Sym hostIP{};
+    Sym user{};
+    Instant startTime;
+    Instant endTime;
+    Elapsed duration;
+    Label<ExportType> exportType;
+    Label<Resolution> resolution;
+    Label<TileScheme> tileScheme;
+    Count photosUsed;
     std::string photoFolders;
-    std::string photoCoverage;
-    std::string fusersUsed;
-    std::string cpuThreads;
-    std::string gpuCount;
-    std::string outputFolder;
-    std::string totalFiles;
-    std::string totalSizeGB;
-    std::string offsetCoordSys;
-    std::string offsetHDatum;
-    std::string offsetVDatum;
-    std::string offsetX;
-    std::string offsetY;
-    std::string offsetZ;
-    std::string pivotCenterX;
-    std::string pivotCenterY;
-    std::string pivotCenterZ;
-    std::string flipYZ;
-    std::string trim;
-    std::string collision;
-    std::string visualLOD;
-    std::string success;
-    std::string warnings;
-    std::string errors;
+    Real photoCoverage;         // km²
+    Count fusersUsed;
+    Count cpuThreads;
+    Count gpuCount;
+    Sym outputFolder{};
+    Count totalFiles;
+    Real totalSizeGB;
+    Sym offsetCoordSys{};
+    Sym offsetHDatum{};
+    Sym offsetVDatum{};
+    Real offsetX;
+    Real offsetY;
+    Real offsetZ;
+    Real pivotCenterX;
+    Real pivotCenterY;
+    Real pivotCenterZ;
+    Tri flipYZ = Tri::Missing;
+    Tri trim = Tri::Missing;
+    Tri collision = Tri::Missing;
+    Tri visualLOD = Tri::Missing;
+    Tri success = Tri::Missing;
+    std::int32_t warnings = 0;  // lines mentioning "Warning" / "Error"
+    std::int32_t errors = 0;
     std::string logPath;
 };
 
 struct RealityMeshRow {
     std::string projectName;
     std::string datasetName;
-    std::string machine;
-    std::string hostIP;
-    std::string user;
-    std::string startTime;
-    std::string endTime;
-    std::string duration;
-    std::string processPreset;
-    std::string exportType;
-    std::string selAreaSize;
-    std::string resolution;
-    std::string tileScheme;
-    std::string offsetCoordSys;
-    std::string offsetHDatum;
-    std::string offsetVDatum;
-    std::string offsetX;
-    std::string offsetY;
-    std::string offsetZ;
-    std::string pivotCenterX;
-    std::string pivotCenterY;
-    std::string pivotCenterZ;
-    std::string flipYZ;
-    std::string trim;
-    std::string collision;
-    std::string visualLOD;
-    std::string outputFolder;
-    std::string totalFiles;
-    std::string totalSizeGB;
-    std::string success;
-    std::string warnings;
-    std::string errors;
+    Sym machine{};
+    Sym hostIP{};
+    Sym user{};
+    Instant startTime;
+    Instant endTime;
+    Elapsed duration;
+    Sym processPreset{};
+    Label<ExportType> exportType;
+    Real selAreaSize;           // km²
+    Label<Resolution> resolution;
+    Label<TileScheme> tileScheme;
+    Sym offsetCoordSys{};
+    Sym offsetHDatum{};
+    Sym offsetVDatum{};
+    Real offsetX;
+    Real offsetY;
+    Real offsetZ;
+    Real pivotCenterX;
+    Real pivotCenterY;
+    Real pivotCenterZ;
+    Tri flipYZ = Tri::Missing;
+    Tri trim = Tri::Missing;
+    Tri collision = Tri::Missing;
+    Tri visualLOD = Tri::Missing;
+    Sym outputFolder{};
+    Count totalFiles;
+    Real totalSizeGB;
+    Tri success = Tri::Missing;
+    std::int32_t warnings = 0;
+    std::int32_t errorCount = 0;  // "Error:" lines
+    std::string errors;           // their messages, joined with ';'
     std::string logPath;
 };
 
-struct SummaryRow {
-    std::string projectName;
-    std::string runDate;
-    std::string tool;
-    std::string exportType;
-    std::string duration;
-    std::string totalSizeGB;
-    std::string photosUsed;
-    std::string fusersUsed;
-    std::string machine;
-    std::string success;
-    std::string errors;
-};
+// Input edge: log text to values (text is expected trimmed)
+void from_text(std::string_view text, std::string &out);
+void from_text(std::string_view text, Sym &out);  // interned in util::strings()
+void from_text(std::string_view text, Count &out);
+void from_text(std::string_view text, Real &out);
+void from_text(std::string_view text, Tri &out);  // True/False, Yes/No, On/Off, 1/0
+template <class E>
+void from_text(std::string_view text, Label<E> &out);
+
+// Output edge: cell text; Missing is empty
+std::string to_text(Sym v);
+std::string to_text(const Count &v);
+std::string to_text(const Real &v);        // shortest round-trip form
+std::string to_text(const Instant &v);     // see util::format_time
+std::string to_text(const Elapsed &v);     // hh:mm:ss
+std::string to_text(Tri v);                // "True" / "False"
+std::string to_text(LogKind v);            // registered format name
+template <class E>
+std::string to_text(const Label<E> &v);
+std::string gb_text(const Real &v);        // two decimals
+std::string date_text(const Instant &v);   // YYYY-MM-DD
+std::string stamp_text(const Instant &v);  // YYYY-MM-DD HH:MM:SS
+std::string tally_text(std::int32_t n);    // empty for 0
+// The messages when there are any, else the count when it is not 0
+std::string errors_text(std::int32_t count, const std::string &messages);
 
-SummaryRow make_summary(const PhotoMeshRow &row);
-SummaryRow make_summary(const RealityMeshRow &row);
+// Same text appended to `out`, for writers that reuse one buffer per cell
+void append_text(std::string &out, std::string_view v);
+void append_text(std::string &out, Sym v);
+void append_text(std::string &out, const Count &v);
+void append_text(std::string &out, const Real &v);
+void append_text(std::string &out, const Instant &v);
+void append_text(std::string &out, const Elapsed &v);
+void append_text(std::string &out, Tri v);
+void append_text(std::string &out, LogKind v);
+template <class E>
+void append_text(std::string &out, const Label<E> &v);
+void append_gb(std::string &out, const Real &v);
+void append_date(std::string &out, const Instant &v);
+void append_stamp(std::string &out, const Instant &v);
+void append_tally(std::string &out, std::int32_t n);
+void append_errors(std::string &out, std::int32_t count, const std::string &messages);
 
+// Encoding in persisted parser states
+void save_value(util::StateWriter &w, const std::string &v);
+void save_value(util::StateWriter &w, Sym v);  // as text: ids are per process
+void save_value(util::StateWriter &w, const Count &v);
+void save_value(util::StateWriter &w, const Real &v);
+void save_value(util::StateWriter &w, const Instant &v);
+void save_value(util::StateWriter &w, const Elapsed &v);
+void save_value(util::StateWriter &w, Tri v);
+template <class E>
+void save_value(util::StateWriter &w, const Label<E> &v);
+void load_value(util::StateReader &r, std::string &v);
+void load_value(util::StateReader &r, Sym &v);
+void load_value(util::StateReader &r, Count &v);
+void load_value(util::StateReader &r, Real &v);
+void load_value(util::StateReader &r, Instant &v);
+void load_value(util::StateReader &r, Elapsed &v);
+void load_value(util::StateReader &r, Tri &v);
+template <class E>
+void load_value(util::StateReader &r, Label<E> &v);
@@ -0,0 +1,696 @@
+#include "native_xlsx.hpp"
+#include "column_store.hpp"
+#include "thread_pool.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <initializer_list>
+#include <set>
+#include <utility>
+
+namespace excel {
+
+namespace {
+
+constexpr std::size_t kBlockBytes = std::size_t{4} << 20;  // cell text per block
+constexpr std::size_t kBlockRows = 16384;
+constexpr std::size_t kMaxRows = 1048576;                  // Excel's sheet limits
+constexpr std::size_t kMaxColumns = 16384;
+constexpr std::size_t kMaxStringChars = 32767;
+constexpr std::uint64_t kMax32 = 0xffffffffu;
+
+// cellXfs of styles.xml, one per number format CellWriter uses
+enum Style { kGeneral, kFixed2, kDate, kTime, kDuration };
+
+constexpr std::string_view kXmlDecl = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+constexpr std::string_view kMainNs = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+constexpr std::string_view kRelNs = "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+constexpr std::string_view kPackageRelNs = "http://schemas.openxmlformats.org/package/2006/relationships";
+
+// ---------------- XML ----------------
+
+// Text for an element or attribute; control characters XML cannot hold are
+// written as Excel's _xHHHH_ escapes
+void append_escaped(std::string &xml, std::string_view text) {
+    std::size_t from = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        const char *escape = nullptr;
+        char code[8];
+        switch (c) {
+        case '&': escape = "&amp;"; break;
+        case '<': escape = "&lt;"; break;
+        case '>': escape = "&gt;"; break;
+        case '"': escape = "&quot;"; break;
+        default:
+            if (c < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+                std::snprintf(code, sizeof code, "_x%04X_", c);
+                escape = code;
+            }
+        }
+        if (!escape) continue;
+        xml.append(text.substr(from, i - from)).append(escape);
+        from = i + 1;
+    }
+    xml.append(text.substr(from));
+}
+
+template <class T>
+void append_number(std::string &xml, T v) {
+    char buf[32];
+    xml.append(buf, std::to_chars(buf, buf + sizeof buf, v).ptr);
+}
+
+// "A", "B", ... "Z", "AA", ...
+std::string column_name(std::size_t c) {
+    std::string name;
+    for (++c; c; c = (c - 1) / 26) name.insert(name.begin(), static_cast<char>('A' + (c - 1) % 26));
+    return name;
+}
+
+std::size_t utf8_chars(std::string_view s) {
+    return static_cast<std::size_t>(
+        std::count_if(s.begin(), s.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xc0) != 0x80; }));
+}
+
+// Excel's serial day of a time: days since 1899-12-30, fraction for the time
+// of day, and one day less before March 1900 (Excel counts a 1900-02-29).
+// False before 1900, where Excel has no dates.
+bool serial_of(std::int64_t ns, double &serial) {
+    using namespace std::chrono;
+    const sys_time<nanoseconds> t{nanoseconds(ns)};
+    const auto day = floor<days>(t);
+    if (year_month_day(day).year() < year(1900)) return false;
+    auto n = (day - sys_days(year(1899) / December / 30)).count();
+    if (n < 61) --n;
+    // Same arithmetic as libxlsxwriter on the broken-down time CellWriter passes
+    const hh_mm_ss<nanoseconds> hms(t - day);
+    const double sec = static_cast<double>(hms.seconds().count()) + static_cast<double>(hms.subseconds().count()) / 1e9;
+    const double seconds = static_cast<double>(hms.hours().count() * 3600 + hms.minutes().count() * 60) + sec;
+    serial = static_cast<double>(n) + seconds / (24 * 60 * 60);
+    return true;
+}
+
+// Cells of one sheet as XML, typed as CellWriter types them
+struct CellXml {
+    std::vector<std::string> columns;  // letters
+    std::vector<CellKind> kinds;
+
+    void cell(std::string &xml, std::size_t c, std::string_view row, CellKind kind, std::string_view text) const {
+        const auto open = [&](int style, const char *type) {
+            xml += "<c r=\"";
+            if (c < columns.size()) xml += columns[c];
+            else xml += column_name(c);
+            xml.append(row).push_back('"');
+            if (style != kGeneral) {
+                xml += " s=\"";
+                append_number(xml, style);
+                xml.push_back('"');
+            }
+            if (type) xml.append(" t=\"").append(type).push_back('"');
+            xml.push_back('>');
+        };
+        const auto number = [&](double v, int style) {
+            open(style, nullptr);
+            xml += "<v>";
+            append_number(xml, v);
+            xml += "</v></c>";
+        };
+        std::uint64_t bits = 0;
+        const auto i = [&] { return static_cast<double>(static_cast<std::int64_t>(bits)); };
+        if (kind == CellKind::Bool) {
+            if (text == "True" || text == "False") {
+                open(kGeneral, "b");
+                xml += text == "True" ? "<v>1</v></c>" : "<v>0</v></c>";
+                return;
+            }
+        } else if (kind != CellKind::Text && ColumnStore::value_of(kind, text, bits)) {
+            switch (kind) {
+            case CellKind::Int: return number(i(), kGeneral);
+            case CellKind::Real: {
+                const double v = std::bit_cast<double>(bits);
+                if (!std::isfinite(v)) break;
+                return number(v, kGeneral);
+            }
+            case CellKind::Fixed2: return number(i() / 100, kFixed2);
+            case CellKind::Duration: return number(i() / 86400, kDuration);
+            case CellKind::Time:
+            case CellKind::Stamp:
+            case CellKind::Date: {
+                double serial = 0;
+                if (!serial_of(static_cast<std::int64_t>(bits), serial)) break;
+                return number(serial, kind == CellKind::Date ? kDate : kTime);
+            }
+            case CellKind::Text:
+            case CellKind::Bool: break;
+            }
+        }
+        if (text.size() > kMaxStringChars && utf8_chars(text) > kMaxStringChars) return;  // Excel holds no more
+        open(kGeneral, "inlineStr");
+        const bool edge = std::isspace(static_cast<unsigned char>(text.front())) ||
+                          std::isspace(static_cast<unsigned char>(text.back()));
+        xml += edge ? "<is><t xml:space=\"preserve\">" : "<is><t>";
+        append_escaped(xml, text);
+        xml += "</t></is></c>";
+    }
+
+    // Sheet row `r` (1-based); a row with no cells is left out
+    void row(std::string &xml, std::size_t r, std::span<const std::string_view> fields, bool header) const {
+        char buf[24];
+        const std::string_view rn(buf, static_cast<std::size_t>(std::to_chars(buf, buf + sizeof buf, r).ptr - buf));
+        const std::size_t mark = xml.size();
+        xml.append("<row r=\"").append(rn).append("\">");
+        const std::size_t open = xml.size();
+        const std::size_t n = std::min(fields.size(), kMaxColumns);
+        for (std::size_t c = 0; c < n; ++c) {
+            if (fields[c].empty()) continue;
+            cell(xml, c, rn, header || c >= kinds.size() ? CellKind::Text : kinds[c], fields[c]);
+        }
+        if (xml.size() == open) xml.resize(mark);
+        else xml += "</row>";
+    }
+};
+
+// `raw` as raw deflate: the end of the stream when `last`, else a run of
+// blocks ending on a byte boundary (Z_SYNC_FLUSH) that another segment can
+// follow. Segments deflated apart and laid end to end are one valid stream.
+bool deflate_segment(std::string_view raw, bool last, std::string &out) {
+    z_stream z{};
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    out.resize(deflateBound(&z, static_cast<uLong>(raw.size())) + 16);
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(raw.data()));
+    z.next_out = reinterpret_cast<Bytef *>(out.data());
+    z.avail_out = static_cast<uInt>(out.size());
+    bool ok = true;
+    for (std::string_view rest = raw; ok;) {
+        const std::size_t take = std::min<std::size_t>(rest.size(), 1u << 30);
+        z.avail_in = static_cast<uInt>(take);
+        rest.remove_prefix(take);
+        const int flush = !rest.empty() ? Z_NO_FLUSH : last ? Z_FINISH : Z_SYNC_FLUSH;
+        const int r = deflate(&z, flush);
+        if (!rest.empty()) ok = r == Z_OK;
+        else {
+            ok = last ? r == Z_STREAM_END : r == Z_OK && z.avail_in == 0 && z.avail_out > 0;
+            break;
+        }
+    }
+    out.resize(z.total_out);
+    deflateEnd(&z);
+    return ok;
+}
+
+std::uint32_t crc_of(std::string_view raw) {
+    return static_cast<std::uint32_t>(crc32_z(0, reinterpret_cast<const Bytef *>(raw.data()), raw.size()));
+}
+
+void put(std::string &out, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+// Rows taken in one piece; a worker turns them into XML and deflates it
+struct Block {
+    std::size_t firstRow = 0;           // sheet row of the first one (1-based)
+    std::string chars;                  // cell text, back to back
+    std::vector<std::size_t> ends;      // end of each cell in chars
+    std::vector<std::size_t> rowEnds;   // end of each row in ends
+    std::string deflated;
+    std::uint32_t crc = 0;
+    std::uint64_t bytes = 0;            // of XML
+    bool ok = false;
+    std::promise<void> done;
+    std::future<void> ready = done.get_future();
+};
+
+struct ZipPart {
+    std::string name;
+    std::uint64_t offset = 0, compressed = 0, size = 0;
+    std::uint32_t crc = 0;
+    bool zip64 = false;                 // local header has zip64 sizes
+};
+
+// 1980-01-01 00:00: the parts carry no time, so equal sheets give equal files
+constexpr std::uint16_t kDosTime = 0, kDosDate = (1 << 5) | 1;
+
+} // namespace
+
+struct NativeSheetWriter::Impl {
+    SheetLayout layout;
+    bool table = false;
+    CellXml cells;
+    std::ofstream out;
+    std::uint64_t at = 0;               // bytes written
+    bool ok = true;
+    bool closed = false;
+    std::vector<ZipPart> parts;
+    std::size_t sheet = 0;              // the sheet's part
+    std::size_t rows = 0;               // data rows taken
+    std::shared_ptr<Block> filling;
+    std::deque<std::shared_ptr<Block>> inflight;  // oldest first
+    std::size_t maxInflight = 0;
+    util::ThreadPool pool;              // last: joined before the rest is destroyed
+
+    Impl(const std::string &path, SheetLayout l, unsigned jobs)
+        : layout(std::move(l)), out(path, std::ios::binary | std::ios::trunc), pool(jobs) {
+        maxInflight = 2 * pool.size() + 1;
+        cells.kinds = layout.kinds;
+        for (std::size_t c = 0; c < layout.headers.size(); ++c) cells.columns.push_back(column_name(c));
+        // A table needs distinct header names (Excel ignores their case);
+        // without them the sheet gets an autofilter
+        std::set<std::string> names;
+        table = layout.table && !layout.headers.empty() && layout.headers.size() <= kMaxColumns;
+        for (const auto &h : layout.headers) {
+            std::string key = h;
+            for (char &ch : key) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+            if (h.empty() || !names.insert(key).second) table = false;
+        }
+        ok = out.is_open();
+
+        // Parts that do not depend on the rows come first, then the sheet
+        add_part("[Content_Types].xml", content_types());
+        add_part("_rels/.rels", relationships({{"officeDocument", "xl/workbook.xml"}}));
+        add_part("xl/_rels/workbook.xml.rels",
+                 relationships({{"worksheet", "worksheets/sheet1.xml"}, {"styles", "styles.xml"}}));
+        add_part("xl/styles.xml", styles());
+        if (table) add_part("xl/worksheets/_rels/sheet1.xml.rels", relationships({{"table", "../tables/table1.xml"}}));
+
+        // Sheet XML beyond 4 GiB needs zip64 sizes, which must be reserved in
+        // the local header before the size is known. Short numeric cells
+        // come to many times their text as XML, so no estimate from the
+        // input is safe: the sheet always gets them, 20 bytes
+        sheet = parts.size();
+        parts.push_back({"xl/worksheets/sheet1.xml", at, 0, 0, 0, true});
+        write(local_header(parts[sheet]));
+        std::string head;
+        sheet_head(head);
+        std::string deflated;
+        ok = deflate_segment(head, false, deflated) && ok;
+        append_sheet(deflated, crc_of(head), head.size());
+    }
+
+    void write(std::string_view bytes) {
+        if (!ok) return;
+        ok = static_cast<bool>(out.write(bytes.data(), static_cast<std::streamsize>(bytes.size())));
+        at += bytes.size();
+    }
+
+    // ---------- zip ----------
+
+    static std::string local_header(const ZipPart &p) {
+        std::string h;
+        put(h, 0x04034b50, 4);
+        put(h, p.zip64 ? 45 : 20, 2);
+        put(h, 0, 2);
+        put(h, Z_DEFLATED, 2);
+        put(h, kDosTime, 2);
+        put(h, kDosDate, 2);
+        put(h, p.crc, 4);
+        put(h, p.zip64 ? kMax32 : p.compressed, 4);
+        put(h, p.zip64 ? kMax32 : p.size, 4);
+        put(h, p.name.size(), 2);
+        put(h, p.zip64 ? 20 : 0, 2);
+        h += p.name;
+        if (p.zip64) {
+            put(h, 1, 2);
+            put(h, 16, 2);
+            put(h, p.size, 8);
+            put(h, p.compressed, 8);
+        }
+        return h;
+    }
+
+    // A whole part, deflated as one stream
+    void add_part(std::string name, std::string_view xml) {
+        std::string deflated;
+        ok = deflate_segment(xml, true, deflated) && ok;
+        add_deflated(std::move(name), xml, deflated);
+    }
+
+    void add_deflated(std::string name, std::string_view xml, std::string_view deflated) {
+        ZipPart p{std::move(name), at, deflated.size(), xml.size(), crc_of(xml), false};
+        if (p.size > kMax32 || p.compressed > kMax32) ok = false;  // only the sheet can get that big
+        write(local_header(p));
+        write(deflated);
+        parts.push_back(std::move(p));
+    }
+
+    void append_sheet(std::string_view deflated, std::uint32_t crc, std::uint64_t bytes) {
+        ZipPart &p = parts[sheet];
+        write(deflated);
+        p.crc = static_cast<std::uint32_t>(crc32_combine(p.crc, crc, static_cast<z_off_t>(bytes)));
+        p.size += bytes;
+        p.compressed += deflated.size();
+    }
+
+    // The sheet's local header again, now that its sizes are known
+    void finish_sheet() {
+        ZipPart &p = parts[sheet];
+        if (!p.zip64 && (p.size >= kMax32 || p.compressed >= kMax32)) ok = false;
+        if (!ok) return;
+        const std::string h = local_header(p);
+        out.seekp(static_cast<std::streamoff>(p.offset));
+        ok = static_cast<bool>(out.write(h.data(), static_cast<std::streamsize>(h.size())));
+        out.seekp(static_cast<std::streamoff>(at));
+    }
+
+    void directory() {
+        std::string cd;
+        for (const auto &p : parts) {
+            std::string extra;
+            if (p.size >= kMax32) put(extra, p.size, 8);
+            if (p.compressed >= kMax32) put(extra, p.compressed, 8);
+            if (p.offset >= kMax32) put(extra, p.offset, 8);
+            if (!extra.empty()) {
+                std::string field;
+                put(field, 1, 2);
+                put(field, extra.size(), 2);
+                extra.insert(0, field);
+            }
+            const bool zip64 = p.zip64 || !extra.empty();
+            put(cd, 0x02014b50, 4);
+            put(cd, 45, 2);
+            put(cd, zip64 ? 45 : 20, 2);
+            put(cd, 0, 2);
+            put(cd, Z_DEFLATED, 2);
+            put(cd, kDosTime, 2);
+            put(cd, kDosDate, 2);
+            put(cd, p.crc, 4);
+            put(cd, std::min(p.compressed, kMax32), 4);
+            put(cd, std::min(p.size, kMax32), 4);
+            put(cd, p.name.size(), 2);
+            put(cd, extra.size(), 2);
+            put(cd, 0, 2);  // comment
+            put(cd, 0, 2);  // disk
+            put(cd, 0, 2);  // internal attributes
+            put(cd, 0, 4);  // external attributes
+            put(cd, std::min(p.offset, kMax32), 4);
+            cd += p.name;
+            cd += extra;
+        }
+        const std::uint64_t cdOffset = at, cdSize = cd.size(), n = parts.size();
+        if (cdOffset >= kMax32) {
+            const std::uint64_t record = cdOffset + cdSize;
+            put(cd, 0x06064b50, 4);
+            put(cd, 44, 8);
+            put(cd, 45, 2);
+            put(cd, 45, 2);
+            put(cd, 0, 4);
+            put(cd, 0, 4);
+            put(cd, n, 8);
+            put(cd, n, 8);
+            put(cd, cdSize, 8);
+            put(cd, cdOffset, 8);
+            put(cd, 0x07064b50, 4);
+            put(cd, 0, 4);
+            put(cd, record, 8);
+            put(cd, 1, 4);
+        }
+        put(cd, 0x06054b50, 4);
+        put(cd, 0, 2);
+        put(cd, 0, 2);
+        put(cd, n, 2);
+        put(cd, n, 2);
+        put(cd, std::min(cdSize, kMax32), 4);
+        put(cd, std::min(cdOffset, kMax32), 4);
+        put(cd, 0, 2);
+        write(cd);
+    }
+
+    // ---------- rows ----------
+
+    void take(std::span<const std::string_view> fields) {
+        if (!filling) {
+            filling = std::make_shared<Block>();
+            filling->firstRow = rows + 2;
+        }
+        Block &b = *filling;
+        for (const std::string_view f : fields) b.ends.push_back(b.chars.append(f).size());
+        b.rowEnds.push_back(b.ends.size());
+        ++rows;
+        if (b.chars.size() >= kBlockBytes || b.rowEnds.size() >= kBlockRows) submit();
+    }
+
+    void submit() {
+        std::shared_ptr<Block> b = std::move(filling);
+        inflight.push_back(b);
+        pool.submit([this, b] {
+            try {
+                build(*b);
+                b->done.set_value();
+            } catch (...) {
+                b->done.set_exception(std::current_exception());
+            }
+        });
+        while (inflight.size() > maxInflight) drain();
+    }
+
+    // Runs on a worker
+    void build(Block &b) const {
+        std::string xml;
+        xml.reserve(b.chars.size() * 3 + b.rowEnds.size() * 16);
+        std::vector<std::string_view> fields;
+        std::size_t cell = 0;
+        for (std::size_t r = 0; r < b.rowEnds.size() && b.firstRow + r <= kMaxRows; ++r) {
+            fields.clear();
+            for (; cell < b.rowEnds[r]; ++cell) {
+                const std::size_t from = cell ? b.ends[cell - 1] : 0;
+                fields.emplace_back(b.chars.data() + from, b.ends[cell] - from);
+            }
+            cells.row(xml, b.firstRow + r, fields, false);
+        }
+        b.chars = {};
+        b.bytes = xml.size();
+        b.crc = crc_of(xml);
+        b.ok = deflate_segment(xml, false, b.deflated);
+    }
+
+    // Writes out the oldest block once it is done
+    void drain() {
+        const std::shared_ptr<Block> b = std::move(inflight.front());
+        inflight.pop_front();
+        try {
+            b->ready.get();
+        } catch (...) {
+            ok = false;
+            return;
+        }
+        ok = b->ok && ok;
+        append_sheet(b->deflated, b->crc, b->bytes);
+    }
+
+    bool close() {
+        if (closed) return ok;
+        closed = true;
+        if (filling) submit();
+        while (!inflight.empty()) drain();
+
+        // The sheet's tail, the workbook and the table, deflated side by side
+        std::vector<std::pair<std::string, std::string>> rest;  // name, XML
+        std::string tail;
+        sheet_tail(tail);
+        rest.emplace_back("xl/workbook.xml", workbook());
+        if (table) rest.emplace_back("xl/tables/table1.xml", table_part());
+        std::string tailDeflated;
+        std::vector<std::string> deflated(rest.size());
+        std::vector<char> good(rest.size() + 1);
+        for (std::size_t i = 0; i <= rest.size(); ++i) {
+            pool.submit([&, i] {
+                good[i] = i == rest.size() ? deflate_segment(tail, true, tailDeflated)
+                                           : deflate_segment(rest[i].second, true, deflated[i]);
+            });
+        }
+        try {
+            pool.wait();
+        } catch (...) {
+            ok = false;
+        }
+        ok = ok && std::all_of(good.begin(), good.end(), [](char g) { return g; });
+
+        append_sheet(tailDeflated, crc_of(tail), tail.size());
+        finish_sheet();
+        for (std::size_t i = 0; i < rest.size(); ++i) add_deflated(rest[i].first, rest[i].second, deflated[i]);
+        directory();
+        out.close();
+        return ok && !out.fail();
+    }
+
+    // ---------- parts ----------
+
+    // Last column and row of the header and data, as "X123"
+    std::string last_cell() const {
+        std::string ref = column_name(std::min(layout.headers.size(), kMaxColumns) - 1);
+        append_number(ref, std::min(std::max<std::size_t>(rows, table ? 1 : 0) + 1, kMaxRows));
+        return ref;
+    }
+
+    void sheet_head(std::string &xml) const {
+        xml.append(kXmlDecl).append("<worksheet xmlns=\"").append(kMainNs);
+        xml.append("\" xmlns:r=\"").append(kRelNs).append("\">");
+        const bool header = !layout.headers.empty();
+        if (header) {
+            // Frozen header row
+            xml += "<sheetViews><sheetView tabSelected=\"1\" workbookViewId=\"0\">"
+                   "<pane ySplit=\"1\" topLeftCell=\"A2\" activePane=\"bottomLeft\" state=\"frozen\"/>"
+                   "<selection pane=\"bottomLeft\"/></sheetView></sheetViews>";
+        } else {
+            xml += "<sheetViews><sheetView tabSelected=\"1\" workbookViewId=\"0\"/></sheetViews>";
+        }
+        xml += "<sheetFormatPr defaultRowHeight=\"15\"/>";
+        if (header) {
+            // The width in characters as libxlsxwriter stores it: whole
+            // pixels of a 7-pixel digit plus 5 pixels of padding
+            const double w = layout.width;
+            const double pixels = w < 1 ? std::floor(w * 12 + 0.5) : std::floor(w * 7 + 0.5) + 5;
+            xml += "<cols><col min=\"1\" max=\"";
+            append_number(xml, std::min(layout.headers.size(), kMaxColumns));
+            xml += "\" width=\"";
+            append_number(xml, std::floor(pixels / 7 * 256) / 256);
+            xml += "\" customWidth=\"1\"/></cols>";
+        }
+        xml += "<sheetData>";
+        if (header) {
+            const std::vector<std::string_view> names(layout.headers.begin(), layout.headers.end());
+            cells.row(xml, 1, names, true);
+        }
+    }
+
+    void sheet_tail(std::string &xml) const {
+        xml += "</sheetData>";
+        if (!layout.headers.empty() && !table) xml.append("<autoFilter ref=\"A1:").append(last_cell()).append("\"/>");
+        const auto success = static_cast<std::size_t>(layout.successColumn);
+        if (layout.successColumn >= 0 && success < kMaxColumns && rows > 0) {
+            const std::string col = column_name(success);
+            xml.append("<conditionalFormatting sqref=\"").append(col).append("2:").append(col);
+            append_number(xml, std::min(rows + 1, kMaxRows));
+            xml += "\"><cfRule type=\"cellIs\" dxfId=\"0\" priority=\"1\" operator=\"equal\"><formula>TRUE</formula>"
+                   "</cfRule><cfRule type=\"cellIs\" dxfId=\"1\" priority=\"2\" operator=\"equal\"><formula>FALSE"
+                   "</formula></cfRule></conditionalFormatting>";
+        }
+        xml += "<pageMargins left=\"0.7\" right=\"0.7\" top=\"0.75\" bottom=\"0.75\" header=\"0.3\" footer=\"0.3\"/>";
+        if (table) xml += "<tableParts count=\"1\"><tablePart r:id=\"rId1\"/></tableParts>";
+        xml += "</worksheet>";
+    }
+
+    std::string workbook() const {
+        std::string xml(kXmlDecl);
+        xml.append("<workbook xmlns=\"").append(kMainNs).append("\" xmlns:r=\"").append(kRelNs).append("\">");
+        xml += "<workbookPr/><bookViews><workbookView xWindow=\"240\" yWindow=\"15\" windowWidth=\"16095\" "
+               "windowHeight=\"9660\"/></bookViews><sheets><sheet name=\"";
+        append_escaped(xml, layout.name);
+        xml += "\" sheetId=\"1\" r:id=\"rId1\"/></sheets>";
+        if (!layout.headers.empty() && !table) {
+            // The range the autofilter works on, as Excel records it
+            std::string sheetName;
+            for (const char c : layout.name) sheetName.append(c == '\'' ? 2 : 1, c);
+            std::string last = last_cell();
+            const std::size_t digits = last.find_first_of("0123456789");
+            last.insert(digits, "$");
+            xml += "<definedNames><definedName name=\"_xlnm._FilterDatabase\" localSheetId=\"0\" hidden=\"1\">";
+            append_escaped(xml, "'" + sheetName + "'!$A$1:$" + last);
+            xml += "</definedName></definedNames>";
+        }
+        xml += "<calcPr calcId=\"124519\" fullCalcOnLoad=\"1\"/></workbook>";
+        return xml;
+    }
+
+    std::string table_part() const {
+        std::string xml(kXmlDecl);
+        const std::string ref = "A1:" + last_cell();
+        xml.append("<table xmlns=\"").append(kMainNs).append("\" id=\"1\" name=\"Table1\" displayName=\"Table1\" ref=\"");
+        xml.append(ref).append("\" totalsRowShown=\"0\"><autoFilter ref=\"").append(ref).append("\"/>");
+        xml += "<tableColumns count=\"";
+        append_number(xml, layout.headers.size());
+        xml += "\">";
+        for (std::size_t c = 0; c < layout.headers.size(); ++c) {
+            xml += "<tableColumn id=\"";
+            append_number(xml, c + 1);
+            xml += "\" name=\"";
+            append_escaped(xml, layout.headers[c]);
+            xml += "\"/>";
+        }
+        xml += "</tableColumns><tableStyleInfo name=\"TableStyleMedium9\" showFirstColumn=\"0\" showLastColumn=\"0\" "
+               "showRowStripes=\"1\" showColumnStripes=\"0\"/></table>";
+        return xml;
+    }
+
+    std::string content_types() const {
+        std::string xml(kXmlDecl);
+        const auto override = [&](std::string_view part, std::string_view type) {
+            xml.append("<Override PartName=\"").append(part);
+            xml.append("\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.");
+            xml.append(type).append("+xml\"/>");
+        };
+        xml += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+               "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+               "<Default Extension=\"xml\" ContentType=\"application/xml\"/>";
+        override("/xl/workbook.xml", "sheet.main");
+        override("/xl/worksheets/sheet1.xml", "worksheet");
+        override("/xl/styles.xml", "styles");
+        if (table) override("/xl/tables/table1.xml", "table");
+        xml += "</Types>";
+        return xml;
+    }
+
+    // Relationships rId1, rId2, ... of one part: (type, target)
+    static std::string relationships(std::initializer_list<std::pair<std::string_view, std::string_view>> rels) {
+        std::string xml(kXmlDecl);
+        xml.append("<Relationships xmlns=\"").append(kPackageRelNs).append("\">");
+        std::size_t id = 0;
+        for (const auto &[type, target] : rels) {
+            xml += "<Relationship Id=\"rId";
+            append_number(xml, ++id);
+            xml.append("\" Type=\"").append(kRelNs).append("/").append(type);
+            xml.append("\" Target=\"").append(target).append("\"/>");
+        }
+        xml += "</Relationships>";
+        return xml;
+    }
+
+    // The number formats of CellWriter ("0.00" and "[h]:mm:ss" are built in
+    // as 2 and 46) and the Success fills, green and red
+    static std::string styles() {
+        std::string xml(kXmlDecl);
+        xml.append("<styleSheet xmlns=\"").append(kMainNs).append("\">");
+        xml += "<numFmts count=\"2\"><numFmt numFmtId=\"164\" formatCode=\"yyyy-mm-dd\"/>"
+               "<numFmt numFmtId=\"165\" formatCode=\"yyyy-mm-dd hh:mm:ss\"/></numFmts>"
+               "<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/><family val=\"2\"/></font></fonts>"
+               "<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill>"
+               "<fill><patternFill patternType=\"gray125\"/></fill></fills>"
+               "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+               "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+               "<cellXfs count=\"5\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>";
+        for (const int fmt : {2, 164, 165, 46}) {
+            xml += "<xf numFmtId=\"";
+            append_number(xml, fmt);
+            xml += "\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>";
+        }
+        xml += "</cellXfs><cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+               "<dxfs count=\"2\"><dxf><fill><patternFill><bgColor rgb=\"FF008000\"/></patternFill></fill></dxf>"
+               "<dxf><fill><patternFill><bgColor rgb=\"FFFF0000\"/></patternFill></fill></dxf></dxfs>"
+               "<tableStyles count=\"0\" defaultTableStyle=\"TableStyleMedium9\" defaultPivotStyle=\"PivotStyleLight16\"/>"
+               "</styleSheet>";
+        return xml;
+    }
+};
+
+NativeSheetWriter::NativeSheetWriter(const std::string &path, SheetLayout layout, unsigned jobs)
+    : impl_(std::make_unique<Impl>(path, std::move(layout), jobs)) {}
+
+NativeSheetWriter::~NativeSheetWriter() = default;
+
+void NativeSheetWriter::add_row(std::span<const std::string_view> fields) { impl_->take(fields); }
+
+bool NativeSheetWriter::close() { return impl_->close(); }
+
+} // namespace excel
@@ -0,0 +1,51 @@
+#pragma once
+#include "columns.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace excel {
+
+// The one sheet a NativeSheetWriter writes: a header row, then data rows
+struct SheetLayout {
+    std::string name = "Sheet1";
+    std::vector<std::string> headers;
+    std::vector<CellKind> kinds;       // per column; Text past the end
+    double width = 22;                 // of every header column
+    bool table = false;                // an Excel table over header and rows, else an autofilter
+    int successColumn = -1;            // TRUE cells green, FALSE cells red
+};
+
+// Writes a one-sheet .xlsx without libxlsxwriter, cells typed as CellWriter
+// types them (strings inline, as in libxlsxwriter's constant_memory mode).
+// Rows are gathered into blocks of a few MB; each block is turned into sheet
+// XML and deflated on a thread pool, and the blocks are written in row order
+// as they finish. Every block ends on a byte boundary (a sync flush), so the
+// compressed blocks join into the one deflate stream of the sheet part and
+// their CRCs combine into its CRC. The workbook, style, relationship and
+// table parts are written after the sheet, then the zip directory. Only a
+// bounded number of blocks is in flight, so memory stays flat.
+class NativeSheetWriter {
+public:
+    // `jobs` threads build and compress blocks (0 = hardware concurrency)
+    NativeSheetWriter(const std::string &path, SheetLayout layout, unsigned jobs = 0);
+    ~NativeSheetWriter();
+    NativeSheetWriter(const NativeSheetWriter &) = delete;
+    NativeSheetWriter &operator=(const NativeSheetWriter &) = delete;
+
+    // Next data row, cells as the TSV holds them; an empty cell is left blank
+    void add_row(std::span<const std::string_view> fields);
+
+    // Finishes the file; false if any part of it could not be written
+    bool close();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace excel
@@ -0,0 +1,184 @@
+#include "parse_state.hpp"
+#include "archive_reader.hpp"
+#include "file_lock.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace util {
+
+void StateWriter::u64(std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) buf_ += static_cast<char>(v >> (8 * i) & 0xff);
+}
+
+void StateWriter::str(std::string_view s) {
+    u64(s.size());
+    buf_ += s;
+}
+
+std::uint64_t StateReader::u64() {
+    if (rest_.size() < 8) { ok_ = false; rest_ = {}; return 0; }
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= std::uint64_t(static_cast<unsigned char>(rest_[i])) << (8 * i);
+    rest_.remove_prefix(8);
+    return v;
+}
+
+std::string StateReader::str() {
+    const std::uint64_t n = u64();
+    if (!ok_ || n > rest_.size()) { ok_ = false; rest_ = {}; return {}; }
+    std::string s(rest_.substr(0, n));
+    rest_.remove_prefix(n);
+    return s;
+}
+
+namespace {
+
+std::uint64_t fnv1a(std::string_view s, std::uint64_t h = 1469598103934665603ull) {
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+    return h;
+}
+
+} // namespace
+
+std::uint64_t prefix_fingerprint(std::string_view file, std::uint64_t offset) {
+    const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(offset, file.size()));
+    return prefix_fingerprint(file, file.substr(0, n), n);
+}
+
+std::uint64_t prefix_fingerprint(std::string_view head, std::string_view before, std::uint64_t offset) {
+    const std::uint64_t n = offset;
+    const std::size_t h = static_cast<std::size_t>(std::min<std::uint64_t>({n, kFingerprintWindow, head.size()}));
+    const std::size_t t = static_cast<std::size_t>(std::min<std::uint64_t>({n - h, kFingerprintWindow, before.size()}));
+    return fnv1a(before.substr(before.size() - t), fnv1a(head.substr(0, h)) ^ n);
+}
+
+std::optional<FileStamp> file_stamp(const std::string &path) {
+    // A log inside an archive changes only when the archive does
+    std::string archive, entry;
+    const bool inArchive = split_archive_path(path, archive, entry);
+    std::error_code ec;
+    const fs::directory_entry e(inArchive ? archive : path, ec);  // one stat, cached by the entry
+    if (ec || !e.is_regular_file(ec)) return std::nullopt;
+    FileStamp s;
+    s.size = e.file_size(ec);
+    if (ec) return std::nullopt;
+    s.mtime = static_cast<std::int64_t>(e.last_write_time(ec).time_since_epoch().count());
+    if (ec) return std::nullopt;
+    return s;
+}
+
+bool mtime_settled(std::int64_t mtime) {
+    const auto now = fs::file_time_type::clock::now();
+    const auto age = now.time_since_epoch() - fs::file_time_type::duration(mtime);
+    return age > std::chrono::seconds(2);
+}
+
+} // namespace util
+
+namespace {
+constexpr std::string_view kMagic = "logtoExcel parse state v4";
+}
+
+std::string ParseStateStore::default_path(const std::string &outputsDir) {
+    return (fs::path(outputsDir) / ".parse_state").string();
+}
+
+std::string ParseStateStore::key(std::string_view kind, const std::string &logPath) {
+    std::error_code ec;
+    fs::path p = fs::absolute(logPath, ec);
+    if (ec) p = logPath;
+    std::string k(kind);
+    k += '\t';
+    k += p.lexically_normal().string();
+    return k;
+}
+
+void ParseStateStore::load(const std::string &file) {
+    entries_.clear();
+    changed_.clear();
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return;
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string bytes = ss.str();
+
+    util::StateReader r(bytes);
+    if (r.str() != kMagic) return;
+    const std::uint64_t n = r.u64();
+    std::unordered_map<std::string, TailEntry> loaded;
+    for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+        std::string k = r.str();
+        TailEntry e;
+        e.offset = r.u64();
+        e.fingerprint = r.u64();
+        e.state = r.str();
+        e.partial = r.str();
+        e.stamp.size = r.u64();
+        e.stamp.mtime = static_cast<std::int64_t>(r.u64());
+        e.contentHash = r.u64();
+        e.hashState = r.str();
+        e.duplicate = r.u64() != 0;
+        loaded[std::move(k)] = std::move(e);
+    }
+    if (r.done()) entries_ = std::move(loaded);
+}
+
+bool ParseStateStore::save(const std::string &file) const {
+    // Another run may have saved since our load: start from its copy
+    util::FileLock lock(file + ".lock");
+    if (!lock.locked()) return false;
+    ParseStateStore merged;
+    merged.load(file);
+    for (const auto &k : changed_) {
+        const auto it = entries_.find(k);
+        if (it == entries_.end()) merged.entries_.erase(k);
+        else merged.entries_[k] = it->second;
+    }
+
+    util::StateWriter w;
+    w.str(kMagic);
+    w.u64(merged.entries_.size());
+    for (const auto &[k, e] : merged.entries_) {
+        w.str(k);
+        w.u64(e.offset);
+        w.u64(e.fingerprint);
+        w.str(e.state);
+        w.str(e.partial);
+        w.u64(e.stamp.size);
+        w.u64(static_cast<std::uint64_t>(e.stamp.mtime));
+        w.u64(e.contentHash);
+        w.str(e.hashState);
+        w.u64(e.duplicate);
+    }
+    const std::string tmp = util::unique_temp_path(file);
+    bool written;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(w.bytes().data(), static_cast<std::streamsize>(w.bytes().size()));
+        written = static_cast<bool>(out.flush());
+    }
+    if (!written) {
+        std::error_code ignored;
+        fs::remove(tmp, ignored);
+        return false;
+    }
+    return util::replace_file(tmp, file);
+}
+
+TailEntry ParseStateStore::get(const std::string &key) const {
+    const auto it = entries_.find(key);
+    return it == entries_.end() ? TailEntry{} : it->second;
+}
+
+void ParseStateStore::put(const std::string &key, TailEntry entry) {
+    changed_.insert(key);
+    if (entry.offset == 0 && entry.state.empty()) entries_.erase(key);
+    else entries_[key] = std::move(entry);
+}
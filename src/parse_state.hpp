@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace util {
+
+// Length-prefixed encoding for persisted parser states
+class StateWriter {
+public:
+    void u64(std::uint64_t v);
+    void str(std::string_view s);
+    const std::string &bytes() const { return buf_; }
+
+private:
+    std::string buf_;
+};
+
+// Reads what StateWriter wrote; ok() turns false on truncated input
+class StateReader {
+public:
+    explicit StateReader(std::string_view bytes) : rest_(bytes) {}
+    std::uint64_t u64();
+    std::string str();
+    bool ok() const { return ok_; }
+    bool done() const { return ok_ && rest_.empty(); }
+
+private:
+    std::string_view rest_;
+    bool ok_ = true;
+};
+
+// Identifies the first `offset` bytes of a log: a hash over its head and over
+// the bytes just before `offset`, so a truncated or replaced file is noticed.
+constexpr std::size_t kFingerprintWindow = 4096;
+std::uint64_t prefix_fingerprint(std::string_view file, std::uint64_t offset);
+
+// The same from two pieces of the file: `head` starts at byte 0 and `before`
+// ends at `offset`; each needs kFingerprintWindow bytes, or all there are.
+std::uint64_t prefix_fingerprint(std::string_view head, std::string_view before, std::uint64_t offset);
+
+// Size and modification time from one stat (of the archive, for a path inside
+// one); nullopt if the file is missing
+struct FileStamp {
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+};
+std::optional<FileStamp> file_stamp(const std::string &path);
+
+// False for an mtime so recent that the file could still be rewritten within
+// the same timestamp tick; such stamps must not be trusted on their own.
+bool mtime_settled(std::int64_t mtime);
+
+} // namespace util
+
+// Saved progress of one log: the parser state after its first `offset` bytes,
+// plus what is needed to reuse it without opening an unchanged file
+struct TailEntry {
+    std::uint64_t offset = 0;       // whole lines only; a partial last line is reparsed
+    std::uint64_t fingerprint = 0;  // util::prefix_fingerprint(file, offset)
+    std::string state;              // parser state written by State::save
+    std::string partial;            // bytes after `offset` (an unfinished last line)
+    util::FileStamp stamp;          // file or archive when saved (mtime 0 if not settled)
+    std::uint64_t contentHash = 0;  // util::content_hash of the whole file, 0 if unknown
+    std::string hashState;          // util::ContentHash after `offset` bytes
+    bool duplicate = false;         // its content was stored under another path first
+};
+
+// Sidecar in the outputs dir that lets the next run parse only appended bytes.
+// Keyed by parser kind and absolute log path.
+class ParseStateStore {
+public:
+    static std::string default_path(const std::string &outputsDir);
+    static std::string key(std::string_view kind, const std::string &logPath);
+
+    // A missing, foreign or corrupt file leaves the store empty
+    void load(const std::string &file);
+    // Under `file`.lock, the entries put since load() are merged into the copy
+    // on disk, so runs sharing an outputs folder keep each other's entries;
+    // written to a temp file and renamed over `file`. False on I/O failure.
+    bool save(const std::string &file) const;
+
+    TailEntry get(const std::string &key) const;
+    void put(const std::string &key, TailEntry entry);  // empty entry erases
+
+    const std::unordered_map<std::string, TailEntry> &entries() const { return entries_; }
+
+private:
+    std::unordered_map<std::string, TailEntry> entries_;
+    std::unordered_set<std::string> changed_;  // keys put since load()
+};
@@ -1,65 +1,204 @@
 #include "photomesh_parser.hpp"
+#include "archive_reader.hpp"
+#include "extract_rules.hpp"
+#include "line_reader.hpp"
+#include "scan_kernel.hpp"
 #include "util_time.hpp"
-#include <fstream>
-#include <regex>
-#include <filesystem>
+#include <bit>
+#include <iterator>
+#include <variant>
+#include <vector>
 
-PhotoMeshRow parse_photomesh(const std::string &path) {
-    PhotoMeshRow row;
-    row.logPath = path;
-    row.projectName = std::filesystem::path(path).stem().string();
-    std::ifstream in(path);
-    if (!in) return row;
-    std::string line;
-    std::regex kv(R"(SLDEFAULT=>\s*(\w+)\s*:\s*(.*))");
-    std::regex machine(R"delim("MachineName"\s*:\s*"([^"]+)")delim");
-    std::regex timeR(R"delim("MsgTime"\s*:\s*"([^"]+)")delim");
-    std::regex exitR(R"(Finished with exit code\s*\((\d+)\))");
-    int warn=0, err=0;
-    while (std::getline(in,line)) {
-        std::smatch m;
-        if (std::regex_search(line,m,machine)) row.machine = m[1];
-        if (std::regex_search(line,m,timeR)) {
-            if (row.startTime.empty()) row.startTime = m[1];
-            row.endTime = m[1];
-        }
-        if (std::regex_search(line,m,kv)) {
-            std::string key = m[1];
-            std::string val = util::trim(m[2]);
-            if (key == "ExportType") row.exportType = val;
-            else if (key == "Resolution") row.resolution = val;
-            else if (key == "TileScheme") row.tileScheme = val;
-            else if (key == "PhotosUsed") row.photosUsed = val;
-            else if (key == "PhotoFolders") row.photoFolders = val;
-            else if (key == "PhotoCoverage") row.photoCoverage = val;
-            else if (key == "FusersUsed") row.fusersUsed = val;
-            else if (key == "CPUThreads") row.cpuThreads = val;
-            else if (key == "GPUCount") row.gpuCount = val;
-            else if (key == "OutputFolder") row.outputFolder = val;
-            else if (key == "TotalFiles") row.totalFiles = val;
-            else if (key == "TotalSize") row.totalSizeGB = util::size_to_gb(val);
-            else if (key == "Offset_CoordSys") row.offsetCoordSys = val;
-            else if (key == "Offset_HDatum") row.offsetHDatum = val;
-            else if (key == "Offset_VDatum") row.offsetVDatum = val;
-            else if (key == "OffsetX") row.offsetX = val;
-            else if (key == "OffsetY") row.offsetY = val;
-            else if (key == "OffsetZ") row.offsetZ = val;
-            else if (key == "PivotCenterX") row.pivotCenterX = val;
-            else if (key == "PivotCenterY") row.pivotCenterY = val;
-            else if (key == "PivotCenterZ") row.pivotCenterZ = val;
-            else if (key == "FlipYZ") row.flipYZ = val;
-            else if (key == "Trim") row.trim = val;
-            else if (key == "Collision") row.collision = val;
-            else if (key == "VisualLOD") row.visualLOD = val;
+namespace {
+
+enum Target { kMachine, kMsgTime, kSetting, kExitCode };
+
+// Table order is the order matches are applied within one line
+constexpr extract::Rule kRules[] = {
+    {"\"MachineName\"",         extract::Shape::Quoted,   kMachine},
+    {"\"MsgTime\"",             extract::Shape::Quoted,   kMsgTime},
+    {"SLDEFAULT=>",             extract::Shape::KeyValue, kSetting},
+    {"Finished with exit code", extract::Shape::ParenInt, kExitCode},
+};
+
+// A last-wins field of any value type
+using Field = std::variant<std::string PhotoMeshRow::*, Sym PhotoMeshRow::*, Count PhotoMeshRow::*, Real PhotoMeshRow::*,
+                           Tri PhotoMeshRow::*, Label<ExportType> PhotoMeshRow::*,
+                           Label<Resolution> PhotoMeshRow::*, Label<TileScheme> PhotoMeshRow::*>;
+
+struct Setting {
+    std::string_view key;
+    Field field;
+    bool sizeToGB = false;  // "<number> B|KB|MB|GB" into a Real field
+};
+
+// SLDEFAULT=> <key> : <value>
+const Setting kSettings[] = {
+    {"ExportType", &PhotoMeshRow::exportType},
+    {"Resolution", &PhotoMeshRow::resolution},
+    {"TileScheme", &PhotoMeshRow::tileScheme},
+    {"PhotosUsed", &PhotoMeshRow::photosUsed},
+    {"PhotoFolders", &PhotoMeshRow::photoFolders},
+    {"PhotoCoverage", &PhotoMeshRow::photoCoverage},
+    {"FusersUsed", &PhotoMeshRow::fusersUsed},
+    {"CPUThreads", &PhotoMeshRow::cpuThreads},
+    {"GPUCount", &PhotoMeshRow::gpuCount},
+    {"OutputFolder", &PhotoMeshRow::outputFolder},
+    {"TotalFiles", &PhotoMeshRow::totalFiles},
+    {"TotalSize", &PhotoMeshRow::totalSizeGB, true},
+    {"Offset_CoordSys", &PhotoMeshRow::offsetCoordSys},
+    {"Offset_HDatum", &PhotoMeshRow::offsetHDatum},
+    {"Offset_VDatum", &PhotoMeshRow::offsetVDatum},
+    {"OffsetX", &PhotoMeshRow::offsetX},
+    {"OffsetY", &PhotoMeshRow::offsetY},
+    {"OffsetZ", &PhotoMeshRow::offsetZ},
+    {"PivotCenterX", &PhotoMeshRow::pivotCenterX},
+    {"PivotCenterY", &PhotoMeshRow::pivotCenterY},
+    {"PivotCenterZ", &PhotoMeshRow::pivotCenterZ},
+    {"FlipYZ", &PhotoMeshRow::flipYZ},
+    {"Trim", &PhotoMeshRow::trim},
+    {"Collision", &PhotoMeshRow::collision},
+    {"VisualLOD", &PhotoMeshRow::visualLOD},
+};
+
+// Any of these near the start of a log marks it as PhotoMesh
+constexpr std::string_view kMarkers[] = {"SLDEFAULT=>", "\"MachineName\"", "\"MsgTime\""};
+
+// Counted per line over whole blocks by the SIMD scan kernel
+constexpr std::string_view kCountedMarkers[] = {"Warning", "Error"};
+static_assert(std::size(kCountedMarkers) <= util::kMaxScanKeywords);
+
+const extract::Matcher &matcher() {
+    static const extract::Matcher m = [] {
+        std::vector<std::string_view> keys;
+        for (const auto &s : kSettings) keys.push_back(s.key);
+        return extract::Matcher(kRules, keys);
+    }();
+    return m;
+}
+
+// Last-wins fields, one bit each in PhotoMeshState::assigned: the settings
+// table first, then the two fields set outside it
+constexpr size_t kMachineBit = std::size(kSettings);
+constexpr size_t kSuccessBit = kMachineBit + 1;
+static_assert(kSuccessBit < 64);
+
+Field assignable(size_t bit) {
+    if (bit == kMachineBit) return &PhotoMeshRow::machine;
+    if (bit == kSuccessBit) return &PhotoMeshRow::success;
+    return kSettings[bit].field;
+}
+
+} // namespace
+
+void PhotoMeshState::feed(std::string_view lines) {
+    const auto counts = util::count_lines(lines, kCountedMarkers);
+    warnings += static_cast<int>(counts.hits[0]);
+    errors += static_cast<int>(counts.hits[1]);
+
+    const auto &m = matcher();
+    extract::Match hits[extract::kMaxRules];
+    std::string_view line;
+    while (util::next_line(lines, line)) {
+        const size_t n = m.scan(line, hits);
+        for (size_t i=0;i<n;++i) {
+            const auto &h = hits[i];
+            switch (h.id) {
+            case kMachine:
+                // Every message names the machine; intern only when it changes
+                if (util::strings().view(row.machine) != h.cap[0]) row.machine = util::strings().intern(h.cap[0]);
+                assigned |= 1ull << kMachineBit;
+                break;
+            case kMsgTime:
+                if (const auto t = times(h.cap[0])) {
+                    if (!row.startTime) row.startTime = t;
+                    row.endTime = t;
+                }
+                break;
+            case kSetting:
+                if (h.key >= 0) {
+                    const auto &s = kSettings[h.key];
+                    if (s.sizeToGB) row.*std::get<Real PhotoMeshRow::*>(s.field) = util::size_in_gb(h.cap[1]);
+                    else std::visit([&](auto f) { from_text(h.cap[1], row.*f); }, s.field);
+                    assigned |= 1ull << h.key;
+                }
+                break;
+            case kExitCode:
+                row.success = h.cap[0]=="0" ? Tri::True : Tri::False;
+                assigned |= 1ull << kSuccessBit;
+                break;
+            }
         }
-        if (line.find("Warning") != std::string::npos) warn++;
-        if (line.find("Error") != std::string::npos) err++;
-        if (std::regex_search(line,m,exitR)) row.success = (m[1]=="0")?"True":"False";
     }
-    if (row.success.empty()) row.success = err==0 ? "True" : "False";
-    row.warnings = warn?std::to_string(warn):"";
-    row.errors = err?std::to_string(err):"";
-    row.duration = util::compute_duration(row.startTime,row.endTime);
+}
+
+void PhotoMeshState::merge(const PhotoMeshState &later) {
+    for (auto bits = later.assigned; bits; bits &= bits - 1) {
+        std::visit([&](auto f) { row.*f = later.row.*f; }, assignable(std::countr_zero(bits)));
+    }
+    assigned |= later.assigned;
+    if (!row.startTime) row.startTime = later.row.startTime;
+    if (later.row.endTime) row.endTime = later.row.endTime;
+    warnings += later.warnings;
+    errors += later.errors;
+}
+
+PhotoMeshRow PhotoMeshState::finish(const std::string &path) const {
+    PhotoMeshRow out = row;
+    out.logPath = path;
+    out.projectName = util::log_stem(path);
+    if (out.success == Tri::Missing) out.success = errors==0 ? Tri::True : Tri::False;
+    out.warnings = warnings;
+    out.errors = errors;
+    if (out.startTime && out.endTime)
+        out.duration = std::chrono::duration_cast<std::chrono::seconds>(*out.endTime - *out.startTime);
+    return out;
+}
+
+void PhotoMeshState::save(util::StateWriter &w) const {
+    w.u64(assigned);
+    w.u64(static_cast<std::uint64_t>(warnings));
+    w.u64(static_cast<std::uint64_t>(errors));
+    save_value(w, row.startTime);
+    save_value(w, row.endTime);
+    for (auto bits = assigned; bits; bits &= bits - 1)
+        std::visit([&](auto f) { save_value(w, row.*f); }, assignable(std::countr_zero(bits)));
+}
+
+bool PhotoMeshState::load(util::StateReader &r) {
+    assigned = r.u64();
+    warnings = static_cast<int>(r.u64());
+    errors = static_cast<int>(r.u64());
+    load_value(r, row.startTime);
+    load_value(r, row.endTime);
+    if (assigned >> (kSuccessBit + 1)) return false;
+    for (auto bits = assigned; bits; bits &= bits - 1)
+        std::visit([&](auto f) { load_value(r, row.*f); }, assignable(std::countr_zero(bits)));
+    return r.ok();
+}
+
+const LogFormat &photomesh_format() {
+    static const LogFormat f{LogKind::PhotoMesh, "PhotoMesh", kMarkers};
+    return f;
+}
+
+namespace {
+
+PhotoMeshRow unreadable(const std::string &path) {
+    PhotoMeshRow row;
+    row.logPath = path;
+    row.projectName = util::log_stem(path);
     return row;
 }
 
+} // namespace
+
+PhotoMeshRow parse_photomesh(const std::string &path, const ParseOptions &opt, TailEntry *resume) {
+    if (auto s = parse_log<PhotoMeshState>(path, opt, resume)) return s->finish(path);
+    return unreadable(path);
+}
+
+PhotoMeshRow parse_photomesh(OpenLog &log, const std::string &path, const ParseOptions &opt, TailEntry *resume) {
+    if (auto s = parse_open<PhotoMeshState>(log, opt, resume)) return s->finish(path);
+    return unreadable(path);
+}
@@ -1,5 +1,34 @@
 #pragma once
+#include "chunked_parse.hpp"
+#include "log_format.hpp"
 #include "models.hpp"
+#include <cstdint>
+#include <string_view>
 
-PhotoMeshRow parse_photomesh(const std::string &path);
+// Parser state over a contiguous run of lines. The state of two adjacent runs
+// is earlier.merge(later); finish() turns the state of a whole log into a row.
+struct PhotoMeshState {
+    PhotoMeshRow row;            // last-wins fields and first/last MsgTime of the run
+    std::uint64_t assigned = 0;  // bit per last-wins field written in this run
+    int warnings = 0;
+    int errors = 0;
+    util::TimeParser times;      // not saved: only caches the MsgTime layout
 
+    void feed(std::string_view lines);   // one or more whole lines
+    void merge(const PhotoMeshState &later);
+    PhotoMeshRow finish(const std::string &path) const;
+
+    void save(util::StateWriter &w) const;
+    bool load(util::StateReader &r);
+};
+
+// With `resume`, parsing starts from the saved state when it still applies
+// and `resume` is updated for the next run (see parse_log).
+PhotoMeshRow parse_photomesh(const std::string &path, const ParseOptions &opt = {},
+                             TailEntry *resume = nullptr);
+
+// Same, for a log the caller already opened (e.g. to classify it)
+PhotoMeshRow parse_photomesh(OpenLog &log, const std::string &path, const ParseOptions &opt, TailEntry *resume);
+
+// Registry entry: name and sniffing markers
+const LogFormat &photomesh_format();
@@ -1,42 +1,153 @@
 #include "realitymesh_parser.hpp"
+#include "archive_reader.hpp"
+#include "extract_rules.hpp"
+#include "line_reader.hpp"
 #include "util_time.hpp"
-#include <fstream>
-#include <regex>
-#include <filesystem>
+#include <charconv>
 
-RealityMeshRow parse_realitymesh(const std::string &path) {
-    RealityMeshRow row;
-    row.logPath = path;
-    row.projectName = std::filesystem::path(path).stem().string();
-    std::ifstream in(path);
-    if (!in) return row;
-    std::string line;
-    std::regex dataset(R"delim(-command_file\s+"([^"]+)")delim");
-    std::regex exitR(R"(Process completed with exit code:\s*(\d+))");
-    std::regex runR(R"(Time to run TT project:\s*([0-9]+)\s*seconds)");
-    std::regex inputOffset(R"(Input offset:\s*([\-0-9\.]+)\s+([\-0-9\.]+)\s+([\-0-9\.]+))");
-    std::regex convOffset(R"(Converted offset:\s*([\-0-9\.]+)\s+([\-0-9\.]+)\s+([\-0-9\.]+))");
-    int errCount=0;
-    while (std::getline(in,line)) {
-        std::smatch m;
-        if (std::regex_search(line,m,dataset)) row.datasetName = m[1];
-        if (std::regex_search(line,m,inputOffset)) {
-            row.offsetX = m[1]; row.offsetY = m[2]; row.offsetZ = m[3];
-        }
-        if (std::regex_search(line,m,convOffset)) {
-            row.offsetX = m[1]; row.offsetY = m[2]; row.offsetZ = m[3];
-        }
-        if (std::regex_search(line,m,exitR)) row.success = (m[1]=="0")?"True":"False";
-        if (std::regex_search(line,m,runR)) row.duration = util::seconds_to_hhmmss(std::stoi(m[1]));
-        auto pos = line.find("Error:");
-        if (pos != std::string::npos) {
-            errCount++;
-            if (!row.errors.empty()) row.errors += ";";
-            row.errors += util::trim(line.substr(pos+6));
+namespace {
+
+enum Target { kDataset, kInputOffset, kConvertedOffset, kExitCode, kRunTime, kError };
+
+// Table order is the order matches are applied within one line
+constexpr extract::Rule kRules[] = {
+    {"-command_file",                      extract::Shape::SpacedQuoted, kDataset},
+    {"Input offset:",                      extract::Shape::Triple,       kInputOffset},
+    {"Converted offset:",                  extract::Shape::Triple,       kConvertedOffset},
+    {"Process completed with exit code:",  extract::Shape::Int,          kExitCode},
+    {"Time to run TT project:",            extract::Shape::Seconds,      kRunTime},
+    {"Error:",                             extract::Shape::Rest,         kError},
+};
+
+// Any of these near the start of a log marks it as RealityMesh
+constexpr std::string_view kMarkers[] = {"Time to run TT project:", "-command_file",
+                                         "Process completed with exit code:", "Converted offset:"};
+
+const extract::Matcher &matcher() {
+    static const extract::Matcher m(kRules);
+    return m;
+}
+
+enum Assigned : std::uint32_t { kDatasetBit = 1, kOffsetBit = 2, kSuccessBit = 4, kDurationBit = 8 };
+
+} // namespace
+
+void RealityMeshState::feed(std::string_view lines) {
+    const auto &m = matcher();
+    extract::Match hits[extract::kMaxRules];
+    std::string_view line;
+    while (util::next_line(lines, line)) {
+        const size_t n = m.scan(line, hits);
+        for (size_t i=0;i<n;++i) {
+            const auto &h = hits[i];
+            switch (h.id) {
+            case kDataset:
+                row.datasetName = h.cap[0];
+                assigned |= kDatasetBit;
+                break;
+            case kInputOffset:
+            case kConvertedOffset:
+                from_text(h.cap[0], row.offsetX); from_text(h.cap[1], row.offsetY); from_text(h.cap[2], row.offsetZ);
+                assigned |= kOffsetBit;
+                break;
+            case kExitCode:
+                row.success = h.cap[0]=="0" ? Tri::True : Tri::False;
+                assigned |= kSuccessBit;
+                break;
+            case kRunTime: {
+                std::int64_t secs = 0;
+                const auto r = std::from_chars(h.cap[0].data(), h.cap[0].data() + h.cap[0].size(), secs);
+                if (r.ec != std::errc()) break;  // out of range
+                row.duration = std::chrono::seconds(secs);
+                assigned |= kDurationBit;
+                break;
+            }
+            case kError:
+                errorCount++;
+                if (!row.errors.empty()) row.errors += ";";
+                else if (h.cap[0].empty()) emptyLeadingErrors++;
+                row.errors += h.cap[0];
+                break;
+            }
         }
     }
-    if (row.success.empty()) row.success = errCount==0 ? "True":"False";
-    if (row.errors.empty() && errCount) row.errors = std::to_string(errCount);
+}
+
+void RealityMeshState::merge(const RealityMeshState &later) {
+    const auto &r = later.row;
+    if (later.assigned & kDatasetBit) row.datasetName = r.datasetName;
+    if (later.assigned & kOffsetBit) { row.offsetX = r.offsetX; row.offsetY = r.offsetY; row.offsetZ = r.offsetZ; }
+    if (later.assigned & kSuccessBit) row.success = r.success;
+    if (later.assigned & kDurationBit) row.duration = r.duration;
+    assigned |= later.assigned;
+
+    // Sequentially, every error after a non-empty list adds a ';' -- including
+    // the empty ones `later` swallowed while its own list was still empty
+    if (row.errors.empty()) {
+        row.errors = r.errors;
+        emptyLeadingErrors += later.emptyLeadingErrors;
+    } else {
+        row.errors.append(later.emptyLeadingErrors, ';');
+        if (!r.errors.empty()) { row.errors += ";"; row.errors += r.errors; }
+    }
+    errorCount += later.errorCount;
+}
+
+RealityMeshRow RealityMeshState::finish(const std::string &path) const {
+    RealityMeshRow out = row;
+    out.logPath = path;
+    out.projectName = util::log_stem(path);
+    if (out.success == Tri::Missing) out.success = errorCount==0 ? Tri::True : Tri::False;
+    out.errorCount = errorCount;
+    return out;
+}
+
+void RealityMeshState::save(util::StateWriter &w) const {
+    w.u64(assigned);
+    w.u64(static_cast<std::uint64_t>(errorCount));
+    w.u64(static_cast<std::uint64_t>(emptyLeadingErrors));
+    save_value(w, row.datasetName);
+    for (const auto *f : {&row.offsetX, &row.offsetY, &row.offsetZ}) save_value(w, *f);
+    save_value(w, row.success);
+    save_value(w, row.duration);
+    save_value(w, row.errors);
+}
+
+bool RealityMeshState::load(util::StateReader &r) {
+    assigned = static_cast<std::uint32_t>(r.u64());
+    errorCount = static_cast<int>(r.u64());
+    emptyLeadingErrors = static_cast<int>(r.u64());
+    load_value(r, row.datasetName);
+    for (auto *f : {&row.offsetX, &row.offsetY, &row.offsetZ}) load_value(r, *f);
+    load_value(r, row.success);
+    load_value(r, row.duration);
+    load_value(r, row.errors);
+    return r.ok();
+}
+
+const LogFormat &realitymesh_format() {
+    static const LogFormat f{LogKind::RealityMesh, "RealityMesh", kMarkers};
+    return f;
+}
+
+namespace {
+
+RealityMeshRow unreadable(const std::string &path) {
+    RealityMeshRow row;
+    row.logPath = path;
+    row.projectName = util::log_stem(path);
     return row;
 }
 
+} // namespace
+
+RealityMeshRow parse_realitymesh(const std::string &path, const ParseOptions &opt, TailEntry *resume) {
+    if (auto s = parse_log<RealityMeshState>(path, opt, resume)) return s->finish(path);
+    return unreadable(path);
+}
+
+RealityMeshRow parse_realitymesh(OpenLog &log, const std::string &path, const ParseOptions &opt,
+                                 TailEntry *resume) {
+    if (auto s = parse_open<RealityMeshState>(log, opt, resume)) return s->finish(path);
+    return unreadable(path);
+}
@@ -1,5 +1,33 @@
 #pragma once
+#include "chunked_parse.hpp"
+#include "log_format.hpp"
 #include "models.hpp"
+#include <cstdint>
+#include <string_view>
 
-RealityMeshRow parse_realitymesh(const std::string &path);
+// Parser state over a contiguous run of lines. The state of two adjacent runs
+// is earlier.merge(later); finish() turns the state of a whole log into a row.
+struct RealityMeshState {
+    RealityMeshRow row;          // last-wins fields; errors joined with ';'
+    std::uint32_t assigned = 0;  // bit per last-wins field written in this run
+    int errorCount = 0;
+    int emptyLeadingErrors = 0;  // "Error:" lines with no text while row.errors was still empty
 
+    void feed(std::string_view lines);   // one or more whole lines
+    void merge(const RealityMeshState &later);
+    RealityMeshRow finish(const std::string &path) const;
+
+    void save(util::StateWriter &w) const;
+    bool load(util::StateReader &r);
+};
+
+// With `resume`, parsing starts from the saved state when it still applies
+// and `resume` is updated for the next run (see parse_log).
+RealityMeshRow parse_realitymesh(const std::string &path, const ParseOptions &opt = {},
+                                 TailEntry *resume = nullptr);
+
+// Same, for a log the caller already opened (e.g. to classify it)
+RealityMeshRow parse_realitymesh(OpenLog &log, const std::string &path, const ParseOptions &opt, TailEntry *resume);
+
+// Registry entry: name and sniffing markers
+const LogFormat &realitymesh_format();
@@ -0,0 +1,200 @@
+#include "scan_kernel.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LTE_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LTE_TARGET_SSE2
+#define LTE_TARGET_AVX2
+#else
+#define LTE_TARGET_SSE2 __attribute__((target("sse2")))
+#define LTE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace util {
+
+namespace {
+
+// Per-line bookkeeping shared by every kernel: events (newlines and keyword
+// candidates) must be delivered in buffer order.
+struct Counter {
+    std::string_view buf;
+    std::span<const std::string_view> kw;
+    LineCounts out{};
+    std::uint32_t seen = 0;       // keywords already counted on the current line
+    std::size_t lineStart = 0;
+
+    void newline(std::size_t pos) {
+        ++out.lines;
+        seen = 0;
+        lineStart = pos + 1;
+    }
+    void candidate(std::size_t pos, std::uint32_t which) {
+        for (which &= ~seen; which; which &= which - 1) {
+            const int k = std::countr_zero(which);
+            if (buf.substr(pos, kw[k].size()) == kw[k]) {
+                ++out.hits[k];
+                seen |= 1u << k;
+            }
+        }
+    }
+    void scalar_from(std::size_t i, const std::uint32_t *first) {
+        for (; i < buf.size(); ++i) {
+            const unsigned char c = static_cast<unsigned char>(buf[i]);
+            if (c == '\n') newline(i);
+            else if (first[c]) candidate(i, first[c]);
+        }
+    }
+    LineCounts finish() {
+        if (lineStart < buf.size()) ++out.lines;  // last line without '\n'
+        return out;
+    }
+};
+
+void first_bytes(std::span<const std::string_view> kw, std::uint32_t *first) {
+    for (int c = 0; c < 256; ++c) first[c] = 0;
+    for (std::size_t k = 0; k < kw.size(); ++k)
+        first[static_cast<unsigned char>(kw[k][0])] |= 1u << k;
+}
+
+LineCounts count_scalar(std::string_view buf, std::span<const std::string_view> kw) {
+    std::uint32_t first[256];
+    first_bytes(kw, first);
+    Counter c{buf, kw};
+    c.scalar_from(0, first);
+    return c.finish();
+}
+
+#ifdef LTE_SCAN_X86
+
+// Candidates need the first two keyword bytes to match, which filters out
+// almost every stray 'E' or 'W' before the exact compare.
+LTE_TARGET_SSE2 LineCounts count_sse2(std::string_view buf, std::span<const std::string_view> kw) {
+    std::uint32_t first[256];
+    first_bytes(kw, first);
+    Counter c{buf, kw};
+    const std::size_t nk = kw.size();
+    __m128i c0[kMaxScanKeywords], c1[kMaxScanKeywords];
+    for (std::size_t k = 0; k < nk; ++k) {
+        c0[k] = _mm_set1_epi8(kw[k][0]);
+        c1[k] = _mm_set1_epi8(kw[k].size() > 1 ? kw[k][1] : kw[k][0]);
+    }
+    const __m128i nlv = _mm_set1_epi8('\n');
+    const char *p = buf.data();
+    std::size_t i = 0;
+    for (; i + 17 <= buf.size(); i += 16) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 1));
+        const std::uint32_t nl = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v0, nlv)));
+        std::uint32_t cand[kMaxScanKeywords], any = 0;
+        for (std::size_t k = 0; k < nk; ++k) {
+            const __m128i second = kw[k].size() > 1 ? _mm_cmpeq_epi8(v1, c1[k]) : _mm_cmpeq_epi8(v0, c0[k]);
+            cand[k] = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, c0[k]), second)));
+            any |= cand[k];
+        }
+        for (std::uint32_t ev = nl | any; ev; ev &= ev - 1) {
+            const int b = std::countr_zero(ev);
+            if (nl >> b & 1) { c.newline(i + b); continue; }
+            std::uint32_t which = 0;
+            for (std::size_t k = 0; k < nk; ++k) which |= (cand[k] >> b & 1) << k;
+            c.candidate(i + b, which);
+        }
+    }
+    c.scalar_from(i, first);
+    return c.finish();
+}
+
+LTE_TARGET_AVX2 LineCounts count_avx2(std::string_view buf, std::span<const std::string_view> kw) {
+    std::uint32_t first[256];
+    first_bytes(kw, first);
+    Counter c{buf, kw};
+    const std::size_t nk = kw.size();
+    __m256i c0[kMaxScanKeywords], c1[kMaxScanKeywords];
+    for (std::size_t k = 0; k < nk; ++k) {
+        c0[k] = _mm256_set1_epi8(kw[k][0]);
+        c1[k] = _mm256_set1_epi8(kw[k].size() > 1 ? kw[k][1] : kw[k][0]);
+    }
+    const __m256i nlv = _mm256_set1_epi8('\n');
+    const char *p = buf.data();
+    std::size_t i = 0;
+    for (; i + 33 <= buf.size(); i += 32) {
+        const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + 1));
+        const std::uint32_t nl = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v0, nlv)));
+        std::uint32_t cand[kMaxScanKeywords], any = 0;
+        for (std::size_t k = 0; k < nk; ++k) {
+            const __m256i second = kw[k].size() > 1 ? _mm256_cmpeq_epi8(v1, c1[k]) : _mm256_cmpeq_epi8(v0, c0[k]);
+            cand[k] = static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(v0, c0[k]), second)));
+            any |= cand[k];
+        }
+        for (std::uint32_t ev = nl | any; ev; ev &= ev - 1) {
+            const int b = std::countr_zero(ev);
+            if (nl >> b & 1) { c.newline(i + b); continue; }
+            std::uint32_t which = 0;
+            for (std::size_t k = 0; k < nk; ++k) which |= (cand[k] >> b & 1) << k;
+            c.candidate(i + b, which);
+        }
+    }
+    c.scalar_from(i, first);
+    return c.finish();
+}
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // LTE_SCAN_X86
+
+} // namespace
+
+ScanIsa scan_isa() {
+#ifdef LTE_SCAN_X86
+    static const ScanIsa isa = cpu_has_avx2() ? ScanIsa::AVX2 : ScanIsa::SSE2;
+    return isa;
+#else
+    return ScanIsa::Scalar;
+#endif
+}
+
+const char *scan_isa_name(ScanIsa isa) {
+    switch (isa) {
+    case ScanIsa::AVX2: return "avx2";
+    case ScanIsa::SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+LineCounts count_lines(std::string_view buf, std::span<const std::string_view> keywords) {
+    return count_lines(buf, keywords, scan_isa());
+}
+
+LineCounts count_lines(std::string_view buf, std::span<const std::string_view> keywords, ScanIsa isa) {
+    if (keywords.size() > kMaxScanKeywords) throw std::invalid_argument("count_lines: too many keywords");
+#ifdef LTE_SCAN_X86
+    if (isa == ScanIsa::AVX2 && scan_isa() == ScanIsa::AVX2) return count_avx2(buf, keywords);
+    if (isa != ScanIsa::Scalar) return count_sse2(buf, keywords);
+#else
+    (void)isa;
+#endif
+    return count_scalar(buf, keywords);
+}
+
+} // namespace util
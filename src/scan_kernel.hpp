@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace util {
+
+constexpr std::size_t kMaxScanKeywords = 8;
+
+struct LineCounts {
+    std::size_t lines = 0;                                // same count next_line() yields
+    std::array<std::size_t, kMaxScanKeywords> hits{};     // lines containing keyword[i]
+};
+
+enum class ScanIsa { Scalar, SSE2, AVX2 };
+
+// Best instruction set count_lines() can use on this CPU (checked once)
+ScanIsa scan_isa();
+const char *scan_isa_name(ScanIsa isa);
+
+// One pass over buf: counts lines and, per keyword, the lines containing it.
+// Keywords must be non-empty and must not contain '\n'; throws
+// std::invalid_argument for more than kMaxScanKeywords. Dispatches at runtime
+// to AVX2 or SSE2 on x86, otherwise runs the scalar loop.
+LineCounts count_lines(std::string_view buf, std::span<const std::string_view> keywords);
+
+// Same, forced to a given instruction set (falls back if unavailable)
+LineCounts count_lines(std::string_view buf, std::span<const std::string_view> keywords, ScanIsa isa);
+
+} // namespace util
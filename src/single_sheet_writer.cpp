@@ -1,127 +1,68 @@
 #include "single_sheet_writer.hpp"
+#include "cell_writer.hpp"
+#include "column_store.hpp"
+#include "columns.hpp"
+#include "external_sort.hpp"
+#include "file_lock.hpp"
+#include "line_reader.hpp"
+#include "logpath_index.hpp"
+#include "native_xlsx.hpp"
+#include "parse_state.hpp"
+#include "tsv_reader.hpp"
 #include "util_time.hpp"
 #include <xlsxwriter.h>
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <optional>
-#include <sstream>
+#include <random>
+#include <set>
+#include <span>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 namespace fs = std::filesystem;
 
-namespace {
-
-inline std::string now_utc() {
-  using namespace std::chrono;
-  auto t = system_clock::to_time_t(system_clock::now());
-  std::tm tm{};
-#ifdef _WIN32
-  gmtime_s(&tm, &t);
-#else
-  gmtime_r(&t, &tm);
-#endif
-  char buf[20]; // YYYY-MM-DD HH:MM:SS
-  std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
-                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-                tm.tm_hour, tm.tm_min, tm.tm_sec);
-  return std::string(buf);
-}
-
-// Order of columns in the single sheet
-static const std::vector<std::string> kHeaders = {
- "ProjectName","Tool","DatasetName","BuildID",
- "StartTime","EndTime","Duration(hh:mm:ss)","RunDate",
- "ProcessPreset","ExportType","SelAreaSize(km²)","Resolution","TileScheme",
- "PhotosUsed","PhotoFolders","PhotoCoverage(km²)","FusersUsed","CPUThreads","GPUCount",
- "Machine","HostIP","User",
- "OutputFolder","TotalFiles","TotalSize(GB)",
- "Offset_CoordSys","Offset_HDatum","Offset_VDatum",
- "OffsetX","OffsetY","OffsetZ",
- "PivotCenterX","PivotCenterY","PivotCenterZ",
- "FlipYZ","Trim","Collision","VisualLOD",
- "Success","Warnings","Errors","LogPath","IngestedAt"
-};
+namespace excel {
 
-inline std::string to_tsv(const std::vector<std::string>& cells) {
-  std::ostringstream os;
-  for (size_t i=0;i<cells.size();++i) {
-    // Use tab-separated with basic sanitization (no tabs/newlines)
-    std::string v = cells[i];
-    for (char& c : v) if (c=='\t' || c=='\r' || c=='\n') c = ' ';
-    os << v;
-    if (i+1<cells.size()) os << '\t';
-  }
-  return os.str();
+const std::string& UnifiedRow::none() {
+  static const std::string empty;
+  return empty;
 }
 
-inline std::vector<std::string> split_tsv(const std::string& line) {
-  std::vector<std::string> out;
-  std::string cur;
-  for (char c : line) {
-    if (c=='\t') { out.push_back(cur); cur.clear(); }
-    else if (c!='\r' && c!='\n') cur.push_back(c);
-  }
-  out.push_back(cur);
-  return out;
+const std::string& UnifiedRow::ProjectName() const {
+  if (pm_) return pm_->projectName;
+  return rm_->projectName.empty() ? rm_->datasetName : rm_->projectName;
 }
 
-} // namespace
-
-namespace excel {
-
 std::vector<UnifiedRow> unify(const std::vector<PhotoMeshRow>& pm,
-                              const std::vector<RealityMeshRow>& rm) {
+                              const std::vector<RealityMeshRow>& rm,
+                              const std::vector<size_t>& pmSkip,
+                              const std::vector<size_t>& rmSkip) {
   std::vector<UnifiedRow> out;
-  const std::string ingested = now_utc();
-
-  for (const auto& r : pm) {
-    UnifiedRow u{};
-    u.ProjectName = r.projectName;
-    u.Tool = "PhotoMesh";
-    u.DatasetName = "";
-    u.BuildID = r.buildID;
-    u.StartTime = r.startTime; u.EndTime = r.endTime; u.Duration = r.duration;
-    u.RunDate = util::extract_date(r.startTime.empty()? r.endTime : r.startTime);
-    u.ProcessPreset = "";
-    u.ExportType = r.exportType; u.SelAreaSize = ""; u.Resolution = r.resolution; u.TileScheme = r.tileScheme;
-    u.PhotosUsed = r.photosUsed; u.PhotoFolders = r.photoFolders; u.PhotoCoverage = r.photoCoverage;
-    u.FusersUsed = r.fusersUsed; u.CPUThreads = r.cpuThreads; u.GPUCount = r.gpuCount;
-    u.Machine = r.machine; u.HostIP = r.hostIP; u.User = r.user;
-    u.OutputFolder = r.outputFolder; u.TotalFiles = r.totalFiles; u.TotalSizeGB = r.totalSizeGB;
-    u.Offset_CoordSys = r.offsetCoordSys; u.Offset_HDatum = r.offsetHDatum; u.Offset_VDatum = r.offsetVDatum;
-    u.OffsetX = r.offsetX; u.OffsetY = r.offsetY; u.OffsetZ = r.offsetZ;
-    u.PivotCenterX = r.pivotCenterX; u.PivotCenterY = r.pivotCenterY; u.PivotCenterZ = r.pivotCenterZ;
-    u.FlipYZ = r.flipYZ; u.Trim = r.trim; u.Collision = r.collision; u.VisualLOD = r.visualLOD;
-    u.Success = r.success; u.Warnings = r.warnings; u.Errors = r.errors; u.LogPath = r.logPath;
-    u.IngestedAt = ingested;
-    out.push_back(std::move(u));
-  }
-  for (const auto& r : rm) {
-    UnifiedRow u{};
-    u.ProjectName = r.projectName.empty()? r.datasetName : r.projectName;
-    u.Tool = "RealityMesh";
-    u.DatasetName = r.datasetName; u.BuildID = "";
-    u.StartTime = r.startTime; u.EndTime = r.endTime; u.Duration = r.duration;
-    u.RunDate = util::extract_date(r.startTime.empty()? r.endTime : r.startTime);
-    u.ProcessPreset = r.processPreset; u.ExportType = r.exportType;
-    u.SelAreaSize = r.selAreaSize; u.Resolution = r.resolution; u.TileScheme = r.tileScheme;
-    u.PhotosUsed = ""; u.PhotoFolders = ""; u.PhotoCoverage = "";
-    u.FusersUsed = ""; u.CPUThreads = ""; u.GPUCount = "";
-    u.Machine = r.machine; u.HostIP = r.hostIP; u.User = r.user;
-    u.OutputFolder = r.outputFolder; u.TotalFiles = r.totalFiles; u.TotalSizeGB = r.totalSizeGB;
-    u.Offset_CoordSys = r.offsetCoordSys; u.Offset_HDatum = r.offsetHDatum; u.Offset_VDatum = r.offsetVDatum;
-    u.OffsetX = r.offsetX; u.OffsetY = r.offsetY; u.OffsetZ = r.offsetZ;
-    u.PivotCenterX = r.pivotCenterX; u.PivotCenterY = r.pivotCenterY; u.PivotCenterZ = r.pivotCenterZ;
-    u.FlipYZ = r.flipYZ; u.Trim = r.trim; u.Collision = r.collision; u.VisualLOD = r.visualLOD;
-    u.Success = r.success; u.Warnings = r.warnings; u.Errors = r.errors; u.LogPath = r.logPath;
-    u.IngestedAt = ingested;
-    out.push_back(std::move(u));
-  }
+  out.reserve(pm.size() + rm.size() - pmSkip.size() - rmSkip.size());
+  const Instant ingested = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+
+  auto add = [&](const auto& rows, const std::vector<size_t>& skip) {
+    size_t next = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (next < skip.size() && skip[next] == i) { ++next; continue; }
+      out.emplace_back(rows[i], ingested);
+    }
+  };
+  add(pm, pmSkip);
+  add(rm, rmSkip);
   return out;
 }
 
@@ -130,116 +71,789 @@ static void ensure_dir(const std::string& d) {
   fs::create_directories(fs::path(d), ec);
 }
 
-static std::string tsv_line_from_unified(const UnifiedRow& u) {
-  std::vector<std::string> cells = {
-    u.ProjectName,u.Tool,u.DatasetName,u.BuildID,
-    u.StartTime,u.EndTime,u.Duration,u.RunDate,
-    u.ProcessPreset,u.ExportType,u.SelAreaSize,u.Resolution,u.TileScheme,
-    u.PhotosUsed,u.PhotoFolders,u.PhotoCoverage,u.FusersUsed,u.CPUThreads,u.GPUCount,
-    u.Machine,u.HostIP,u.User,
-    u.OutputFolder,u.TotalFiles,u.TotalSizeGB,
-    u.Offset_CoordSys,u.Offset_HDatum,u.Offset_VDatum,
-    u.OffsetX,u.OffsetY,u.OffsetZ,
-    u.PivotCenterX,u.PivotCenterY,u.PivotCenterZ,
-    u.FlipYZ,u.Trim,u.Collision,u.VisualLOD,
-    u.Success,u.Warnings,u.Errors,u.LogPath,u.IngestedAt
-  };
-  return to_tsv(cells);
-}
+// Appends the master lines in `lines` whose LogPath is neither in the master
+// nor earlier in `lines`. False if the TSV could not take them; it is cut
+// back to its old size then, so a replay appends them whole.
+static bool append_unique_to_tsv(const std::string& tsv_path,
+                                 std::string_view lines,
+                                 ColumnStore* store) {
+  static constexpr size_t kLogPath = column_index(kMasterColumns, "LogPath");
 
-static void append_unique_to_tsv(const std::string& tsv_path,
-                                 const std::vector<UnifiedRow>& rows) {
-  std::unordered_set<std::string> seen;
+  // LogPaths already in the master, from the index beside it; only a stale
+  // or missing index makes this read the whole TSV
+  LogPathIndex seen(tsv_path);
   bool exists = fs::exists(tsv_path);
 
-  // Build 'seen' from existing TSV by LogPath column
-  if (exists) {
-    std::ifstream in(tsv_path, std::ios::binary);
-    std::string line;
-    if (std::getline(in, line)) {
-      auto hdr = split_tsv(line);
-      int idx = -1;
-      for (size_t i=0;i<hdr.size();++i) if (hdr[i] == "LogPath") { idx = (int)i; break; }
-      if (idx >= 0) {
-        while (std::getline(in, line)) {
-          if (line.empty()) continue;
-          auto cols = split_tsv(line);
-          if ((size_t)idx < cols.size()) seen.insert(cols[idx]);
-        }
-      }
-    }
-  }
-
   std::ofstream out(tsv_path, std::ios::app | std::ios::binary);
   out.seekp(0, std::ios::end);
-  if (!exists || out.tellp() == std::streampos(0)) {
-    out << to_tsv(kHeaders) << "\n";
+  const std::uint64_t base = static_cast<std::uint64_t>(out.tellp());
+
+  // Lines are copied into one buffer, written out in large pieces. With a
+  // column store they all stay buffered, since the store takes them first.
+  std::string buf;
+  std::uint64_t flushed = 0;
+  if (!exists || base == 0) {
+    append_tsv_header(buf, kMasterColumns);
   }
+  const size_t firstRow = buf.size();
 
-  for (const auto& u : rows) {
-    if (seen.find(u.LogPath) == seen.end()) {
-      out << tsv_line_from_unified(u) << "\n";
-    }
+  // Lines from several runs can share a LogPath too, so the batch is checked
+  // against itself as well; the index learns the new rows once written
+  std::vector<std::pair<std::string_view, std::uint64_t>> added;
+  std::unordered_set<std::string_view> batch;
+  util::TsvReader reader(lines);
+  const size_t project[] = {kLogPath};
+  reader.project(project);
+  while (reader.next()) {
+    const std::string_view line = reader.line();
+    if (line.empty()) continue;
+    const std::string_view path = reader.fields()[0];
+    if (seen.contains(path) || !batch.insert(path).second) continue;
+    added.emplace_back(path, base + flushed + buf.size());
+    buf.append(line).push_back('\n');
+    if (!store && buf.size() >= (1u << 20)) { out.write(buf.data(), (std::streamsize)buf.size()); flushed += buf.size(); buf.clear(); }
+  }
+  // The store is the record: a store that cannot take the rows is dropped,
+  // and the next run imports the TSV again
+  if (store && !added.empty() &&
+      !store->append(std::string_view(buf).substr(firstRow), base + buf.size())) {
+    store->discard();
   }
+  out.write(buf.data(), (std::streamsize)buf.size());
+  out.close();
+  if (!out) {
+    std::error_code ec;
+    if (fs::exists(tsv_path, ec)) fs::resize_file(tsv_path, base, ec);
+    return false;
+  }
+  for (const auto& [path, offset] : added) seen.add(path, offset);
+  seen.save();
+  return true;
 }
 
-static void rebuild_xlsx_from_tsv(const std::string& tsv_path,
-                                  const std::string& xlsx_path) {
-  std::ifstream in(tsv_path, std::ios::binary);
-  if (!in) return;
+// The column store the master is exported from: the existing one (the TSV is
+// rewritten from it if the two differ), else one imported from the TSV, else
+// a new one. A TSV in another column layout, or one the store could not give
+// back byte for byte, stays the record and gets no store.
+static ColumnStore open_master_store(const std::string& outputs_dir, const std::string& tsv_path) {
+  ColumnStore store(ColumnStore::path_for(outputs_dir));
+  if (store.is_open()) {
+    store.export_tsv(tsv_path);
+    return store;
+  }
+  std::string header;
+  append_tsv_header(header, kMasterColumns);
+  std::vector<std::pair<std::string, CellKind>> columns;
+  for (const auto& c : kMasterColumns) columns.emplace_back(std::string(c.name), c.kind);
 
-  std::vector<std::string> headers;
-  std::vector<std::vector<std::string>> rows;
+  util::MappedFile master(tsv_path);
+  const std::string_view text = master.data();
+  if (!text.empty() && (!text.starts_with(header) || !ColumnStore::importable(text))) return store;
+  if (store.create(columns) && text.size() > header.size() &&
+      !store.append(text.substr(header.size()), text.size()))
+    store.discard();
+  return store;
+}
 
-  std::string line;
-  if (std::getline(in, line)) headers = split_tsv(line);
-  while (std::getline(in, line)) {
-    if (!line.empty()) rows.push_back(split_tsv(line));
+// Data rows of the master: non-empty lines after the header, counted by
+// newlines alone so the rebuild knows its ranges before writing any row
+static size_t count_master_rows(std::string_view text) {
+  util::TsvReader reader(text);
+  reader.project({});
+  size_t rows = 0;
+  bool header = true;
+  while (reader.next()) {
+    if (reader.line().empty()) continue;
+    if (!header) ++rows;
+    header = false;
   }
+  return rows;
+}
 
-  lxw_workbook* wb = workbook_new(xlsx_path.c_str());
-  lxw_worksheet* ws = workbook_add_worksheet(wb, "All_Exports");
-
-  // Write header & rows
-  for (size_t c=0;c<headers.size();++c)
-    worksheet_write_string(ws, 0, (lxw_col_t)c, headers[c].c_str(), nullptr);
-  for (size_t r=0;r<rows.size();++r)
-    for (size_t c=0;c<rows[r].size();++c)
-      worksheet_write_string(ws, (lxw_row_t)(r+1), (lxw_col_t)c, rows[r][c].c_str(), nullptr);
+// Workbooks are written under a temp name and renamed over the old one, so a
+// reader (or a run that dies halfway) never leaves a half-written workbook.
+// False if the old one stays.
+static bool publish_workbook(bool written, const std::string& tmp, const std::string& xlsx_path) {
+  if (written && util::replace_file(tmp, xlsx_path)) return true;
+  std::error_code ec;
+  fs::remove(tmp, ec);
+  return false;
+}
 
-  // Format as table, freeze header, set width
+// The All_Exports sheet of a constant_memory workbook, laid out for nrows
+// data rows (ranges must be set before any row is written), with its header
+static lxw_worksheet* add_master_sheet(lxw_workbook* wb, const std::vector<std::string>& headers, size_t nrows) {
+  lxw_worksheet* ws = workbook_add_worksheet(wb, "All_Exports");
   if (!headers.empty()) {
-    worksheet_add_table(ws, 0, 0, (lxw_row_t)rows.size(), (lxw_col_t)(headers.size()-1), nullptr);
+    worksheet_autofilter(ws, 0, 0, (lxw_row_t)nrows, (lxw_col_t)(headers.size()-1));
     worksheet_freeze_panes(ws, 1, 0);
     worksheet_set_column(ws, 0, (lxw_col_t)(headers.size()-1), 22, nullptr);
   }
 
-  // Conditional format for Success column
+  // Conditional format for Success column (boolean cells)
   int success_col = -1;
   for (size_t i=0;i<headers.size();++i) if (headers[i] == "Success") { success_col = (int)i; break; }
-  if (success_col >= 0) {
+  if (success_col >= 0 && nrows > 0) {
     lxw_format* green = workbook_add_format(wb); format_set_bg_color(green, LXW_COLOR_GREEN);
     lxw_conditional_format cf1{}; cf1.type = LXW_CONDITIONAL_TYPE_CELL; cf1.criteria = LXW_CONDITIONAL_CRITERIA_EQUAL_TO;
-    cf1.value_string = const_cast<char*>("True"); cf1.format = green;
-    worksheet_conditional_format_range(ws, 1, success_col, (lxw_row_t)rows.size(), success_col, &cf1);
+    cf1.value_string = const_cast<char*>("TRUE"); cf1.format = green;
+    worksheet_conditional_format_range(ws, 1, success_col, (lxw_row_t)nrows, success_col, &cf1);
 
     lxw_format* red = workbook_add_format(wb); format_set_bg_color(red, LXW_COLOR_RED);
     lxw_conditional_format cf2{}; cf2.type = LXW_CONDITIONAL_TYPE_CELL; cf2.criteria = LXW_CONDITIONAL_CRITERIA_EQUAL_TO;
-    cf2.value_string = const_cast<char*>("False"); cf2.format = red;
-    worksheet_conditional_format_range(ws, 1, success_col, (lxw_row_t)rows.size(), success_col, &cf2);
+    cf2.value_string = const_cast<char*>("FALSE"); cf2.format = red;
+    worksheet_conditional_format_range(ws, 1, success_col, (lxw_row_t)nrows, success_col, &cf2);
   }
 
-  workbook_close(wb);
+  // Empty cells are skipped elsewhere too: without a format libxlsxwriter
+  // writes nothing for them anyway
+  for (size_t c=0;c<headers.size();++c)
+    worksheet_write_string(ws, 0, (lxw_col_t)c, headers[c].c_str(), nullptr);
+  return ws;
 }
 
-void append_to_master_and_rebuild_xlsx(const std::string& outputs_dir,
-                                       const std::vector<UnifiedRow>& new_rows) {
-  ensure_dir(outputs_dir);
+// ---------------- sorted master ----------------
+
+bool parse_master_sort(const std::string& spec, MasterSort& out) {
+  out.keys.clear();
+  for (size_t from = 0; from < spec.size();) {
+    size_t comma = spec.find(',', from);
+    if (comma == std::string::npos) comma = spec.size();
+    std::string_view name(spec.data() + from, comma - from);
+    from = comma + 1;
+    if (name.empty()) continue;
+    MasterSort::Key key;
+    if (name.front() == '-') { key.descending = true; name.remove_prefix(1); }
+    key.column = std::string(name);
+    if (std::none_of(kMasterColumns.begin(), kMasterColumns.end(),
+                     [&](const auto& c) { return c.name == name; }))
+      return false;
+    out.keys.push_back(std::move(key));
+  }
+  return true;
+}
+
+struct SortColumn {
+  size_t column;     // in the sheet being sorted
+  CellKind kind;
+  bool descending;
+};
+
+// The sort keys found among `headers`; keys naming absent columns are dropped
+static std::vector<SortColumn> sort_columns(const MasterSort& sort, const std::vector<std::string>& headers) {
+  std::vector<SortColumn> out;
+  for (const auto& k : sort.keys) {
+    const auto at = std::find(headers.begin(), headers.end(), k.column);
+    if (at == headers.end()) continue;
+    out.push_back({(size_t)(at - headers.begin()), kind_named(kMasterColumns, k.column), k.descending});
+  }
+  return out;
+}
+
+// A typed cell's value to sort by: numbers, and durations (h:mm:ss) in seconds
+static std::optional<double> sort_value(CellKind kind, std::string_view cell) {
+  const char* end = cell.data() + cell.size();
+  if (kind == CellKind::Int || kind == CellKind::Real || kind == CellKind::Fixed2) {
+    double v = 0;
+    const auto r = std::from_chars(cell.data(), end, v);
+    if (r.ec == std::errc{} && r.ptr == end) return v;
+  } else if (kind == CellKind::Duration) {
+    long long parts[3] = {};
+    const char* p = cell.data();
+    for (int i = 0; i < 3; ++i) {
+      const auto r = std::from_chars(p, end, parts[i]);
+      if (r.ec != std::errc{} || (i < 2 ? r.ptr == end || *r.ptr != ':' : r.ptr != end)) return std::nullopt;
+      p = r.ptr + 1;
+    }
+    return double(parts[0] * 3600 + parts[1] * 60 + parts[2]);
+  }
+  return std::nullopt;
+}
+
+// One cell of a sort key, encoded so that keys compare bytewise in sort
+// order and each cell's encoding ends unambiguously: empty cells first, then
+// typed values by value (doubles with the sign bit flipped, or every bit for
+// negatives, big-endian), then text in byte order ('\0' escaped, "\0\0" ending
+// it). A descending cell is the same bytes inverted.
+static void append_sort_key(std::string& key, const SortColumn& k, std::string_view cell) {
+  const size_t from = key.size();
+  if (cell.empty()) {
+    key.push_back('\0');
+  } else if (const auto v = sort_value(k.kind, cell)) {
+    std::uint64_t bits = std::bit_cast<std::uint64_t>(*v == 0 ? 0.0 : *v);
+    bits = bits >> 63 ? ~bits : bits | (std::uint64_t{1} << 63);
+    key.push_back('\1');
+    for (int shift = 56; shift >= 0; shift -= 8) key.push_back((char)(bits >> shift));
+  } else {
+    key.push_back('\2');
+    for (const char c : cell) {
+      key.push_back(c);
+      if (c == '\0') key.push_back('\xff');
+    }
+    key.append(2, '\0');
+  }
+  if (k.descending)
+    for (size_t i = from; i < key.size(); ++i) key[i] = (char)~key[i];
+}
+
+// Kind of each master column among `headers`, for typed cell writes
+static std::vector<CellKind> master_kinds(const std::vector<std::string>& headers) {
+  std::vector<CellKind> kinds;
+  for (const auto& h : headers) kinds.push_back(kind_named(kMasterColumns, h));
+  return kinds;
+}
+
+bool parse_workbook_backend(const std::string& name, WorkbookBackend& out) {
+  if (name == "libxlsxwriter") out = WorkbookBackend::Libxlsxwriter;
+  else if (name == "native") out = WorkbookBackend::Native;
+  else return false;
+  return true;
+}
+
+// The master sheet of a workbook being written by either backend, laid out
+// up front; rows follow the header in order, each cell as its column's kind.
+// The native sheet gets a table where libxlsxwriter's constant_memory mode
+// only allows an autofilter, since the native writer adds the table part
+// after the rows.
+class MasterSheet {
+public:
+  MasterSheet(WorkbookBackend backend, const std::string& path, const std::vector<std::string>& headers,
+              size_t nrows, unsigned jobs)
+      : kinds_(master_kinds(headers)) {
+    if (backend == WorkbookBackend::Native) {
+      SheetLayout layout;
+      layout.name = "All_Exports";
+      layout.headers = headers;
+      layout.kinds = kinds_;
+      layout.table = true;
+      const auto success = std::find(headers.begin(), headers.end(), "Success");
+      if (success != headers.end()) layout.successColumn = (int)(success - headers.begin());
+      native_.emplace(path, std::move(layout), jobs);
+      return;
+    }
+    lxw_workbook_options options{};
+    options.constant_memory = LXW_TRUE;
+    wb_ = workbook_new_opt(path.c_str(), &options);
+    ws_ = add_master_sheet(wb_, headers, nrows);
+    cells_.emplace(wb_);
+  }
+
+  void add_row(std::span<const std::string_view> fields) {
+    if (native_) return native_->add_row(fields);
+    lxw_col_t col = 0;
+    for (const std::string_view field : fields) {
+      cells_->write(ws_, row_, col, col < kinds_.size() ? kinds_[col] : CellKind::Text, field);
+      ++col;
+    }
+    ++row_;
+  }
+
+  // Row `r` of the store's segment `s`: libxlsxwriter gets each cell decoded
+  // straight from its column, the native writer the row as TSV fields
+  void add_row(const ColumnStore& store, size_t s, size_t r) {
+    if (native_) {
+      line_.clear();
+      store.append_line(line_, s, r);
+      line_.pop_back();
+      reader_.reset(line_);
+      reader_.next();
+      return native_->add_row(reader_.fields());
+    }
+    for (size_t c = 0; c < store.columns(); ++c) {
+      cell_.clear();
+      store.append_cell(cell_, s, r, c);
+      cells_->write(ws_, row_, (lxw_col_t)c, c < kinds_.size() ? kinds_[c] : CellKind::Text, cell_);
+    }
+    ++row_;
+  }
+
+  // False when the workbook came out incomplete
+  bool close() { return native_ ? native_->close() : workbook_close(wb_) == LXW_NO_ERROR; }
+
+private:
+  std::vector<CellKind> kinds_;
+  std::optional<NativeSheetWriter> native_;
+  lxw_workbook* wb_ = nullptr;
+  lxw_worksheet* ws_ = nullptr;
+  std::optional<CellWriter> cells_;
+  lxw_row_t row_ = 1;
+  std::string line_, cell_;
+  util::TsvReader reader_{{}};
+};
+
+// A workbook that came out incomplete: the old one stays
+static bool drop_workbook(MasterSheet& sheet, const std::string& tmp, const std::string& xlsx_path) {
+  sheet.close();
+  return publish_workbook(false, tmp, xlsx_path);
+}
+
+// Adds the lines handed to `sorter` to `sheet` in key order; false if the
+// sort lost its runs
+static bool write_sorted_rows(MasterSheet& sheet, util::ExternalSorter& sorter) {
+  util::TsvReader reader({});
+  return sorter.finish([&](std::string_view line) {
+    reader.reset(line);
+    reader.next();
+    sheet.add_row(reader.fields());
+  });
+}
+
+// Where a workbook's sort spills its runs
+static std::string sort_dir(const std::string& xlsx_path) { return xlsx_path + ".sort"; }
+
+// Streams the TSV into a worksheet in libxlsxwriter's constant_memory mode
+// (or the native writer's blocks): rows are written in order and flushed as
+// they go, so memory stays flat however large the master grows (the TSV is
+// mapped, not read in). libxlsxwriter has no tables in that mode, so its
+// header gets an autofilter instead. Sorted, the lines go through an external
+// sort first. False if the workbook could not be written.
+static bool rebuild_xlsx_from_tsv(const std::string& tsv_path,
+                                  const std::string& xlsx_path,
+                                  const MasterSort& sort,
+                                  WorkbookBackend backend,
+                                  unsigned jobs) {
+  if (!fs::exists(tsv_path)) return true;
+  util::MappedFile master(tsv_path);
+  const size_t nrows = count_master_rows(master.data());
+
+  util::TsvReader reader(master.data());
+  std::vector<std::string> headers;
+  while (reader.next()) {
+    if (reader.line().empty()) continue;
+    headers.assign(reader.fields().begin(), reader.fields().end());
+    break;
+  }
+
+  const auto keys = sort_columns(sort, headers);
+  std::optional<util::ExternalSorter> sorter;
+  if (!keys.empty()) {
+    sorter.emplace(sort_dir(xlsx_path), sort.memoryLimit);
+    std::string key;
+    while (reader.next()) {
+      if (reader.line().empty()) continue;
+      const auto fields = reader.fields();
+      key.clear();
+      for (const auto& k : keys) append_sort_key(key, k, k.column < fields.size() ? fields[k.column] : std::string_view{});
+      sorter->add(key, reader.line());
+    }
+  }
+
+  const std::string tmp = xlsx_path + ".tmp";
+  MasterSheet sheet(backend, tmp, headers, nrows, jobs);
+
+  if (sorter) {
+    if (!write_sorted_rows(sheet, *sorter)) return drop_workbook(sheet, tmp, xlsx_path);
+  } else {
+    // Each row as it is read
+    size_t row = 0;
+    while (row < nrows && reader.next()) {
+      if (reader.line().empty()) continue;
+      sheet.add_row(reader.fields());
+      ++row;
+    }
+  }
+
+  return publish_workbook(sheet.close(), tmp, xlsx_path);
+}
+
+// Same sheet from the column store: the row count is known up front and each
+// row is decoded from its columns (or, sorted, as a line)
+static bool rebuild_xlsx_from_store(const ColumnStore& store, const std::string& xlsx_path, const MasterSort& sort,
+                                    WorkbookBackend backend, unsigned jobs) {
+  std::vector<std::string> headers;
+  for (size_t c = 0; c < store.columns(); ++c) headers.emplace_back(store.name(c));
+
+  const auto keys = sort_columns(sort, headers);
+  std::optional<util::ExternalSorter> sorter;
+  if (!keys.empty()) {
+    sorter.emplace(sort_dir(xlsx_path), sort.memoryLimit);
+    std::string key, line, cell;
+    for (size_t s = 0; s < store.segments(); ++s) {
+      for (size_t r = 0; r < store.segment_rows(s); ++r) {
+        key.clear();
+        for (const auto& k : keys) {
+          cell.clear();
+          store.append_cell(cell, s, r, k.column);
+          append_sort_key(key, k, cell);
+        }
+        line.clear();
+        store.append_line(line, s, r);
+        line.pop_back();
+        sorter->add(key, line);
+      }
+    }
+  }
+
+  const std::string tmp = xlsx_path + ".tmp";
+  MasterSheet sheet(backend, tmp, headers, store.rows(), jobs);
+
+  if (sorter) {
+    if (!write_sorted_rows(sheet, *sorter)) return drop_workbook(sheet, tmp, xlsx_path);
+  } else {
+    for (size_t s = 0; s < store.segments(); ++s)
+      for (size_t r = 0; r < store.segment_rows(s); ++r) sheet.add_row(store, s, r);
+  }
+
+  return publish_workbook(sheet.close(), tmp, xlsx_path);
+}
+
+// ---------------- partitioned master ----------------
+
+static const char* partition_dir_name(MasterPartition p) {
+  return p == MasterPartition::Month ? "All_Exports_by_month" : "All_Exports_by_project";
+}
+
+// Partition workbooks and TSVs live in this subfolder of the partition
+// folder, apart from partitions.tsv and Index.xlsx, whatever a project is named
+static constexpr const char* kPartsDir = "parts";
+
+// Names Windows reserves for devices, with or without an extension
+static bool is_device_name(std::string_view name) {
+  name = name.substr(0, name.find('.'));
+  while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+  std::string upper(name);
+  for (char& c : upper) c = (char)std::toupper((unsigned char)c);
+  if (upper == "CON" || upper == "PRN" || upper == "AUX" || upper == "NUL") return true;
+  return upper.size() == 4 && (upper.starts_with("COM") || upper.starts_with("LPT")) && upper[3] >= '1' &&
+         upper[3] <= '9';
+}
+
+// Partition of a master line, usable as a file name: the RunDate month
+// (YYYY-MM) or the ProjectName with unsafe characters replaced
+static std::string partition_key(MasterPartition p, std::string_view cell) {
+  if (p == MasterPartition::Month) return cell.size() >= 7 ? std::string(cell.substr(0, 7)) : "undated";
+  std::string key(cell);
+  for (char& c : key)
+    if (!(std::isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == ' ')) c = '_';
+  while (!key.empty() && (key.back() == '.' || key.back() == ' ')) key.pop_back();  // not allowed last on Windows
+  if (is_device_name(key)) key += '_';
+  return key.empty() ? "unnamed" : key;
+}
+
+// Keys that differ only in case would share a file on Windows
+static std::string fold_case(std::string_view key) {
+  std::string folded(key);
+  for (char& c : folded) c = (char)std::tolower((unsigned char)c);
+  return folded;
+}
+
+struct PartitionInfo {
+  size_t rows = 0;
+  std::uint64_t bytes = 0;  // of its TSV as of the covered master bytes
+  std::string updated;      // IngestedAt-style stamp of the last rebuild
+};
+
+// <dir>/partitions.tsv: how many master TSV bytes the partitions reflect (and
+// their util::prefix_fingerprint), then one line per partition
+static constexpr std::string_view kPartitionsMagic = "logtoExcel partitions v2";
+
+static bool load_partitions(const std::string& path, std::string_view master,
+                            std::uint64_t& covered, std::map<std::string, PartitionInfo>& parts) {
+  if (!fs::exists(path)) return false;
+  util::MappedFile file(path);
+  util::TsvReader reader(file.data());
+  if (!reader.next()) return false;
+  const auto cells = reader.fields();
+  auto number = [](std::string_view cell) { return std::strtoull(std::string(cell).c_str(), nullptr, 10); };
+  if (cells.size() != 3 || cells[0] != kPartitionsMagic) return false;
+  covered = number(cells[1]);
+  if (covered > master.size() || util::prefix_fingerprint(master, covered) != number(cells[2]))
+    return false;
+  while (reader.next()) {
+    const auto p = reader.fields();
+    if (p.size() == 4) parts[std::string(p[0])] = {number(p[1]), number(p[2]), std::string(p[3])};
+  }
+  return true;
+}
+
+static bool save_partitions(const std::string& path, std::string_view master,
+                            const std::map<std::string, PartitionInfo>& parts) {
+  std::string text = std::string(kPartitionsMagic) + '\t' + std::to_string(master.size()) + '\t' +
+                     std::to_string(util::prefix_fingerprint(master, master.size())) + '\n';
+  for (const auto& [key, info] : parts)
+    text += key + '\t' + std::to_string(info.rows) + '\t' + std::to_string(info.bytes) + '\t' + info.updated + '\n';
+  return util::write_file_durably(path, text);
+}
+
+// Undoes what a run that died before saving the manifest left in `parts`:
+// lines it appended to a partition TSV are cut off and partitions it created
+// are removed, so routing again from the manifest adds every line once.
+// False if a partition TSV is shorter than the manifest says.
+static bool roll_back_partitions(const fs::path& parts, const std::map<std::string, PartitionInfo>& known) {
+  std::error_code ec;
+  for (fs::directory_iterator it(parts, ec), end; !ec && it != end; it.increment(ec)) {
+    const fs::path file = it->path();
+    const auto found = known.find(file.stem().string());
+    if (found == known.end()) {
+      std::error_code ignored;
+      fs::remove(file, ignored);
+      continue;
+    }
+    if (file.extension() != ".tsv") continue;
+    const std::uintmax_t size = fs::file_size(file, ec);
+    if (ec || size < found->second.bytes) return false;
+    if (size > found->second.bytes) fs::resize_file(file, found->second.bytes, ec);
+    if (ec) return false;
+  }
+  for (const auto& [key, info] : known)
+    if (info.bytes && !fs::exists(parts / (key + ".tsv"))) return false;
+  return !ec;
+}
+
+// One row per partition with its row count and workbook
+static bool write_partition_index(const std::string& xlsx_path, const std::map<std::string, PartitionInfo>& parts) {
+  const std::string tmp = xlsx_path + ".tmp";
+  lxw_workbook* wb = workbook_new(tmp.c_str());
+  lxw_worksheet* ws = workbook_add_worksheet(wb, "Partitions");
+  const char* headers[] = {"Partition", "Rows", "Workbook", "UpdatedAt"};
+  for (lxw_col_t c = 0; c < 4; ++c) worksheet_write_string(ws, 0, c, headers[c], nullptr);
+  lxw_row_t r = 1;
+  for (const auto& [key, info] : parts) {
+    worksheet_write_string(ws, r, 0, key.c_str(), nullptr);
+    worksheet_write_number(ws, r, 1, (double)info.rows, nullptr);
+    worksheet_write_string(ws, r, 2, (std::string(kPartsDir) + '/' + key + ".xlsx").c_str(), nullptr);
+    worksheet_write_string(ws, r, 3, info.updated.c_str(), nullptr);
+    ++r;
+  }
+  worksheet_autofilter(ws, 0, 0, r - 1, 3);
+  worksheet_freeze_panes(ws, 1, 0);
+  worksheet_set_column(ws, 0, 3, 22, nullptr);
+  return publish_workbook(workbook_close(wb) == LXW_NO_ERROR, tmp, xlsx_path);
+}
+
+// Route the master lines the partitions have not seen into parts/<key>.tsv
+// under the partition folder, then rebuild only the workbooks of the
+// partitions that received lines, and the index. A master that was rewritten
+// (or a missing manifest) re-splits it from the start. The manifest is saved
+// last and records each partition TSV's size, so a run cut short is rolled
+// back to it and redone by the next one. A workbook that could not be
+// written is named in `failed` (the first of them); its old one stays.
+static void update_partitions(const std::string& tsv_path, const std::string& outputs_dir, MasterPartition mode,
+                              const MasterSort& sort, WorkbookBackend backend, unsigned jobs,
+                              std::string& failed) {
+  const fs::path dir = fs::path(outputs_dir) / partition_dir_name(mode);
+  const fs::path partsDir = dir / kPartsDir;
+  const std::string manifest = (dir / "partitions.tsv").string();
+  util::MappedFile master(tsv_path);
+  const std::string_view text = master.data();
+
+  std::uint64_t covered = 0;
+  std::map<std::string, PartitionInfo> parts;
+  if (!load_partitions(manifest, text, covered, parts) || !roll_back_partitions(partsDir, parts)) {
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    covered = 0;
+    parts.clear();
+  }
+  ensure_dir(partsDir.string());
+  std::map<std::string, std::string> byFolded;  // fold_case(key) -> the key first given to it
+  for (const auto& entry : parts) byFolded.emplace(fold_case(entry.first), entry.first);
+
+  std::string_view rest = text, header;
+  if (!util::next_line(rest, header)) return;
+  util::TsvReader head(header);
+  head.next();
+  const auto headers = head.fields();
+  const std::string_view keyColumn = mode == MasterPartition::Month ? "RunDate" : "ProjectName";
+  const size_t column = std::find(headers.begin(), headers.end(), keyColumn) - headers.begin();
+  const std::string headerLine = std::string(header) + '\n';
+  if (covered > text.size() - rest.size()) rest = text.substr((size_t)covered);
+
+  // New lines per partition, written out whenever they pile up
+  std::map<std::string, std::string> pending;
+  std::set<std::string> dirty;
+  size_t pendingBytes = 0;
+  auto flush = [&] {
+    for (auto& [key, lines] : pending) {
+      const fs::path part = partsDir / (key + ".tsv");
+      const bool fresh = !fs::exists(part);
+      {
+        std::ofstream out(part, std::ios::app | std::ios::binary);
+        if (fresh) out << headerLine;
+        out.write(lines.data(), (std::streamsize)lines.size());
+      }
+      std::error_code ec;
+      parts[key].bytes = fs::file_size(part, ec);
+    }
+    pending.clear();
+    pendingBytes = 0;
+  };
+  util::TsvReader reader(rest);
+  if (column < headers.size()) {
+    const size_t project[] = {column};
+    reader.project(project);
+  } else {
+    reader.project({});
+  }
+  while (reader.next()) {
+    const std::string_view line = reader.line();
+    if (line.empty()) continue;
+    std::string key = partition_key(mode, column < headers.size() ? reader.fields()[0] : std::string_view{});
+    key = byFolded.emplace(fold_case(key), key).first->second;
+    auto& lines = pending[key];
+    lines.append(line).push_back('\n');
+    pendingBytes += line.size() + 1;
+    ++parts[key].rows;
+    dirty.insert(key);
+    if (pendingBytes >= (8u << 20)) flush();
+  }
+  flush();
+
+  const auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+  char stamp[32];
+  const std::string updated(stamp, util::format_stamp(stamp, now));
+  for (const auto& key : dirty) {
+    const std::string xlsx = (partsDir / (key + ".xlsx")).string();
+    if (rebuild_xlsx_from_tsv((partsDir / (key + ".tsv")).string(), xlsx, sort, backend, jobs))
+      parts[key].updated = updated;
+    else if (failed.empty())
+      failed = xlsx;
+  }
+  const std::string index = (dir / "Index.xlsx").string();
+  if ((!dirty.empty() || !fs::exists(index)) && !write_partition_index(index, parts) && failed.empty())
+    failed = index;
+  save_partitions(manifest, text, parts);
+}
+
+bool parse_master_partition(const std::string& name, MasterPartition& out) {
+  if (name == "none") out = MasterPartition::None;
+  else if (name == "month") out = MasterPartition::Month;
+  else if (name == "project") out = MasterPartition::Project;
+  else return false;
+  return true;
+}
+
+// ---------------- group commit ----------------
+//
+// Runs sharing an outputs folder (several farm nodes, say) never write the
+// master at the same time. Each run first leaves its lines in the journal
+// folder, flushed to disk, then waits for the master lock. The lock holder
+// commits every entry waiting in the journal with one append and one rebuild,
+// then removes them; a run whose entry is gone by the time it gets the lock
+// was committed by another run and is done. An entry left behind by a run
+// that died is committed by the next one, and since rows already in the
+// master are skipped by LogPath, replaying an entry never adds a row twice.
+
+// Unique across processes and hosts; sorts by creation time
+static std::string journal_entry_name() {
+  static std::atomic<unsigned> seq{0};
+  static const std::uint64_t nonce = (std::uint64_t(std::random_device{}()) << 32) ^ std::random_device{}();
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  char name[80];
+  std::snprintf(name, sizeof name, "%020lld-%016llx-%u.tsv", (long long)ns, (unsigned long long)nonce, seq++);
+  return name;
+}
+
+// Entries waiting in the journal, oldest first
+static std::vector<fs::path> journal_entries(const fs::path& journal) {
+  std::vector<fs::path> entries;
+  std::error_code ec;
+  for (fs::directory_iterator it(journal, ec), end; !ec && it != end; it.increment(ec))
+    if (it->is_regular_file(ec) && it->path().extension() == ".tsv") entries.push_back(it->path());
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+// With the lock held: the journal entries (and `extra` lines that could not
+// be journaled) into the master, the workbooks rebuilt once, the entries
+// removed. False, with `error` set, if a workbook could not be written; the
+// rows are in the master regardless.
+static bool commit_journal(const std::string& outputs_dir, const fs::path& journal,
+                           std::string_view extra, MasterPartition partition, const MasterSort& sort,
+                           WorkbookBackend backend, unsigned jobs, std::string& error) {
   const std::string tsv = (fs::path(outputs_dir) / "All_Exports.tsv").string();
   const std::string xlsx = (fs::path(outputs_dir) / "All_Exports.xlsx").string();
-  append_unique_to_tsv(tsv, new_rows);
-  rebuild_xlsx_from_tsv(tsv, xlsx);
+  const auto entries = journal_entries(journal);
+  std::string batch;
+  for (const auto& e : entries) {
+    util::MappedFile f(e.string());
+    batch.append(f.data());
+    if (!batch.empty() && batch.back() != '\n') batch.push_back('\n');
+  }
+  batch.append(extra);
+
+  ColumnStore store = open_master_store(outputs_dir, tsv);
+  // On disk before the journal lets go of the rows; until then the entries
+  // stay for the next run to replay
+  if (!append_unique_to_tsv(tsv, batch, store.is_open() ? &store : nullptr) ||
+      (store.is_open() && !util::sync_file(ColumnStore::path_for(outputs_dir))) || !util::sync_file(tsv)) {
+    error = "Could not write the master " + tsv + "; the journal keeps its entries for the next run" +
+            (extra.empty() ? "" : ", but this run's rows could not be journaled");
+    return false;
+  }
+  std::string failed;
+  if (partition != MasterPartition::None) update_partitions(tsv, outputs_dir, partition, sort, backend, jobs, failed);
+  else if (!(store.is_open() ? rebuild_xlsx_from_store(store, xlsx, sort, backend, jobs)
+                             : rebuild_xlsx_from_tsv(tsv, xlsx, sort, backend, jobs)))
+    failed = xlsx;
+  for (const auto& e : entries) {
+    std::error_code ec;
+    fs::remove(e, ec);
+  }
+  if (failed.empty()) return true;
+  error = "Could not write " + failed + "; the master has the rows, the previous workbook stays";
+  return false;
 }
 
-} // namespace excel
+bool append_to_master_and_rebuild_xlsx(const std::string& outputs_dir,
+                                       const std::vector<UnifiedRow>& new_rows,
+                                       std::string& error,
+                                       MasterPartition partition,
+                                       const MasterSort& sort,
+                                       WorkbookBackend backend,
+                                       unsigned jobs) {
+  ensure_dir(outputs_dir);
+  const fs::path journal = fs::path(outputs_dir) / "All_Exports.journal";
+  std::string lines;
+  for (const auto& u : new_rows) append_tsv_line(lines, kMasterColumns, u);
 
+  std::string entry;
+  if (!lines.empty()) {
+    ensure_dir(journal.string());
+    entry = (journal / journal_entry_name()).string();
+    if (util::write_file_durably(entry, lines)) lines.clear();
+    else entry.clear();   // committed from memory instead
+  }
+
+  util::FileLock lock(master_lock_path(outputs_dir));
+  if (!lock.locked()) {
+    error = "Could not lock " + master_lock_path(outputs_dir) + "; the master was not updated" +
+            (entry.empty() ? "" : " (this run's rows wait in the journal for the next run)");
+    return false;
+  }
+  if (!entry.empty() && !fs::exists(entry)) return true;   // in another run's group
+  return commit_journal(outputs_dir, journal, lines, partition, sort, backend, jobs, error);
+}
+
+std::string master_lock_path(const std::string& outputs_dir) {
+  return (fs::path(outputs_dir) / "All_Exports.lock").string();
+}
+
+bool replace_master(const std::string& outputs_dir, const util::FileLock& lock, const std::string& merged_tsv,
+                    std::string& error, MasterPartition partition, const MasterSort& sort, WorkbookBackend backend,
+                    unsigned jobs) {
+  if (!lock.locked()) {
+    error = "Could not lock " + master_lock_path(outputs_dir);
+    return false;
+  }
+  const std::string tsv = (fs::path(outputs_dir) / "All_Exports.tsv").string();
+  // The store would otherwise export its own rows back over the new TSV
+  std::error_code ec;
+  fs::remove(ColumnStore::path_for(outputs_dir), ec);
+  fs::remove(LogPathIndex::path_for(tsv), ec);
+  util::sync_file(merged_tsv);
+  if (!util::replace_file(merged_tsv, tsv)) {
+    error = "Could not replace " + tsv + " with " + merged_tsv;
+    return false;
+  }
+  return commit_journal(outputs_dir, fs::path(outputs_dir) / "All_Exports.journal", {}, partition, sort, backend,
+                        jobs, error);
+}
+
+bool write_tsv_workbook(const std::string& tsv_path, const std::string& xlsx_path, WorkbookBackend backend,
+                        unsigned jobs) {
+  return rebuild_xlsx_from_tsv(tsv_path, xlsx_path, MasterSort{}, backend, jobs);
+}
+
+} // namespace excel
@@ -1,33 +1,171 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
+#include "file_lock.hpp"
 #include "models.hpp"
 
 namespace excel {
 
-// Unified row: superset of PM/RM fields + Tool + IngestedAt
-struct UnifiedRow {
-  std::string ProjectName, Tool, DatasetName, BuildID;
-  std::string StartTime, EndTime, Duration, RunDate;
-  std::string ProcessPreset, ExportType, SelAreaSize, Resolution, TileScheme;
-  std::string PhotosUsed, PhotoFolders, PhotoCoverage, FusersUsed, CPUThreads, GPUCount;
-  std::string Machine, HostIP, User;
-  std::string OutputFolder, TotalFiles, TotalSizeGB;
-  std::string Offset_CoordSys, Offset_HDatum, Offset_VDatum;
-  std::string OffsetX, OffsetY, OffsetZ;
-  std::string PivotCenterX, PivotCenterY, PivotCenterZ;
-  std::string FlipYZ, Trim, Collision, VisualLOD;
-  std::string Success, Warnings, Errors, LogPath, IngestedAt;
+// Unified row: a parsed PhotoMesh or RealityMesh row read through the master
+// columns (superset of PM/RM fields + Tool + IngestedAt). It points at the
+// parsed row instead of copying it, so the rows must outlive it; fields the
+// tool does not log are empty. RunDate is StartTime (or EndTime) when written.
+class UnifiedRow {
+public:
+  UnifiedRow(const PhotoMeshRow& r, Instant ingestedAt) : pm_(&r), ingested_(ingestedAt) {}
+  UnifiedRow(const RealityMeshRow& r, Instant ingestedAt) : rm_(&r), ingested_(ingestedAt) {}
+
+  const PhotoMeshRow* photomesh() const { return pm_; }      // exactly one is set
+  const RealityMeshRow* realitymesh() const { return rm_; }
+
+  LogKind Tool() const { return pm() ? LogKind::PhotoMesh : LogKind::RealityMesh; }
+  const std::string& ProjectName() const;  // RealityMesh: DatasetName when empty
+  const std::string& DatasetName() const { return rm() ? rm()->datasetName : none(); }
+  Sym BuildID() const { return pm() ? pm()->buildID : Sym{}; }
+  Instant StartTime() const { return shared(&PhotoMeshRow::startTime, &RealityMeshRow::startTime); }
+  Instant EndTime() const { return shared(&PhotoMeshRow::endTime, &RealityMeshRow::endTime); }
+  Instant RunDate() const { const Instant s = StartTime(); return s ? s : EndTime(); }
+  Elapsed Duration() const { return shared(&PhotoMeshRow::duration, &RealityMeshRow::duration); }
+  Sym ProcessPreset() const { return rm() ? rm()->processPreset : Sym{}; }
+  Label<::ExportType> ExportType() const { return shared(&PhotoMeshRow::exportType, &RealityMeshRow::exportType); }
+  Real SelAreaSize() const { return rm() ? rm()->selAreaSize : Real{}; }
+  Label<::Resolution> Resolution() const { return shared(&PhotoMeshRow::resolution, &RealityMeshRow::resolution); }
+  Label<::TileScheme> TileScheme() const { return shared(&PhotoMeshRow::tileScheme, &RealityMeshRow::tileScheme); }
+  Count PhotosUsed() const { return pm() ? pm()->photosUsed : Count{}; }
+  const std::string& PhotoFolders() const { return pm() ? pm()->photoFolders : none(); }
+  Real PhotoCoverage() const { return pm() ? pm()->photoCoverage : Real{}; }
+  Count FusersUsed() const { return pm() ? pm()->fusersUsed : Count{}; }
+  Count CPUThreads() const { return pm() ? pm()->cpuThreads : Count{}; }
+  Count GPUCount() const { return pm() ? pm()->gpuCount : Count{}; }
+  Sym Machine() const { return shared(&PhotoMeshRow::machine, &RealityMeshRow::machine); }
+  Sym HostIP() const { return shared(&PhotoMeshRow::hostIP, &RealityMeshRow::hostIP); }
+  Sym User() const { return shared(&PhotoMeshRow::user, &RealityMeshRow::user); }
+  Sym OutputFolder() const { return shared(&PhotoMeshRow::outputFolder, &RealityMeshRow::outputFolder); }
+  Count TotalFiles() const { return shared(&PhotoMeshRow::totalFiles, &RealityMeshRow::totalFiles); }
+  Real TotalSizeGB() const { return shared(&PhotoMeshRow::totalSizeGB, &RealityMeshRow::totalSizeGB); }
+  Sym Offset_CoordSys() const { return shared(&PhotoMeshRow::offsetCoordSys, &RealityMeshRow::offsetCoordSys); }
+  Sym Offset_HDatum() const { return shared(&PhotoMeshRow::offsetHDatum, &RealityMeshRow::offsetHDatum); }
+  Sym Offset_VDatum() const { return shared(&PhotoMeshRow::offsetVDatum, &RealityMeshRow::offsetVDatum); }
+  Real OffsetX() const { return shared(&PhotoMeshRow::offsetX, &RealityMeshRow::offsetX); }
+  Real OffsetY() const { return shared(&PhotoMeshRow::offsetY, &RealityMeshRow::offsetY); }
+  Real OffsetZ() const { return shared(&PhotoMeshRow::offsetZ, &RealityMeshRow::offsetZ); }
+  Real PivotCenterX() const { return shared(&PhotoMeshRow::pivotCenterX, &RealityMeshRow::pivotCenterX); }
+  Real PivotCenterY() const { return shared(&PhotoMeshRow::pivotCenterY, &RealityMeshRow::pivotCenterY); }
+  Real PivotCenterZ() const { return shared(&PhotoMeshRow::pivotCenterZ, &RealityMeshRow::pivotCenterZ); }
+  Tri FlipYZ() const { return shared(&PhotoMeshRow::flipYZ, &RealityMeshRow::flipYZ); }
+  Tri Trim() const { return shared(&PhotoMeshRow::trim, &RealityMeshRow::trim); }
+  Tri Collision() const { return shared(&PhotoMeshRow::collision, &RealityMeshRow::collision); }
+  Tri VisualLOD() const { return shared(&PhotoMeshRow::visualLOD, &RealityMeshRow::visualLOD); }
+  Tri Success() const { return shared(&PhotoMeshRow::success, &RealityMeshRow::success); }
+  std::int32_t Warnings() const { return shared(&PhotoMeshRow::warnings, &RealityMeshRow::warnings); }
+  std::int32_t Errors() const { return shared(&PhotoMeshRow::errors, &RealityMeshRow::errorCount); }
+  const std::string& ErrorMessages() const { return rm() ? rm()->errors : none(); }
+  const std::string& LogPath() const { return shared(&PhotoMeshRow::logPath, &RealityMeshRow::logPath); }
+  Instant IngestedAt() const { return ingested_; }
+
+private:
+  const PhotoMeshRow* pm() const { return pm_; }
+  const RealityMeshRow* rm() const { return rm_; }
+  template <class T, class U>
+  const T& shared(T PhotoMeshRow::* p, U RealityMeshRow::* r) const {
+    static_assert(std::is_same_v<T, U>);
+    return pm() ? pm()->*p : rm()->*r;
+  }
+  static const std::string& none();
+
+  const PhotoMeshRow* pm_ = nullptr;
+  const RealityMeshRow* rm_ = nullptr;
+  Instant ingested_;
 };
 
-// Build unified rows from parsed structs
+// Views of the parsed rows, PhotoMesh first, all stamped with the same
+// IngestedAt. Rows listed in pmSkip / rmSkip (ascending indices) are left out.
 std::vector<UnifiedRow> unify(const std::vector<PhotoMeshRow>& pm,
-                              const std::vector<RealityMeshRow>& rm);
+                              const std::vector<RealityMeshRow>& rm,
+                              const std::vector<size_t>& pmSkip = {},
+                              const std::vector<size_t>& rmSkip = {});
+
+// How the master workbook is laid out: one All_Exports.xlsx, or one workbook
+// per RunDate month / per ProjectName under All_Exports_by_month/ or
+// All_Exports_by_project/, with an Index.xlsx listing them
+enum class MasterPartition { None, Month, Project };
+
+// "none", "month" or "project"; false for anything else
+bool parse_master_partition(const std::string& name, MasterPartition& out);
+
+// Row order of the master workbooks: ingestion order when `keys` is empty,
+// else by these master columns in turn (typed ones by value, a descending
+// key marked), ties kept in ingestion order. The sort holds about
+// `memoryLimit` bytes and spills sorted runs beside the workbook beyond that,
+// so masters larger than memory sort too. The TSV and store keep ingestion order.
+struct MasterSort {
+  struct Key {
+    std::string column;
+    bool descending = false;
+  };
+  std::vector<Key> keys;
+  std::size_t memoryLimit = std::size_t{256} << 20;
+};
+
+// Comma-separated master column names, each optionally prefixed with '-' for
+// descending ("RunDate,Machine", "-RunDate"); false naming an unknown column
+bool parse_master_sort(const std::string& spec, MasterSort& out);
+
+// What writes the master workbooks: libxlsxwriter, or the native writer
+// (see native_xlsx.hpp) that builds and compresses the sheet on several
+// threads and gives the sheet an Excel table
+enum class WorkbookBackend { Libxlsxwriter, Native };
+
+// "libxlsxwriter" or "native"; false for anything else
+bool parse_workbook_backend(const std::string& name, WorkbookBackend& out);
+
+// Append into <outputs_dir>/All_Exports.cols, the column store of record
+// (imported from an existing All_Exports.tsv on first use), and into the TSV
+// exported from it (create + header if missing; skip duplicates by LogPath),
+// then rebuild <outputs_dir>/All_Exports.xlsx (single-sheet) from the store.
+// When partitioned, only the partitions that received rows are rebuilt instead.
+// Workbook rows are ordered by `sort` and written by `backend` (the native
+// one on `jobs` threads, 0 = hardware concurrency).
+// Safe to call from many processes on one shared folder: rows go through a
+// journal (<outputs_dir>/All_Exports.journal) and are committed in groups
+// under a lock file, and workbooks are replaced by rename. False, with
+// `error` set, if the lock file cannot be locked (the rows then stay in the
+// journal for the next run) or a workbook cannot be written (the old one
+// stays; the master TSV and store have the rows).
+bool append_to_master_and_rebuild_xlsx(const std::string& outputs_dir,
+                                       const std::vector<UnifiedRow>& new_rows,
+                                       std::string& error,
+                                       MasterPartition partition = MasterPartition::None,
+                                       const MasterSort& sort = {},
+                                       WorkbookBackend backend = WorkbookBackend::Libxlsxwriter,
+                                       unsigned jobs = 0);
+
+// <outputs_dir>/All_Exports.lock, the lock every writer of the master holds
+std::string master_lock_path(const std::string& outputs_dir);
+
+// Makes the master TSV at `merged_tsv` (from merge_masters, say) the master of
+// <outputs_dir>: it is renamed into place, the column store and LogPath index
+// are rebuilt from it, rows waiting in the journal are committed on top, and
+// the workbooks are rebuilt. `lock` is a FileLock on master_lock_path(),
+// taken before the current master was read into `merged_tsv` so that no
+// append lands in between. False, with `error` set, if it is not held, the
+// TSV cannot be renamed into place or a workbook cannot be written.
+bool replace_master(const std::string& outputs_dir, const util::FileLock& lock, const std::string& merged_tsv,
+                    std::string& error,
+                    MasterPartition partition = MasterPartition::None,
+                    const MasterSort& sort = {},
+                    WorkbookBackend backend = WorkbookBackend::Libxlsxwriter,
+                    unsigned jobs = 0);
 
-// Append into <outputs_dir>/All_Exports.tsv (create + header if missing; skip duplicates by LogPath),
-// then rebuild <outputs_dir>/All_Exports.xlsx (single-sheet) from the TSV.
-void append_to_master_and_rebuild_xlsx(const std::string& outputs_dir,
-                                       const std::vector<UnifiedRow>& new_rows);
+// A TSV with a header row (query results, say) as a workbook laid out like
+// the master's single sheet, streamed the same way; false if it could not be
+// written
+bool write_tsv_workbook(const std::string& tsv_path, const std::string& xlsx_path,
+                        WorkbookBackend backend = WorkbookBackend::Libxlsxwriter,
+                        unsigned jobs = 0);
 
 } // namespace excel
 
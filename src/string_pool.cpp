@@ -0,0 +1,91 @@
+#include "string_pool.hpp"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace util {
+
+namespace {
+
+constexpr std::size_t kBlockBytes = 64 << 10;
+
+} // namespace
+
+StringPool::StringPool() {
+    intern({});  // id 0
+}
+
+StringPool::~StringPool() {
+    for (auto &s : segments_) delete[] s.load(std::memory_order_relaxed);
+}
+
+const char *StringPool::store(std::string_view s) {
+    const std::size_t need = s.size() + 1;
+    char *p;
+    if (need > kBlockBytes / 4) {
+        // A large string gets a block of its own; the current block stays open
+        p = large_.emplace_back(std::make_unique<char[]>(need)).get();
+    } else {
+        if (kBlockBytes - blockUsed_ < need || blocks_.empty()) {
+            blocks_.push_back(std::make_unique<char[]>(kBlockBytes));
+            blockUsed_ = 0;
+        }
+        p = blocks_.back().get() + blockUsed_;
+        blockUsed_ += need;
+    }
+    if (!s.empty()) std::memcpy(p, s.data(), s.size());
+    p[s.size()] = '\0';
+    arenaBytes_ += need;
+    return p;
+}
+
+Sym StringPool::intern(std::string_view s) {
+    std::lock_guard lock(m_);
+    if (auto it = ids_.find(s); it != ids_.end()) return it->second;
+
+    const std::uint32_t id = next_;
+    const std::size_t q = id / kFirstSegment + 1;
+    const std::size_t k = std::bit_width(q) - 1;
+    if (k >= kSegments) throw std::length_error("string pool full");
+    Entry *seg = segments_[k].load(std::memory_order_relaxed);
+    if (!seg) {
+        seg = new Entry[kFirstSegment << k];
+        segments_[k].store(seg, std::memory_order_release);
+    }
+    const char *text = store(s);
+    seg[id - kFirstSegment * ((std::size_t(1) << k) - 1)] = {text, static_cast<std::uint32_t>(s.size())};
+    ++next_;
+    ids_.emplace(std::string_view(text, s.size()), Sym{id});
+    return Sym{id};
+}
+
+std::optional<Sym> StringPool::find(std::string_view s) const {
+    std::lock_guard lock(m_);
+    if (auto it = ids_.find(s); it != ids_.end()) return it->second;
+    return std::nullopt;
+}
+
+std::string_view StringPool::view(Sym id) const {
+    const std::size_t i = static_cast<std::size_t>(id);
+    const std::size_t k = std::bit_width(i / kFirstSegment + 1) - 1;
+    const Entry &e = segments_[k].load(std::memory_order_acquire)[i - kFirstSegment * ((std::size_t(1) << k) - 1)];
+    return {e.text, e.size};
+}
+
+std::size_t StringPool::size() const {
+    std::lock_guard lock(m_);
+    return next_;
+}
+
+std::size_t StringPool::arena_bytes() const {
+    std::lock_guard lock(m_);
+    return arenaBytes_;
+}
+
+StringPool &strings() {
+    static StringPool pool;
+    return pool;
+}
+
+} // namespace util
@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+
+// Id of a string in a StringPool; Sym{} is the empty string in every pool
+enum class Sym : std::uint32_t {};
+
+// Interned strings: each distinct value is stored once in an append-only
+// arena and named by a dense 32-bit id that stays valid for the pool's
+// lifetime. intern() and find() may be called from several threads; view()
+// takes no lock, for ids the caller got from this pool.
+class StringPool {
+public:
+    StringPool();
+    ~StringPool();
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    Sym intern(std::string_view s);
+    std::optional<Sym> find(std::string_view s) const;  // without adding s
+
+    // The text of an id; the view is followed by a '\0' in the arena
+    std::string_view view(Sym id) const;
+
+    std::size_t size() const;        // distinct strings, "" included
+    std::size_t arena_bytes() const;
+
+private:
+    struct Entry {
+        const char *text;
+        std::uint32_t size;
+    };
+    // Segment k holds kFirstSegment << k entries and is never moved
+    static constexpr std::size_t kFirstSegment = 1024;
+    static constexpr std::size_t kSegments = 22;
+
+    const char *store(std::string_view s);
+
+    mutable std::mutex m_;
+    std::unordered_map<std::string_view, Sym> ids_;
+    std::array<std::atomic<Entry *>, kSegments> segments_{};
+    std::vector<std::unique_ptr<char[]>> blocks_;  // kBlockBytes each, the last one open
+    std::vector<std::unique_ptr<char[]>> large_;
+    std::size_t blockUsed_ = 0, arenaBytes_ = 0;
+    std::uint32_t next_ = 0;
+};
+
+// Process-wide pool behind the categorical fields of the row model
+StringPool &strings();
+
+} // namespace util
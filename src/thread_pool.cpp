@@ -0,0 +1,120 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace util {
+
+namespace {
+// Index of the pool worker running on this thread, so nested submits stay local
+thread_local const void *tls_pool = nullptr;
+thread_local unsigned tls_index = 0;
+}
+
+unsigned resolve_jobs(unsigned jobs) {
+    if (jobs) return jobs;
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw ? hw : 1;
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+    const unsigned n = resolve_jobs(threads);
+    for (unsigned i = 0; i < n; ++i) queues_.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < n; ++i) workers_.emplace_back([this, i] { run(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stop_ = true;
+    }
+    work_.notify_all();
+    for (auto &t : workers_) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    const unsigned n = size();
+    unsigned target;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        target = (tls_pool == this) ? tls_index : static_cast<unsigned>(next_++ % n);
+        ++pending_;
+    }
+    {
+        std::lock_guard<std::mutex> lk(queues_[target]->m);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        ++pushed_;
+    }
+    work_.notify_one();
+}
+
+bool ThreadPool::try_pop(unsigned self, std::function<void()> &task) {
+    {
+        auto &own = *queues_[self];
+        std::lock_guard<std::mutex> lk(own.m);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    const unsigned n = size();
+    for (unsigned k = 1; k < n; ++k) {
+        auto &victim = *queues_[(self + k) % n];
+        std::lock_guard<std::mutex> lk(victim.m);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned self) {
+    tls_pool = this;
+    tls_index = self;
+    for (;;) {
+        std::uint64_t seen;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            seen = pushed_;
+        }
+        std::function<void()> task;
+        if (try_pop(self, task)) {
+            std::exception_ptr err;
+            try { task(); } catch (...) { err = std::current_exception(); }
+            std::lock_guard<std::mutex> lk(m_);
+            if (err && !error_) error_ = err;
+            if (--pending_ == 0) idle_.notify_all();
+            continue;
+        }
+        // Every deque was empty after the `seen`-th push: park until a later
+        // one, or until the pool stops with nothing left to run
+        std::unique_lock<std::mutex> lk(m_);
+        work_.wait(lk, [&] { return stop_ || pushed_ != seen; });
+        if (pushed_ == seen) return;
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lk(m_);
+    idle_.wait(lk, [this] { return pending_ == 0; });
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+void parallel_for(std::size_t n, unsigned jobs, const std::function<void(std::size_t)> &fn) {
+    const unsigned threads = static_cast<unsigned>(std::min<std::size_t>(resolve_jobs(jobs), n));
+    if (threads <= 1) {
+        for (std::size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+    ThreadPool pool(threads);
+    for (std::size_t i = 0; i < n; ++i) pool.submit([&fn, i] { fn(i); });
+    pool.wait();
+}
+
+} // namespace util
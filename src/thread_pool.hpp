@@ -0,0 +1,62 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// Number of worker threads to use for a --jobs value (0 = hardware concurrency)
+unsigned resolve_jobs(unsigned jobs);
+
+// Work-stealing pool: each worker owns a deque, pops its own newest task and
+// steals the oldest task of another worker when it runs dry.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Queues are all created before the first worker starts, so workers can
+    // read this while the constructor is still starting the others
+    unsigned size() const { return static_cast<unsigned>(queues_.size()); }
+
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task has finished; rethrows the first
+    // exception a task threw.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool try_pop(unsigned self, std::function<void()> &task);
+    void run(unsigned self);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex m_;
+    std::condition_variable work_;
+    std::condition_variable idle_;
+    std::uint64_t pushed_ = 0; // tasks ever pushed into a deque
+    std::size_t pending_ = 0;  // queued + running
+    std::size_t next_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+};
+
+// Run fn(i) for every i in [0, n) on up to `jobs` threads (0 = hardware
+// concurrency). Runs inline when one thread is enough.
+void parallel_for(std::size_t n, unsigned jobs, const std::function<void(std::size_t)> &fn);
+
+} // namespace util
@@ -0,0 +1,156 @@
+#include "tsv_reader.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LTE_TSV_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define LTE_TARGET_SSE2
+#define LTE_TARGET_AVX2
+#else
+#define LTE_TARGET_SSE2 __attribute__((target("sse2")))
+#define LTE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace util {
+
+namespace {
+
+constexpr std::size_t kBlock = 64;
+
+// Bit i of tabs/newlines set when p[i] is '\t' / '\n'; n < 64 bytes
+void scan_tail(const char *p, std::size_t n, std::uint64_t &tabs, std::uint64_t &newlines) {
+    tabs = newlines = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        tabs |= std::uint64_t{p[i] == '\t'} << i;
+        newlines |= std::uint64_t{p[i] == '\n'} << i;
+    }
+}
+
+void scan_scalar(const char *p, std::uint64_t &tabs, std::uint64_t &newlines) { scan_tail(p, kBlock, tabs, newlines); }
+
+#ifdef LTE_TSV_X86
+
+LTE_TARGET_SSE2 void scan_sse2(const char *p, std::uint64_t &tabs, std::uint64_t &newlines) {
+    const __m128i tab = _mm_set1_epi8('\t'), nl = _mm_set1_epi8('\n');
+    tabs = newlines = 0;
+    for (int k = 0; k < 4; ++k) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * k));
+        tabs |= std::uint64_t(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, tab)))) << (16 * k);
+        newlines |= std::uint64_t(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))) << (16 * k);
+    }
+}
+
+LTE_TARGET_AVX2 void scan_avx2(const char *p, std::uint64_t &tabs, std::uint64_t &newlines) {
+    const __m256i tab = _mm256_set1_epi8('\t'), nl = _mm256_set1_epi8('\n');
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+    const auto tlo = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, tab)));
+    const auto thi = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, tab)));
+    const auto nlo = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl)));
+    const auto nhi = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl)));
+    tabs = tlo | std::uint64_t{thi} << 32;
+    newlines = nlo | std::uint64_t{nhi} << 32;
+}
+
+#endif // LTE_TSV_X86
+
+} // namespace
+
+TsvReader::TsvReader(std::string_view buf, ScanIsa isa) : buf_(buf), scan_(scan_scalar) {
+#ifdef LTE_TSV_X86
+    if (isa == ScanIsa::AVX2 && scan_isa() == ScanIsa::AVX2) scan_ = scan_avx2;
+    else if (isa != ScanIsa::Scalar) scan_ = scan_sse2;
+#else
+    (void)isa;
+#endif
+    load_block(0, tabs_, newlines_);
+}
+
+void TsvReader::project(std::span<const std::size_t> columns) {
+    projected_ = true;
+    needed_ = columns.empty() ? 0 : *std::max_element(columns.begin(), columns.end()) + 1;
+    slot_.assign(needed_, -1);
+    for (std::size_t i = 0; i < columns.size(); ++i) slot_[columns[i]] = static_cast<std::int32_t>(i);
+    fields_.assign(columns.size(), {});
+    count_ = columns.size();
+}
+
+void TsvReader::reset(std::string_view buf) {
+    buf_ = buf;
+    pos_ = block_ = 0;
+    line_ = {};
+    load_block(0, tabs_, newlines_);
+}
+
+// Separator masks of the block at `block`
+void TsvReader::load_block(std::size_t block, std::uint64_t &tabs, std::uint64_t &newlines) const {
+    const std::size_t n = std::min(kBlock, buf_.size() - block);
+    if (n == kBlock) scan_(buf_.data() + block, tabs, newlines);
+    else scan_tail(buf_.data() + block, n, tabs, newlines);
+}
+
+// Separators are taken lowest bit first from the current block's masks, which
+// are kept in locals for the whole line
+bool TsvReader::next() {
+    const std::size_t size = buf_.size();
+    if (pos_ >= size) return false;
+    const char *data = buf_.data();
+    const std::size_t start = pos_;
+    std::size_t block = block_;
+    std::uint64_t tabs = tabs_, newlines = newlines_;
+    if (projected_) std::fill(fields_.begin(), fields_.end(), std::string_view{});
+    std::string_view *out = fields_.data();
+    std::size_t count = 0, room = fields_.size();
+
+    for (std::size_t column = 0, from = start;; ++column) {
+        // Next '\n', or '\t' as well while there are columns to split
+        const bool split = !projected_ || column < needed_;
+        std::size_t sep = size;
+        for (;;) {
+            const std::uint64_t m = split ? tabs | newlines : newlines;
+            if (m) {
+                const int bit = std::countr_zero(m);
+                const std::uint64_t later = ~std::uint64_t{1} << bit;
+                tabs &= later;
+                newlines &= later;
+                sep = block + static_cast<std::size_t>(bit);
+                break;
+            }
+            if (size - block <= kBlock) break;
+            block += kBlock;
+            load_block(block, tabs, newlines);
+        }
+
+        const bool last = sep == size || data[sep] == '\n';
+        std::size_t end = sep;
+        if (last && end > start && data[end - 1] == '\r') --end;
+        if (split) {
+            const std::string_view field(data + from, end >= from ? end - from : 0);
+            if (!projected_) {
+                if (count == room) {
+                    fields_.resize(room = std::max<std::size_t>(16, 2 * room));
+                    out = fields_.data();
+                }
+                out[count++] = field;
+            } else if (slot_[column] >= 0) {
+                out[slot_[column]] = field;
+            }
+        }
+        if (last) {
+            if (!projected_) count_ = count;
+            line_ = std::string_view(data + start, end - start);
+            pos_ = sep == size ? size : sep + 1;
+            block_ = block;
+            tabs_ = tabs;
+            newlines_ = newlines;
+            return true;
+        }
+        from = sep + 1;
+    }
+}
+
+} // namespace util
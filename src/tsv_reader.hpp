@@ -0,0 +1,53 @@
+#pragma once
+#include "scan_kernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// Line-by-line reader of TSV text held in one buffer (typically a mapping).
+// Tabs and newlines are found 64 bytes at a time with SSE2/AVX2 compares, and
+// fields are string_views into the buffer, so reading allocates nothing per
+// line. With a projection only the listed columns are kept, and once the last
+// of them is passed the rest of the line is skipped by its newline alone.
+// Each line's trailing '\r' is dropped.
+class TsvReader {
+public:
+    explicit TsvReader(std::string_view buf, ScanIsa isa = scan_isa());
+
+    // Keep only these columns: fields()[i] is column columns[i] (empty when a
+    // line is shorter). An empty list keeps no fields, only the lines.
+    void project(std::span<const std::size_t> columns);
+
+    // Starts over on another buffer, keeping the projection
+    void reset(std::string_view buf);
+
+    // Next line, empty ones included; false at the end of the buffer
+    bool next();
+
+    // Fields of the current line, valid as long as the buffer
+    std::span<const std::string_view> fields() const { return {fields_.data(), count_}; }
+    std::string_view line() const { return line_; }
+    std::size_t offset() const { return static_cast<std::size_t>(line_.data() - buf_.data()); }
+
+private:
+    void load_block(std::size_t block, std::uint64_t &tabs, std::uint64_t &newlines) const;
+
+    std::string_view buf_;
+    void (*scan_)(const char *p, std::uint64_t &tabs, std::uint64_t &newlines);
+    std::size_t pos_ = 0;                 // start of the next line
+    std::size_t block_ = 0;               // start of the 64-byte block being read
+    std::uint64_t tabs_ = 0, newlines_ = 0;  // its separators not consumed yet
+    bool projected_ = false;
+    std::size_t needed_ = 0;              // projected: columns past this are not split
+    std::vector<std::int32_t> slot_;      // projected: column -> field index, or -1
+    std::vector<std::string_view> fields_;
+    std::size_t count_ = 0;
+    std::string_view line_;
+};
+
+} // namespace util
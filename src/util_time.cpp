@@ -1,26 +1,148 @@
 // util_time.cpp
 #include "util_time.hpp"
 
-#include <algorithm>
+#include <charconv>
 #include <chrono>
-#include <cctype>
-#include <ctime>      // _mkgmtime / timegm
-#include <iomanip>
-#include <optional>
-#include <regex>
-#include <sstream>
+#include <cstdint>
 #include <string>
 
 namespace util {
 
-    // --- UTC tm* -> time_t portability shim ---
-    static std::time_t timegm_portable(std::tm* tm) {
-#ifdef _WIN32
-        return _mkgmtime(tm);   // MSVC / Windows
-#else
-        return timegm(tm);      // POSIX
-#endif
-    }
+    namespace {
+
+        // Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's
+        // days_from_civil). Days past the month end roll over, as with timegm.
+        constexpr std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+            y -= m <= 2;
+            const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned yoe = static_cast<unsigned>(y - era * 400);
+            const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+        }
+
+        struct Civil { std::int64_t y; unsigned m, d; };
+
+        // Inverse of days_from_civil (H. Hinnant's civil_from_days)
+        constexpr Civil civil_from_days(std::int64_t z) {
+            z += 719468;
+            const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const unsigned doe = static_cast<unsigned>(z - era * 146097);
+            const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const unsigned mp = (5 * doy + 2) / 153;
+            const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+            const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+            return {static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2), m, d};
+        }
+
+        char* put2(char* out, unsigned v) {
+            *out++ = static_cast<char>('0' + v / 10 % 10);
+            *out++ = static_cast<char>('0' + v % 10);
+            return out;
+        }
+
+        // "YYYY-MM-DD", then "<sep>HH:MM:SS" unless sep is 0; returns the end
+        // and the sub-second remainder
+        char* put_civil(char* out, TimePoint t, char sep, TimePoint::duration* frac) {
+            using namespace std::chrono;
+            const auto day = floor<days>(t);
+            const Civil c = civil_from_days(day.time_since_epoch().count());
+            if (c.y < 0 || c.y > 9999) *out++ = '?';  // outside what the parsers accept
+            else {
+                const unsigned y = static_cast<unsigned>(c.y);
+                out = put2(put2(out, y / 100), y % 100);
+            }
+            *out++ = '-';
+            out = put2(out, c.m);
+            *out++ = '-';
+            out = put2(out, c.d);
+            if (!sep) return out;
+            const auto tod = t - day;
+            const auto secs = floor<seconds>(tod).count();
+            *out++ = sep;
+            out = put2(out, static_cast<unsigned>(secs / 3600));
+            *out++ = ':';
+            out = put2(out, static_cast<unsigned>(secs / 60 % 60));
+            *out++ = ':';
+            out = put2(out, static_cast<unsigned>(secs % 60));
+            if (frac) *frac = tod - floor<seconds>(tod);
+            return out;
+        }
+
+        bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+        // Reads timestamp fields left to right; every step fails once one did
+        struct Cursor {
+            const char *p;
+            const char *end;
+            bool ok = true;
+
+            // 1..maxDigits digits within [lo, hi]
+            int num(int maxDigits, int lo, int hi) {
+                int v = 0, n = 0;
+                while (ok && n < maxDigits && p < end && is_digit(*p)) { v = v * 10 + (*p++ - '0'); ++n; }
+                if (n == 0 || v < lo || v > hi) ok = false;
+                return v;
+            }
+            void lit(char c) {
+                if (ok && p < end && *p == c) ++p;
+                else ok = false;
+            }
+            bool peek(char c) const { return ok && p < end && *p == c; }
+        };
+
+        enum Layout { kIsoT, kIsoSpace, kUS, kLayouts };
+
+        std::optional<TimePoint> parse_layout(std::string_view s, int layout) {
+            Cursor c{s.data(), s.data() + s.size()};
+            int y, mo, d;
+            if (layout == kUS) {
+                mo = c.num(2, 1, 12); c.lit('/');
+                d = c.num(2, 1, 31);  c.lit('/');
+                y = c.num(4, 0, 9999);
+                c.lit(' ');
+            } else {
+                y = c.num(4, 0, 9999); c.lit('-');
+                mo = c.num(2, 1, 12);  c.lit('-');
+                d = c.num(2, 1, 31);
+                c.lit(layout == kIsoT ? 'T' : ' ');
+            }
+            const int h = c.num(2, 0, 23); c.lit(':');
+            const int mi = c.num(2, 0, 59); c.lit(':');
+            const int sec = c.num(2, 0, 60);
+            if (!c.ok) return std::nullopt;
+
+            // Fractional seconds (nanosecond precision)
+            std::int64_t nanos = 0;
+            if ((c.peek('.') || c.peek(',')) && c.p + 1 < c.end && is_digit(c.p[1])) {
+                ++c.p;
+                std::int64_t scale = 100000000;
+                for (; c.p < c.end && is_digit(*c.p); ++c.p, scale /= 10) nanos += (*c.p - '0') * scale;
+            }
+
+            // Zone: Z, +hh, +hhmm or +hh:mm (east of UTC is positive)
+            std::int64_t offset = 0;
+            if (c.peek('Z')) {
+                ++c.p;
+            } else if ((c.peek('+') || c.peek('-')) && c.p + 2 < c.end && is_digit(c.p[1]) && is_digit(c.p[2])) {
+                const int sign = *c.p++ == '-' ? -1 : 1;
+                Cursor z{c.p, c.end};
+                const int oh = z.num(2, 0, 23);
+                int om = 0;
+                if (z.peek(':')) ++z.p;
+                if (z.p + 1 < z.end && is_digit(z.p[0]) && is_digit(z.p[1])) om = z.num(2, 0, 59);
+                if (!z.ok) return std::nullopt;
+                offset = sign * (oh * 3600 + om * 60);
+            }
+
+            const std::int64_t secs = days_from_civil(y, static_cast<unsigned>(mo), static_cast<unsigned>(d)) * 86400 +
+                                      h * 3600 + mi * 60 + sec - offset;
+            return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::seconds(secs) +
+                                                                             std::chrono::nanoseconds(nanos)));
+        }
+
+    } // namespace
 
     // Trim leading/trailing ASCII whitespace
     std::string trim(const std::string& s) {
@@ -31,76 +153,118 @@ namespace util {
         return s.substr(b, e - b + 1);
     }
 
-    // Parse a few common UTC timestamp formats into a time_point
-    std::optional<std::chrono::system_clock::time_point>
-        parse_time(const std::string& s) {
-        std::tm tm{};
-        std::istringstream ss(s);
-
-        // ISO 8601 with trailing Z
-        ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
-        if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm_portable(&tm));
-        ss.clear(); ss.str(s);
-
-        // "YYYY-MM-DD HH:MM:SS"
-        ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-        if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm_portable(&tm));
-        ss.clear(); ss.str(s);
+    std::optional<TimePoint> TimeParser::operator()(std::string_view s) {
+        if (auto t = parse_layout(s, last_)) return t;
+        for (int layout = 0; layout < kLayouts; ++layout) {
+            if (layout == last_) continue;
+            if (auto t = parse_layout(s, layout)) {
+                last_ = layout;
+                return t;
+            }
+        }
+        return std::nullopt;
+    }
 
-        // "MM/DD/YYYY HH:MM:SS"
-        ss >> std::get_time(&tm, "%m/%d/%Y %H:%M:%S");
-        if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm_portable(&tm));
+    std::optional<TimePoint> parse_time(std::string_view s) {
+        return TimeParser{}(s);
+    }
 
-        return std::nullopt;
+    void parse_times(std::span<const std::string_view> in, std::span<std::optional<TimePoint>> out) {
+        TimeParser parse;
+        for (std::size_t i = 0; i < in.size(); ++i) out[i] = parse(in[i]);
     }
 
     std::string compute_duration(const std::string& start, const std::string& end) {
-        auto s = parse_time(start);
-        auto e = parse_time(end);
+        TimeParser parse;  // end almost always shares start's layout
+        auto s = parse(start);
+        auto e = parse(end);
         if (!s || !e) return "";
         auto diff = std::chrono::duration_cast<std::chrono::seconds>(*e - *s);
         return seconds_to_hhmmss(static_cast<int>(diff.count()));
     }
 
-    std::string seconds_to_hhmmss(int seconds) {
+    char* format_hhmmss(char* out, int seconds) {
         if (seconds < 0) seconds = 0;
         const int h = seconds / 3600;
         const int m = (seconds % 3600) / 60;
         const int s = seconds % 60;
+        if (h < 10) *out++ = '0';
+        out = std::to_chars(out, out + 12, h).ptr;
+        *out++ = ':';
+        *out++ = static_cast<char>('0' + m / 10);
+        *out++ = static_cast<char>('0' + m % 10);
+        *out++ = ':';
+        *out++ = static_cast<char>('0' + s / 10);
+        *out++ = static_cast<char>('0' + s % 10);
+        return out;
+    }
 
-        std::ostringstream os;
-        os << std::setw(2) << std::setfill('0') << h << ':'
-            << std::setw(2) << std::setfill('0') << m << ':'
-            << std::setw(2) << std::setfill('0') << s;
-        return os.str();
+    std::string seconds_to_hhmmss(int seconds) {
+        char buf[16];
+        return std::string(buf, format_hhmmss(buf, seconds));
+    }
+
+    std::optional<double> size_in_gb(std::string_view text) {
+        // Leftmost "<digits>[.<digits>] <spaces> B|KB|MB|GB"; a start inside a
+        // digit run is tried too ("1.2.3 MB" reads 2.3)
+        auto upper = [](char c) { return static_cast<char>(c >= 'a' && c <= 'z' ? c - 32 : c); };
+        auto space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+        const std::size_t n = text.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!is_digit(text[i])) continue;
+            std::size_t k = i;
+            while (k < n && is_digit(text[k])) ++k;
+            if (k + 1 < n && text[k] == '.' && is_digit(text[k + 1])) {
+                k += 2;
+                while (k < n && is_digit(text[k])) ++k;
+            }
+            std::size_t u = k;
+            while (u < n && space(text[u])) ++u;
+            if (u >= n) continue;
+            double scale;
+            const char c0 = upper(text[u]);
+            if (c0 == 'B') scale = 1024.0 * 1024.0 * 1024.0;
+            else if (u + 1 < n && upper(text[u + 1]) == 'B' && c0 == 'K') scale = 1024.0 * 1024.0;
+            else if (u + 1 < n && upper(text[u + 1]) == 'B' && c0 == 'M') scale = 1024.0;
+            else if (u + 1 < n && upper(text[u + 1]) == 'B' && c0 == 'G') scale = 1.0;
+            else continue;
+            double val = 0;
+            const auto r = std::from_chars(text.data() + i, text.data() + k, val);
+            if (r.ec != std::errc()) return std::nullopt;
+            return scale == 1.0 ? val : val / scale;
+        }
+        return std::nullopt;
     }
 
     std::string size_to_gb(const std::string& text) {
-        // capture "123", "123.45" with units B/KB/MB/GB (case-insensitive)
-        static const std::regex re(R"(([0-9]+(?:\.[0-9]+)?)\s*(B|KB|MB|GB))",
-            std::regex::icase);
-
-        std::smatch m;
-        if (!std::regex_search(text, m, re)) return text;
-
-        double val = std::stod(m[1].str());
-        std::string unit = m[2].str();
-        std::transform(unit.begin(), unit.end(), unit.begin(),
-            [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
-
-        if (unit == "B")       val /= (1024.0 * 1024.0 * 1024.0);
-        else if (unit == "KB") val /= (1024.0 * 1024.0);
-        else if (unit == "MB") val /= 1024.0;
-        // GB: leave as-is
-
-        std::ostringstream os;
-        os.setf(std::ios::fixed);
-        os << std::setprecision(2) << val;
-        return os.str();
+        const auto gb = size_in_gb(text);
+        if (!gb) return text;
+        char buf[400];  // fixed notation of the largest double
+        return std::string(buf, std::to_chars(buf, buf + sizeof buf, *gb, std::chars_format::fixed, 2).ptr);
+    }
+
+    char* format_time(char* out, TimePoint t) {
+        TimePoint::duration frac{};
+        out = put_civil(out, t, 'T', &frac);
+        if (frac.count()) {
+            // Nanoseconds without trailing zeros
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(frac).count();
+            int digits = 9;
+            while (ns % 10 == 0) { ns /= 10; --digits; }
+            *out++ = '.';
+            for (int i = digits - 1; i >= 0; --i) { out[i] = static_cast<char>('0' + ns % 10); ns /= 10; }
+            out += digits;
+        }
+        *out++ = 'Z';
+        return out;
+    }
+
+    char* format_stamp(char* out, TimePoint t) {
+        return put_civil(out, t, ' ', nullptr);
     }
 
-    std::string extract_date(const std::string& ts) {
-        return ts.size() >= 10 ? ts.substr(0, 10) : std::string{};
+    char* format_date(char* out, TimePoint t) {
+        return put_civil(out, t, 0, nullptr);
     }
 
 } // namespace util
@@ -1,14 +1,51 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <optional>
+#include <span>
 #include <chrono>
 
 namespace util {
+using TimePoint = std::chrono::system_clock::time_point;
+
 std::string trim(const std::string &s);
-std::optional<std::chrono::system_clock::time_point> parse_time(const std::string &s);
+
+// UTC timestamps: "YYYY-MM-DDTHH:MM:SS", "YYYY-MM-DD HH:MM:SS" or
+// "MM/DD/YYYY HH:MM:SS", each optionally followed by fractional seconds and
+// "Z" or a "+hh[:mm]" / "-hh[:mm]" offset. Anything after that is ignored.
+std::optional<TimePoint> parse_time(std::string_view s);
+
+// parse_time that tries the layout of the previous match first; logs use one
+// layout throughout, so keep one per file.
+class TimeParser {
+public:
+    std::optional<TimePoint> operator()(std::string_view s);
+
+private:
+    int last_ = 0;
+};
+
+// Batch form with one cached layout; out.size() must be >= in.size()
+void parse_times(std::span<const std::string_view> in, std::span<std::optional<TimePoint>> out);
+
 std::string compute_duration(const std::string &start, const std::string &end);
 std::string seconds_to_hhmmss(int seconds);
+// Writes "HH:MM:SS" (hours widen past 99, negatives clamp to 0); returns the end.
+// out needs 16 bytes.
+char *format_hhmmss(char *out, int seconds);
+
+// First "<number> B|KB|MB|GB" in text (case-insensitive) converted to GB with
+// two decimals; text unchanged when there is none
 std::string size_to_gb(const std::string &text);
-std::string extract_date(const std::string &ts);
-}
+// The value in GB, without formatting
+std::optional<double> size_in_gb(std::string_view text);
 
+// UTC text of a time point; each returns the end of what it wrote into a
+// buffer of at least 32 bytes.
+// "YYYY-MM-DDTHH:MM:SSZ", with the fractional seconds when there are any
+char *format_time(char *out, TimePoint t);
+// "YYYY-MM-DD HH:MM:SS"
+char *format_stamp(char *out, TimePoint t);
+// "YYYY-MM-DD"
+char *format_date(char *out, TimePoint t);
+}
@@ -27,7 +27,7 @@ std::vector<std::string> open_logs_dialog(const wchar_t* title, bool allowMulti)
     if (title) dlg->SetTitle(title);
 
     COMDLG_FILTERSPEC filters[] = {
-        { L"Log files (*.log;*.txt)", L"*.log;*.txt" },
+        { L"Log files (*.log;*.txt;*.gz;*.zip)", L"*.log;*.txt;*.gz;*.zip" },
         { L"All files (*.*)",         L"*.*" }
     };
     dlg->SetFileTypes((UINT)(sizeof(filters)/sizeof(filters[0])), filters);
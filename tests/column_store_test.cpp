@@ -0,0 +1,190 @@
+// Master column store: lossless import and export of a TSV, appends across
+// segments, small appends merged into the last segment, zone maps, and
+// recovering the segments of a torn append.
+#include "column_store.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+using excel::CellKind;
+using excel::ColumnStore;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+static std::string yes(bool b) { return b ? "yes" : "no"; }
+
+static const std::string kHeader = "Name\tFiles\tSize\tStart\tDay\tTook\tRatio\tAt\n";
+
+// Rows [from, to): mostly values of each column's kind, with empty cells and
+// text that only looks typed ("007", "1.50", "2025-13-40") in a few of them
+static std::string lines(int from, int to) {
+    std::string out;
+    for (int i = from; i < to; ++i) {
+        const int day = 1 + i % 28, sec = i % 60;
+        out += "Project_" + std::to_string(i % 37) + '\t';
+        out += (i % 11 == 0 ? std::string() : std::to_string(i * 3 - 500)) + '\t';
+        out += std::to_string(i / 100) + '.' + (i % 100 < 10 ? "0" : "") + std::to_string(i % 100) + '\t';
+        out += "2025-08-" + std::string(day < 10 ? "0" : "") + std::to_string(day) + "T10:00:" +
+               (sec < 10 ? "0" : "") + std::to_string(sec) + "Z\t";
+        out += (i == 70001 ? std::string("2025-13-40") : "2025-08-" + std::string(day < 10 ? "0" : "") + std::to_string(day)) + '\t';
+        out += (i == 3 ? std::string("007") : std::to_string(i % 120) + ":0" + std::to_string(i % 6) + ":00") + '\t';
+        out += (i == 5 ? std::string("1.50") : std::to_string(i % 9) + ".25") + '\t';
+        out += "2025-09-01 12:00:00\n";
+    }
+    return out;
+}
+
+static std::string read_file(const fs::path &p) {
+    std::ifstream in(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_column_store_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string path = ColumnStore::path_for(dir.string());
+    const fs::path tsv = dir / "All_Exports.tsv";
+    const std::vector<std::pair<std::string, CellKind>> columns = {
+        {"Name", CellKind::Text},  {"Files", CellKind::Int},     {"Size", CellKind::Fixed2}, {"Start", CellKind::Time},
+        {"Day", CellKind::Date},   {"Took", CellKind::Duration}, {"Ratio", CellKind::Real},  {"At", CellKind::Stamp},
+    };
+
+    // Import: more rows than one segment holds, exported back byte for byte
+    const std::string first = kHeader + lines(0, 70010);
+    check("importable", yes(ColumnStore::importable(first)), "yes");
+    check("importable.crlf", yes(ColumnStore::importable(kHeader + "a\tb\r\n")), "no");
+    check("importable.ragged", yes(ColumnStore::importable(kHeader + "a\tb\n")), "no");
+    {
+        ColumnStore store(path);
+        check("absent.open", yes(store.is_open()), "no");
+        check("create", yes(store.create(columns)), "yes");
+        check("import", yes(store.append(std::string_view(first).substr(kHeader.size()), first.size())), "yes");
+        check("import.rows", std::to_string(store.rows()), "70010");
+        check("import.segments", std::to_string(store.segments()), "2");
+    }
+    {
+        ColumnStore store(path);
+        check("reopen.open", yes(store.is_open()), "yes");
+        check("reopen.recovered", yes(store.recovered()), "no");
+        check("reopen.rows", std::to_string(store.rows()), "70010");
+        check("reopen.export", yes(store.export_tsv(tsv.string())), "yes");
+        check("reopen.lossless", yes(read_file(tsv) == first), "yes");
+
+        std::string cell;
+        store.append_cell(cell, 1, 70001 - ColumnStore::kSegmentRows, 4);
+        check("cell.fallback", cell, "2025-13-40");
+        cell.clear();
+        store.append_cell(cell, 0, 3, 5);
+        check("cell.text", cell, "007");
+
+        const auto &files = store.zone(0, 1);
+        check("zone.empty", std::to_string(files.empty), "5958");
+        check("zone.min", std::to_string(static_cast<std::int64_t>(files.min)), "-497");
+        check("zone.max", std::to_string(static_cast<std::int64_t>(files.max)), std::to_string(65535 * 3 - 500));
+        check("zone.text", std::string(store.zone(0, 0).minText) + ".." + std::string(store.zone(0, 0).maxText),
+              "Project_0..Project_9");
+
+        // Append: the export size recorded matches the TSV once it is written
+        const std::string more = lines(70010, 70100);
+        check("append", yes(store.append(more, first.size() + more.size())), "yes");
+        std::ofstream(tsv, std::ios::binary | std::ios::app) << more;
+        check("append.rows", std::to_string(store.rows()), "70100");
+    }
+    const std::string whole = first + lines(70010, 70100);
+    {
+        ColumnStore store(path);
+        check("synced.rows", std::to_string(store.rows()), "70100");
+        check("synced.bytes", std::to_string(store.export_bytes()), std::to_string(whole.size()));
+
+        // A TSV that lost lines is exported again from the store
+        fs::resize_file(tsv, 100);
+        check("resync.export", yes(store.export_tsv(tsv.string())), "yes");
+        check("resync.lossless", yes(read_file(tsv) == whole), "yes");
+    }
+
+    // Runs that add a row each go into the short last segment instead of a
+    // segment apiece; it is closed once it holds kMergeRows rows
+    {
+        ColumnStore store(path);
+        bool appended = true;
+        for (int i = 70100; i < 70300; ++i) appended = store.append(lines(i, i + 1), 0) && appended;
+        check("small.append", yes(appended), "yes");
+        check("small.segments", std::to_string(store.segments()), "2");
+        check("small.rows", std::to_string(store.segment_rows(1)), std::to_string(70300 - ColumnStore::kSegmentRows));
+        check("fill.append", yes(store.append(lines(70300, 78000), 0)), "yes");
+        check("fill.segments", std::to_string(store.segments()), "2");
+        check("fill.closed", yes(store.segment_rows(1) >= ColumnStore::kMergeRows), "yes");
+    }
+    const std::string grown = whole + lines(70100, 78000);
+    {
+        ColumnStore store(path);
+        check("merged.recovered", yes(store.recovered()), "no");
+        check("merged.rows", std::to_string(store.rows()), "78000");
+        check("merged.export", yes(store.export_tsv(tsv.string())), "yes");
+        check("merged.lossless", yes(read_file(tsv) == grown), "yes");
+        check("merged.next", yes(store.append(lines(78000, 78001), 0)), "yes");
+        check("merged.segments", std::to_string(store.segments()), "3");
+        check("merged.tail", yes(store.append(lines(78001, 78002), 0)), "yes");
+        check("merged.tail.segments", std::to_string(store.segments()), "3");
+        check("merged.ragged", yes(store.append("only\tthree\tcells\n", 0)), "no");
+        check("merged.kept", std::to_string(store.rows()), "78002");
+    }
+    {
+        ColumnStore store(path);
+        check("merged.reopen", std::to_string(store.rows()), "78002");
+        check("merged.reexport", yes(store.export_tsv(tsv.string())), "yes");
+        check("merged.relossless", yes(read_file(tsv) == grown + lines(78000, 78002)), "yes");
+    }
+
+    // A torn append: the new segment (written over the old footer, and
+    // longer than it) cut short at the old file size, no footer. The store
+    // is first put back to a last segment too long to be rewritten.
+    std::ofstream(tsv, std::ios::binary | std::ios::trunc) << grown;
+    fs::remove(path);
+    {
+        ColumnStore store(path);
+        check("grown.create", yes(store.create(columns)), "yes");
+        check("grown.import", yes(store.append(std::string_view(grown).substr(kHeader.size()), grown.size())), "yes");
+        check("grown.segments", std::to_string(store.segments()), "2");
+    }
+    const auto before = fs::file_size(path);
+    {
+        ColumnStore store(path);
+        check("torn.append", yes(store.append(lines(78000, 78100), 0)), "yes");
+        check("torn.segments", std::to_string(store.segments()), "3");
+    }
+    fs::resize_file(path, before);
+    {
+        ColumnStore store(path);
+        check("torn.open", yes(store.is_open()), "yes");
+        check("torn.recovered", yes(store.recovered()), "yes");
+        check("torn.rows", std::to_string(store.rows()), "78000");
+        check("torn.bytes", std::to_string(store.export_bytes()), "0");
+        check("torn.export", yes(store.export_tsv(tsv.string())), "yes");
+        check("torn.lossless", yes(read_file(tsv) == grown), "yes");
+    }
+    {
+        // The recovered store takes appends again
+        ColumnStore store(path);
+        check("after.recovered", yes(store.recovered()), "no");
+        check("after.append", yes(store.append(lines(78000, 78001), 1)), "yes");
+        check("after.rows", std::to_string(store.rows()), "78001");
+        check("after.ragged", yes(store.append("only\tthree\tcells\n", 1)), "no");
+    }
+
+    fs::remove_all(dir);
+    if (failures) return 1;
+    std::puts("column_store_test OK");
+    return 0;
+}
@@ -0,0 +1,73 @@
+// External sort: spilled runs and multi-pass merges give the same order as a
+// stable in-memory sort, and the run files are cleaned up.
+#include "external_sort.hpp"
+#include "single_sheet_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+static std::string yes(bool b) { return b ? "yes" : "no"; }
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_external_sort_test";
+    fs::remove_all(dir);
+
+    // Few distinct keys, so stability matters; payloads number the records
+    std::mt19937 rng(7);
+    std::vector<std::pair<std::string, std::string>> records;
+    for (int i = 0; i < 60000; ++i) {
+        std::string key = "2025-0" + std::to_string(1 + rng() % 9) + "\tNODE" + std::to_string(rng() % 13);
+        if (i % 1000 == 0) key.push_back('\0');
+        records.emplace_back(std::move(key), "row " + std::to_string(i) + std::string(rng() % 40, 'x'));
+    }
+    auto want = records;
+    std::stable_sort(want.begin(), want.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::string expected;
+    for (const auto &r : want) expected.append(r.second).push_back('\n');
+
+    for (const std::size_t limit : {std::size_t{1} << 30, std::size_t{128} << 10, std::size_t{1} << 20}) {
+        const std::string name = std::to_string(limit >> 10) + "k";
+        std::string got;
+        std::size_t runs = 0;
+        {
+            util::ExternalSorter sorter(dir.string(), limit);
+            bool added = true;
+            for (const auto &r : records) added &= sorter.add(r.first, r.second);
+            check((name + ".add").c_str(), yes(added), "yes");
+            runs = sorter.runs();
+            const bool ok = sorter.finish([&](std::string_view p) { got.append(p).push_back('\n'); });
+            check((name + ".finish").c_str(), yes(ok), "yes");
+            check((name + ".records").c_str(), std::to_string(sorter.records()), "60000");
+        }
+        check((name + ".order").c_str(), yes(got == expected), "yes");
+        check((name + ".spilled").c_str(), yes(runs > 0), limit < (std::size_t{1} << 30) ? "yes" : "no");
+        check((name + ".cleaned").c_str(), yes(fs::exists(dir)), "no");
+    }
+
+    // Sort specs name master columns; '-' marks a descending key
+    excel::MasterSort sort;
+    check("spec.parse", yes(excel::parse_master_sort("RunDate,-Machine,ProjectName,Tool", sort)), "yes");
+    check("spec.keys", std::to_string(sort.keys.size()), "4");
+    check("spec.desc", sort.keys[1].column + (sort.keys[1].descending ? " desc" : ""), "Machine desc");
+    check("spec.unknown", yes(excel::parse_master_sort("RunDate,Bogus", sort)), "no");
+    check("spec.empty", yes(excel::parse_master_sort("", sort) && sort.keys.empty()), "yes");
+
+    if (failures) return 1;
+    std::puts("external_sort_test OK");
+    return 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+// The istringstream/get_time/regex versions of util_time that the hand-written
+// parsers replaced; kept for the equivalence test and bench_time.
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string>
+
+namespace legacy {
+
+inline std::time_t timegm_portable(std::tm *tm) {
+#ifdef _WIN32
+    return _mkgmtime(tm);
+#else
+    return timegm(tm);
+#endif
+}
+
+inline std::optional<std::chrono::system_clock::time_point> parse_time(const std::string &s) {
+    std::tm tm{};
+    std::istringstream ss(s);
+    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+    if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm_portable(&tm));
+    ss.clear(); ss.str(s);
+    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm_portable(&tm));
+    ss.clear(); ss.str(s);
+    ss >> std::get_time(&tm, "%m/%d/%Y %H:%M:%S");
+    if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm_portable(&tm));
+    return std::nullopt;
+}
+
+inline std::string seconds_to_hhmmss(int seconds) {
+    if (seconds < 0) seconds = 0;
+    std::ostringstream os;
+    os << std::setw(2) << std::setfill('0') << seconds / 3600 << ':'
+       << std::setw(2) << std::setfill('0') << (seconds % 3600) / 60 << ':'
+       << std::setw(2) << std::setfill('0') << seconds % 60;
+    return os.str();
+}
+
+inline std::string compute_duration(const std::string &start, const std::string &end) {
+    auto s = parse_time(start);
+    auto e = parse_time(end);
+    if (!s || !e) return "";
+    auto diff = std::chrono::duration_cast<std::chrono::seconds>(*e - *s);
+    return seconds_to_hhmmss(static_cast<int>(diff.count()));
+}
+
+inline std::string size_to_gb(const std::string &text) {
+    static const std::regex re(R"(([0-9]+(?:\.[0-9]+)?)\s*(B|KB|MB|GB))", std::regex::icase);
+    std::smatch m;
+    if (!std::regex_search(text, m, re)) return text;
+    double val = std::stod(m[1].str());
+    std::string unit = m[2].str();
+    std::transform(unit.begin(), unit.end(), unit.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    if (unit == "B") val /= (1024.0 * 1024.0 * 1024.0);
+    else if (unit == "KB") val /= (1024.0 * 1024.0);
+    else if (unit == "MB") val /= 1024.0;
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os << std::setprecision(2) << val;
+    return os.str();
+}
+
+} // namespace legacy
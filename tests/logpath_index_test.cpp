@@ -0,0 +1,152 @@
+// Master LogPath index: incremental appends, catching up with lines written
+// behind its back, and rebuilding when the TSV or the index is replaced.
+#include "logpath_index.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+static std::string yes(bool b) { return b ? "yes" : "no"; }
+
+static std::string path_of(int i) { return "D:\\logs\\run_" + std::to_string(i) + ".log"; }
+
+// Append rows i in [from, to) the way the master writer does, indexing them
+static void append_rows(const std::string &tsv, int from, int to, excel::LogPathIndex *index) {
+    const bool fresh = !fs::exists(tsv);
+    std::ofstream out(tsv, std::ios::app | std::ios::binary);
+    out.seekp(0, std::ios::end);
+    std::uint64_t offset = static_cast<std::uint64_t>(out.tellp());
+    if (fresh) {
+        const std::string header = "ProjectName\tLogPath\tIngestedAt\n";
+        out << header;
+        offset += header.size();
+    }
+    for (int i = from; i < to; ++i) {
+        const std::string line = "P" + std::to_string(i % 7) + "\t" + path_of(i) + "\t2025-01-01 00:00:00\n";
+        out << line;
+        if (index) index->add(path_of(i), offset);
+        offset += line.size();
+    }
+}
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_logpath_index_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string tsv = (dir / "All_Exports.tsv").string();
+
+    {
+        // No master yet: empty, and the index is written once the TSV exists
+        excel::LogPathIndex index(tsv);
+        check("empty.size", std::to_string(index.size()), "0");
+        check("empty.contains", yes(index.contains(path_of(1))), "no");
+        append_rows(tsv, 0, 5000, &index);
+        check("empty.save", yes(index.save()), "yes");
+    }
+    {
+        excel::LogPathIndex index(tsv);
+        check("reopen.rebuilt", yes(index.rebuilt()), "no");
+        check("reopen.size", std::to_string(index.size()), "5000");
+        bool all = true;
+        for (int i = 0; i < 5000; ++i) all &= index.contains(path_of(i));
+        check("reopen.all", yes(all), "yes");
+        check("reopen.absent", yes(index.contains(path_of(5000))), "no");
+        check("reopen.prefix", yes(index.contains("D:\\logs\\run_1")), "no");
+
+        // A few rows go to the tail, in place
+        append_rows(tsv, 5000, 5010, &index);
+        check("tail.save", yes(index.save()), "yes");
+    }
+    {
+        excel::LogPathIndex index(tsv);
+        check("tail.rebuilt", yes(index.rebuilt()), "no");
+        check("tail.size", std::to_string(index.size()), "5010");
+        check("tail.contains", yes(index.contains(path_of(5005))), "yes");
+        check("tail.old", yes(index.contains(path_of(17))), "yes");
+    }
+
+    // Lines appended without the index are picked up when it is opened
+    append_rows(tsv, 5010, 5020, nullptr);
+    {
+        excel::LogPathIndex index(tsv);
+        check("catchup.rebuilt", yes(index.rebuilt()), "no");
+        check("catchup.size", std::to_string(index.size()), "5020");
+        check("catchup.contains", yes(index.contains(path_of(5015))), "yes");
+
+        // Enough new rows to merge the tail into the sorted table
+        append_rows(tsv, 5020, 8000, &index);
+        check("merge.save", yes(index.save()), "yes");
+    }
+    {
+        excel::LogPathIndex index(tsv);
+        check("merge.rebuilt", yes(index.rebuilt()), "no");
+        check("merge.size", std::to_string(index.size()), "8000");
+        bool all = true;
+        for (int i = 0; i < 8000; ++i) all &= index.contains(path_of(i));
+        check("merge.all", yes(all), "yes");
+        check("merge.absent", yes(index.contains(path_of(8000))), "no");
+    }
+
+    // A rewritten master (same length, other content) is rescanned
+    {
+        std::string text;
+        {
+            std::ifstream in(tsv, std::ios::binary);
+            text.assign(std::istreambuf_iterator<char>(in), {});
+        }
+        const auto at = text.find(path_of(3) + "\t");
+        text.replace(at, path_of(3).size(), "D:\\logs\\run_X.log");
+        std::ofstream(tsv, std::ios::binary | std::ios::trunc) << text;
+        excel::LogPathIndex index(tsv);
+        check("rewrite.rebuilt", yes(index.rebuilt()), "yes");
+        check("rewrite.old", yes(index.contains(path_of(3))), "no");
+        check("rewrite.new", yes(index.contains("D:\\logs\\run_X.log")), "yes");
+        check("rewrite.save", yes(index.save()), "yes");
+    }
+
+    // A corrupt index is rebuilt from the TSV
+    {
+        std::ofstream(excel::LogPathIndex::path_for(tsv), std::ios::binary | std::ios::app) << "junk";
+        excel::LogPathIndex index(tsv);
+        check("corrupt.rebuilt", yes(index.rebuilt()), "yes");
+        check("corrupt.size", std::to_string(index.size()), "8000");
+        check("corrupt.contains", yes(index.contains(path_of(7999))), "yes");
+        check("corrupt.save", yes(index.save()), "yes");
+    }
+
+    // A save that cannot write the index (here a folder is in its way) fails,
+    // and every entry, old and new, can still be looked up
+    {
+        const std::string idx = excel::LogPathIndex::path_for(tsv);
+        excel::LogPathIndex tailOnly(tsv);
+        excel::LogPathIndex merged(tsv);
+        fs::remove(idx);
+        fs::create_directories(fs::path(idx) / "blocked");
+        append_rows(tsv, 8000, 8010, &tailOnly);
+        check("blocked.tail.save", yes(tailOnly.save()), "no");
+        check("blocked.tail.old", yes(tailOnly.contains(path_of(10))), "yes");
+        check("blocked.tail.new", yes(tailOnly.contains(path_of(8005))), "yes");
+        append_rows(tsv, 8010, 10000, &merged);
+        check("blocked.merge.save", yes(merged.save()), "no");
+        check("blocked.merge.old", yes(merged.contains(path_of(10))), "yes");
+        check("blocked.merge.new", yes(merged.contains(path_of(9999))), "yes");
+        fs::remove_all(idx);
+    }
+
+    fs::remove_all(dir);
+    if (failures) return 1;
+    std::puts("logpath_index_test OK");
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Merging partial masters: order by IngestedAt across inputs, LogPath and
+// content de-duplication, headers mapped by name; and --shard input splits.
+#include "columns.hpp"
+#include "ingest.hpp"
+#include "master_merge.hpp"
+#include "single_sheet_writer.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+static constexpr std::size_t kProject = excel::column_index(excel::kMasterColumns, "ProjectName");
+static constexpr std::size_t kMachine = excel::column_index(excel::kMasterColumns, "Machine");
+static constexpr std::size_t kLogPath = excel::column_index(excel::kMasterColumns, "LogPath");
+static constexpr std::size_t kIngestedAt = excel::column_index(excel::kMasterColumns, "IngestedAt");
+
+// A master line: the project, its log, when it was ingested (seconds)
+static std::string row(const std::string &project, const std::string &log, int at) {
+    std::string line;
+    for (std::size_t c = 0; c < excel::kMasterColumns.size(); ++c) {
+        if (c) line.push_back('\t');
+        if (c == kProject) line += project;
+        if (c == kMachine) line += "NODE1";
+        if (c == kLogPath) line += "D:\\logs\\" + log;
+        if (c == kIngestedAt) line += "2025-09-01 12:00:0" + std::to_string(at);
+    }
+    return line + '\n';
+}
+
+static void write(const fs::path &p, const std::string &text) { std::ofstream(p, std::ios::binary) << text; }
+
+static std::string read(const fs::path &p) {
+    std::ifstream in(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+// Projects of a merged master's rows, in order
+static std::string projects(const std::string &tsv) {
+    std::string out;
+    std::size_t line = 0;
+    for (std::size_t from = 0; from < tsv.size(); ++line) {
+        const std::size_t nl = tsv.find('\n', from);
+        if (line) out += (line > 1 ? " " : "") + tsv.substr(from, tsv.find('\t', from) - from);
+        from = nl + 1;
+    }
+    return out;
+}
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_master_merge_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    std::string header;
+    excel::append_tsv_header(header, excel::kMasterColumns);
+    write(dir / "a.tsv", header + row("a1", "a1.log", 1) + row("a2", "a2.log", 3) + row("a3", "a3.log", 5));
+    write(dir / "b.tsv", header + row("b1", "b1.log", 2) + row("b2", "b2.log", 3) + row("b3", "a2.log", 4));
+    // An older layout: three columns, in another order
+    write(dir / "c.tsv", "IngestedAt\tLogPath\tProjectName\n2025-09-01 12:00:00\tD:\\logs\\c1.log\tc1\n\n");
+    write(dir / "d.tsv", "Name\tSize\nx\t1\n");
+    // a1 again under another path, in another run
+    write(dir / "e.tsv", header + row("a1", "copy\\a1.log", 6));
+
+    const std::vector<std::string> inputs = {(dir / "a.tsv").string(), (dir / "b.tsv").string(),
+                                             (dir / "c.tsv").string(), (dir / "d.tsv").string(),
+                                             (dir / "e.tsv").string(), (dir / "absent.tsv").string()};
+    {
+        excel::MergeStats stats;
+        check("merge", excel::merge_masters(inputs, (dir / "out.tsv").string(), {}, stats) ? "ok" : "failed", "ok");
+        const std::string out = read(dir / "out.tsv");
+        check("order", projects(out), "c1 a1 b1 a2 b2 a3 a1");
+        check("rows", std::to_string(stats.rows), "7");
+        check("duplicates", std::to_string(stats.duplicates), "1");
+        check("skipped", std::to_string(stats.skipped.size()), "2");
+        check("header", out.substr(0, header.size()), header);
+        check("mapped", out.substr(header.size(), out.find('\n', header.size()) - header.size()),
+              [&] {
+                  std::string want(excel::kMasterColumns.size() - 1, '\t');
+                  want.insert(kIngestedAt, "2025-09-01 12:00:00");
+                  want.insert(kLogPath, "D:\\logs\\c1.log");
+                  want.insert(kProject, "c1");
+                  return want;
+              }());
+    }
+    {
+        excel::MergeStats stats;
+        excel::MergeOptions options;
+        options.dedupeContent = true;
+        excel::merge_masters(inputs, (dir / "out.tsv").string(), options, stats);
+        check("content.order", projects(read(dir / "out.tsv")), "c1 a1 b1 a2 b2 a3");
+        check("content.duplicates", std::to_string(stats.duplicates), "2");
+    }
+
+    // Shards: every log in exactly one of them, the same one every time
+    LogInputs logs;
+    for (int i = 0; i < 200; ++i) logs.detect.push_back("\\\\farm\\logs\\run_" + std::to_string(i) + ".log");
+    std::set<std::string> seen;
+    std::size_t total = 0;
+    for (unsigned s = 0; s < 4; ++s) {
+        const auto shard = select_shard(logs, s, 4);
+        total += shard.detect.size();
+        seen.insert(shard.detect.begin(), shard.detect.end());
+        check("shard.nonempty", shard.detect.empty() ? "empty" : "some", "some");
+        check("shard.stable", select_shard(logs, s, 4).detect == shard.detect ? "yes" : "no", "yes");
+    }
+    check("shard.total", std::to_string(total), "200");
+    check("shard.disjoint", std::to_string(seen.size()), "200");
+    LogInputs slashed;
+    slashed.detect.push_back("//farm/logs/run_7.log");
+    LogInputs one;
+    one.detect.push_back(logs.detect[7]);
+    for (unsigned s = 0; s < 4; ++s)
+        check("shard.separators", std::to_string(select_shard(slashed, s, 4).detect.size()),
+              std::to_string(select_shard(one, s, 4).detect.size()));
+
+    fs::remove_all(dir);
+    if (failures) return 1;
+    std::puts("master_merge_test OK");
+    return 0;
+}
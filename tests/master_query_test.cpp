@@ -0,0 +1,180 @@
+// Master queries: predicates on typed and text columns, date periods, zone-map
+// skipping, the LogPath index, and the same answers from a TSV-only master.
+#include "column_store.hpp"
+#include "columns.hpp"
+#include "logpath_index.hpp"
+#include "master_query.hpp"
+#include "util_time.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using excel::ColumnStore;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+constexpr int kRows = 150000;  // three segments
+
+static std::string errors_of(int i) { return i % 97 == 0 ? "Error: tile " + std::to_string(i % 5) + " failed" : ""; }
+
+// Row i runs on day i / 1000 of 2025; one TotalFiles cell is not a number
+static std::string master_text() {
+    using excel::column_index;
+    using excel::kMasterColumns;
+    std::string text;
+    excel::append_tsv_header(text, kMasterColumns);
+    std::vector<std::string> cells(kMasterColumns.size());
+    const auto jan1 = util::TimePoint(std::chrono::seconds(1735689600));
+    char buf[32];
+    for (int i = 0; i < kRows; ++i) {
+        cells[column_index(kMasterColumns, "ProjectName")] = "Project_" + std::to_string(i % 50);
+        cells[column_index(kMasterColumns, "Tool")] = i % 3 ? "PhotoMesh" : "RealityMesh";
+        cells[column_index(kMasterColumns, "Duration(hh:mm:ss)")] = util::seconds_to_hhmmss(i % 7200);
+        cells[column_index(kMasterColumns, "RunDate")] =
+            std::string(buf, util::format_date(buf, jan1 + std::chrono::hours(24) * (i / 1000)));
+        cells[column_index(kMasterColumns, "Machine")] = "NODE" + std::to_string(i % 8);
+        cells[column_index(kMasterColumns, "TotalFiles")] = i == 70000 ? "n/a" : std::to_string(i % 1000);
+        const int cents = i % 10000;
+        cells[column_index(kMasterColumns, "TotalSize(GB)")] =
+            std::to_string(cents / 100) + '.' + (cents % 100 < 10 ? "0" : "") + std::to_string(cents % 100);
+        cells[column_index(kMasterColumns, "Errors")] = errors_of(i);
+        cells[column_index(kMasterColumns, "LogPath")] = "D:\\logs\\run_" + std::to_string(i) + ".log";
+        cells[column_index(kMasterColumns, "IngestedAt")] = "2025-06-01 00:00:00";
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            if (c) text.push_back('\t');
+            text += cells[c];
+        }
+        text.push_back('\n');
+    }
+    return text;
+}
+
+struct Result {
+    std::string text;  // header and rows as TSV
+    std::size_t matches = 0, skipped = 0;
+    std::string plan, error;
+};
+
+static Result run(const fs::path &dir, const std::vector<std::string> &where, const std::vector<std::string> &columns = {}) {
+    excel::Query q;
+    for (const auto &w : where) {
+        excel::QueryPredicate p;
+        if (!excel::parse_query_predicate(w, p)) return {"", 0, 0, "", "unparsed " + w};
+        q.where.push_back(p);
+    }
+    q.columns = columns;
+    Result r;
+    excel::QueryStats stats;
+    const bool ok = excel::query_master(dir.string(), q, [&](std::span<const std::string_view> cells) {
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            if (c) r.text.push_back('\t');
+            r.text.append(cells[c]);
+        }
+        r.text.push_back('\n');
+    }, stats, r.error);
+    if (!ok) return r;
+    r.matches = stats.matches;
+    r.skipped = stats.skipped;
+    r.plan = stats.plan;
+    return r;
+}
+
+template <class F>
+static std::string count(F &&pred) {
+    int n = 0;
+    for (int i = 0; i < kRows; ++i) n += pred(i);
+    return std::to_string(n);
+}
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_master_query_test";
+    const fs::path plain = dir / "tsv_only";
+    fs::remove_all(dir);
+    fs::create_directories(plain);
+
+    // The same master with a column store and as a TSV alone
+    const std::string text = master_text();
+    std::ofstream(dir / "All_Exports.tsv", std::ios::binary) << text;
+    std::ofstream(plain / "All_Exports.tsv", std::ios::binary) << text;
+    {
+        std::vector<std::pair<std::string, excel::CellKind>> columns;
+        for (const auto &c : excel::kMasterColumns) columns.emplace_back(std::string(c.name), c.kind);
+        ColumnStore store(ColumnStore::path_for(dir.string()));
+        const std::size_t header = text.find('\n') + 1;
+        check("store", std::to_string(store.create(columns) && store.append(std::string_view(text).substr(header), text.size())), "1");
+    }
+    check("index.saved", std::to_string(excel::LogPathIndex((dir / "All_Exports.tsv").string()).save()), "1");
+    check("index.saved.plain", std::to_string(excel::LogPathIndex((plain / "All_Exports.tsv").string()).save()), "1");
+
+    struct Case {
+        const char *name;
+        std::vector<std::string> where;
+        std::string want;
+    };
+    const std::vector<Case> cases = {
+        {"day", {"RunDate=2025-01-05"}, "1000"},
+        {"month.range", {"RunDate>=2025-05", "TotalFiles<10"}, "300"},
+        {"after.month", {"RunDate>2025-04"}, std::to_string(kRows - 120000)},
+        {"before.day", {"rundate<2025-01-03"}, "2000"},
+        {"through.day", {"RunDate<=2025-01-03"}, "3000"},
+        {"timestamp", {"RunDate>=2025-01-02 00:00:00", "RunDate<2025-01-03T00:00:00Z"}, "1000"},
+        {"year", {"RunDate=2025"}, std::to_string(kRows)},
+        {"contains", {"Errors~TILE 3"}, count([](int i) { return i % 97 == 0 && i % 5 == 3; })},
+        {"no.errors", {"Errors="}, count([](int i) { return i % 97 != 0; })},
+        {"size", {"TotalSize>=99.5"}, count([](int i) { return i % 10000 >= 9950; })},
+        {"duration", {"Duration<0:00:10"}, count([](int i) { return i % 7200 < 10; })},
+        {"ne.text.cell", {"TotalFiles!=5"}, std::to_string(kRows - kRows / 1000)},
+        {"text.eq", {"Machine=NODE3", "Tool=RealityMesh"}, count([](int i) { return i % 8 == 3 && i % 3 == 0; })},
+        {"text.none", {"Machine=NODE9"}, "0"},
+    };
+    for (const auto &c : cases) {
+        const Result store = run(dir, c.where), scan = run(plain, c.where);
+        check((std::string(c.name) + ".error").c_str(), store.error + scan.error, "");
+        check(c.name, std::to_string(store.matches), c.want);
+        check((std::string(c.name) + ".plans").c_str(), store.plan + "/" + scan.plan, "store/scan");
+        check((std::string(c.name) + ".same").c_str(), std::to_string(store.text == scan.text), "1");
+    }
+
+    // Zone maps: a day in the first segment rules out the other two
+    check("skip.day", std::to_string(run(dir, {"RunDate=2025-01-05"}).skipped), "2");
+    check("skip.none", std::to_string(run(dir, {"Machine=NODE9"}).skipped), "3");
+
+    // The LogPath index, with a projection; a cell that is no number
+    const Result one = run(dir, {"LogPath=D:\\logs\\run_123.log"}, {"projectname", "TotalFiles"});
+    check("index.plan", one.plan, "index");
+    check("index.rows", one.text, "ProjectName\tTotalFiles\nProject_23\t123\n");
+    check("index.plain", run(plain, {"LogPath=D:\\logs\\run_123.log", "TotalFiles=123"}, {"LogPath"}).text,
+          "LogPath\nD:\\logs\\run_123.log\n");
+    check("index.absent", std::to_string(run(dir, {"LogPath=D:\\logs\\run_x.log"}).matches), "0");
+    check("text.cell", run(dir, {"TotalFiles=n/a"}).error.empty() ? "parsed" : "rejected", "rejected");
+    check("text.cell.row", run(dir, {"LogPath~run_70000.", "TotalFiles!=0"}, {"TotalFiles"}).text, "TotalFiles\nn/a\n");
+
+    // Predicates that do not fit the master
+    check("unknown", run(dir, {"Nope=1"}).error, "Unknown column 'Nope' in --where");
+    check("ambiguous", run(dir, {"Offset=1"}).error, "Unknown column 'Offset' in --where");
+    check("bad.date", run(dir, {"RunDate=June"}).error.empty() ? "no" : "yes", "yes");
+    check("range.empty", run(dir, {"Errors>"}).error, "--where on Errors: a range needs a value");
+    check("contains.typed", run(dir, {"TotalFiles~1"}).error.empty() ? "no" : "yes", "yes");
+    check("columns", run(dir, {}, {"Nope"}).error, "Unknown column 'Nope' in --columns");
+    excel::QueryPredicate p;
+    check("parse.none", std::to_string(excel::parse_query_predicate("RunDate", p)), "0");
+    check("parse.ge", std::to_string(excel::parse_query_predicate(" TotalFiles >= 5 ", p) && p.column == "TotalFiles" &&
+                                     p.op == excel::QueryPredicate::Op::Ge && p.value == "5"), "1");
+
+    fs::remove_all(dir);
+    if (failures) return 1;
+    std::puts("master_query_test OK");
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Concurrent master appends: several processes append to one outputs folder
+// at once, with LogPaths of their own and LogPaths they all share. Every row
+// must land in the master exactly once, and the journal must end up empty.
+// A journal entry left by a run that died is committed by the next run.
+#include "column_store.hpp"
+#include "line_reader.hpp"
+#include "single_sheet_writer.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+constexpr int kWorkers = 6;
+constexpr int kRounds = 5;
+constexpr int kOwnPerRound = 8;
+constexpr int kShared = 10;
+
+// One worker: kRounds appends of its own rows plus every shared row
+static int worker(const std::string &dir, int id) {
+    for (int round = 0; round < kRounds; ++round) {
+        std::vector<PhotoMeshRow> pm;
+        for (int j = 0; j < kOwnPerRound; ++j) {
+            auto &r = pm.emplace_back();
+            r.projectName = "Node" + std::to_string(id);
+            r.logPath = "node" + std::to_string(id) + "/run_" + std::to_string(round * kOwnPerRound + j) + ".log";
+        }
+        for (int j = 0; j < kShared; ++j) {
+            auto &r = pm.emplace_back();
+            r.projectName = "Shared";
+            r.logPath = "shared/run_" + std::to_string(j) + ".log";
+        }
+        std::string error;
+        if (!excel::append_to_master_and_rebuild_xlsx(dir, excel::unify(pm, {}), error)) {
+            std::fprintf(stderr, "worker %d: %s\n", id, error.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Each master LogPath and how often it occurs
+static std::map<std::string, int> master_paths(const fs::path &tsv, int &headers) {
+    std::map<std::string, int> paths;
+    util::MappedFile f(tsv.string());
+    std::string_view rest = f.data(), line;
+    headers = 0;
+    while (util::next_line(rest, line)) {
+        if (line.rfind("ProjectName\t", 0) == 0) { ++headers; continue; }
+        std::string_view cell = line;
+        for (std::size_t c = 0; c < excel::column_index(excel::kMasterColumns, "LogPath"); ++c)
+            cell.remove_prefix(cell.find('\t') + 1);
+        ++paths[std::string(cell.substr(0, cell.find('\t')))];
+    }
+    return paths;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && std::string(argv[1]) == "worker") return worker(argv[2], std::atoi(argv[3]));
+
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_master_stress_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string self = fs::absolute(argv[0]).string(), out = dir.string();
+
+    // All workers at once, as separate processes
+    std::vector<std::string> ids;
+    for (int i = 0; i < kWorkers; ++i) ids.push_back(std::to_string(i));
+#ifdef _WIN32
+    std::vector<intptr_t> children;
+    for (int i = 0; i < kWorkers; ++i) {
+        const char *args[] = {self.c_str(), "worker", out.c_str(), ids[i].c_str(), nullptr};
+        children.push_back(_spawnv(_P_NOWAIT, self.c_str(), args));
+    }
+    for (auto h : children) {
+        int status = 1;
+        _cwait(&status, h, 0);
+        check("worker.exit", std::to_string(status), "0");
+    }
+#else
+    std::vector<pid_t> children;
+    for (int i = 0; i < kWorkers; ++i) {
+        char *args[] = {self.data(), const_cast<char *>("worker"), out.data(), ids[i].data(), nullptr};
+        pid_t pid = 0;
+        if (posix_spawn(&pid, self.c_str(), nullptr, nullptr, args, environ) == 0) children.push_back(pid);
+    }
+    check("workers.started", std::to_string(children.size()), std::to_string(kWorkers));
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        check("worker.exit", std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1), "0");
+    }
+#endif
+
+    const fs::path tsv = dir / "All_Exports.tsv";
+    int headers = 0;
+    auto paths = master_paths(tsv, headers);
+    const int expected = kWorkers * kRounds * kOwnPerRound + kShared;
+    check("headers", std::to_string(headers), "1");
+    check("rows", std::to_string(paths.size()), std::to_string(expected));
+    int repeated = 0;
+    for (const auto &[path, n] : paths) repeated += n != 1;
+    check("duplicates", std::to_string(repeated), "0");
+    check("own", std::to_string(paths.count("node5/run_39.log")), "1");
+    check("store.rows", std::to_string(excel::ColumnStore(excel::ColumnStore::path_for(out)).rows()),
+          std::to_string(expected));
+    check("journal.empty", fs::is_empty(dir / "All_Exports.journal") ? "yes" : "no", "yes");
+
+    // A run that journaled its rows and died before committing them
+    std::string line;
+    {
+        PhotoMeshRow r;
+        r.projectName = "Crashed";
+        r.logPath = "crashed/run.log";
+        std::vector<PhotoMeshRow> pm{r};
+        for (const auto &u : excel::unify(pm, {})) excel::append_tsv_line(line, excel::kMasterColumns, u);
+    }
+    std::ofstream(dir / "All_Exports.journal" / "00000000000000000001-orphan.tsv", std::ios::binary) << line;
+    std::string error;
+    check("replay.ok", std::to_string(excel::append_to_master_and_rebuild_xlsx(out, {}, error)), "1");
+    paths = master_paths(tsv, headers);
+    check("replay.rows", std::to_string(paths.size()), std::to_string(expected + 1));
+    check("replay.row", std::to_string(paths["crashed/run.log"]), "1");
+    check("replay.journal", fs::is_empty(dir / "All_Exports.journal") ? "yes" : "no", "yes");
+
+    // Replayed again (say, the run died after the master write): no new row
+    std::ofstream(dir / "All_Exports.journal" / "00000000000000000002-orphan.tsv", std::ios::binary) << line;
+    check("again.ok", std::to_string(excel::append_to_master_and_rebuild_xlsx(out, {}, error)), "1");
+    paths = master_paths(tsv, headers);
+    check("again.rows", std::to_string(paths.size()), std::to_string(expected + 1));
+
+    fs::remove_all(dir);
+    if (failures) return 1;
+    std::puts("master_stress_test OK");
+    return 0;
+}
@@ -0,0 +1,347 @@
+// The native workbook writer against what the master's cells should be:
+// typed values and number formats, strings that need escaping, blocks joined
+// into one sheet, the table, frozen header, widths and Success formats, the
+// same bytes whatever the thread count, and the same cells as libxlsxwriter's
+// workbook when the linked library writes one.
+#include "archive_reader.hpp"
+#include "columns.hpp"
+#include "line_reader.hpp"
+#include "native_xlsx.hpp"
+#include "single_sheet_writer.hpp"
+#include "util_time.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+using excel::column_index;
+using excel::kMasterColumns;
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+// A cell as Excel reads it: a string ('s'), boolean ('b') or number ('n') and
+// the number format it is shown with
+struct Cell {
+    char type = 0;
+    std::string text;
+    double number = 0;
+    std::string format = "General";
+};
+
+static bool same(const Cell &a, const Cell &b) {
+    if (a.type != b.type || a.format != b.format) return false;
+    if (a.type != 'n') return a.text == b.text;
+    return std::fabs(a.number - b.number) <= 1e-9 * std::max(1.0, std::fabs(b.number));
+}
+
+static std::string show(const Cell &c) {
+    return std::string(1, c.type ? c.type : '-') + ":" + (c.type == 'n' ? std::to_string(c.number) : c.text) + "@" + c.format;
+}
+
+using Sheet = std::map<std::pair<std::size_t, std::size_t>, Cell>;  // (row, column), 0-based
+
+// ---------- reading a workbook back ----------
+
+static std::string part(const util::ZipDirectory &zip, std::string_view name) {
+    const util::ZipEntry *e = zip.find(name);
+    if (!e) return {};
+    util::Inflater in(util::Inflater::Format::RawDeflate, zip.data(*e));
+    std::string out(e->size, '\0');
+    std::size_t got = 0;
+    while (got < out.size()) {
+        const std::size_t n = in.read(out.data() + got, out.size() - got);
+        if (!n) break;
+        got += n;
+    }
+    out.resize(got);
+    return out;
+}
+
+static std::string attr(std::string_view tag, std::string_view name) {
+    const std::string key = " " + std::string(name) + "=\"";
+    const std::size_t at = tag.find(key);
+    if (at == std::string_view::npos) return {};
+    const std::size_t from = at + key.size();
+    return std::string(tag.substr(from, tag.find('"', from) - from));
+}
+
+static std::string unescape(std::string_view s) {
+    std::string out;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '&') {
+            const std::size_t semi = s.find(';', i);
+            const std::string_view e = s.substr(i, semi - i + 1);
+            out.push_back(e == "&amp;" ? '&' : e == "&lt;" ? '<' : e == "&gt;" ? '>' : e == "&quot;" ? '"' : '\'');
+            i = semi;
+        } else if (s.substr(i, 2) == "_x" && i + 7 <= s.size() && s[i + 6] == '_') {
+            out.push_back(static_cast<char>(std::strtol(std::string(s.substr(i + 2, 4)).c_str(), nullptr, 16)));
+            i += 6;
+        } else {
+            out.push_back(s[i]);
+        }
+    }
+    return out;
+}
+
+// Text between each <tag ...> and </tag>, with the opening tag
+static std::vector<std::pair<std::string_view, std::string_view>> elements(std::string_view xml, std::string_view tag) {
+    std::vector<std::pair<std::string_view, std::string_view>> out;
+    const std::string open = "<" + std::string(tag), close = "</" + std::string(tag) + ">";
+    for (std::size_t at = 0; (at = xml.find(open, at)) != std::string_view::npos;) {
+        const char next = xml[at + open.size()];
+        if (next != ' ' && next != '>' && next != '/') { ++at; continue; }
+        const std::size_t end = xml.find('>', at);
+        const std::string_view head = xml.substr(at, end - at + 1);
+        std::string_view body;
+        if (head[head.size() - 2] != '/') {
+            const std::size_t stop = xml.find(close, end);
+            body = xml.substr(end + 1, stop - end - 1);
+        }
+        out.emplace_back(head, body);
+        at = end + 1;
+    }
+    return out;
+}
+
+static std::size_t column_of(std::string_view ref) {
+    std::size_t c = 0;
+    for (const char ch : ref) {
+        if (ch < 'A' || ch > 'Z') break;
+        c = c * 26 + static_cast<std::size_t>(ch - 'A' + 1);
+    }
+    return c - 1;
+}
+
+static std::size_t row_of(std::string_view ref) {
+    return std::strtoull(std::string(ref.substr(ref.find_first_of("0123456789"))).c_str(), nullptr, 10) - 1;
+}
+
+struct Workbook {
+    bool ok = false;
+    Sheet cells;
+    std::string sheet, workbook, table, styles;
+};
+
+static Workbook read_workbook(const fs::path &path) {
+    Workbook wb;
+    util::MappedFile file(path.string());
+    util::ZipDirectory zip(file.data());
+    if (!zip.ok()) return wb;
+    wb.sheet = part(zip, "xl/worksheets/sheet1.xml");
+    wb.workbook = part(zip, "xl/workbook.xml");
+    wb.table = part(zip, "xl/tables/table1.xml");
+    wb.styles = part(zip, "xl/styles.xml");
+
+    // Number format of each cell style
+    std::map<std::string, std::string> codes = {{"0", "General"}, {"2", "0.00"}, {"46", "[h]:mm:ss"}};
+    for (const auto &[tag, body] : elements(wb.styles, "numFmt")) codes[attr(tag, "numFmtId")] = unescape(attr(tag, "formatCode"));
+    std::vector<std::string> formats;
+    for (const auto &[xfs, body] : elements(wb.styles, "cellXfs"))
+        for (const auto &[tag, none] : elements(body, "xf")) formats.push_back(codes[attr(tag, "numFmtId")]);
+    std::vector<std::string> shared;
+    for (const auto &[tag, body] : elements(part(zip, "xl/sharedStrings.xml"), "si")) {
+        std::string text;
+        for (const auto &[t, inner] : elements(body, "t")) text += unescape(inner);
+        shared.push_back(text);
+    }
+
+    for (const auto &[tag, body] : elements(wb.sheet, "c")) {
+        const std::string ref = attr(tag, "r"), type = attr(tag, "t"), style = attr(tag, "s");
+        Cell c;
+        if (!style.empty()) c.format = formats.at(std::stoul(style));
+        const auto value = elements(body, "v");
+        const std::string v = value.empty() ? "" : std::string(value[0].second);
+        if (type == "inlineStr" || type == "str") {
+            c.type = 's';
+            for (const auto &[t, inner] : elements(body, "t")) c.text += unescape(inner);
+            if (type == "str") c.text = unescape(v);
+        } else if (type == "s") {
+            c.type = 's';
+            c.text = shared.at(std::stoul(v));
+        } else if (type == "b") {
+            c.type = 'b';
+            c.text = v;
+        } else {
+            c.type = 'n';
+            c.number = std::strtod(v.c_str(), nullptr);
+        }
+        wb.cells[{row_of(ref), column_of(ref)}] = c;
+    }
+    wb.ok = !wb.sheet.empty();
+    return wb;
+}
+
+static std::string first_diff(const Sheet &got, const Sheet &want) {
+    for (const auto &[at, w] : want) {
+        const auto g = got.find(at);
+        if (g == got.end() || !same(g->second, w))
+            return std::to_string(at.first) + "," + std::to_string(at.second) + " " +
+                   (g == got.end() ? std::string("missing") : show(g->second)) + " want " + show(w);
+    }
+    for (const auto &[at, g] : got)
+        if (!want.count(at)) return std::to_string(at.first) + "," + std::to_string(at.second) + " extra " + show(g);
+    return "";
+}
+
+// ---------- the master written ----------
+
+constexpr std::size_t kRows = 40000;  // several blocks
+
+static Cell text(std::string s) { return {'s', std::move(s)}; }
+static Cell number(double v, std::string format = "General") { return {'n', "", v, std::move(format)}; }
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "logtoexcel_native_xlsx_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    // The master TSV and the sheet it should give: 2025-01-01 is day 45658
+    std::string tsv;
+    excel::append_tsv_header(tsv, kMasterColumns);
+    Sheet want;
+    for (std::size_t c = 0; c < kMasterColumns.size(); ++c) want[{0, c}] = text(std::string(kMasterColumns[c].name));
+    std::vector<std::string> cells(kMasterColumns.size());
+    const auto jan1 = util::TimePoint(std::chrono::seconds(1735689600));
+    char buf[40];
+    for (std::size_t i = 0; i < kRows; ++i) {
+        const std::size_t row = i + 1;
+        auto set = [&](std::string_view name, std::string cell, Cell expect) {
+            const std::size_t c = column_index(kMasterColumns, name);
+            cells[c] = std::move(cell);
+            if (!cells[c].empty()) want[{row, c}] = std::move(expect);
+        };
+        for (auto &cell : cells) cell.clear();
+        std::string project = "Project_" + std::to_string(i % 50);
+        if (i == 7) project = "A & B <c> \"q\"";
+        if (i == 8) project = " leading space";
+        if (i == 9) project = std::string("bell\x07here");
+        if (i == 10) project = "Ünïcødé ✓";
+        set("ProjectName", project, text(project));
+        set("Tool", i % 3 ? "PhotoMesh" : "RealityMesh", text(i % 3 ? "PhotoMesh" : "RealityMesh"));
+        const auto start = jan1 + std::chrono::minutes(i);
+        set("StartTime", std::string(buf, util::format_time(buf, start)),
+            number(45658 + static_cast<double>(i) / 1440, "yyyy-mm-dd hh:mm:ss"));
+        if (i == 11) set("StartTime", "1899-12-31T00:00:00Z", text("1899-12-31T00:00:00Z"));
+        if (i == 12) set("StartTime", "1900-01-01T12:00:00Z", number(1.5, "yyyy-mm-dd hh:mm:ss"));
+        if (i == 13) set("StartTime", "1900-03-01T00:00:00Z", number(61, "yyyy-mm-dd hh:mm:ss"));
+        set("Duration(hh:mm:ss)", util::seconds_to_hhmmss(static_cast<int>(i % 7200)),
+            number(static_cast<double>(i % 7200) / 86400, "[h]:mm:ss"));
+        set("RunDate", std::string(buf, util::format_date(buf, start)), number(45658 + static_cast<double>(i / 1440), "yyyy-mm-dd"));
+        set("TotalFiles", std::to_string(i % 1000), number(static_cast<double>(i % 1000)));
+        if (i == 14) set("TotalFiles", "n/a", text("n/a"));
+        const std::size_t cents = i % 10000;
+        set("TotalSize(GB)", std::to_string(cents / 100) + '.' + (cents % 100 < 10 ? "0" : "") + std::to_string(cents % 100),
+            number(static_cast<double>(cents) / 100, "0.00"));
+        set("OffsetX", i % 2 ? "-12.5" : "", number(-12.5));
+        set("Success", i % 5 == 0 ? "" : i % 3 ? "True" : "False", {'b', i % 3 ? "1" : "0"});
+        const std::string log = "D:\\logs\\run_" + std::to_string(i) + ".log";
+        set("LogPath", log, text(log));
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            if (c) tsv.push_back('\t');
+            tsv += cells[c];
+        }
+        tsv.push_back('\n');
+    }
+    const fs::path master = dir / "All_Exports.tsv";
+    std::ofstream(master, std::ios::binary) << tsv;
+
+    const fs::path nativeXlsx = dir / "native.xlsx", lxwXlsx = dir / "libxlsxwriter.xlsx";
+    excel::write_tsv_workbook(master.string(), nativeXlsx.string(), excel::WorkbookBackend::Native);
+    excel::write_tsv_workbook(master.string(), lxwXlsx.string(), excel::WorkbookBackend::Libxlsxwriter);
+
+    const Workbook native = read_workbook(nativeXlsx);
+    check("native.read", std::to_string(native.ok), "1");
+    check("native.cells", first_diff(native.cells, want), "");
+
+    // Layout: a table over the rows, the header frozen, widths as
+    // libxlsxwriter stores 22, green and red for Success
+    const std::string last = "AQ" + std::to_string(kRows + 1);
+    check("table.ref", attr(elements(native.table, "table").at(0).first, "ref"), "A1:" + last);
+    check("table.columns", attr(elements(native.table, "tableColumns").at(0).first, "count"),
+          std::to_string(kMasterColumns.size()));
+    check("pane", attr(elements(native.sheet, "pane").at(0).first, "state"), "frozen");
+    check("width", attr(elements(native.sheet, "col").at(0).first, "width"), "22.7109375");
+    const auto rules = elements(native.sheet, "conditionalFormatting");
+    check("success.range", rules.size() == 1 ? attr(rules[0].first, "sqref") : "", "AM2:AM" + std::to_string(kRows + 1));
+    std::string formulas;
+    for (const auto &[tag, body] : elements(rules.empty() ? "" : rules[0].second, "formula")) formulas += std::string(body) + ";";
+    check("success.values", formulas, "TRUE;FALSE;");
+    check("success.fills", std::to_string(native.styles.find("FF008000") != std::string::npos &&
+                                          native.styles.find("FFFF0000") != std::string::npos), "1");
+
+    // Thread count changes nothing that is read back
+    auto direct = [&](const fs::path &path, unsigned jobs) {
+        excel::SheetLayout layout;
+        layout.name = "All_Exports";
+        for (const auto &c : kMasterColumns) {
+            layout.headers.emplace_back(c.name);
+            layout.kinds.push_back(c.kind);
+        }
+        layout.table = true;
+        layout.successColumn = static_cast<int>(column_index(kMasterColumns, "Success"));
+        excel::NativeSheetWriter writer(path.string(), layout, jobs);
+        std::string_view rest(tsv), line;
+        util::next_line(rest, line);
+        std::vector<std::string_view> fields;
+        while (util::next_line(rest, line)) {
+            fields.clear();
+            for (std::size_t from = 0;;) {
+                const std::size_t tab = line.find('\t', from);
+                fields.push_back(line.substr(from, tab - from));
+                if (tab == std::string_view::npos) break;
+                from = tab + 1;
+            }
+            writer.add_row(fields);
+        }
+        return writer.close();
+    };
+    auto bytes = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+    check("one.thread", std::to_string(direct(dir / "one.xlsx", 1)), "1");
+    check("four.threads", std::to_string(direct(dir / "four.xlsx", 4)), "1");
+    check("threads.same", std::to_string(bytes(dir / "one.xlsx") == bytes(dir / "four.xlsx")), "1");
+    check("threads.as.rebuild", std::to_string(bytes(dir / "one.xlsx") == bytes(nativeXlsx)), "1");
+    // The sheet's local header reserves zip64 sizes (version 45, a 20-byte
+    // extra field), however small the sheet
+    const std::string one = bytes(dir / "one.xlsx");
+    const std::size_t name = one.find("xl/worksheets/sheet1.xml");
+    const auto u16 = [&](std::size_t at) {
+        return std::to_string(static_cast<unsigned char>(one[at]) | static_cast<unsigned char>(one[at + 1]) << 8);
+    };
+    check("zip64.version", name >= 30 ? u16(name - 30 + 4) : "", "45");
+    check("zip64.extra", name >= 30 ? u16(name - 30 + 28) : "", "20");
+
+    // libxlsxwriter's workbook, when the library linked in writes one: the
+    // same cells (its sheet has an autofilter where the native one has a table)
+    const Workbook lxw = read_workbook(lxwXlsx);
+    if (lxw.ok) {
+        check("libxlsxwriter.cells", first_diff(native.cells, lxw.cells), "");
+        check("libxlsxwriter.autofilter", attr(elements(lxw.sheet, "autoFilter").at(0).first, "ref"), "A1:" + last);
+        check("libxlsxwriter.pane", attr(elements(lxw.sheet, "pane").at(0).first, "state"), "frozen");
+        check("libxlsxwriter.width", attr(elements(lxw.sheet, "col").at(0).first, "width"), "22.7109375");
+    } else {
+        std::puts("libxlsxwriter wrote no workbook here; native cells checked against the TSV only");
+    }
+
+    fs::remove_all(dir);
+    if (failures) return 1;
+    std::puts("native_xlsx_test OK");
+    return 0;
+}
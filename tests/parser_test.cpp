@@ -0,0 +1,410 @@
+// Field-level checks for the log parsers against the sample logs.
+#include "archive_reader.hpp"
+#include "extract_rules.hpp"
+#include "ingest.hpp"
+#include "line_reader.hpp"
+#include "photomesh_parser.hpp"
+#include "realitymesh_parser.hpp"
+#include "scan_kernel.hpp"
+#include "single_sheet_writer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::string dir = argc > 1 ? argv[1] : ".";
+
+    PhotoMeshRow pm = parse_photomesh(dir + "/sample_pm.log");
+    check("pm.machine", to_text(pm.machine), "MACHINE1");
+    check("pm.startTime", to_text(pm.startTime), "2025-08-20T17:59:55Z");
+    check("pm.endTime", to_text(pm.endTime), "2025-08-20T18:59:55Z");
+    check("pm.duration", to_text(pm.duration), "01:00:00");
+    check("pm.exportType", to_text(pm.exportType), "3MX");
+    check("pm.resolution", to_text(pm.resolution), "HIGH");
+    check("pm.tileScheme", to_text(pm.tileScheme), "QTM");
+    check("pm.photosUsed", to_text(pm.photosUsed), "1200");
+    check("pm.fusersUsed", to_text(pm.fusersUsed), "4");
+    check("pm.outputFolder", to_text(pm.outputFolder), "C:\\\\Exports");
+    check("pm.totalFiles", to_text(pm.totalFiles), "20");
+    check("pm.totalSizeGB", gb_text(pm.totalSizeGB), "2.00");
+    check("pm.success", to_text(pm.success), "True");
+    check("pm.warnings", tally_text(pm.warnings), "");
+    check("pm.errors", tally_text(pm.errors), "");
+
+    RealityMeshRow rm = parse_realitymesh(dir + "/sample_rm.log");
+    check("rm.datasetName", rm.datasetName, "dataset1.txt");
+    check("rm.offsetX", to_text(rm.offsetX), "100");
+    check("rm.offsetY", to_text(rm.offsetY), "200");
+    check("rm.offsetZ", to_text(rm.offsetZ), "300");
+    check("rm.duration", to_text(rm.duration), "00:00:10");
+    check("rm.success", to_text(rm.success), "True");
+    check("rm.errors", rm.errors, "No models imported");
+
+    // Gzip logs (two members here) and zip entries parse like the plain logs
+    {
+        PhotoMeshRow gz = parse_photomesh(dir + "/sample_pm.log.gz");
+        check("gz.projectName", gz.projectName, "sample_pm");
+        check("gz.row", to_text(gz.machine) + to_text(gz.startTime) + to_text(gz.endTime) + gb_text(gz.totalSizeGB) + to_text(gz.success),
+              to_text(pm.machine) + to_text(pm.startTime) + to_text(pm.endTime) + gb_text(pm.totalSizeGB) + to_text(pm.success));
+
+        const std::string zip = dir + "/sample_logs.zip";
+        const auto entries = util::expand_archives({zip, dir + "/sample_rm.log"});
+        check("zip.count", std::to_string(entries.size()), "3");
+        check("zip.entry", entries.at(1), zip + "!/logs/sample_rm.log");
+        check("zip.plain", entries.at(2), dir + "/sample_rm.log");
+
+        ParsedLogs z = parse_logs({entries.at(0)}, {entries.at(1)}, 2);
+        check("zip.pm.logPath", z.pm[0].logPath, zip + "!/logs/sample_pm.log");
+        check("zip.pm.projectName", z.pm[0].projectName, "sample_pm");
+        check("zip.pm.row", to_text(z.pm[0].machine) + to_text(z.pm[0].duration) + to_text(z.pm[0].exportType),
+              to_text(pm.machine) + to_text(pm.duration) + to_text(pm.exportType));
+        check("zip.rm.row", z.rm[0].datasetName + to_text(z.rm[0].offsetZ) + to_text(z.rm[0].duration) + z.rm[0].errors,
+              rm.datasetName + to_text(rm.offsetZ) + to_text(rm.duration) + rm.errors);
+
+        RealityMeshRow missing = parse_realitymesh(zip + "!/logs/nope.log");
+        check("zip.missing", missing.projectName + to_text(missing.success), "nope");
+    }
+
+    // A zip64 extra field that claims more bytes than the extra area holds is
+    // ignored rather than read past the end of the directory
+    {
+        auto put = [](std::string &out, std::uint64_t v, int bytes) {
+            for (int i = 0; i < bytes; ++i) out += static_cast<char>(v >> (8 * i) & 0xff);
+        };
+        std::string z;
+        put(z, 0x02014b50, 4);
+        z.append(16, '\0');
+        put(z, 0xffffffff, 4);   // compressed size
+        put(z, 0xffffffff, 4);   // size
+        put(z, 1, 2);            // name length
+        put(z, 4, 2);            // extra length
+        z.append(14, '\0');
+        z += 'a';
+        put(z, 1, 2);            // zip64 field ...
+        put(z, 0xfff0, 2);       // ... claiming 65520 bytes
+        const std::size_t cdSize = z.size();
+        put(z, 0x06054b50, 4);
+        z.append(4, '\0');
+        put(z, 1, 2);
+        put(z, 1, 2);
+        put(z, cdSize, 4);
+        put(z, 0, 4);
+        put(z, 0, 2);
+        const util::ZipDirectory dir(z);
+        const util::ZipEntry *e = dir.find("a");
+        check("zip.extra", e ? std::to_string(e->size) : "missing", "4294967295");
+        check("zip.find", std::to_string(dir.find("b") == nullptr), "1");
+    }
+
+    // Bare paths are classified from their first lines and parsed once by
+    // the matching parser; anything else is reported, not turned into a row
+    {
+        check("sniff.pm", std::to_string(int(sniff_log("x\n\"MsgTime\": 1\n"))), std::to_string(int(LogKind::PhotoMesh)));
+        check("sniff.rm", std::to_string(int(sniff_log("x\nConverted offset: 1 2 3\nSLDEFAULT=> A : b\n"))),
+              std::to_string(int(LogKind::RealityMesh)));
+        check("sniff.none", std::to_string(int(sniff_log("hello\nworld"))), std::to_string(int(LogKind::Unknown)));
+
+        const auto junk = (std::filesystem::temp_directory_path() / "parser_test_junk.txt").string();
+        std::ofstream(junk) << "nothing to see\n";
+        LogInputs in;
+        in.detect = util::expand_archives({dir + "/sample_rm.log", junk, dir + "/sample_pm.log.gz",
+                                           dir + "/sample_logs.zip"});
+        ParsedLogs got = parse_logs(in, 2);
+        check("detect.pm", std::to_string(got.pm.size()), "2");
+        check("detect.rm", std::to_string(got.rm.size()), "2");
+        check("detect.unknown", got.unknown.size() == 1 ? got.unknown[0] : "", junk);
+        check("detect.pm.first", got.pm.at(0).logPath, dir + "/sample_pm.log.gz");
+        check("detect.rm.first", got.rm.at(0).datasetName, rm.datasetName);
+        check("detect.rm.zip", got.rm.at(1).logPath, dir + "/sample_logs.zip!/logs/sample_rm.log");
+        std::filesystem::remove(junk);
+    }
+
+    // CRLF line endings and a missing final newline parse the same
+    {
+        std::ifstream src(dir + "/sample_pm.log", std::ios::binary);
+        std::stringstream ss; ss << src.rdbuf();
+        std::string text = ss.str(), crlf;
+        for (char c : text) { if (c == '\n') crlf += '\r'; crlf += c; }
+        while (!crlf.empty() && (crlf.back() == '\n' || crlf.back() == '\r')) crlf.pop_back();
+        const auto tmp = (std::filesystem::temp_directory_path() / "parser_test_crlf.log").string();
+        std::ofstream(tmp, std::ios::binary) << crlf;
+        PhotoMeshRow c = parse_photomesh(tmp);
+        check("crlf.endTime", to_text(c.endTime), to_text(pm.endTime));
+        check("crlf.exportType", to_text(c.exportType), to_text(pm.exportType));
+        check("crlf.totalSizeGB", gb_text(c.totalSizeGB), gb_text(pm.totalSizeGB));
+        check("crlf.success", to_text(c.success), to_text(pm.success));
+        std::filesystem::remove(tmp);
+    }
+
+    // A log truncated by rotation while it is mapped reads zeros past the cut
+    // instead of faulting, and is parsed again as it is now
+    {
+        const auto tmp = (std::filesystem::temp_directory_path() / "parser_test_rotated.log").string();
+        std::ifstream src(dir + "/sample_pm.log", std::ios::binary);
+        std::stringstream ss; ss << src.rdbuf();
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            for (int i = 0; i < 100000; ++i) out << "Warning: line " << i << "\n";
+        }
+        {
+            util::LineReader in(tmp);
+            std::filesystem::resize_file(tmp, 0);
+            size_t lines = 0;
+            std::string_view line;
+            while (in.next(line)) ++lines;
+            check("rotated.truncated", std::to_string(in.truncated()), "1");
+            check("rotated.lines", std::to_string(lines), "1");
+            check("rotated.read_at", std::to_string(in.read_at(0, 100).size()), "0");
+        }
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            for (int i = 0; i < 100000; ++i) out << "Warning: line " << i << "\n";
+        }
+        OpenLog log(tmp, util::file_stamp(tmp));
+        std::ofstream(tmp, std::ios::binary) << ss.str();
+        TailEntry tail;
+        PhotoMeshRow r = parse_photomesh(log, tmp, ParseOptions{}, &tail);
+        check("rotated.endTime", to_text(r.endTime), to_text(pm.endTime));
+        check("rotated.success", to_text(r.success), to_text(pm.success));
+        check("rotated.offset", std::to_string(tail.offset <= ss.str().size()), "1");
+        std::filesystem::remove(tmp);
+    }
+
+    // Parallel ingestion keeps input order
+    {
+        std::vector<std::string> pms, rms;
+        for (int i = 0; i < 16; ++i) {
+            pms.push_back(dir + (i % 2 ? "/sample_pm.log" : "/missing.log"));
+            rms.push_back(dir + (i % 3 ? "/sample_rm.log" : "/missing.log"));
+        }
+        ParsedLogs got = parse_logs(pms, rms, 4);
+        for (size_t i = 0; i < pms.size(); ++i) {
+            check("jobs.pm.logPath", got.pm[i].logPath, pms[i]);
+            check("jobs.pm.machine", to_text(got.pm[i].machine), i % 2 ? to_text(pm.machine) : "");
+        }
+        for (size_t i = 0; i < rms.size(); ++i) {
+            check("jobs.rm.logPath", got.rm[i].logPath, rms[i]);
+            check("jobs.rm.errors", got.rm[i].errors, i % 3 ? rm.errors : "");
+        }
+    }
+
+    // Chunked parsing merges into the same row as a sequential pass
+    {
+        const auto tmp = (std::filesystem::temp_directory_path() / "parser_test_chunks.log").string();
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            for (int i = 0; i < 400; ++i) {
+                out << "[Msg] { \"MachineName\": \"NODE" << i % 7 << "\", \"MsgTime\": \"2025-08-20T17:"
+                    << 10 + i % 40 << ":00Z\" }\n";
+                if (i % 13 == 0) out << "SLDEFAULT=> TileScheme : T" << i << "\n";
+                if (i == 97) out << "SLDEFAULT=> Trim :\n";
+                if (i % 29 == 0) out << "Warning: slow tile\r\n";
+                if (i % 31 == 0) out << "Error: tile " << i << "\n";
+                if (i % 37 == 0) out << "Error:\n";
+                if (i % 41 == 0) out << "Converted offset: " << i << " 2 3\n";
+                if (i % 53 == 0) out << "Finished with exit code (" << i % 2 << ")\n";
+                if (i % 61 == 0) out << "Time to run TT project: " << i << " seconds\n";
+            }
+        }
+        ParseOptions chunked;
+        chunked.threads = 4;
+        chunked.chunkBytes = 64;
+        PhotoMeshRow a = parse_photomesh(tmp), b = parse_photomesh(tmp, chunked);
+        check("chunk.pm.machine", to_text(b.machine), to_text(a.machine));
+        check("chunk.pm.startTime", to_text(b.startTime), to_text(a.startTime));
+        check("chunk.pm.endTime", to_text(b.endTime), to_text(a.endTime));
+        check("chunk.pm.tileScheme", to_text(b.tileScheme), to_text(a.tileScheme));
+        check("chunk.pm.trim", to_text(b.trim), to_text(a.trim));
+        check("chunk.pm.warnings", tally_text(b.warnings), tally_text(a.warnings));
+        check("chunk.pm.errors", tally_text(b.errors), tally_text(a.errors));
+        check("chunk.pm.success", to_text(b.success), to_text(a.success));
+        RealityMeshRow c = parse_realitymesh(tmp), d = parse_realitymesh(tmp, chunked);
+        check("chunk.rm.offsetX", to_text(d.offsetX), to_text(c.offsetX));
+        check("chunk.rm.duration", to_text(d.duration), to_text(c.duration));
+        check("chunk.rm.errors", errors_text(d.errorCount, d.errors), errors_text(c.errorCount, c.errors));
+        check("chunk.rm.success", to_text(d.success), to_text(c.success));
+        std::filesystem::remove(tmp);
+    }
+
+    // Resuming from a saved state gives the same rows as a full parse, for
+    // appends that cut a line in half and for truncated or replaced files
+    {
+        namespace fs = std::filesystem;
+        const auto tmp = (fs::temp_directory_path() / "parser_test_tail.log").string();
+        const auto storeFile = (fs::temp_directory_path() / "parser_test_tail.state").string();
+        std::ostringstream gen;
+        for (int i = 0; i < 120; ++i) {
+            gen << "{ \"MachineName\": \"NODE" << i % 5 << "\", \"MsgTime\": \"2025-08-20T17:" << 10 + i % 40
+                << ":00Z\" }\n";
+            if (i % 11 == 0) gen << "SLDEFAULT=> TileScheme : T" << i << "\n";
+            if (i % 17 == 0) gen << "Warning: slow\nError: tile " << i << "\nError:\n";
+            if (i % 23 == 0) gen << "Converted offset: " << i << " 2 3\nProcess completed with exit code: 1\n";
+        }
+        const std::string text = gen.str();
+        auto write = [&](const std::string &bytes) { std::ofstream(tmp, std::ios::binary) << bytes; };
+        auto same = [&](const char *what) {
+            ParseStateStore store;
+            store.load(storeFile);
+            ParsedLogs got = parse_logs({tmp}, {tmp}, 1, &store);
+            check(what, std::to_string(store.save(storeFile)), "1");
+            const PhotoMeshRow a = parse_photomesh(tmp);
+            const RealityMeshRow c = parse_realitymesh(tmp);
+            const PhotoMeshRow &b = got.pm[0];
+            const RealityMeshRow &d = got.rm[0];
+            auto pmText = [](const PhotoMeshRow &r) {
+                return to_text(r.machine) + to_text(r.startTime) + to_text(r.endTime) + to_text(r.tileScheme) +
+                       tally_text(r.warnings) + tally_text(r.errors) + to_text(r.success);
+            };
+            auto rmText = [](const RealityMeshRow &r) {
+                return to_text(r.offsetX) + to_text(r.success) + errors_text(r.errorCount, r.errors);
+            };
+            check(what, pmText(b), pmText(a));
+            check(what, rmText(d), rmText(c));
+        };
+        fs::remove(storeFile);
+        for (size_t cut : {size_t(0), text.size() / 3 + 5, text.size() / 2, text.size() - 1, text.size()}) {
+            write(text.substr(0, cut));
+            same("tail.append");
+        }
+        {
+            ParseStateStore store;
+            store.load(storeFile);
+            check("tail.offset", std::to_string(store.get(ParseStateStore::key("PhotoMesh", tmp)).offset),
+                  std::to_string(text.size()));
+        }
+        write(text.substr(0, text.size() / 4));
+        same("tail.truncated");
+        std::string replaced = text;
+        replaced[10] = 'X';
+        write(replaced);
+        same("tail.replaced");
+        fs::remove(tmp);
+        fs::remove(storeFile);
+    }
+
+    // Two runs that loaded the same store keep each other's entries when they save
+    {
+        namespace fs = std::filesystem;
+        const auto storeFile = (fs::temp_directory_path() / "parser_test_shared_state").string();
+        fs::remove(storeFile);
+        TailEntry e;
+        e.offset = 7;
+        e.state = "s";
+        ParseStateStore first, second;
+        first.load(storeFile);
+        second.load(storeFile);
+        first.put("a", e);
+        second.put("b", e);
+        check("shared.save1", std::to_string(first.save(storeFile)), "1");
+        check("shared.save2", std::to_string(second.save(storeFile)), "1");
+        ParseStateStore both;
+        both.load(storeFile);
+        check("shared.entries", std::to_string(both.entries().size()), "2");
+        first.put("a", TailEntry{});
+        check("shared.erase", std::to_string(first.save(storeFile)), "1");
+        both.load(storeFile);
+        check("shared.kept", std::to_string(both.entries().size()) + both.entries().begin()->first, "1b");
+        fs::remove(storeFile);
+        fs::remove(storeFile + ".lock");
+    }
+
+    // A log with an unchanged size and settled mtime is served from the store
+    // without being read; copies of one log are flagged as duplicate content
+    {
+        namespace fs = std::filesystem;
+        const auto a = (fs::temp_directory_path() / "parser_test_cache_a.log").string();
+        const auto b = (fs::temp_directory_path() / "parser_test_cache_b.log").string();
+        const auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+        std::ofstream(a, std::ios::binary) << "{ \"MachineName\": \"OLD\" }\nWarning: x\nFinished with exit code (0)";
+        fs::last_write_time(a, old);
+        fs::copy_file(a, b, fs::copy_options::overwrite_existing);
+
+        ParseStateStore store;
+        ParsedLogs first = parse_logs({a, b}, {}, 1, &store);
+        check("cache.first", to_text(first.pm[0].machine) + tally_text(first.pm[0].warnings) + to_text(first.pm[0].success), "OLD1True");
+        check("cache.dups", std::to_string(first.pmDuplicates.size()), "1");
+        check("cache.dup", std::to_string(first.pmDuplicates.at(0)), "1");
+
+        // Same size and mtime: the rewritten content is deliberately not seen.
+        // The first path stored with a content owns it; only its copies are flagged
+        std::ofstream(a, std::ios::binary) << "{ \"MachineName\": \"NEW\" }\nWarning: x\nFinished with exit code (0)";
+        fs::last_write_time(a, old);
+        ParsedLogs cached = parse_logs({a}, {}, 1, &store);
+        check("cache.hit", to_text(cached.pm[0].machine) + tally_text(cached.pm[0].warnings) + to_text(cached.pm[0].success), "OLD1True");
+        check("cache.hit.dups", std::to_string(cached.pmDuplicates.size()), "0");
+        ParsedLogs copy = parse_logs({b}, {}, 1, &store);
+        check("cache.copy.dups", std::to_string(copy.pmDuplicates.size()), "1");
+        ParsedLogs both = parse_logs({b, a}, {}, 1, &store);
+        check("cache.both.dups", std::to_string(both.pmDuplicates.size()) + std::to_string(both.pmDuplicates.at(0)), "10");
+
+        // A new mtime with different content is reparsed
+        fs::last_write_time(a, old + std::chrono::minutes(1));
+        ParsedLogs fresh = parse_logs({a}, {}, 1, &store);
+        check("cache.miss", to_text(fresh.pm[0].machine), "NEW");
+        check("cache.miss.dups", std::to_string(fresh.pmDuplicates.size()), "0");
+        const auto kept = excel::unify(first.pm, first.rm, first.pmDuplicates, first.rmDuplicates);
+        check("cache.unify", std::to_string(kept.size()) + std::to_string(kept.at(0).photomesh() == &first.pm[0]), "11");
+        fs::remove(a);
+        fs::remove(b);
+    }
+
+    // A key listed twice resolves to its first index; an empty anchor is refused
+    {
+        constexpr extract::Rule rules[] = {{"=>", extract::Shape::KeyValue, 0}};
+        constexpr std::string_view keys[] = {"Trim", "Tile", "Trim", "Tile", "Out"};
+        const extract::Matcher m(rules, keys);
+        check("matcher.dup", std::to_string(m.key_index("Trim")) + std::to_string(m.key_index("Tile")) +
+                                 std::to_string(m.key_index("Out")) + std::to_string(m.key_index("In")),
+              "014-1");
+        constexpr extract::Rule empty[] = {{"", extract::Shape::Rest, 0}};
+        bool threw = false;
+        try { extract::Matcher bad(empty); } catch (const std::invalid_argument &) { threw = true; }
+        check("matcher.empty", std::to_string(threw), "1");
+    }
+
+    // Every scan kernel counts exactly what a per-line find loop counts
+    {
+        constexpr std::string_view kw[] = {"Warning", "Error", "E", "Error:"};
+        const char pieces[][12] = {"Warning", "Error:", "Err", "E", "\n", "\r\n", "xx", "WarnError", " "};
+        unsigned seed = 7;
+        for (int round = 0; round < 200; ++round) {
+            std::string buf;
+            const int n = round % 60;
+            for (int i = 0; i < n; ++i) { seed = seed * 1103515245u + 12345u; buf += pieces[(seed >> 16) % 9]; }
+            size_t lines = 0, hits[4] = {};
+            std::string_view rest = buf, line;
+            while (util::next_line(rest, line)) {
+                ++lines;
+                for (int k = 0; k < 4; ++k) hits[k] += line.find(kw[k]) != std::string_view::npos;
+            }
+            for (auto isa : {util::ScanIsa::Scalar, util::ScanIsa::SSE2, util::ScanIsa::AVX2}) {
+                const auto c = util::count_lines(buf, kw, isa);
+                check("scan.lines", std::to_string(c.lines), std::to_string(lines));
+                for (int k = 0; k < 4; ++k) check("scan.hits", std::to_string(c.hits[k]), std::to_string(hits[k]));
+            }
+        }
+        // More keywords than the counts hold are refused, not silently dropped
+        const std::string_view many[util::kMaxScanKeywords + 1] = {"a", "b", "c", "d", "e", "f", "g", "h", "i"};
+        bool refused = false;
+        try { util::count_lines("a\n", many); } catch (const std::invalid_argument &) { refused = true; }
+        check("scan.tooMany", std::to_string(refused), "1");
+    }
+
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
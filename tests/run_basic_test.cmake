@@ -1,5 +1,5 @@
 execute_process(
-  COMMAND ${TEST_EXE} --photomesh sample_pm.log --realitymesh sample_rm.log -o out.xlsx
+  COMMAND ${TEST_EXE} --photomesh ${SAMPLE_DIR}/sample_pm.log --realitymesh ${SAMPLE_DIR}/sample_rm.log -o out.xlsx
   WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
   RESULT_VARIABLE result)
 if(NOT result EQUAL 0)
@@ -12,3 +12,27 @@ file(SIZE ${CMAKE_CURRENT_SOURCE_DIR}/out.xlsx size)
 if(size LESS 1000)
   message(FATAL_ERROR "Workbook too small")
 endif()
+
+# Partitioned master: one workbook per RunDate month plus an index
+set(parts ${CMAKE_CURRENT_SOURCE_DIR}/part_out)
+file(REMOVE_RECURSE ${parts})
+foreach(log sample_pm.log sample_rm.log)
+  execute_process(
+    COMMAND ${TEST_EXE} ${SAMPLE_DIR}/${log} --outputs-dir ${parts} --no-report --partition-master month
+    WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "logtoExcel --partition-master returned ${result}")
+  endif()
+endforeach()
+foreach(f Index.xlsx parts/2025-08.tsv parts/2025-08.xlsx parts/undated.xlsx partitions.tsv)
+  if(NOT EXISTS ${parts}/All_Exports_by_month/${f})
+    message(FATAL_ERROR "Partitioned master has no ${f}")
+  endif()
+endforeach()
+file(STRINGS ${parts}/All_Exports_by_month/partitions.tsv manifest)
+list(FILTER manifest INCLUDE REGEX "^(2025-08|undated)\t1\t")
+list(LENGTH manifest n)
+if(NOT n EQUAL 2)
+  message(FATAL_ERROR "Partition manifest does not list one row per partition")
+endif()
@@ -0,0 +1,49 @@
+// Interning: one stable id per distinct string, across threads and segments.
+#include "string_pool.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+int main() {
+    util::StringPool pool;
+    check("empty", std::to_string(static_cast<unsigned>(pool.intern(""))), "0");
+    check("empty.view", std::string(pool.view(util::Sym{})), "");
+
+    // Enough distinct values to span several segments and arena blocks, with
+    // a few too large for a shared block; every thread interns all of them
+    const int distinct = 5000;
+    auto value = [](int i) {
+        return (i % 97 == 0 ? std::string(40000, 'x') : std::string("NODE")) + std::to_string(i);
+    };
+    std::vector<std::vector<util::Sym>> ids(8, std::vector<util::Sym>(distinct));
+    util::parallel_for(ids.size(), 8, [&](size_t t) {
+        for (int k = 0; k < distinct; ++k) {
+            const int i = static_cast<int>((k * 7 + t * 131) % distinct);
+            ids[t][i] = pool.intern(value(i));
+        }
+    });
+    check("size", std::to_string(pool.size()), std::to_string(distinct + 1));
+    for (int i = 0; i < distinct; ++i) {
+        for (size_t t = 1; t < ids.size(); ++t)
+            if (ids[t][i] != ids[0][i]) check("same id", std::to_string(t), "0");
+        const auto v = pool.view(ids[0][i]);
+        if (v != value(i) || v.data()[v.size()] != '\0') check("view", std::string(v.substr(0, 20)), value(i).substr(0, 20));
+    }
+    check("find", pool.find("NODE1") ? "hit" : "miss", "hit");
+    check("find.absent", pool.find("NODE-1") ? "hit" : "miss", "miss");
+    check("find.no-insert", std::to_string(pool.size()), std::to_string(distinct + 1));
+
+    if (failures) std::fprintf(stderr, "%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
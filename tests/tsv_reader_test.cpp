@@ -0,0 +1,87 @@
+// TSV reader: fields and projections on every SIMD path, against a plain
+// find() split, including fields that straddle the 64-byte blocks.
+#include "tsv_reader.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+// Fields joined with '|', lines with ';'
+static std::string read_all(std::string_view text, util::ScanIsa isa, const std::vector<std::size_t> *project) {
+    util::TsvReader reader(text, isa);
+    if (project) reader.project(*project);
+    std::string out;
+    while (reader.next()) {
+        for (std::size_t i = 0; i < reader.fields().size(); ++i) (out += i ? "|" : "") += reader.fields()[i];
+        out += ';';
+    }
+    return out;
+}
+
+static std::string reference(std::string_view text, const std::vector<std::size_t> *project) {
+    std::string out;
+    while (!text.empty()) {
+        const std::size_t nl = text.find('\n');
+        std::string_view line = text.substr(0, nl);
+        text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        std::vector<std::string_view> cells;
+        for (std::size_t from = 0;;) {
+            const std::size_t tab = line.find('\t', from);
+            cells.push_back(line.substr(from, tab == std::string_view::npos ? std::string_view::npos : tab - from));
+            if (tab == std::string_view::npos) break;
+            from = tab + 1;
+        }
+        if (project) {
+            std::vector<std::string_view> picked;
+            for (std::size_t c : *project) picked.push_back(c < cells.size() ? cells[c] : std::string_view{});
+            cells = picked;
+        }
+        for (std::size_t i = 0; i < cells.size(); ++i) (out += i ? "|" : "") += cells[i];
+        out += ';';
+    }
+    return out;
+}
+
+int main() {
+    // Lines of growing width, so separators land on every block offset
+    std::string text = "Name\tPath\tSize\r\n\n";
+    for (int i = 0; i < 300; ++i) {
+        text += std::string(i % 70, 'a') + '\t' + "D:\\logs\\" + std::to_string(i) + '\t';
+        if (i % 5) text += std::to_string(i * 7);
+        if (i % 3 == 0) text += "\textra";
+        text += i % 4 ? "\n" : "\r\n";
+        if (i % 50 == 0) text += "short\n\t\n";
+    }
+    text += "last\tline";
+
+    const std::vector<std::size_t> path = {1}, swapped = {3, 0}, none = {};
+    for (auto isa : {util::ScanIsa::Scalar, util::ScanIsa::SSE2, util::ScanIsa::AVX2}) {
+        const std::string name = util::scan_isa_name(isa);
+        check((name + ".all").c_str(), read_all(text, isa, nullptr), reference(text, nullptr));
+        check((name + ".path").c_str(), read_all(text, isa, &path), reference(text, &path));
+        check((name + ".swapped").c_str(), read_all(text, isa, &swapped), reference(text, &swapped));
+        check((name + ".none").c_str(), read_all(text, isa, &none), reference(text, &none));
+    }
+
+    util::TsvReader reader("a\tb\nc\td\r\n");
+    reader.next();
+    reader.next();
+    check("line", std::string(reader.line()), "c\td");
+    check("offset", std::to_string(reader.offset()), "4");
+    check("end", reader.next() ? "more" : "end", "end");
+    check("empty", util::TsvReader("").next() ? "line" : "none", "none");
+
+    if (failures) return 1;
+    std::puts("tsv_reader_test OK");
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Equivalence of the hand-written util_time parsers with the previous
+// get_time/regex implementations, plus the formats only the new ones accept.
+#include "legacy_util_time.hpp"
+#include "util_time.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(const char *what, const std::string &got, const std::string &want) {
+    if (got != want) {
+        std::fprintf(stderr, "FAIL %s: got '%s', want '%s'\n", what, got.c_str(), want.c_str());
+        ++failures;
+    }
+}
+
+static std::string show(const std::optional<util::TimePoint> &t) {
+    if (!t) return "none";
+    return std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(t->time_since_epoch()).count());
+}
+
+int main() {
+    // Timestamps: every layout, boundary values, rollover and malformed input
+    std::vector<std::string> times = {
+        "2025-08-20T17:59:55Z", "2025-08-20 17:59:55", "08/20/2025 17:59:55",
+        "1970-01-01T00:00:00Z", "1969-12-31T23:59:59Z", "2000-02-29T12:00:00Z", "2024-12-31 23:59:60",
+        "2023-02-31 10:00:00", "2100-03-01T00:00:00Z", "0001-01-01 00:00:00", "9999-12-31T23:59:59Z",
+        "2025-8-2 7:05:09", "8/2/2025 7:05:09", "2025-08-20 17:59:55 trailing", "2025-08-20T17:59:55Zjunk",
+        "12/31/1999 23:59:59PM", "", "garbage", "2025-13-01T00:00:00Z", "2025-00-10T00:00:00Z",
+        "2025-01-32 00:00:00", "2025-01-01 24:00:00", "2025-01-01 00:60:00", "2025-01-01 00:00:61",
+        "2025/01/01 00:00:00", "13/01/2025 00:00:00",
+        "2025-01-01X00:00:00Z", "20250-01-01 00:00:00", "2025-001-01 00:00:00",
+    };
+    for (int y : {1999, 2024, 2025})
+        for (int mo = 1; mo <= 12; mo += 5)
+            for (int d = 1; d <= 31; d += 10)
+                for (int h = 0; h < 24; h += 7) {
+                    char buf[64];
+                    std::snprintf(buf, sizeof buf, "%04d-%02d-%02dT%02d:%02d:%02dZ", y, mo, d, h, (h * 7) % 60, (d * 3) % 60);
+                    times.push_back(buf);
+                    std::snprintf(buf, sizeof buf, "%02d/%02d/%04d %02d:%02d:%02d", mo, d, y, h, h % 60, d % 60);
+                    times.push_back(buf);
+                }
+    util::TimeParser cached;
+    for (const auto &s : times) {
+        const std::string want = show(legacy::parse_time(s));
+        check(("parse_time " + s).c_str(), show(util::parse_time(s)), want);
+        check(("TimeParser " + s).c_str(), show(cached(s)), want);
+    }
+    std::vector<std::string_view> views(times.begin(), times.end());
+    std::vector<std::optional<util::TimePoint>> batch(views.size());
+    util::parse_times(views, batch);
+    for (size_t i = 0; i < views.size(); ++i)
+        check("parse_times", show(batch[i]), show(legacy::parse_time(times[i])));
+
+    // Only the new parser: fractions, offsets, ISO without Z
+    check("frac", show(util::parse_time("2025-08-20T17:59:55.250Z")),
+          show(*util::parse_time("2025-08-20T17:59:55Z") + std::chrono::milliseconds(250)));
+    check("offset", show(util::parse_time("2025-08-20T19:59:55+02:00")), show(util::parse_time("2025-08-20T17:59:55Z")));
+    check("offset.compact", show(util::parse_time("2025-08-20 12:29:55.5-0530")),
+          show(*util::parse_time("2025-08-20T17:59:55Z") + std::chrono::milliseconds(500)));
+    check("offset.hours", show(util::parse_time("08/20/2025 18:59:55+01")), show(util::parse_time("2025-08-20T17:59:55Z")));
+    check("noZ", show(util::parse_time("2025-08-20T17:59:55")), show(util::parse_time("2025-08-20T17:59:55Z")));
+    // Input cut short: libstdc++'s get_time stopped at end of input and
+    // succeeded, MSVC's failed; the date and the full time are required now
+    check("truncated.date", show(util::parse_time("2025-01-01")), "none");
+    check("truncated.time", show(util::parse_time("2025-01-01 00:00")), "none");
+    check("duration.offsets", util::compute_duration("2025-08-20T17:00:00Z", "2025-08-20T20:30:15+02:00"), "01:30:15");
+
+    // Formatting back to text
+    auto text = [](auto fmt, std::string_view s) {
+        char buf[40];
+        return std::string(buf, fmt(buf, *util::parse_time(s)));
+    };
+    check("format_time", text(util::format_time, "2025-08-20T19:59:55.250+02:00"), "2025-08-20T17:59:55.25Z");
+    check("format_time.whole", text(util::format_time, "08/02/2025 07:05:09"), "2025-08-02T07:05:09Z");
+    check("format_time.ns", text(util::format_time, "1969-12-31T23:59:59.000000001Z"), "1969-12-31T23:59:59.000000001Z");
+    check("format_stamp", text(util::format_stamp, "2000-02-29T23:59:60Z"), "2000-03-01 00:00:00");
+    check("format_date", text(util::format_date, "1900-01-01 00:00:00"), "1900-01-01");
+
+    for (int secs : {-5, 0, 1, 59, 60, 3599, 3600, 86399, 359999, 360000, 2147483647}) {
+        check("hhmmss", util::seconds_to_hhmmss(secs), legacy::seconds_to_hhmmss(secs));
+    }
+    check("duration", util::compute_duration("2025-08-20T17:59:55Z", "2025-08-20T18:59:55Z"),
+          legacy::compute_duration("2025-08-20T17:59:55Z", "2025-08-20T18:59:55Z"));
+    check("duration.bad", util::compute_duration("x", "2025-08-20T18:59:55Z"), "");
+
+    for (const char *s : {"2048 MB", "2048MB", "1.5 gb", "1.5GB", "123 b", "512 KB", "0.004 KB", "Size: 12 items, 5 MB",
+                          "1.2.3 MB", "12.MB", "10 GiB", "no size", "", "7\tkB", "3.14159 Gb extra 9 MB", "999999999999 B",
+                          "1.005 GB", "2.675 GB", "0.125 GB", "5 Mb", "MB 5", "55", "x9MBy"}) {
+        check(("size_to_gb " + std::string(s)).c_str(), util::size_to_gb(s), legacy::size_to_gb(s));
+    }
+
+    if (failures) std::fprintf(stderr, "%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}